@@ -0,0 +1,127 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+// Compares the byte-wise json_value_end() boundary scanner against the
+// block classifier based fastjson_split_values().
+//
+// Usage: json_boundary_bench [FILE]
+//
+// Without FILE a synthetic JSON Lines document is generated.
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "fastjson_parser.hpp"
+#include "value_boundary.hpp"
+
+using namespace prio;
+
+namespace {
+
+constexpr int ROUNDS = 10;
+
+std::string generate_jsonl(std::size_t target_size)
+{
+  std::string text;
+  text.reserve(target_size + 256);
+  for (int i = 0; text.size() < target_size; ++i) {
+    text += std::format(R"({{"event-{}": {{"id": {}, "name": "record \"{}\"", )"
+                        R"("values": [1.5, -2, 3e4, true, null], "tags": ["a", "b[c]", "{{d}}"]}}}})",
+                        i % 17, i, i);
+    text += '\n';
+  }
+  return text;
+}
+
+std::vector<std::string_view> split_bytewise(std::string_view text)
+{
+  std::vector<std::string_view> values;
+  char const* p = text.data();
+  char const* const end = p + text.size();
+  while (true) {
+    while (p < end && std::isspace(static_cast<unsigned char>(*p))) {
+      ++p;
+    }
+    if (p >= end) {
+      break;
+    }
+
+    char const* const value_end = json_value_end(p, end);
+    if (!value_end) {
+      throw std::runtime_error("incomplete or invalid JSON value");
+    }
+    values.emplace_back(p, static_cast<std::size_t>(value_end - p));
+    p = value_end;
+  }
+  return values;
+}
+
+template<typename Func>
+void run(std::string_view name, std::string_view text, Func func)
+{
+  double best = 1e30;
+  std::size_t count = 0;
+  for (int round = 0; round < ROUNDS; ++round) {
+    auto const start = std::chrono::steady_clock::now();
+    count = func(text).size();
+    std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+    best = std::min(best, elapsed.count());
+  }
+
+  std::cout << std::format("{:<24} {:>10} values {:>10.3f} ms {:>10.1f} MiB/s\n",
+                           name, count, best * 1000.0,
+                           static_cast<double>(text.size()) / (1024.0 * 1024.0) / best);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  std::string text;
+  if (argc > 1) {
+    std::ifstream in(argv[1], std::ios::binary);
+    if (!in) {
+      std::cerr << argv[1] << ": failed to open" << std::endl;
+      return EXIT_FAILURE;
+    }
+    text.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  } else {
+    text = generate_jsonl(64 * 1024 * 1024);
+  }
+
+  std::cout << std::format("input: {} bytes, best of {} rounds\n", text.size(), ROUNDS);
+
+  if (split_bytewise(text) != fastjson_split_values(text)) {
+    std::cerr << "error: scanners disagree" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  run("json_value_end", text, split_bytewise);
+  run("fastjson_split_values", text, fastjson_split_values);
+
+  return EXIT_SUCCESS;
+}
+
+/* EOF */
@@ -38,7 +38,7 @@ void write(Writer& writer, ReaderMapping const& body, std::string_view key);
 
 void write(Writer& writer, ReaderMapping const& body)
 {
-  for (auto const& key : body.get_keys()) {
+  for (std::string_view key : body.keys()) {
     try {
       write(writer, body, key);
     } catch (ReaderError const& err) {
@@ -89,7 +89,7 @@ void write(Writer& writer, ReaderMapping const& body, std::string_view key)
     writer.end_mapping();
   } else if (body.read(key, collection)) {
     writer.begin_collection(key);
-    for (auto const& obj : collection.get_objects()) {
+    for (ReaderObject const& obj : collection) {
       writer.begin_object(obj.get_name());
       write(writer, obj.get_mapping());
       writer.end_object();
@@ -220,13 +220,13 @@ void linearize_object(std::ostream& out, std::string const& path_prefix, ReaderO
     : append_key(path_prefix, object.get_name());
 
   ReaderMapping const mapping = object.get_mapping();
-  std::vector<std::string> const keys = mapping.get_keys();
+  ReaderMapping::KeyRange const keys = mapping.keys();
   if (keys.empty()) {
     // Empty object: still emit a line so the name is visible to grep.
     emit_line(out, path, "");
     return;
   }
-  for (std::string const& key : keys) {
+  for (std::string_view key : keys) {
     try {
       linearize_key(out, path, mapping, key);
     } catch (ReaderError const& err) {
@@ -238,7 +238,7 @@ void linearize_object(std::ostream& out, std::string const& path_prefix, ReaderO
 
 void linearize_mapping(std::ostream& out, std::string const& path, ReaderMapping const& body)
 {
-  for (std::string const& key : body.get_keys()) {
+  for (std::string_view key : body.keys()) {
     try {
       linearize_key(out, path, body, key);
     } catch (ReaderError const& err) {
@@ -300,19 +300,20 @@ void linearize_key(std::ostream& out, std::string const& path, ReaderMapping con
   }
 
   else if (body.read(key, mapping)) {
-    if (mapping.get_keys().empty()) {
+    if (mapping.keys().empty()) {
       emit_line(out, child, "");
     } else {
       linearize_mapping(out, child, mapping);
     }
   } else if (body.read(key, collection)) {
-    std::vector<ReaderObject> const objects = collection.get_objects();
-    if (objects.empty()) {
+    if (collection.size() == 0) {
       emit_line(out, child, "[]");
     } else {
-      for (std::size_t i = 0; i < objects.size(); ++i) {
+      std::size_t i = 0;
+      for (ReaderObject const& obj : collection) {
         // collection[i].ObjectName.prop = ...
-        linearize_object(out, append_index(child, i), objects[i]);
+        linearize_object(out, append_index(child, i), obj);
+        i += 1;
       }
     }
   } else if (body.read(key, object)) {
@@ -344,6 +345,9 @@ void print_usage(char const* arg0)
             << "  --json         Output pretty json\n"
             << "  --fastjson     Output fastjson\n"
             << "  --sexp         Output s-expressions\n"
+            << "  --fastsexp     Output s-expressions (same as --sexp)\n"
+            << "  --binary       Output binary, input format is detected automatically\n"
+            << "  --msgpack      Output MessagePack\n"
             << "  --linearize    Flatten to path = value lines (grep-friendly)\n"
             << "  -l             Same as --linearize\n"
             << "\n"
@@ -378,6 +382,12 @@ Options parse_args(int argc, char** argv)
         opts.format = Format::FASTJSON;
       } else if (strcmp(argv[i], "--sexp") == 0) {
         opts.format = Format::SEXPR;
+      } else if (strcmp(argv[i], "--fastsexp") == 0) {
+        opts.format = Format::FASTSEXPR;
+      } else if (strcmp(argv[i], "--binary") == 0) {
+        opts.format = Format::BINARY;
+      } else if (strcmp(argv[i], "--msgpack") == 0) {
+        opts.format = Format::MSGPACK;
       } else if (strcmp(argv[i], "--linearize") == 0 || strcmp(argv[i], "-l") == 0) {
         opts.linearize = true;
       } else {
@@ -0,0 +1,154 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_PRIO_BINARY_READER_IMPL_HPP
+#define HEADER_PRIO_BINARY_READER_IMPL_HPP
+
+#include "reader_impl.hpp"
+
+#include <assert.h>
+#include <cstdint>
+#include <memory>
+
+#include "error_handler.hpp"
+
+namespace prio {
+
+class InputBuffer;
+
+/** Backend for Format::BINARY. Opening a document only checks the
+    header, nodes are bounds checked and decoded in place as they are
+    accessed, so that only the touched parts of a mapped file are paged
+    in. Corrupted structure is reported as ReaderError regardless of the
+    ErrorHandler. */
+class BinaryReaderDocumentImpl final : public ReaderDocumentImpl
+{
+public:
+  static constexpr std::uint32_t npos = UINT32_MAX;
+
+public:
+  BinaryReaderDocumentImpl(std::shared_ptr<InputBuffer const> buffer, ErrorHandler error_handler,
+                           std::optional<std::string> filename);
+  BinaryReaderDocumentImpl(BinaryReaderDocumentImpl const&) = delete;
+  BinaryReaderDocumentImpl& operator=(BinaryReaderDocumentImpl const&) = delete;
+  ~BinaryReaderDocumentImpl() override;
+
+  ReaderObject get_root() const override;
+  std::optional<std::string> get_filename() const override { return m_filename; }
+  void set_parent(ReaderDocument const* parent) override { m_parent = parent; }
+  ReaderDocument const& get_parent() const override { assert(m_parent != nullptr); return *m_parent; }
+  std::size_t get_memory_usage() const override;
+
+  void error(std::uint32_t offset, std::string_view message) const;
+  void error(ErrorHandler error_handler, std::uint32_t offset, std::string_view message) const;
+
+  std::string_view get_data() const { return m_data; }
+
+private:
+  std::shared_ptr<InputBuffer const> m_buffer;
+  std::string_view m_data;
+  std::uint32_t m_root;
+  ErrorHandler m_error_handler;
+  std::optional<std::string> m_filename;
+  ReaderDocument const* m_parent;
+};
+
+class BinaryReaderObjectImpl final : public ReaderObjectImpl
+{
+public:
+  /** @a node is the offset of the object's mapping node or npos if the
+      value is not a mapping */
+  BinaryReaderObjectImpl(BinaryReaderDocumentImpl const& doc, std::uint32_t node);
+  ~BinaryReaderObjectImpl() override;
+
+  BinaryReaderDocumentImpl const& get_document() const override { return m_doc; }
+  std::string get_name() const override;
+  std::string_view get_name_view() const override;
+  ReaderMapping get_mapping() const override;
+
+private:
+  BinaryReaderDocumentImpl const& m_doc;
+  std::uint32_t m_node;
+  std::uint32_t m_count;
+};
+
+class BinaryReaderCollectionImpl final : public ReaderCollectionImpl
+{
+public:
+  BinaryReaderCollectionImpl(BinaryReaderDocumentImpl const& doc, std::uint32_t node);
+  ~BinaryReaderCollectionImpl() override;
+
+  BinaryReaderDocumentImpl const& get_document() const override { return m_doc; }
+  std::vector<ReaderObject> get_objects() const override;
+
+  std::size_t get_size() const override;
+  ReaderObject get_object(std::size_t index) const override;
+
+private:
+  BinaryReaderDocumentImpl const& m_doc;
+  std::uint32_t m_node;
+  std::uint32_t m_count;
+};
+
+class BinaryReaderMappingImpl final : public ReaderMappingImpl
+{
+public:
+  BinaryReaderMappingImpl(BinaryReaderDocumentImpl const& doc, std::uint32_t node);
+  ~BinaryReaderMappingImpl() override;
+
+  BinaryReaderDocumentImpl const& get_document() const override { return m_doc; }
+  std::vector<std::string> get_keys() const override;
+  std::size_t first_key_cursor() const override;
+  std::size_t next_key_cursor(std::size_t cursor) const override;
+  std::size_t end_key_cursor() const override;
+  std::string_view get_key_at_cursor(std::size_t cursor, std::string& buffer) const override;
+
+  bool read(Key const& key, bool& value) const override;
+  bool read(Key const& key, int& value) const override;
+  bool read(Key const& key, float& value) const override;
+  bool read(Key const& key, std::string& value) const override;
+
+  bool read(Key const& key, std::vector<bool>& values) const override;
+  bool read(Key const& key, std::vector<int>& values) const override;
+  bool read(Key const& key, std::vector<float>& values) const override;
+  bool read(Key const& key, std::vector<std::string>& values) const override;
+
+  bool read(Key const& key, std::string_view& value) const override;
+  bool read(Key const& key, std::span<int> values) const override;
+  bool read(Key const& key, std::span<float> values) const override;
+
+  bool read(Key const& key, ReaderMapping& value) const override;
+  bool read(Key const& key, ReaderCollection& value) const override;
+  bool read(Key const& key, ReaderObject& value) const override;
+
+  void error(std::string_view key, std::string_view message) const override;
+  void missing_key_error(std::string_view key) const override;
+
+private:
+  /** Returns the index of the entry for @a key, npos if there is none */
+  std::uint32_t find(std::string_view key) const;
+
+private:
+  BinaryReaderDocumentImpl const& m_doc;
+  std::uint32_t m_node;
+  std::uint32_t m_count;
+};
+
+} // namespace prio
+
+#endif
+
+/* EOF */
@@ -0,0 +1,72 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_PRIO_DOCUMENT_ARENA_HPP
+#define HEADER_PRIO_DOCUMENT_ARENA_HPP
+
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace prio {
+
+/** Storage owned by a document for strings that have to be decoded
+    but are handed out as views into the document. The strings are
+    copied into blocks that are all freed at once when the document is
+    destroyed. Thread-safe, as documents may be shared between threads. */
+class DocumentArena final
+{
+public:
+  DocumentArena();
+  ~DocumentArena();
+
+  /** Copies @a text into the arena. Equal strings are only stored
+      once, so reading the same value again doesn't grow the arena. */
+  std::string_view store(std::string_view text);
+
+  /** Like the above, but for strings identified by @a id, e.g. their
+      position in the document, so that they only have to be decoded
+      once. find() returns the string stored for @a id, if any. */
+  std::string_view store(std::size_t id, std::string_view text);
+  std::optional<std::string_view> find(std::size_t id) const;
+
+  /** Number of bytes stored so far */
+  std::size_t get_size() const;
+
+private:
+  std::string_view copy(std::string_view text);
+
+private:
+  mutable std::mutex m_mutex;
+  std::pmr::monotonic_buffer_resource m_resource;
+  std::size_t m_size;
+  std::unordered_set<std::string_view> m_strings;
+  std::unordered_map<std::size_t, std::string_view> m_ids;
+
+private:
+  DocumentArena(DocumentArena const&) = delete;
+  DocumentArena& operator=(DocumentArena const&) = delete;
+};
+
+} // namespace prio
+
+#endif
+
+/* EOF */
@@ -0,0 +1,131 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_PRIO_DOCUMENT_CACHE_HPP
+#define HEADER_PRIO_DOCUMENT_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+#include "error_handler.hpp"
+#include "format.hpp"
+#include "reader_document.hpp"
+
+namespace prio {
+
+/** Shares loaded documents between the users of a process. Documents
+    are handed out as shared immutable handles and stay valid for as long
+    as a handle is held, even after the cache dropped them.
+
+    Documents are kept until the sum of their
+    ReaderDocument::get_memory_usage() exceeds the memory budget, then the
+    least recently used ones are evicted. Documents grow as strings are
+    decoded into their arena, their memory usage is updated whenever they
+    are requested again and before documents are evicted. The cache doesn't watch the
+    files, use erase() when a file is known to have changed. As with
+    ReaderDocument::from_file(), large files stay mapped for as long as
+    their document is in use and must not be truncated in place.
+
+    All member functions are thread-safe. */
+class DocumentCache final
+{
+public:
+  using Handle = std::shared_ptr<ReaderDocument const>;
+
+public:
+  explicit DocumentCache(std::size_t memory_budget);
+  ~DocumentCache();
+
+  /** Returns the document for @a filename, loading it on the first
+      request. Concurrent requests for a document that is being loaded
+      wait for that load instead of starting their own. Load errors are
+      reported to all of them and are not cached. Documents loaded with
+      different formats or error handlers are cached separately. */
+  Handle from_file(Format format, std::filesystem::path const& filename,
+                   ErrorHandler error_handler = ErrorHandler::THROW);
+  Handle from_file(std::filesystem::path const& filename,
+                   ErrorHandler error_handler = ErrorHandler::THROW);
+
+  /** Drops all documents loaded from @a filename, loads in progress
+      complete but their result isn't cached */
+  void erase(std::filesystem::path const& filename);
+
+  /** Drops all documents */
+  void clear();
+
+  /** Changes the memory budget, evicting documents as needed */
+  void set_memory_budget(std::size_t memory_budget);
+  std::size_t get_memory_budget() const;
+
+  /** Returns the memory used by the cached documents as of their last
+      request or eviction check */
+  std::size_t get_memory_usage() const;
+
+  /** Returns the number of cached documents, loads in progress excluded */
+  std::size_t size() const;
+
+private:
+  using Key = std::tuple<std::string, Format, ErrorHandler>;
+  struct Entry;
+  using Entries = std::map<Key, Entry>;
+
+  struct Entry
+  {
+    /** identifies the load that created the entry */
+    std::uint64_t id;
+
+    /** ready once the load finished */
+    std::shared_future<Handle> future;
+
+    /** null while loading */
+    Handle document;
+    std::size_t memory_usage;
+    std::list<Entries::iterator>::iterator lru;
+  };
+
+  void update(Entries::iterator it);
+  void evict();
+  void remove(Entries::iterator it);
+
+private:
+  mutable std::mutex m_mutex;
+  Entries m_entries;
+
+  /** loaded entries, most recently used first */
+  std::list<Entries::iterator> m_lru;
+
+  std::size_t m_memory_budget;
+  std::size_t m_memory_usage;
+  std::uint64_t m_next_id;
+
+private:
+  DocumentCache(DocumentCache const&) = delete;
+  DocumentCache& operator=(DocumentCache const&) = delete;
+};
+
+} // namespace prio
+
+#endif
+
+/* EOF */
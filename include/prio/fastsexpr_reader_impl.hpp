@@ -0,0 +1,186 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_PRIO_FASTSEXPR_READER_IMPL_HPP
+#define HEADER_PRIO_FASTSEXPR_READER_IMPL_HPP
+
+#include "reader_impl.hpp"
+
+#include <assert.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "error_handler.hpp"
+
+namespace prio {
+
+class InputBuffer;
+class FastSExprTape;
+
+/** In-tree s-expression backend used for Format::FASTSEXPR, follows the
+    semantics of SExprReaderDocumentImpl but reads values straight from
+    the tape built by fastsexpr_parse() */
+class FastSExprReaderDocumentImpl final : public ReaderDocumentImpl
+{
+public:
+  FastSExprReaderDocumentImpl(std::shared_ptr<InputBuffer const> buffer, ErrorHandler error_handler,
+                                std::optional<std::string> filename);
+
+  /** Uses an already built @a tape for the text of @a buffer */
+  FastSExprReaderDocumentImpl(std::shared_ptr<InputBuffer const> buffer, std::unique_ptr<FastSExprTape> tape,
+                            ErrorHandler error_handler, std::optional<std::string> filename);
+  FastSExprReaderDocumentImpl(FastSExprReaderDocumentImpl const&) = delete;
+  FastSExprReaderDocumentImpl& operator=(FastSExprReaderDocumentImpl const&) = delete;
+  ~FastSExprReaderDocumentImpl() override;
+
+  ReaderObject get_root() const override;
+  std::optional<std::string> get_filename() const override { return m_filename; }
+  void set_parent(ReaderDocument const* parent) override { m_parent = parent; }
+  ReaderDocument const& get_parent() const override { assert(m_parent != nullptr); return *m_parent; }
+  std::size_t get_memory_usage() const override;
+
+  void error(std::uint32_t index, std::string_view message) const;
+  void error(ErrorHandler error_handler, std::uint32_t index, std::string_view message) const;
+
+  FastSExprTape const& get_tape() const { return *m_tape; }
+  std::string_view get_text() const { return m_text; }
+
+private:
+  std::shared_ptr<InputBuffer const> m_buffer;
+  std::string_view m_text;
+  std::unique_ptr<FastSExprTape> m_tape;
+  ErrorHandler m_error_handler;
+  std::optional<std::string> m_filename;
+  ReaderDocument const* m_parent;
+};
+
+class FastSExprReaderObjectImpl final : public ReaderObjectImpl
+{
+public:
+  FastSExprReaderObjectImpl(FastSExprReaderDocumentImpl const& doc, std::uint32_t index);
+  ~FastSExprReaderObjectImpl() override;
+
+  FastSExprReaderDocumentImpl const& get_document() const override { return m_doc; }
+  std::string get_name() const override;
+  std::string_view get_name_view() const override;
+  ReaderMapping get_mapping() const override;
+
+private:
+  FastSExprReaderDocumentImpl const& m_doc;
+  std::uint32_t m_index;
+};
+
+class FastSExprReaderCollectionImpl final : public ReaderCollectionImpl
+{
+public:
+  FastSExprReaderCollectionImpl(FastSExprReaderDocumentImpl const& doc, std::uint32_t index);
+  FastSExprReaderCollectionImpl(FastSExprReaderCollectionImpl&& other) noexcept;
+  ~FastSExprReaderCollectionImpl() override;
+
+  FastSExprReaderDocumentImpl const& get_document() const override { return m_doc; }
+  std::vector<ReaderObject> get_objects() const override;
+
+  std::size_t get_size() const override;
+  ReaderObject get_object(std::size_t index) const override;
+
+  std::size_t first_cursor() const override;
+  std::size_t next_cursor(std::size_t cursor) const override;
+  std::size_t end_cursor() const override;
+  ReaderObject get_object_at_cursor(std::size_t cursor) const override;
+
+private:
+  /** Tape positions of the elements, built on the first call so that
+      get_size() and get_object() don't walk the tape, iteration with
+      the cursors doesn't use them. Published with a compare-and-swap,
+      a thread that loses the race discards its copy. */
+  using Elements = std::vector<std::uint32_t>;
+  Elements const& get_elements() const;
+
+private:
+  FastSExprReaderDocumentImpl const& m_doc;
+  std::uint32_t m_index;
+  mutable std::atomic<Elements const*> m_elements;
+};
+
+class FastSExprReaderMappingImpl final : public ReaderMappingImpl
+{
+public:
+  FastSExprReaderMappingImpl(FastSExprReaderDocumentImpl const& doc, std::uint32_t index);
+  ~FastSExprReaderMappingImpl() override;
+
+  FastSExprReaderDocumentImpl const& get_document() const override { return m_doc; }
+  std::vector<std::string> get_keys() const override;
+  std::size_t first_key_cursor() const override;
+  std::size_t next_key_cursor(std::size_t cursor) const override;
+  std::size_t end_key_cursor() const override;
+  std::string_view get_key_at_cursor(std::size_t cursor, std::string& buffer) const override;
+
+  bool read(Key const& key, bool& value) const override;
+  bool read(Key const& key, int& value) const override;
+  bool read(Key const& key, float& value) const override;
+  bool read(Key const& key, std::string& value) const override;
+
+  bool read(Key const& key, std::vector<bool>& values) const override;
+  bool read(Key const& key, std::vector<int>& values) const override;
+  bool read(Key const& key, std::vector<float>& values) const override;
+  bool read(Key const& key, std::vector<std::string>& values) const override;
+
+  bool read(Key const& key, std::string_view& value) const override;
+  bool read(Key const& key, std::span<int> values) const override;
+  bool read(Key const& key, std::span<float> values) const override;
+
+  bool read(Key const& key, ReaderMapping& value) const override;
+  bool read(Key const& key, ReaderCollection& value) const override;
+  bool read(Key const& key, ReaderObject& value) const override;
+
+  void read_fields(ReaderFieldTable const& fields, std::span<bool> found) const override;
+
+  void error(std::string_view key, std::string_view message) const override;
+  void missing_key_error(std::string_view key) const override;
+
+private:
+  bool read_element(std::uint32_t sub, bool& value) const;
+  bool read_element(std::uint32_t sub, int& value) const;
+  bool read_element(std::uint32_t sub, float& value) const;
+  bool read_element(std::uint32_t sub, std::string& value) const;
+
+  bool read_element(std::uint32_t sub, std::vector<bool>& values) const;
+  bool read_element(std::uint32_t sub, std::vector<int>& values) const;
+  bool read_element(std::uint32_t sub, std::vector<float>& values) const;
+  bool read_element(std::uint32_t sub, std::vector<std::string>& values) const;
+
+  bool read_element(std::uint32_t sub, std::string_view& value) const;
+  bool read_element(std::uint32_t sub, std::span<int> values) const;
+  bool read_element(std::uint32_t sub, std::span<float> values) const;
+
+  bool read_element(std::uint32_t sub, ReaderMapping& value) const;
+  bool read_element(std::uint32_t sub, ReaderCollection& value) const;
+  bool read_element(std::uint32_t sub, ReaderObject& value) const;
+
+  std::uint32_t get_item(std::uint32_t sub) const;
+  std::uint32_t get_subsection(std::string_view key) const;
+
+private:
+  FastSExprReaderDocumentImpl const& m_doc;
+  std::uint32_t m_index;
+};
+
+} // namespace prio
+
+#endif
+
+/* EOF */
@@ -0,0 +1,235 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef HEADER_PRIO_FIELDS_HPP
+#define HEADER_PRIO_FIELDS_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "key.hpp"
+#include "reader_field.hpp"
+#include "reader_mapping.hpp"
+#include "writer.hpp"
+#include "writer_field.hpp"
+
+/** Declares the members of a struct that are read from and written to
+    a mapping, each under a key of the same name:
+
+      struct Enemy { std::string name; int health; float speed; };
+      PRIO_FIELDS(Enemy, name, health, speed)
+
+    Afterwards `mapping.get<Enemy>("enemy")` reads the struct in a
+    single pass over the mapping, missing keys leave their member
+    untouched, and `writer.write("enemy", enemy)` writes it as a
+    mapping in a single call into the writer. The macro must be placed
+    in the namespace of the struct, for keys that differ from the
+    member names a prio_fields() function can be written by hand in the
+    same way. */
+#define PRIO_FIELDS(type, ...)                                          \
+  constexpr auto prio_fields(type const*)                               \
+  {                                                                     \
+    return std::make_tuple(PRIO_FIELDS_FOR_EACH_(type, __VA_ARGS__));   \
+  }
+
+#define PRIO_FIELDS_EXPAND_(...) PRIO_FIELDS_EXPAND4_(PRIO_FIELDS_EXPAND4_(PRIO_FIELDS_EXPAND4_(PRIO_FIELDS_EXPAND4_(__VA_ARGS__))))
+#define PRIO_FIELDS_EXPAND4_(...) PRIO_FIELDS_EXPAND3_(PRIO_FIELDS_EXPAND3_(PRIO_FIELDS_EXPAND3_(PRIO_FIELDS_EXPAND3_(__VA_ARGS__))))
+#define PRIO_FIELDS_EXPAND3_(...) PRIO_FIELDS_EXPAND2_(PRIO_FIELDS_EXPAND2_(PRIO_FIELDS_EXPAND2_(PRIO_FIELDS_EXPAND2_(__VA_ARGS__))))
+#define PRIO_FIELDS_EXPAND2_(...) PRIO_FIELDS_EXPAND1_(PRIO_FIELDS_EXPAND1_(PRIO_FIELDS_EXPAND1_(PRIO_FIELDS_EXPAND1_(__VA_ARGS__))))
+#define PRIO_FIELDS_EXPAND1_(...) __VA_ARGS__
+
+#define PRIO_FIELDS_FOR_EACH_(type, ...)                                \
+  __VA_OPT__(PRIO_FIELDS_EXPAND_(PRIO_FIELDS_FOR_EACH_HELPER_(type, __VA_ARGS__)))
+#define PRIO_FIELDS_FOR_EACH_HELPER_(type, member, ...)                 \
+  ::prio::make_field(#member, &type::member)                            \
+  __VA_OPT__(, PRIO_FIELDS_FOR_EACH_AGAIN_ PRIO_FIELDS_PARENS_ (type, __VA_ARGS__))
+#define PRIO_FIELDS_PARENS_ ()
+#define PRIO_FIELDS_FOR_EACH_AGAIN_() PRIO_FIELDS_FOR_EACH_HELPER_
+
+namespace prio {
+
+/** Binds @a key to the member @a member of T */
+template<typename T, typename M>
+struct Field
+{
+  using struct_type = T;
+  using member_type = M;
+
+  Key key;
+  M T::* member;
+};
+
+template<typename T, typename M>
+constexpr Field<T, M> make_field(Key key, M T::* member)
+{
+  return Field<T, M>{key, member};
+}
+
+namespace detail {
+
+/** Fields of a type supported by ReaderFieldTarget are stored by
+    ReaderMapping::read_fields(), others are read separately */
+template<typename F>
+constexpr bool is_direct_field = std::is_constructible_v<ReaderFieldTarget, typename F::member_type*>;
+
+/** Likewise for Writer::write_fields() and WriterFieldValue */
+template<typename F>
+constexpr bool is_direct_writer_field = std::is_constructible_v<WriterFieldValue, typename F::member_type const*>;
+
+/** Returns the smallest table size for which `hash % size` differs for
+    all of @a hashes, zero if there is none among the first sizes tried,
+    lookups then fall back to comparing the keys. The search is bounded
+    to keep compile times low for structs with many fields. */
+template<std::size_t N>
+constexpr std::size_t perfect_hash_size(std::array<std::uint64_t, N> const& hashes)
+{
+  constexpr std::size_t min_size = std::max<std::size_t>(N, 1);
+  constexpr std::size_t max_size = std::min<std::size_t>(min_size * 8 + 64, 0xffff);
+
+  std::array<bool, max_size> used{};
+  for (std::size_t size = min_size; size <= max_size; ++size) {
+    std::fill_n(used.begin(), size, false);
+    bool collision = false;
+    for (std::size_t i = 0; i < N && !collision; ++i) {
+      std::size_t const slot = hashes[i] % size;
+      collision = used[slot];
+      used[slot] = true;
+    }
+    if (!collision) {
+      return size;
+    }
+  }
+  return 0;
+}
+
+template<typename T>
+struct FieldInfo
+{
+  static constexpr auto fields = prio_fields(static_cast<T const*>(nullptr));
+  using Fields = std::remove_cv_t<decltype(fields)>;
+  static constexpr std::size_t count = std::tuple_size_v<Fields>;
+
+  static constexpr std::size_t direct_count = []<std::size_t... I>(std::index_sequence<I...>) {
+    return (std::size_t{0} + ... + (is_direct_field<std::tuple_element_t<I, Fields>> ? 1 : 0));
+  }(std::make_index_sequence<count>());
+
+  static constexpr std::array<std::uint64_t, direct_count> hashes = []<std::size_t... I>(std::index_sequence<I...>) {
+    std::array<std::uint64_t, direct_count> result{};
+    std::size_t n = 0;
+    ((is_direct_field<std::tuple_element_t<I, Fields>> ?
+      void(result[n++] = std::get<I>(fields).key.get_hash()) : void()), ...);
+    return result;
+  }(std::make_index_sequence<count>());
+
+  static constexpr bool unique_keys = []<std::size_t... I>(std::index_sequence<I...>) {
+    std::array<Key, count> const keys = { std::get<I>(fields).key... };
+    for (std::size_t i = 0; i < count; ++i) {
+      for (std::size_t j = 0; j < i; ++j) {
+        if (keys[i] == keys[j]) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }(std::make_index_sequence<count>());
+  static_assert(unique_keys, "duplicate key in prio_fields()");
+
+  static constexpr std::array<bool, count> plain_keys = []<std::size_t... I>(std::index_sequence<I...>) {
+    return std::array<bool, count>{ is_plain_key(std::get<I>(fields).key.get_name())... };
+  }(std::make_index_sequence<count>());
+  static_assert(direct_count < 0xffff, "too many fields in prio_fields()");
+
+  /** Perfect hash over the direct fields for ReaderFieldTable, empty
+      if none was found */
+  static constexpr std::array<std::uint16_t, perfect_hash_size(hashes)> slots = [] {
+    std::array<std::uint16_t, perfect_hash_size(hashes)> result{};
+    for (std::size_t i = 0; i < direct_count && !result.empty(); ++i) {
+      result[hashes[i] % result.size()] = static_cast<std::uint16_t>(i + 1);
+    }
+    return result;
+  }();
+};
+
+} // namespace detail
+
+template<HasFields T>
+bool read_struct(ReaderMapping const& mapping, T& value)
+{
+  using Info = detail::FieldInfo<T>;
+
+  return [&]<std::size_t... I>(std::index_sequence<I...>) {
+    std::array<ReaderField, Info::direct_count> table;
+    std::size_t n = 0;
+    ([&] {
+      auto const& field = std::get<I>(Info::fields);
+      if constexpr (detail::is_direct_field<std::remove_cvref_t<decltype(field)>>) {
+        table[n++] = ReaderField{field.key, &(value.*field.member)};
+      }
+    }(), ...);
+
+    bool const result = mapping.read_fields(ReaderFieldTable(table, Info::slots));
+
+    ([&] {
+      auto const& field = std::get<I>(Info::fields);
+      if constexpr (!detail::is_direct_field<std::remove_cvref_t<decltype(field)>>) {
+        mapping.read(field.key, value.*field.member);
+      }
+    }(), ...);
+
+    return result;
+  }(std::make_index_sequence<Info::count>());
+}
+
+template<HasFields T>
+void write_struct(Writer& writer, T const& value)
+{
+  using Info = detail::FieldInfo<T>;
+
+  // consecutive fields of the basic types are written in one batch, the
+  // others separately in between to preserve the declaration order
+  [&]<std::size_t... I>(std::index_sequence<I...>) {
+    std::array<WriterField, Info::count> table;
+    std::size_t n = 0;
+    ([&] {
+      auto const& field = std::get<I>(Info::fields);
+      if constexpr (detail::is_direct_writer_field<std::remove_cvref_t<decltype(field)>>) {
+        table[n++] = WriterField{field.key.get_name(), &(value.*field.member), Info::plain_keys[I]};
+      } else {
+        if (n != 0) {
+          writer.write_fields(std::span<WriterField const>(table.data(), n));
+          n = 0;
+        }
+        writer.write(field.key.get_name(), value.*field.member);
+      }
+    }(), ...);
+
+    if (n != 0) {
+      writer.write_fields(std::span<WriterField const>(table.data(), n));
+    }
+  }(std::make_index_sequence<Info::count>());
+}
+
+} // namespace prio
+
+#endif
+
+/* EOF */
@@ -24,7 +24,10 @@ enum class Format
   AUTO,
   SEXPR,
   JSON,
-  FASTJSON
+  FASTJSON,
+  FASTSEXPR,
+  BINARY,
+  MSGPACK
 };
 
 } // namespace prio
@@ -19,15 +19,28 @@
 
 namespace prio {
 
+class Key;
 class ReaderCollection;
 class ReaderDocument;
 class ReaderError;
 class ReaderMapping;
 class ReaderObject;
+class ReaderStream;
 class Writer;
 
 enum class Format;
 
+/** Types whose members are bound to keys with PRIO_FIELDS(), see
+    fields.hpp */
+template<typename T>
+concept HasFields = requires(T const* value) { prio_fields(value); };
+
+template<HasFields T>
+bool read_struct(ReaderMapping const& mapping, T& value);
+
+template<HasFields T>
+void write_struct(Writer& writer, T const& value);
+
 } // namespace prio
 
 #endif
@@ -0,0 +1,181 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_PRIO_IMPL_STORAGE_HPP
+#define HEADER_PRIO_IMPL_STORAGE_HPP
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace prio {
+
+/** Owning pointer to a polymorphic implementation, like
+    std::unique_ptr<Base>, but with room for @a Size bytes inline.
+    Implementations that fit and are nothrow movable are constructed
+    in place by emplace(), so handles like ReaderMapping don't need a
+    heap allocation. Larger ones go to the heap. Moving the storage
+    moves an inline implementation, so references to it don't stay
+    valid. */
+template<typename Base, std::size_t Size>
+class ImplStorage final
+{
+public:
+  ImplStorage() noexcept :
+    m_buffer(),
+    m_ptr(nullptr),
+    m_ops(nullptr)
+  {}
+
+  ImplStorage(std::unique_ptr<Base> impl) noexcept :
+    m_buffer(),
+    m_ptr(impl.release()),
+    m_ops(m_ptr != nullptr ? &heap_ops : nullptr)
+  {}
+
+  ImplStorage(ImplStorage&& other) noexcept :
+    m_buffer(),
+    m_ptr(nullptr),
+    m_ops(nullptr)
+  {
+    take(other);
+  }
+
+  ~ImplStorage()
+  {
+    reset();
+  }
+
+  ImplStorage& operator=(ImplStorage&& other) noexcept
+  {
+    if (this != &other) {
+      reset();
+      take(other);
+    }
+    return *this;
+  }
+
+  template<typename T, typename... Args>
+  T& emplace(Args&&... args)
+  {
+    static_assert(std::is_base_of_v<Base, T>);
+
+    reset();
+    if constexpr (fits_inline<T>) {
+      return construct_inline<T>(std::forward<Args>(args)...);
+    } else {
+      T* const impl = new T(std::forward<Args>(args)...);
+      m_ptr = impl;
+      m_ops = &heap_ops;
+      return *impl;
+    }
+  }
+
+  void reset() noexcept
+  {
+    if (m_ops != nullptr) {
+      m_ops->destroy(m_ptr);
+    }
+    m_ptr = nullptr;
+    m_ops = nullptr;
+  }
+
+  Base* get() const { return m_ptr; }
+  Base& operator*() const { return *m_ptr; }
+  Base* operator->() const { return m_ptr; }
+  explicit operator bool() const { return m_ptr != nullptr; }
+
+  /** True if the implementation is stored inline */
+  bool is_inline() const { return m_ops != nullptr && m_ops->relocate != nullptr; }
+
+  template<typename T>
+  static constexpr bool fits_inline = sizeof(T) <= Size &&
+                                      alignof(T) <= alignof(std::max_align_t) &&
+                                      std::is_nothrow_move_constructible_v<T>;
+
+private:
+  /** How the implementation is destroyed and, if it is stored inline,
+      moved to another buffer */
+  struct Ops
+  {
+    void (*destroy)(Base* impl) noexcept;
+    Base* (*relocate)(std::byte* buffer, Base* from) noexcept;
+  };
+
+  template<typename T>
+  static void destroy_inline(Base* impl) noexcept
+  {
+    static_cast<T*>(impl)->~T();
+  }
+
+  static void destroy_heap(Base* impl) noexcept
+  {
+    delete impl;
+  }
+
+  /** Moves the T at @a from into @a buffer and destroys the original */
+  template<typename T>
+  static Base* relocate(std::byte* buffer, Base* from) noexcept
+  {
+    T& source = static_cast<T&>(*from);
+    T* const impl = ::new (static_cast<void*>(buffer)) T(std::move(source));
+    source.~T();
+    return impl;
+  }
+
+  template<typename T>
+  static constexpr Ops inline_ops = { &destroy_inline<T>, &relocate<T> };
+  static constexpr Ops heap_ops = { &destroy_heap, nullptr };
+
+  template<typename T, typename... Args>
+  T& construct_inline(Args&&... args)
+  {
+    T* const impl = ::new (static_cast<void*>(m_buffer)) T(std::forward<Args>(args)...);
+    m_ptr = impl;
+    m_ops = &inline_ops<T>;
+    return *impl;
+  }
+
+  void take(ImplStorage& other) noexcept
+  {
+    if (other.is_inline()) {
+      m_ptr = other.m_ops->relocate(m_buffer, other.m_ptr);
+    } else {
+      m_ptr = other.m_ptr;
+    }
+    m_ops = other.m_ops;
+
+    other.m_ptr = nullptr;
+    other.m_ops = nullptr;
+  }
+
+private:
+  alignas(std::max_align_t) std::byte m_buffer[Size];
+  Base* m_ptr;
+  Ops const* m_ops;
+
+private:
+  ImplStorage(ImplStorage const&) = delete;
+  ImplStorage& operator=(ImplStorage const&) = delete;
+};
+
+} // namespace prio
+
+#endif
+
+/* EOF */
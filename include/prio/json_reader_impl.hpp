@@ -21,6 +21,9 @@
 
 #include <assert.h>
 #include <json/value.h>
+#include <mutex>
+#include <span>
+#include <unordered_map>
 
 #include "error_handler.hpp"
 
@@ -37,15 +40,24 @@ public:
   std::optional<std::string> get_filename() const override { return m_filename; }
   void set_parent(ReaderDocument const* parent) override { m_parent = parent; }
   ReaderDocument const& get_parent() const override { assert(m_parent != nullptr); return *m_parent; }
+  std::size_t get_memory_usage() const override;
 
   void error(Json::Value const& json, std::string_view message) const;
   void error(ErrorHandler error_handler, Json::Value const& json, std::string_view message) const;
 
+  /** Names of the members of the object @a json in iteration order.
+      Json::Value has no random access to its members, so they are
+      collected on the first call and kept with the document. */
+  std::span<std::string_view const> get_member_names(Json::Value const& json) const;
+
 private:
   Json::Value m_value;
   ErrorHandler m_error_handler;
   std::optional<std::string> m_filename;
   ReaderDocument const* m_parent;
+
+  mutable std::mutex m_member_names_mutex;
+  mutable std::unordered_map<Json::Value const*, std::vector<std::string_view>> m_member_names;
 };
 
 class JsonReaderObjectImpl final : public ReaderObjectImpl
@@ -56,6 +68,7 @@ public:
 
   JsonReaderDocumentImpl const& get_document() const override { return m_doc; }
   std::string get_name() const override;
+  std::string_view get_name_view() const override;
   ReaderMapping get_mapping() const override;
 
 private:
@@ -72,6 +85,9 @@ public:
   JsonReaderDocumentImpl const& get_document() const override { return m_doc; }
   std::vector<ReaderObject> get_objects() const override;
 
+  std::size_t get_size() const override;
+  ReaderObject get_object(std::size_t index) const override;
+
 private:
   JsonReaderDocumentImpl const& m_doc;
   Json::Value const& m_json;
@@ -85,20 +101,28 @@ public:
 
   JsonReaderDocumentImpl const& get_document() const override { return m_doc; }
   std::vector<std::string> get_keys() const override;
-
-  bool read(std::string_view key, bool& value) const override;
-  bool read(std::string_view key, int& value) const override;
-  bool read(std::string_view key, float& value) const override;
-  bool read(std::string_view key, std::string& value) const override;
-
-  bool read(std::string_view key, std::vector<bool>& values) const override;
-  bool read(std::string_view key, std::vector<int>& values) const override;
-  bool read(std::string_view key, std::vector<float>& values) const override;
-  bool read(std::string_view key, std::vector<std::string>& values) const override;
-
-  bool read(std::string_view key, ReaderMapping& value) const override;
-  bool read(std::string_view key, ReaderCollection& value) const override;
-  bool read(std::string_view key, ReaderObject& value) const override;
+  std::size_t first_key_cursor() const override;
+  std::size_t next_key_cursor(std::size_t cursor) const override;
+  std::size_t end_key_cursor() const override;
+  std::string_view get_key_at_cursor(std::size_t cursor, std::string& buffer) const override;
+
+  bool read(Key const& key, bool& value) const override;
+  bool read(Key const& key, int& value) const override;
+  bool read(Key const& key, float& value) const override;
+  bool read(Key const& key, std::string& value) const override;
+
+  bool read(Key const& key, std::vector<bool>& values) const override;
+  bool read(Key const& key, std::vector<int>& values) const override;
+  bool read(Key const& key, std::vector<float>& values) const override;
+  bool read(Key const& key, std::vector<std::string>& values) const override;
+
+  bool read(Key const& key, std::string_view& value) const override;
+  bool read(Key const& key, std::span<int> values) const override;
+  bool read(Key const& key, std::span<float> values) const override;
+
+  bool read(Key const& key, ReaderMapping& value) const override;
+  bool read(Key const& key, ReaderCollection& value) const override;
+  bool read(Key const& key, ReaderObject& value) const override;
 
   void error(std::string_view key, std::string_view message) const override;
   void missing_key_error(std::string_view key) const override;
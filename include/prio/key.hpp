@@ -0,0 +1,104 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef HEADER_PRIO_KEY_HPP
+#define HEADER_PRIO_KEY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace prio {
+
+/** Name of a mapping entry together with its precomputed hash, used
+    by ReaderMapping to look up keys without allocating. A Key is
+    implicitly constructible from any string, declaring it `constexpr`
+    computes the hash at compile time:
+
+      static constexpr prio::Key key_speed("speed");
+      float speed = mapping.get<float>(key_speed);
+
+    A Key only references the characters it was built from, these must
+    outlive it. */
+class Key final
+{
+public:
+  /** 64-bit FNV-1a */
+  static constexpr std::uint64_t hash(std::string_view text)
+  {
+    std::uint64_t result = 0xcbf29ce484222325u;
+    for (char c : text) {
+      result ^= static_cast<unsigned char>(c);
+      result *= 0x100000001b3u;
+    }
+    return result;
+  }
+
+public:
+  constexpr Key() :
+    Key(std::string_view())
+  {}
+
+  constexpr Key(std::string_view name) :
+    m_name(name),
+    m_hash(hash(name))
+  {}
+
+  constexpr Key(char const* name) :
+    Key(std::string_view(name))
+  {}
+
+  Key(std::string const& name) :
+    Key(std::string_view(name))
+  {}
+
+  constexpr std::string_view get_name() const { return m_name; }
+  constexpr std::size_t size() const { return m_name.size(); }
+  constexpr std::uint64_t get_hash() const { return m_hash; }
+
+  constexpr operator std::string_view() const { return m_name; }
+
+  friend constexpr bool operator==(Key const& lhs, Key const& rhs)
+  {
+    return lhs.m_hash == rhs.m_hash && lhs.m_name == rhs.m_name;
+  }
+
+  friend constexpr bool operator==(Key const& lhs, std::string_view rhs)
+  {
+    return lhs.m_name == rhs;
+  }
+
+private:
+  std::string_view m_name;
+  std::uint64_t m_hash;
+};
+
+/** Hash function for containers keyed by strings that accepts a Key
+    for heterogeneous lookup, reusing its precomputed hash */
+struct KeyHash
+{
+  using is_transparent = void;
+
+  std::size_t operator()(Key const& key) const { return static_cast<std::size_t>(key.get_hash()); }
+};
+
+} // namespace prio
+
+#endif
+
+/* EOF */
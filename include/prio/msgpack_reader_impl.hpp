@@ -0,0 +1,187 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_PRIO_MSGPACK_READER_IMPL_HPP
+#define HEADER_PRIO_MSGPACK_READER_IMPL_HPP
+
+#include "reader_impl.hpp"
+
+#include <assert.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "error_handler.hpp"
+
+namespace prio {
+
+class InputBuffer;
+class MsgPackTape;
+
+/** Backend for Format::MSGPACK, values are read straight from the tape
+    built by msgpack_parse() and strings are views into the input */
+class MsgPackReaderDocumentImpl final : public ReaderDocumentImpl
+{
+public:
+  MsgPackReaderDocumentImpl(std::shared_ptr<InputBuffer const> buffer, ErrorHandler error_handler,
+                            std::optional<std::string> filename);
+
+  /** Reads the document from @a data, which is a part of @a buffer, as
+      done by ReaderDocument::parse_many(). Offsets in error messages
+      refer to the whole buffer. */
+  MsgPackReaderDocumentImpl(std::shared_ptr<InputBuffer const> buffer, std::string_view data,
+                            ErrorHandler error_handler, std::optional<std::string> filename);
+  MsgPackReaderDocumentImpl(MsgPackReaderDocumentImpl const&) = delete;
+  MsgPackReaderDocumentImpl& operator=(MsgPackReaderDocumentImpl const&) = delete;
+  ~MsgPackReaderDocumentImpl() override;
+
+  ReaderObject get_root() const override;
+  std::optional<std::string> get_filename() const override { return m_filename; }
+  void set_parent(ReaderDocument const* parent) override { m_parent = parent; }
+  ReaderDocument const& get_parent() const override { assert(m_parent != nullptr); return *m_parent; }
+  std::size_t get_memory_usage() const override;
+
+  void error(std::uint32_t index, std::string_view message) const;
+  void error(ErrorHandler error_handler, std::uint32_t index, std::string_view message) const;
+
+  MsgPackTape const& get_tape() const { return *m_tape; }
+  std::string_view get_data() const { return m_data; }
+
+private:
+  std::shared_ptr<InputBuffer const> m_buffer;
+  std::string_view m_data;
+  std::size_t m_base;
+  std::unique_ptr<MsgPackTape> m_tape;
+  ErrorHandler m_error_handler;
+  std::optional<std::string> m_filename;
+  ReaderDocument const* m_parent;
+};
+
+class MsgPackReaderObjectImpl final : public ReaderObjectImpl
+{
+public:
+  MsgPackReaderObjectImpl(MsgPackReaderDocumentImpl const& doc, std::uint32_t index);
+  ~MsgPackReaderObjectImpl() override;
+
+  MsgPackReaderDocumentImpl const& get_document() const override { return m_doc; }
+  std::string get_name() const override;
+  std::string_view get_name_view() const override;
+  ReaderMapping get_mapping() const override;
+
+private:
+  MsgPackReaderDocumentImpl const& m_doc;
+  std::uint32_t m_index;
+};
+
+class MsgPackReaderCollectionImpl final : public ReaderCollectionImpl
+{
+public:
+  MsgPackReaderCollectionImpl(MsgPackReaderDocumentImpl const& doc, std::uint32_t index);
+  MsgPackReaderCollectionImpl(MsgPackReaderCollectionImpl&& other) noexcept;
+  ~MsgPackReaderCollectionImpl() override;
+
+  MsgPackReaderDocumentImpl const& get_document() const override { return m_doc; }
+  std::vector<ReaderObject> get_objects() const override;
+
+  std::size_t get_size() const override;
+  ReaderObject get_object(std::size_t index) const override;
+
+  std::size_t first_cursor() const override;
+  std::size_t next_cursor(std::size_t cursor) const override;
+  std::size_t end_cursor() const override;
+  ReaderObject get_object_at_cursor(std::size_t cursor) const override;
+
+private:
+  /** Tape positions of the elements, built on the first call so that
+      get_object() doesn't walk the tape, iteration with
+      the cursors doesn't use them. Published with a compare-and-swap,
+      a thread that loses the race discards its copy. */
+  using Elements = std::vector<std::uint32_t>;
+  Elements const& get_elements() const;
+
+private:
+  MsgPackReaderDocumentImpl const& m_doc;
+  std::uint32_t m_index;
+  mutable std::atomic<Elements const*> m_elements;
+};
+
+class MsgPackReaderMappingImpl final : public ReaderMappingImpl
+{
+public:
+  MsgPackReaderMappingImpl(MsgPackReaderDocumentImpl const& doc, std::uint32_t index);
+  ~MsgPackReaderMappingImpl() override;
+
+  MsgPackReaderDocumentImpl const& get_document() const override { return m_doc; }
+  std::vector<std::string> get_keys() const override;
+  std::size_t first_key_cursor() const override;
+  std::size_t next_key_cursor(std::size_t cursor) const override;
+  std::size_t end_key_cursor() const override;
+  std::string_view get_key_at_cursor(std::size_t cursor, std::string& buffer) const override;
+
+  bool read(Key const& key, bool& value) const override;
+  bool read(Key const& key, int& value) const override;
+  bool read(Key const& key, float& value) const override;
+  bool read(Key const& key, std::string& value) const override;
+
+  bool read(Key const& key, std::vector<bool>& values) const override;
+  bool read(Key const& key, std::vector<int>& values) const override;
+  bool read(Key const& key, std::vector<float>& values) const override;
+  bool read(Key const& key, std::vector<std::string>& values) const override;
+
+  bool read(Key const& key, std::string_view& value) const override;
+  bool read(Key const& key, std::span<int> values) const override;
+  bool read(Key const& key, std::span<float> values) const override;
+
+  bool read(Key const& key, ReaderMapping& value) const override;
+  bool read(Key const& key, ReaderCollection& value) const override;
+  bool read(Key const& key, ReaderObject& value) const override;
+
+  void read_fields(ReaderFieldTable const& fields, std::span<bool> found) const override;
+
+  void error(std::string_view key, std::string_view message) const override;
+  void missing_key_error(std::string_view key) const override;
+
+private:
+  bool read_element(std::uint32_t element, bool& value) const;
+  bool read_element(std::uint32_t element, int& value) const;
+  bool read_element(std::uint32_t element, float& value) const;
+  bool read_element(std::uint32_t element, std::string& value) const;
+
+  bool read_element(std::uint32_t element, std::vector<bool>& values) const;
+  bool read_element(std::uint32_t element, std::vector<int>& values) const;
+  bool read_element(std::uint32_t element, std::vector<float>& values) const;
+  bool read_element(std::uint32_t element, std::vector<std::string>& values) const;
+
+  bool read_element(std::uint32_t element, std::string_view& value) const;
+  bool read_element(std::uint32_t element, std::span<int> values) const;
+  bool read_element(std::uint32_t element, std::span<float> values) const;
+
+  bool read_element(std::uint32_t element, ReaderMapping& value) const;
+  bool read_element(std::uint32_t element, ReaderCollection& value) const;
+  bool read_element(std::uint32_t element, ReaderObject& value) const;
+
+  std::uint32_t find(std::string_view key) const;
+
+private:
+  MsgPackReaderDocumentImpl const& m_doc;
+  std::uint32_t m_index;
+};
+
+} // namespace prio
+
+#endif
+
+/* EOF */
@@ -0,0 +1,68 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_PRIO_PARSE_CACHE_HPP
+#define HEADER_PRIO_PARSE_CACHE_HPP
+
+#include <filesystem>
+#include <optional>
+
+#include "error_handler.hpp"
+#include "format.hpp"
+#include "reader_document.hpp"
+
+namespace prio {
+
+/** Opt-in persistent cache for ReaderDocument::from_file(). The
+    structure found by parsing a text document is stored in a cache file
+    and reused as long as the path, size, modification time and content
+    hash of the source still match, so loading an unchanged file only
+    costs reading and hashing it.
+
+    Cached documents are served by the FASTJSON and FASTSEXPR backends,
+    whatever text format was requested. Documents that those reject are
+    loaded by the requested backend without caching, so the cache
+    doesn't change which documents parse. BINARY and MSGPACK documents
+    are cheap to open and are not cached. Cache files are only usable on
+    the machine that wrote them; invalid or foreign ones count as a miss
+    and are replaced. Failing to write a cache file is not an error. */
+class ParseCache final
+{
+public:
+  /** Keeps cache files next to their source, as "<filename>.priocache" */
+  ParseCache();
+
+  /** Keeps cache files in @a directory, which is created when needed */
+  explicit ParseCache(std::filesystem::path directory);
+
+  ReaderDocument from_file(Format format,
+                           std::filesystem::path const& filename,
+                           ErrorHandler error_handler = ErrorHandler::THROW) const;
+  ReaderDocument from_file(std::filesystem::path const& filename,
+                           ErrorHandler error_handler = ErrorHandler::THROW) const;
+
+  /** Returns the path of the cache file used for @a filename */
+  std::filesystem::path get_cache_filename(std::filesystem::path const& filename) const;
+
+private:
+  std::optional<std::filesystem::path> m_directory;
+};
+
+} // namespace prio
+
+#endif
+
+/* EOF */
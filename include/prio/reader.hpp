@@ -20,9 +20,11 @@
 #include "override_reader_mapping.hpp"
 #include "reader_collection.hpp"
 #include "reader_document.hpp"
+#include "reader_document_range.hpp"
 #include "reader_error.hpp"
 #include "reader_mapping.hpp"
 #include "reader_object.hpp"
+#include "reader_stream.hpp"
 
 #endif
 
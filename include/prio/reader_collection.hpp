@@ -17,9 +17,15 @@
 #ifndef HEADER_PRIO_READER_COLLECTION_HPP
 #define HEADER_PRIO_READER_COLLECTION_HPP
 
+#include <cstddef>
+#include <iterator>
 #include <memory>
+#include <utility>
 #include <vector>
 
+#include "impl_storage.hpp"
+#include "reader_object.hpp"
+
 namespace prio {
 
 class ReaderCollectionImpl;
@@ -28,10 +34,22 @@ class ReaderObject;
 
 class ReaderCollection final
 {
+public:
+  using Storage = ImplStorage<ReaderCollectionImpl, 32>;
+
 public:
   ReaderCollection();
   ReaderCollection(ReaderCollection&&) noexcept;
   ReaderCollection(std::unique_ptr<ReaderCollectionImpl> impl);
+
+  /** Constructs the implementation @a T in place, without a heap
+      allocation if it fits into Storage */
+  template<typename T, typename... Args>
+  explicit ReaderCollection(std::in_place_type_t<T>, Args&&... args) :
+    m_impl()
+  {
+    m_impl.template emplace<T>(std::forward<Args>(args)...);
+  }
   ~ReaderCollection();
 
   explicit operator bool() const { return static_cast<bool>(m_impl); }
@@ -42,8 +60,51 @@ public:
 
   std::vector<ReaderObject> get_objects() const;
 
+  /** Number of objects in the collection */
+  std::size_t size() const;
+
+  /** Returns the object at @a index, throws std::out_of_range if there
+      is none. Constant time, the tape based backends (FASTJSON,
+      FASTSEXPR, MSGPACK) index the elements on the first call. */
+  ReaderObject at(std::size_t index) const;
+
+  /** Forward iterator over the objects, the objects are created on
+      dereference instead of up front like with get_objects() */
+  class iterator final
+  {
+  public:
+    using iterator_concept = std::forward_iterator_tag;
+    using iterator_category = std::input_iterator_tag;
+    using value_type = ReaderObject;
+    using reference = ReaderObject;
+    using difference_type = std::ptrdiff_t;
+
+  public:
+    iterator() = default;
+    iterator(ReaderCollectionImpl const* impl, std::size_t cursor) :
+      m_impl(impl),
+      m_cursor(cursor)
+    {}
+
+    ReaderObject operator*() const;
+    iterator& operator++();
+    iterator operator++(int);
+
+    bool operator==(iterator const& other) const
+    {
+      return m_impl == other.m_impl && m_cursor == other.m_cursor;
+    }
+
+  private:
+    ReaderCollectionImpl const* m_impl = nullptr;
+    std::size_t m_cursor = 0;
+  };
+
+  iterator begin() const;
+  iterator end() const;
+
 private:
-  std::unique_ptr<ReaderCollectionImpl> m_impl;
+  Storage m_impl;
 };
 
 } // namespace prio
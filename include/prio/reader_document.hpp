@@ -18,9 +18,11 @@
 #define HEADER_PRIO_READER_DOCUMENT_HPP
 
 #include <assert.h>
+#include <cstddef>
 #include <filesystem>
 #include <memory>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -39,10 +41,16 @@ class ReaderObjectImpl;
 class ReaderMappingImpl;
 class ReaderCollectionImpl;
 class ReaderDocumentImpl;
+class ReaderDocumentRange;
 
 class ReaderDocument final
 {
 public:
+  /** Loads @a filename, files of at least 1 MiB are memory mapped and
+      referenced by the document for its lifetime. Truncating such a
+      file in place while the document is alive, e.g. by rewriting it
+      with std::ofstream, crashes later reads with SIGBUS. Replace files
+      in use by renaming a new file over them instead. */
   static ReaderDocument from_file(Format format,
                                   std::filesystem::path const& filename,
                                   ErrorHandler error_handler = ErrorHandler::THROW);
@@ -55,6 +63,23 @@ public:
                                     ErrorHandler error_handler = ErrorHandler::THROW,
                                     std::optional<std::string> const& filename = {});
 
+  /** Parses @a data in place, a private copy is only made for backends
+      that keep references into the input (FASTJSON, FASTSEXPR, BINARY,
+      MSGPACK). Either way @a data only has to stay valid for the
+      duration of the call. */
+  static ReaderDocument from_buffer(Format format,
+                                    std::span<std::byte const> data,
+                                    ErrorHandler error_handler = ErrorHandler::THROW,
+                                    std::optional<std::string> const& filename = {});
+
+  /** Like from_buffer(), but the document references @a data instead of
+      copying it. @a data must stay valid and unmodified for the lifetime
+      of the document and everything obtained from it. */
+  static ReaderDocument from_borrowed_buffer(Format format,
+                                             std::span<std::byte const> data,
+                                             ErrorHandler error_handler = ErrorHandler::THROW,
+                                             std::optional<std::string> const& filename = {});
+
   static ReaderDocument from_file(std::filesystem::path const& filename,
                                   ErrorHandler error_handler = ErrorHandler::THROW);
   static ReaderDocument from_string(std::string_view text,
@@ -63,6 +88,9 @@ public:
   static ReaderDocument from_stream(std::istream& stream,
                                     ErrorHandler error_handler = ErrorHandler::THROW,
                                     std::optional<std::string> const& filename = {});
+  static ReaderDocument from_buffer(std::span<std::byte const> data,
+                                    ErrorHandler error_handler = ErrorHandler::THROW,
+                                    std::optional<std::string> const& filename = {});
 
   /** Reads multiple top-level trees from a file that has no single root
       wrapper. For sexpr this is successive top-level lists; for JSON this
@@ -72,6 +100,22 @@ public:
       non-whitespace character ('{'/'[' => JSON, otherwise sexpr). */
   static std::vector<ReaderDocument> parse_many(const std::string& pathname);
 
+  /** Like parse_many(), but the documents are parsed on up to
+      @a num_threads threads, 0 uses one thread per core. The value
+      boundaries are found in a single pass up front, the documents are
+      returned in their original order. */
+  static std::vector<ReaderDocument> parse_many(const std::string& pathname, unsigned int num_threads);
+
+  /** Lazy variant of parse_many(), documents are read and parsed one at
+      a time while iterating, so memory use is bounded by the largest
+      single record instead of the file size. The returned range is
+      declared in reader_document_range.hpp. */
+  static ReaderDocumentRange iterate_many(std::filesystem::path const& pathname,
+                                          ErrorHandler error_handler = ErrorHandler::THROW);
+  static ReaderDocumentRange iterate_many(std::istream& stream,
+                                          ErrorHandler error_handler = ErrorHandler::THROW,
+                                          std::optional<std::string> const& filename = {});
+
 public:
   ReaderDocument();
   ReaderDocument(ReaderDocument&&) noexcept;
@@ -92,6 +136,10 @@ public:
   /** Returns the directory of the document */
   std::string get_directory() const;
 
+  /** Returns the approximate number of bytes held by the document,
+      including its input when the backend keeps it and its arena */
+  std::size_t get_memory_usage() const;
+
   explicit operator bool() const { return static_cast<bool>(m_impl); }
 
   ReaderDocumentImpl const& get_impl() const { assert(m_impl != nullptr); return *m_impl; }
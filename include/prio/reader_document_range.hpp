@@ -0,0 +1,91 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_PRIO_READER_DOCUMENT_RANGE_HPP
+#define HEADER_PRIO_READER_DOCUMENT_RANGE_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+
+#include "reader_document.hpp"
+
+namespace prio {
+
+class ReaderDocumentRangeImpl;
+
+/** Single pass range over the top-level values of a multi-document
+    file, returned by ReaderDocument::iterate_many(). Documents are
+    parsed one at a time as the range is advanced, the input is read
+    through a rolling window that only has to hold the current record. */
+class ReaderDocumentRange final
+{
+public:
+  class iterator final
+  {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = ReaderDocument;
+    using difference_type = std::ptrdiff_t;
+    using pointer = ReaderDocument*;
+    using reference = ReaderDocument&;
+
+  public:
+    iterator() : m_range(nullptr) {}
+    explicit iterator(ReaderDocumentRange* range) : m_range(range) {}
+
+    reference operator*() const { return m_range->m_current; }
+    pointer operator->() const { return &m_range->m_current; }
+
+    iterator& operator++() { m_range->advance(); return *this; }
+    iterator operator++(int) { iterator result = *this; m_range->advance(); return result; }
+
+    bool operator==(std::default_sentinel_t) const { return !m_range || !m_range->m_current; }
+
+  private:
+    ReaderDocumentRange* m_range;
+  };
+
+public:
+  ReaderDocumentRange(std::unique_ptr<ReaderDocumentRangeImpl> impl);
+  ReaderDocumentRange(ReaderDocumentRange&&) noexcept;
+  ~ReaderDocumentRange();
+
+  ReaderDocumentRange& operator=(ReaderDocumentRange&&) noexcept;
+
+  /** Parses the first document on the first call, later calls continue
+      where the previous iteration stopped */
+  iterator begin();
+  std::default_sentinel_t end() const { return std::default_sentinel; }
+
+private:
+  void advance();
+
+private:
+  std::unique_ptr<ReaderDocumentRangeImpl> m_impl;
+  ReaderDocument m_current;
+  bool m_started;
+
+private:
+  ReaderDocumentRange(ReaderDocumentRange const&) = delete;
+  ReaderDocumentRange& operator=(ReaderDocumentRange const&) = delete;
+};
+
+} // namespace prio
+
+#endif
+
+/* EOF */
@@ -0,0 +1,98 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef HEADER_PRIO_READER_FIELD_HPP
+#define HEADER_PRIO_READER_FIELD_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "key.hpp"
+
+namespace prio {
+
+class ReaderCollection;
+class ReaderMapping;
+class ReaderObject;
+
+using ReaderFieldTarget = std::variant<bool*, int*, float*, std::string*,
+                                       std::vector<bool>*, std::vector<int>*,
+                                       std::vector<float>*, std::vector<std::string>*,
+                                       ReaderMapping*, ReaderCollection*, ReaderObject*>;
+
+/** Entry in a table of fields read with ReaderMapping::read_fields(),
+    the value of @a key is stored in @a target. Fields that are not
+    required are left untouched when missing. */
+struct ReaderField
+{
+  Key key = {};
+  ReaderFieldTarget target = {};
+  bool required = false;
+};
+
+/** The fields read by ReaderMapping::read_fields(), optionally with a
+    perfect hash over their keys: @a slots maps `hash % slots.size()`
+    to one plus the index of the field with that hash, or zero. Without
+    slots keys are searched linearly. */
+class ReaderFieldTable final
+{
+public:
+  ReaderFieldTable(std::span<ReaderField const> fields,
+                   std::span<std::uint16_t const> slots = {}) :
+    m_fields(fields),
+    m_slots(slots)
+  {}
+
+  std::size_t size() const { return m_fields.size(); }
+  ReaderField const& operator[](std::size_t index) const { return m_fields[index]; }
+
+  /** Returns the index of the field named @a name, or size() if there
+      is none */
+  std::size_t find(std::string_view name) const
+  {
+    std::uint64_t const hash = Key::hash(name);
+    if (!m_slots.empty()) {
+      std::uint16_t const slot = m_slots[hash % m_slots.size()];
+      if (slot != 0 && m_fields[slot - 1].key.get_hash() == hash && m_fields[slot - 1].key.get_name() == name) {
+        return slot - 1;
+      }
+      return size();
+    }
+
+    for (std::size_t i = 0; i < m_fields.size(); ++i) {
+      if (m_fields[i].key.get_hash() == hash && m_fields[i].key.get_name() == name) {
+        return i;
+      }
+    }
+    return size();
+  }
+
+private:
+  std::span<ReaderField const> m_fields;
+  std::span<std::uint16_t const> m_slots;
+};
+
+} // namespace prio
+
+#endif
+
+/* EOF */
@@ -17,11 +17,17 @@
 #ifndef HEADER_PRIO_READER_IMPL_HPP
 #define HEADER_PRIO_READER_IMPL_HPP
 
+#include <cstddef>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
 #include <vector>
 
+#include "document_arena.hpp"
+#include "key.hpp"
+#include "reader_field.hpp"
+
 namespace prio {
 
 class ReaderCollection;
@@ -32,12 +38,26 @@ class ReaderObject;
 class ReaderDocumentImpl
 {
 public:
+  ReaderDocumentImpl() : m_arena() {}
   virtual ~ReaderDocumentImpl() {}
 
   virtual ReaderObject get_root() const = 0;
   virtual std::optional<std::string> get_filename() const = 0;
   virtual void set_parent(ReaderDocument const* parent) = 0;
   virtual ReaderDocument const& get_parent() const = 0;
+
+  /** Approximate number of bytes held by the document */
+  virtual std::size_t get_memory_usage() const = 0;
+
+  /** Arena for decoded strings that live as long as the document */
+  DocumentArena& get_arena() const { return m_arena; }
+
+private:
+  mutable DocumentArena m_arena;
+
+private:
+  ReaderDocumentImpl(ReaderDocumentImpl const&) = delete;
+  ReaderDocumentImpl& operator=(ReaderDocumentImpl const&) = delete;
 };
 
 class ReaderObjectImpl
@@ -46,6 +66,12 @@ public:
   virtual ~ReaderObjectImpl() {}
 
   virtual std::string get_name() const = 0;
+
+  /** Like get_name(), but refers to the document instead of copying.
+      The default stores the name in the document arena, once for
+      each distinct name. */
+  virtual std::string_view get_name_view() const;
+
   virtual ReaderMapping get_mapping() const = 0;
   virtual ReaderDocumentImpl const& get_document() const = 0;
 };
@@ -57,6 +83,19 @@ public:
 
   virtual std::vector<ReaderObject> get_objects() const = 0;
   virtual ReaderDocumentImpl const& get_document() const = 0;
+
+  /** Number of objects and the object at @a index, which is less than
+      get_size(). The defaults go through get_objects(), backends
+      override them to access their elements directly. */
+  virtual std::size_t get_size() const;
+  virtual ReaderObject get_object(std::size_t index) const;
+
+  /** Forward iteration over the objects, a cursor is a backend specific
+      position of an object. The defaults use the index as cursor. */
+  virtual std::size_t first_cursor() const;
+  virtual std::size_t next_cursor(std::size_t cursor) const;
+  virtual std::size_t end_cursor() const;
+  virtual ReaderObject get_object_at_cursor(std::size_t cursor) const;
 };
 
 class ReaderMappingImpl
@@ -66,19 +105,44 @@ public:
 
   virtual std::vector<std::string> get_keys() const = 0;
 
-  virtual bool read(std::string_view key, bool& value) const = 0;
-  virtual bool read(std::string_view key, int& value) const = 0;
-  virtual bool read(std::string_view key, float& value) const = 0;
-  virtual bool read(std::string_view key, std::string& value) const = 0;
-
-  virtual bool read(std::string_view key, std::vector<bool>& values) const = 0;
-  virtual bool read(std::string_view key, std::vector<int>& values) const = 0;
-  virtual bool read(std::string_view key, std::vector<float>& values) const = 0;
-  virtual bool read(std::string_view key, std::vector<std::string>& values) const = 0;
-
-  virtual bool read(std::string_view key, ReaderMapping& mapping) const = 0;
-  virtual bool read(std::string_view key, ReaderCollection& collection) const = 0;
-  virtual bool read(std::string_view key, ReaderObject& object) const = 0;
+  /** Forward iteration over the keys, a cursor is a backend specific
+      position of a key/value pair. get_key_at_cursor() returns a view
+      into the document where possible, keys that have to be decoded
+      are stored in @a buffer instead. The defaults use the index into
+      get_keys() as cursor and call it for every key, which makes a walk
+      quadratic, backends should override them. */
+  virtual std::size_t first_key_cursor() const;
+  virtual std::size_t next_key_cursor(std::size_t cursor) const;
+  virtual std::size_t end_key_cursor() const;
+  virtual std::string_view get_key_at_cursor(std::size_t cursor, std::string& buffer) const;
+
+  virtual bool read(Key const& key, bool& value) const = 0;
+  virtual bool read(Key const& key, int& value) const = 0;
+  virtual bool read(Key const& key, float& value) const = 0;
+  virtual bool read(Key const& key, std::string& value) const = 0;
+
+  virtual bool read(Key const& key, std::vector<bool>& values) const = 0;
+  virtual bool read(Key const& key, std::vector<int>& values) const = 0;
+  virtual bool read(Key const& key, std::vector<float>& values) const = 0;
+  virtual bool read(Key const& key, std::vector<std::string>& values) const = 0;
+
+  /** Readers that don't copy, the views refer to the document and
+      the spans are caller storage that must match the number of
+      elements. The defaults go through the copying readers above and
+      store each distinct string once in the document arena. */
+  virtual bool read(Key const& key, std::string_view& value) const;
+  virtual bool read(Key const& key, std::span<int> values) const;
+  virtual bool read(Key const& key, std::span<float> values) const;
+
+  virtual bool read(Key const& key, ReaderMapping& mapping) const = 0;
+  virtual bool read(Key const& key, ReaderCollection& collection) const = 0;
+  virtual bool read(Key const& key, ReaderObject& object) const = 0;
+
+  /** Reads each of @a fields and sets the matching entry of @a found
+      when successful. The default calls read() for each field,
+      backends that have to search for keys override it to visit the
+      mapping only once. */
+  virtual void read_fields(ReaderFieldTable const& fields, std::span<bool> found) const;
 
   virtual void error(std::string_view key, std::string_view message) const = 0;
   virtual void missing_key_error(std::string_view key) const = 0;
@@ -17,10 +17,22 @@
 #ifndef HEADER_PRIO_READER_MAPPING_HPP
 #define HEADER_PRIO_READER_MAPPING_HPP
 
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
 #include <memory>
+#include <span>
 #include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
+#include "fwd.hpp"
+#include "impl_storage.hpp"
+#include "key.hpp"
+#include "reader_field.hpp"
+
 namespace prio {
 
 class ReaderCollection;
@@ -39,10 +51,22 @@ bool read_custom(ReaderMapping const& map, std::string_view key, T& value)
 
 class ReaderMapping final
 {
+public:
+  using Storage = ImplStorage<ReaderMappingImpl, 32>;
+
 public:
   ReaderMapping();
   ReaderMapping(ReaderMapping&&) noexcept;
   ReaderMapping(std::unique_ptr<ReaderMappingImpl> impl);
+
+  /** Constructs the implementation @a T in place, without a heap
+      allocation if it fits into Storage */
+  template<typename T, typename... Args>
+  explicit ReaderMapping(std::in_place_type_t<T>, Args&&... args) :
+    m_impl()
+  {
+    m_impl.template emplace<T>(std::forward<Args>(args)...);
+  }
   ~ReaderMapping();
 
   explicit operator bool() const { return static_cast<bool>(m_impl); }
@@ -53,24 +77,97 @@ public:
   ReaderDocument const& get_document() const;
   std::vector<std::string> get_keys() const;
 
+  /** Input iterator over the keys, unlike get_keys() it doesn't copy
+      them. The views point into the document and stay valid as long as
+      it does, except for keys that had to be decoded, e.g. JSON keys
+      with escape sequences, which are held by the iterator and only
+      stay valid until it is advanced or destroyed. */
+  class key_iterator final
+  {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = std::string_view;
+    using reference = std::string_view;
+    using difference_type = std::ptrdiff_t;
+
+  public:
+    key_iterator() = default;
+    key_iterator(ReaderMappingImpl const* impl, std::size_t cursor) :
+      m_impl(impl),
+      m_cursor(cursor)
+    {}
+
+    // the buffer only caches the current key, copies decode it again
+    key_iterator(key_iterator const& other) :
+      m_impl(other.m_impl),
+      m_cursor(other.m_cursor),
+      m_buffer()
+    {}
+    key_iterator(key_iterator&&) noexcept = default;
+    key_iterator& operator=(key_iterator const& other)
+    {
+      m_impl = other.m_impl;
+      m_cursor = other.m_cursor;
+      return *this;
+    }
+    key_iterator& operator=(key_iterator&&) noexcept = default;
+
+    std::string_view operator*() const;
+    key_iterator& operator++();
+    key_iterator operator++(int);
+
+    bool operator==(key_iterator const& other) const
+    {
+      return m_impl == other.m_impl && m_cursor == other.m_cursor;
+    }
+
+  private:
+    ReaderMappingImpl const* m_impl = nullptr;
+    std::size_t m_cursor = 0;
+    mutable std::string m_buffer = {};
+  };
+
+  class KeyRange final
+  {
+  public:
+    explicit KeyRange(ReaderMappingImpl const* impl) : m_impl(impl) {}
+
+    key_iterator begin() const;
+    key_iterator end() const;
+    bool empty() const { return begin() == end(); }
+
+  private:
+    ReaderMappingImpl const* m_impl;
+  };
+
+  /** Returns the keys as a range for use in range-based for loops */
+  KeyRange keys() const;
+
   // regular readers
-  bool read(std::string_view key, bool& value) const;
-  bool read(std::string_view key, int& value) const;
-  bool read(std::string_view key, float& value) const;
-  bool read(std::string_view key, std::string& value) const;
+  bool read(Key const& key, bool& value) const;
+  bool read(Key const& key, int& value) const;
+  bool read(Key const& key, float& value) const;
+  bool read(Key const& key, std::string& value) const;
+
+  bool read(Key const& key, std::vector<bool>& value) const;
+  bool read(Key const& key, std::vector<int>& value) const;
+  bool read(Key const& key, std::vector<float>& value) const;
+  bool read(Key const& key, std::vector<std::string>& value) const;
 
-  bool read(std::string_view key, std::vector<bool>& value) const;
-  bool read(std::string_view key, std::vector<int>& value) const;
-  bool read(std::string_view key, std::vector<float>& value) const;
-  bool read(std::string_view key, std::vector<std::string>& value) const;
+  // zero-copy readers, the views refer to the document and stay valid
+  // as long as it. The spans are caller storage and must match the
+  // number of elements.
+  bool read(Key const& key, std::string_view& value) const;
+  bool read(Key const& key, std::span<int> values) const;
+  bool read(Key const& key, std::span<float> values) const;
 
-  bool read(std::string_view key, ReaderMapping&) const;
-  bool read(std::string_view key, ReaderCollection&) const;
-  bool read(std::string_view key, ReaderObject&) const;
+  bool read(Key const& key, ReaderMapping&) const;
+  bool read(Key const& key, ReaderCollection&) const;
+  bool read(Key const& key, ReaderObject&) const;
 
   template<typename Enum, typename String2Enum,
            typename std::enable_if_t<std::is_enum<Enum>::value, int> = 0>
-  bool read(std::string_view key, Enum& value, String2Enum string2enum) const
+  bool read(Key const& key, Enum& value, String2Enum string2enum) const
   {
     std::string str;
     if (!read(key, str)) {
@@ -83,14 +180,19 @@ public:
   }
 
   template<typename T>
-  bool read(std::string_view key, T& value) const {
-    return read_custom<T>(*this, key, value);
+  bool read(Key const& key, T& value) const {
+    if constexpr (HasFields<T>) {
+      ReaderMapping mapping;
+      return read(key, mapping) && read_struct(mapping, value);
+    } else {
+      return read_custom<T>(*this, key, value);
+    }
   }
 
   // regular getters
   template<typename T>
   [[nodiscard]]
-  T get(std::string_view key, T fallback = {}) const {
+  T get(Key const& key, T fallback = {}) const {
     read(key, fallback);
     return fallback;
   }
@@ -98,14 +200,14 @@ public:
   template<typename Enum, typename String2Enum,
            typename std::enable_if_t<std::is_enum<Enum>::value, int> = 0>
   [[nodiscard]]
-  Enum get(std::string_view key, String2Enum string2enum, Enum fallback = {}) const {
+  Enum get(Key const& key, String2Enum string2enum, Enum fallback = {}) const {
     read(key, fallback, string2enum);
     return fallback;
   }
 
   // must readers
   template<typename T>
-  void must_read(std::string_view key, T& value) const {
+  void must_read(Key const& key, T& value) const {
     if (!read(key, value)) {
       missing_key_error(key);
     }
@@ -113,7 +215,7 @@ public:
 
   template<typename Enum, typename String2Enum,
            typename std::enable_if_t<std::is_enum<Enum>::value, int> = 0>
-  void must_read(std::string_view key, Enum& value, String2Enum string2enum) const
+  void must_read(Key const& key, Enum& value, String2Enum string2enum) const
   {
     if (!read(key, value, string2enum)) {
       missing_key_error(key);
@@ -122,7 +224,7 @@ public:
 
   // must getters
   template<typename T>
-  T must_get(std::string_view key) const {
+  T must_get(Key const& key) const {
     T value;
     if (!read(key, value)) {
       missing_key_error(key);
@@ -132,7 +234,7 @@ public:
 
   template<typename Enum, typename String2Enum,
            typename std::enable_if_t<std::is_enum<Enum>::value, int> = 0>
-  Enum must_get(std::string_view key, String2Enum string2enum) const
+  Enum must_get(Key const& key, String2Enum string2enum) const
   {
     Enum value{};
     if (!read(key, value, string2enum)) {
@@ -141,6 +243,15 @@ public:
     return value;
   }
 
+  /** Reads all of @a fields in a single pass over the mapping instead
+      of looking each key up separately, otherwise the same as calling
+      read() for each of them. Missing required fields are reported
+      together with missing_key_error(), returns false if there were
+      any. */
+  bool read_fields(ReaderFieldTable const& fields) const;
+  bool read_fields(std::span<ReaderField const> fields) const;
+  bool read_fields(std::initializer_list<ReaderField> fields) const;
+
   /** report error with key that can be ignored */
   void error(std::string_view key, std::string_view message) const;
 
@@ -148,7 +259,7 @@ public:
   void missing_key_error(std::string_view key) const;
 
 private:
-  std::unique_ptr<ReaderMappingImpl> m_impl;
+  Storage m_impl;
 };
 
 } // namespace prio
@@ -18,6 +18,11 @@
 #define HEADER_PRIO_READER_OBJECT_HPP
 
 #include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "impl_storage.hpp"
 
 namespace prio {
 
@@ -27,10 +32,22 @@ class ReaderMapping;
 
 class ReaderObject final
 {
+public:
+  using Storage = ImplStorage<ReaderObjectImpl, 32>;
+
 public:
   ReaderObject();
   ReaderObject(ReaderObject&&) noexcept;
   ReaderObject(std::unique_ptr<ReaderObjectImpl> impl);
+
+  /** Constructs the implementation @a T in place, without a heap
+      allocation if it fits into Storage */
+  template<typename T, typename... Args>
+  explicit ReaderObject(std::in_place_type_t<T>, Args&&... args) :
+    m_impl()
+  {
+    m_impl.template emplace<T>(std::forward<Args>(args)...);
+  }
   ~ReaderObject();
 
   explicit operator bool() const { return static_cast<bool>(m_impl); }
@@ -41,10 +58,15 @@ public:
   ReaderObject& operator=(ReaderObject&&) noexcept;
 
   std::string get_name() const;
+
+  /** Name of the object without copying it, the view stays valid as
+      long as the document */
+  std::string_view get_name_view() const;
+
   ReaderMapping get_mapping() const;
 
 private:
-  std::unique_ptr<ReaderObjectImpl> m_impl;
+  Storage m_impl;
 };
 
 } // namespace prio
@@ -0,0 +1,119 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_PRIO_READER_STREAM_HPP
+#define HEADER_PRIO_READER_STREAM_HPP
+
+#include <filesystem>
+#include <iosfwd>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "format.hpp"
+
+namespace prio {
+
+class ReaderStreamImpl;
+
+/** Pull parser that reads a document as a sequence of events without
+    building a tree, memory use is bounded by the nesting depth and the
+    size of the largest single token.
+
+    Both formats are presented in the same vocabulary as the Writer:
+    an object is a named node, `(name ...)` in s-expressions and a
+    `"name": ...` member in JSON, a key/value pair is simply an object
+    holding a single value. JSON objects themselves are transparent, as
+    are arrays that are the value of a member; nameless lists, such as
+    an s-expression list not starting with a symbol or a JSON array
+    nested in another array, are reported as collections. JSON null
+    values produce no event.
+
+    Documents may contain multiple top-level values, e.g. JSON Lines or
+    successive s-expressions, END_DOCUMENT is returned after the last. */
+class ReaderStream final
+{
+public:
+  enum class Event
+  {
+    BEGIN_OBJECT,
+    END_OBJECT,
+    BEGIN_COLLECTION,
+    END_COLLECTION,
+    BOOL,
+    INT,
+    FLOAT,
+    STRING,
+    END_DOCUMENT
+  };
+
+public:
+  static ReaderStream from_file(Format format, std::filesystem::path const& filename);
+  static ReaderStream from_stream(Format format, std::istream& stream,
+                                  std::optional<std::string> const& filename = {});
+
+  static ReaderStream from_file(std::filesystem::path const& filename);
+  static ReaderStream from_stream(std::istream& stream,
+                                  std::optional<std::string> const& filename = {});
+
+public:
+  ReaderStream(ReaderStream&&) noexcept;
+  ~ReaderStream();
+
+  ReaderStream& operator=(ReaderStream&&) noexcept;
+
+  /** Advances to the next event, throws ReaderError on malformed input */
+  Event next();
+
+  /** Skips the remainder of the object or collection opened by the last
+      BEGIN_OBJECT or BEGIN_COLLECTION event, the next event is the one
+      following its end */
+  void skip();
+
+  /** Name of the object, valid after BEGIN_OBJECT */
+  std::string_view get_name() const;
+
+  /** Value of the last BOOL, INT, FLOAT or STRING event, get_float()
+      also accepts INT. The returned views are valid until the next call
+      to next(). */
+  bool get_bool() const;
+  int get_int() const;
+  float get_float() const;
+  std::string_view get_string() const;
+
+  /** Number of currently open objects and collections */
+  int get_depth() const;
+
+  /** Line of the current event */
+  int get_line() const;
+
+private:
+  ReaderStream(std::unique_ptr<ReaderStreamImpl> impl);
+
+private:
+  std::unique_ptr<ReaderStreamImpl> m_impl;
+
+private:
+  ReaderStream(ReaderStream const&) = delete;
+  ReaderStream& operator=(ReaderStream const&) = delete;
+};
+
+} // namespace prio
+
+#endif
+
+/* EOF */
@@ -18,6 +18,13 @@
 #define HEADER_PRIO_SEXPR_READER_HPP
 
 #include <assert.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
 #include <sexp/value.hpp>
 
 #include "error_handler.hpp"
@@ -28,8 +35,10 @@ namespace prio {
 class SExprReaderDocumentImpl final : public ReaderDocumentImpl
 {
 public:
+  /** @a line_offset is added to line numbers in error messages, for
+      documents parsed from a part of a larger file */
   SExprReaderDocumentImpl(sexp::Value sx, ErrorHandler error_handler,
-                          std::optional<std::string> filename);
+                          std::optional<std::string> filename, int line_offset = 0);
   SExprReaderDocumentImpl(SExprReaderDocumentImpl const&) = delete;
   SExprReaderDocumentImpl& operator=(SExprReaderDocumentImpl const&) = delete;
 
@@ -37,17 +46,31 @@ public:
   std::optional<std::string> get_filename() const override { return m_filename; }
   void set_parent(ReaderDocument const* parent) override { m_parent = parent; }
   ReaderDocument const& get_parent() const override { assert(m_parent != nullptr); return *m_parent; }
+  std::size_t get_memory_usage() const override;
 
   void error(sexp::Value const& sx, std::string_view message) const;
   void error(ErrorHandler error_handler, sexp::Value const& sx, std::string_view message) const;
 
   sexp::Value const& get_sx() const { return m_sx; }
 
+  /** Maps each key of a mapping to its key/value pair, the last of
+      several duplicate keys wins */
+  using Index = std::unordered_map<std::string_view, sexp::Value const*, KeyHash, std::equal_to<>>;
+
+  /** Returns the index of the mapping @a sx. It is built on the first
+      call and kept with the document, so it is paid for once per node
+      and not for every handle to it. */
+  Index const& get_index(sexp::Value const& sx) const;
+
 private:
   sexp::Value m_sx;
   ErrorHandler m_error_handler;
   std::optional<std::string> m_filename;
+  int m_line_offset;
   ReaderDocument const* m_parent;
+
+  mutable std::mutex m_indices_mutex;
+  mutable std::unordered_map<sexp::Value const*, Index> m_indices;
 };
 
 class SExprReaderObjectImpl final : public ReaderObjectImpl
@@ -58,6 +81,7 @@ public:
 
   SExprReaderDocumentImpl const& get_document() const override { return m_doc; }
   std::string get_name() const override;
+  std::string_view get_name_view() const override;
   ReaderMapping get_mapping() const override;
 
   sexp::Value const& get_sx() const { return m_sx; }
@@ -76,6 +100,9 @@ public:
   SExprReaderDocumentImpl const& get_document() const override { return m_doc; }
   std::vector<ReaderObject> get_objects() const override;
 
+  std::size_t get_size() const override;
+  ReaderObject get_object(std::size_t index) const override;
+
   sexp::Value const& get_sx() const { return m_sx; }
 
 private:
@@ -87,24 +114,35 @@ class SExprReaderMappingImpl final : public ReaderMappingImpl
 {
 public:
   SExprReaderMappingImpl(SExprReaderDocumentImpl const& doc, sexp::Value const& m_sx);
+  SExprReaderMappingImpl(SExprReaderMappingImpl&& other) noexcept;
   ~SExprReaderMappingImpl() override;
 
   SExprReaderDocumentImpl const& get_document() const override { return m_doc; }
   std::vector<std::string> get_keys() const override;
+  std::size_t first_key_cursor() const override;
+  std::size_t next_key_cursor(std::size_t cursor) const override;
+  std::size_t end_key_cursor() const override;
+  std::string_view get_key_at_cursor(std::size_t cursor, std::string& buffer) const override;
+
+  bool read(Key const& key, bool& value) const override;
+  bool read(Key const& key, int& value) const override;
+  bool read(Key const& key, float& value) const override;
+  bool read(Key const& key, std::string& value) const override;
+
+  bool read(Key const& key, std::vector<bool>& v) const override;
+  bool read(Key const& key, std::vector<int>& v) const override;
+  bool read(Key const& key, std::vector<float>& v) const override;
+  bool read(Key const& key, std::vector<std::string>& v) const override;
 
-  bool read(std::string_view key, bool& value) const override;
-  bool read(std::string_view key, int& value) const override;
-  bool read(std::string_view key, float& value) const override;
-  bool read(std::string_view key, std::string& value) const override;
+  bool read(Key const& key, std::string_view& value) const override;
+  bool read(Key const& key, std::span<int> v) const override;
+  bool read(Key const& key, std::span<float> v) const override;
 
-  bool read(std::string_view key, std::vector<bool>& v) const override;
-  bool read(std::string_view key, std::vector<int>& v) const override;
-  bool read(std::string_view key, std::vector<float>& v) const override;
-  bool read(std::string_view key, std::vector<std::string>& v) const override;
+  bool read(Key const& key, ReaderMapping& value) const override;
+  bool read(Key const& key, ReaderCollection& value) const override;
+  bool read(Key const& key, ReaderObject& value) const override;
 
-  bool read(std::string_view key, ReaderMapping& value) const override;
-  bool read(std::string_view key, ReaderCollection& value) const override;
-  bool read(std::string_view key, ReaderObject& value) const override;
+  void read_fields(ReaderFieldTable const& fields, std::span<bool> found) const override;
 
   void error(std::string_view key, std::string_view message) const override;
   void missing_key_error(std::string_view key) const override;
@@ -112,13 +150,37 @@ public:
   sexp::Value const& get_sx() const { return m_sx; }
 
 private:
-  sexp::Value const* get_subsection_item(std::string_view key) const;
-  sexp::Value const* get_subsection_items(std::string_view key) const;
-  sexp::Value const* get_subsection(std::string_view key) const;
+  bool read_element(sexp::Value const* sub, bool& value) const;
+  bool read_element(sexp::Value const* sub, int& value) const;
+  bool read_element(sexp::Value const* sub, float& value) const;
+  bool read_element(sexp::Value const* sub, std::string& value) const;
+
+  bool read_element(sexp::Value const* sub, std::vector<bool>& v) const;
+  bool read_element(sexp::Value const* sub, std::vector<int>& v) const;
+  bool read_element(sexp::Value const* sub, std::vector<float>& v) const;
+  bool read_element(sexp::Value const* sub, std::vector<std::string>& v) const;
+
+  bool read_element(sexp::Value const* sub, std::string_view& value) const;
+  bool read_element(sexp::Value const* sub, std::span<int> v) const;
+  bool read_element(sexp::Value const* sub, std::span<float> v) const;
+
+  bool read_element(sexp::Value const* sub, ReaderMapping& value) const;
+  bool read_element(sexp::Value const* sub, ReaderCollection& value) const;
+  bool read_element(sexp::Value const* sub, ReaderObject& value) const;
+
+  sexp::Value const* get_item(sexp::Value const* sub) const;
+  sexp::Value const* get_items(sexp::Value const* sub) const;
+  sexp::Value const* get_subsection(Key const& key) const;
+
+  /** Mappings with more than INDEX_THRESHOLD keys are looked up
+      through the index of the document, which is fetched on the first
+      lookup, smaller ones are scanned linearly */
+  static constexpr std::size_t INDEX_THRESHOLD = 16;
 
 private:
   SExprReaderDocumentImpl const& m_doc;
   sexp::Value const& m_sx;
+  mutable std::atomic<SExprReaderDocumentImpl::Index const*> m_index;
 };
 
 } // namespace prio
@@ -18,12 +18,15 @@
 #define HEADER_PRIO_WRITER_HPP
 
 #include <filesystem>
+#include <initializer_list>
 #include <memory>
 #include <span>
 #include <string>
 #include <vector>
 
 #include "format.hpp"
+#include "fwd.hpp"
+#include "writer_field.hpp"
 
 namespace prio {
 
@@ -93,9 +96,22 @@ public:
   Writer& write(std::string_view key, std::vector<float> const& values);
   Writer& write(std::string_view key, std::vector<std::string> const& values);
 
+  /** write a sequence of name/value pairs inside a mapping in one go,
+      output is the same as that of writing them one by one as long as
+      the stream uses the default formatting flags, numbers are
+      formatted with std::to_chars() instead of the stream */
+  Writer& write_fields(std::span<WriterField const> fields);
+  Writer& write_fields(std::initializer_list<WriterField> fields);
+
   template<typename T>
   Writer& write(std::string_view key, T const& value) {
-    write_custom<T>(*this, key, value);
+    if constexpr (HasFields<T>) {
+      begin_mapping(key);
+      write_struct(*this, value);
+      end_mapping();
+    } else {
+      write_custom<T>(*this, key, value);
+    }
     return *this;
   }
 
@@ -0,0 +1,57 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_PRIO_WRITER_FIELD_HPP
+#define HEADER_PRIO_WRITER_FIELD_HPP
+
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace prio {
+
+using WriterFieldValue = std::variant<bool const*, int const*, float const*, std::string const*,
+                                      std::vector<bool> const*, std::vector<int> const*,
+                                      std::vector<float> const*, std::vector<std::string> const*>;
+
+/** Entry in a table of name/value pairs written with
+    Writer::write_fields(). @a plain_key promises that @a key contains
+    no characters that any format needs to escape, which allows the
+    writer to copy it to the output verbatim. */
+struct WriterField
+{
+  std::string_view key = {};
+  WriterFieldValue value = {};
+  bool plain_key = false;
+};
+
+/** Returns true if @a key can be written without escaping */
+constexpr bool is_plain_key(std::string_view key)
+{
+  for (char const c : key) {
+    if (c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace prio
+
+#endif
+
+/* EOF */
@@ -0,0 +1,121 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef HEADER_PRIO_ARRAY_VALUES_HPP
+#define HEADER_PRIO_ARRAY_VALUES_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <format>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace prio {
+
+/** Returns true if @a values can receive @a count elements, vectors
+    are resized while spans are caller storage of a fixed size */
+template<typename T>
+bool fits_values(std::vector<T> const& /*values*/, std::size_t /*count*/)
+{
+  return true;
+}
+
+template<typename T>
+bool fits_values(std::span<T> values, std::size_t count)
+{
+  return values.size() == count;
+}
+
+/** Makes @a values hold @a count elements, returns false if it can't */
+template<typename T>
+bool resize_values(std::vector<T>& values, std::size_t count)
+{
+  values.resize(count);
+  return true;
+}
+
+template<typename T>
+bool resize_values(std::span<T> values, std::size_t count)
+{
+  return fits_values(values, count);
+}
+
+/** Buffer that span elements are decoded into, inline for small counts */
+template<typename T>
+class StagedSpan final
+{
+public:
+  explicit StagedSpan(std::size_t count) :
+    m_inline(),
+    m_heap(count > INLINE_COUNT ? count : 0),
+    m_values(count > INLINE_COUNT ? m_heap.data() : m_inline.data(), count)
+  {}
+
+  T& operator[](std::size_t index) { return m_values[index]; }
+  std::span<T const> get() const { return m_values; }
+
+private:
+  static constexpr std::size_t INLINE_COUNT = 16;
+
+  std::array<T, INLINE_COUNT> m_inline;
+  std::vector<T> m_heap;
+  std::span<T> m_values;
+
+private:
+  StagedSpan(StagedSpan const&) = delete;
+  StagedSpan& operator=(StagedSpan const&) = delete;
+};
+
+/** Returns storage for @a count elements that are decoded before they
+    replace @a values with commit_values(), so that a type mismatch part
+    way through leaves @a values untouched */
+template<typename T>
+std::vector<T> stage_values(std::vector<T> const& /*values*/, std::size_t count)
+{
+  return std::vector<T>(count);
+}
+
+template<typename T>
+StagedSpan<T> stage_values(std::span<T> /*values*/, std::size_t count)
+{
+  return StagedSpan<T>(count);
+}
+
+template<typename T>
+void commit_values(std::vector<T>& values, std::vector<T>& staged)
+{
+  values.swap(staged);
+}
+
+template<typename T>
+void commit_values(std::span<T> values, StagedSpan<T> const& staged)
+{
+  std::ranges::copy(staged.get(), values.begin());
+}
+
+inline std::string size_mismatch_message(std::size_t expected, std::size_t count)
+{
+  return std::format("expected {} elements, got {}", expected, count);
+}
+
+} // namespace prio
+
+#endif
+
+/* EOF */
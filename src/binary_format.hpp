@@ -0,0 +1,153 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_PRIO_BINARY_FORMAT_HPP
+#define HEADER_PRIO_BINARY_FORMAT_HPP
+
+#include <bit>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace prio {
+
+/** Layout of Format::BINARY documents, shared by BinaryWriterImpl and
+    BinaryReaderDocumentImpl. All integers are little-endian and all
+    references are absolute byte offsets into the document, so a reader
+    can work directly on a memory mapping without parsing it first.
+
+      Header    magic[8], uint32 version, uint32 size, uint32 root
+
+    The root is the offset of the MAPPING node of the root object. The
+    value model is the one of the JSON backends: an object is a mapping
+    with a single member named after its type, a collection is an array
+    of objects.
+
+    Values inside mappings and arrays are stored as 8 byte slots:
+
+      Slot      uint8 tag, uint8 padding[3], uint32 payload
+
+    BOOL_FALSE and BOOL_TRUE have no payload, INT and FLOAT store the
+    int32/float32 bits in it, STRING, ARRAY and MAPPING the offset of
+    their node:
+
+      String    uint32 length, bytes
+      Mapping   uint32 count, Entry[count], uint32 order[count]
+      Entry     uint32 key, Slot
+      Array     uint32 count, uint8 kind, uint8 padding[3], elements
+
+    Mapping entries are sorted bytewise by key, which is the offset of a
+    string node, and can be looked up by binary search; order[] lists
+    the entry indices in the order they were written. Array elements are
+    uint8 (BOOLS), int32 (INTS), float32 (FLOATS) or Slot (SLOTS), with
+    numbers stored contiguously so that they can be read as a span.
+
+    Mapping and array nodes are 4 byte aligned. Nodes are written after
+    the nodes they reference, so every reference points backwards, which
+    readers check to rule out cycles in corrupted input. */
+namespace binary {
+
+inline constexpr std::string_view MAGIC{"\x89PRIO\r\n\x1a", 8};
+inline constexpr std::uint32_t VERSION = 2;
+inline constexpr std::size_t HEADER_SIZE = MAGIC.size() + 12;
+
+inline constexpr std::size_t SLOT_SIZE = 8;
+inline constexpr std::size_t ENTRY_SIZE = 4 + SLOT_SIZE;
+inline constexpr std::size_t ARRAY_HEADER_SIZE = 8;
+
+enum Tag : std::uint8_t
+{
+  BOOL_FALSE = 0x01,
+  BOOL_TRUE = 0x02,
+  INT = 0x03,
+  FLOAT = 0x04,
+  STRING = 0x05,
+  ARRAY = 0x06,
+  MAPPING = 0x07
+};
+
+enum ArrayKind : std::uint8_t
+{
+  SLOTS = 0x00,
+  BOOLS = 0x01,
+  INTS = 0x02,
+  FLOATS = 0x03
+};
+
+struct Slot
+{
+  std::uint8_t tag;
+  std::uint32_t payload;
+};
+
+inline std::uint32_t load_u32(std::string_view data, std::size_t offset)
+{
+  auto const* p = reinterpret_cast<unsigned char const*>(data.data() + offset);
+  return static_cast<std::uint32_t>(p[0]) |
+    (static_cast<std::uint32_t>(p[1]) << 8) |
+    (static_cast<std::uint32_t>(p[2]) << 16) |
+    (static_cast<std::uint32_t>(p[3]) << 24);
+}
+
+inline std::int32_t load_i32(std::string_view data, std::size_t offset)
+{
+  return std::bit_cast<std::int32_t>(load_u32(data, offset));
+}
+
+inline float load_f32(std::string_view data, std::size_t offset)
+{
+  return std::bit_cast<float>(load_u32(data, offset));
+}
+
+inline void append_u32(std::string& out, std::uint32_t value)
+{
+  char const bytes[4] = {
+    static_cast<char>(value & 0xff),
+    static_cast<char>((value >> 8) & 0xff),
+    static_cast<char>((value >> 16) & 0xff),
+    static_cast<char>((value >> 24) & 0xff)
+  };
+  out.append(bytes, 4);
+}
+
+inline void store_u32(std::string& out, std::size_t offset, std::uint32_t value)
+{
+  out[offset + 0] = static_cast<char>(value & 0xff);
+  out[offset + 1] = static_cast<char>((value >> 8) & 0xff);
+  out[offset + 2] = static_cast<char>((value >> 16) & 0xff);
+  out[offset + 3] = static_cast<char>((value >> 24) & 0xff);
+}
+
+inline void append_slot(std::string& out, Slot slot)
+{
+  char const head[4] = { static_cast<char>(slot.tag), 0, 0, 0 };
+  out.append(head, 4);
+  append_u32(out, slot.payload);
+}
+
+/** Returns true if @a text starts with a Format::BINARY header */
+inline bool has_magic(std::string_view text)
+{
+  return text.starts_with(MAGIC);
+}
+
+} // namespace binary
+
+} // namespace prio
+
+#endif
+
+/* EOF */
@@ -0,0 +1,670 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "binary_reader_impl.hpp"
+
+#include <bit>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <type_traits>
+#include <utility>
+
+#include <logmich/log.hpp>
+
+#include "array_values.hpp"
+#include "binary_format.hpp"
+#include "input_buffer.hpp"
+#include "reader_collection.hpp"
+#include "reader_error.hpp"
+#include "reader_mapping.hpp"
+#include "reader_object.hpp"
+
+namespace prio {
+
+namespace {
+
+using binary::Slot;
+
+[[noreturn]]
+void corrupt(std::uint64_t offset, std::string_view message)
+{
+  throw ReaderError(std::format("binary parse error: offset {}: {}", offset, message));
+}
+
+// Nothing but the header is checked when a document is opened, so all
+// accessors below check the bounds of what they read. References must
+// point backwards, which keeps corrupted documents from forming cycles.
+
+void require(BinaryReaderDocumentImpl const& doc, std::uint64_t offset, std::uint64_t size)
+{
+  if (offset + size > doc.get_data().size()) {
+    corrupt(offset, "unexpected end of data");
+  }
+}
+
+std::uint32_t load(BinaryReaderDocumentImpl const& doc, std::uint64_t offset)
+{
+  require(doc, offset, 4);
+  return binary::load_u32(doc.get_data(), offset);
+}
+
+std::uint32_t reference(BinaryReaderDocumentImpl const& doc, std::uint64_t offset, std::uint32_t referrer)
+{
+  std::uint32_t const target = load(doc, offset);
+  if (target < binary::HEADER_SIZE || target >= referrer) {
+    corrupt(offset, "invalid reference");
+  }
+  return target;
+}
+
+Slot slot_at(BinaryReaderDocumentImpl const& doc, std::uint64_t offset, std::uint32_t referrer)
+{
+  require(doc, offset, binary::SLOT_SIZE);
+  std::uint8_t const tag = static_cast<std::uint8_t>(doc.get_data()[offset]);
+  if (tag == binary::STRING || tag == binary::ARRAY || tag == binary::MAPPING) {
+    return Slot{tag, reference(doc, offset + 4, referrer)};
+  } else {
+    return Slot{tag, load(doc, offset + 4)};
+  }
+}
+
+std::string_view string_at(BinaryReaderDocumentImpl const& doc, std::uint32_t offset)
+{
+  std::uint32_t const length = load(doc, offset);
+  require(doc, offset + 4, length);
+  return doc.get_data().substr(offset + 4, length);
+}
+
+std::uint32_t mapping_count(BinaryReaderDocumentImpl const& doc, std::uint32_t node)
+{
+  std::uint32_t const count = load(doc, node);
+  require(doc, node, 4 + std::uint64_t{count} * (binary::ENTRY_SIZE + 4));
+  return count;
+}
+
+std::string_view entry_key(BinaryReaderDocumentImpl const& doc, std::uint32_t node, std::uint32_t index)
+{
+  return string_at(doc, reference(doc, node + 4 + std::uint64_t{index} * binary::ENTRY_SIZE, node));
+}
+
+Slot entry_value(BinaryReaderDocumentImpl const& doc, std::uint32_t node, std::uint32_t index)
+{
+  return slot_at(doc, node + 4 + std::uint64_t{index} * binary::ENTRY_SIZE + 4, node);
+}
+
+/** Returns the index of the entry written @a nth */
+std::uint32_t entry_order(BinaryReaderDocumentImpl const& doc, std::uint32_t node, std::uint32_t count, std::uint32_t nth)
+{
+  std::uint64_t const offset = node + 4 + std::uint64_t{count} * binary::ENTRY_SIZE + std::uint64_t{nth} * 4;
+  std::uint32_t const index = load(doc, offset);
+  if (index >= count) {
+    corrupt(offset, "invalid entry index");
+  }
+  return index;
+}
+
+binary::ArrayKind array_kind(BinaryReaderDocumentImpl const& doc, std::uint32_t node)
+{
+  require(doc, node, binary::ARRAY_HEADER_SIZE);
+  return static_cast<binary::ArrayKind>(doc.get_data()[node + 4]);
+}
+
+std::uint32_t array_count(BinaryReaderDocumentImpl const& doc, std::uint32_t node)
+{
+  std::uint64_t element_size;
+  switch (array_kind(doc, node)) {
+    case binary::BOOLS: element_size = 1; break;
+    case binary::INTS: element_size = 4; break;
+    case binary::FLOATS: element_size = 4; break;
+    case binary::SLOTS: element_size = binary::SLOT_SIZE; break;
+    default: corrupt(node + 4, "unknown array kind");
+  }
+
+  std::uint32_t const count = load(doc, node);
+  require(doc, node, binary::ARRAY_HEADER_SIZE + count * element_size);
+  return count;
+}
+
+Slot array_element(BinaryReaderDocumentImpl const& doc, std::uint32_t node, binary::ArrayKind kind, std::uint32_t index)
+{
+  std::uint64_t const base = node + binary::ARRAY_HEADER_SIZE;
+  switch (kind) {
+    case binary::BOOLS:
+      return Slot{doc.get_data()[base + index] ? binary::BOOL_TRUE : binary::BOOL_FALSE, 0};
+
+    case binary::INTS:
+      return Slot{binary::INT, binary::load_u32(doc.get_data(), base + std::uint64_t{index} * 4)};
+
+    case binary::FLOATS:
+      return Slot{binary::FLOAT, binary::load_u32(doc.get_data(), base + std::uint64_t{index} * 4)};
+
+    default:
+      return slot_at(doc, base + std::uint64_t{index} * binary::SLOT_SIZE, node);
+  }
+}
+
+// The predicates follow the ones of the JSON backends, so that a
+// document converted to binary reads the same as the original.
+
+bool is_bool(Slot slot)
+{
+  return slot.tag == binary::BOOL_FALSE || slot.tag == binary::BOOL_TRUE;
+}
+
+bool is_int(Slot slot)
+{
+  if (slot.tag == binary::INT) {
+    return true;
+  } else if (slot.tag == binary::FLOAT) {
+    float const value = std::bit_cast<float>(slot.payload);
+    float intpart;
+    return value >= static_cast<float>(INT_MIN) && value < static_cast<float>(INT_MAX) &&
+      std::modf(value, &intpart) == 0.0f;
+  } else {
+    return false;
+  }
+}
+
+bool is_double(Slot slot)
+{
+  return slot.tag == binary::INT || slot.tag == binary::FLOAT;
+}
+
+bool is_string(Slot slot)
+{
+  return slot.tag == binary::STRING;
+}
+
+bool as_bool(BinaryReaderDocumentImpl const& /*doc*/, Slot slot)
+{
+  return slot.tag == binary::BOOL_TRUE;
+}
+
+int as_int(BinaryReaderDocumentImpl const& /*doc*/, Slot slot)
+{
+  if (slot.tag == binary::INT) {
+    return std::bit_cast<std::int32_t>(slot.payload);
+  } else {
+    return static_cast<int>(std::bit_cast<float>(slot.payload));
+  }
+}
+
+float as_float(BinaryReaderDocumentImpl const& /*doc*/, Slot slot)
+{
+  if (slot.tag == binary::INT) {
+    return static_cast<float>(std::bit_cast<std::int32_t>(slot.payload));
+  } else {
+    return std::bit_cast<float>(slot.payload);
+  }
+}
+
+std::string as_string(BinaryReaderDocumentImpl const& doc, Slot slot)
+{
+  return std::string(string_at(doc, slot.payload));
+}
+
+std::string_view as_string_view(BinaryReaderDocumentImpl const& doc, Slot slot)
+{
+  return string_at(doc, slot.payload);
+}
+
+/** Reads the array at @a node into @a values, a vector or a span of
+    matching size, returns false without touching @a values if an
+    element isn't of the requested type. Arrays of the matching number
+    type are copied straight out of the document without decoding the
+    elements. */
+template<typename T, typename Values>
+bool read_array(BinaryReaderDocumentImpl const& doc, std::uint32_t node, Values& values,
+                bool (*checker)(Slot), T (*getter)(BinaryReaderDocumentImpl const&, Slot))
+{
+  std::uint32_t const count = array_count(doc, node);
+  binary::ArrayKind const kind = array_kind(doc, node);
+
+  if constexpr (std::is_same_v<T, int> || std::is_same_v<T, float>) {
+    constexpr binary::ArrayKind native_kind = std::is_same_v<T, int> ? binary::INTS : binary::FLOATS;
+    if (kind == native_kind && std::endian::native == std::endian::little) {
+      resize_values(values, count);
+      std::memcpy(values.data(), doc.get_data().data() + node + binary::ARRAY_HEADER_SIZE, count * sizeof(T));
+      return true;
+    }
+  }
+
+  for (std::uint32_t i = 0; i < count; ++i) {
+    if (!checker(array_element(doc, node, kind, i))) {
+      return false;
+    }
+  }
+
+  resize_values(values, count);
+  for (std::uint32_t i = 0; i < count; ++i) {
+    values[i] = getter(doc, array_element(doc, node, kind, i));
+  }
+  return true;
+}
+
+} // namespace
+
+BinaryReaderDocumentImpl::BinaryReaderDocumentImpl(std::shared_ptr<InputBuffer const> buffer, ErrorHandler error_handler,
+                                                   std::optional<std::string> filename) :
+  m_buffer(std::move(buffer)),
+  m_data(m_buffer->get_text()),
+  m_root(0),
+  m_error_handler(error_handler),
+  m_filename(std::move(filename)),
+  m_parent(nullptr)
+{
+  if (m_data.size() < binary::HEADER_SIZE || !binary::has_magic(m_data)) {
+    corrupt(0, "not a prio binary document");
+  }
+
+  std::uint32_t const version = binary::load_u32(m_data, binary::MAGIC.size());
+  if (version != binary::VERSION) {
+    corrupt(binary::MAGIC.size(), std::format("unsupported version {}", version));
+  }
+
+  std::uint32_t const size = binary::load_u32(m_data, binary::MAGIC.size() + 4);
+  if (size != m_data.size()) {
+    corrupt(binary::MAGIC.size() + 4, std::format("document size is {} bytes, expected {}", m_data.size(), size));
+  }
+
+  m_root = binary::load_u32(m_data, binary::MAGIC.size() + 8);
+  if (m_root < binary::HEADER_SIZE || m_root >= size) {
+    corrupt(binary::MAGIC.size() + 8, "invalid root");
+  }
+
+  m_buffer->advise_random_access();
+}
+
+BinaryReaderDocumentImpl::~BinaryReaderDocumentImpl()
+{
+}
+
+void
+BinaryReaderDocumentImpl::error(std::uint32_t offset, std::string_view message) const
+{
+  error(m_error_handler, offset, message);
+}
+
+void
+BinaryReaderDocumentImpl::error(ErrorHandler error_handler, std::uint32_t offset, std::string_view message) const
+{
+  switch (error_handler) {
+    case ErrorHandler::THROW:
+      throw ReaderError(std::format("{}: offset {}: {}", m_filename ? *m_filename : "<unknown>",
+                                    offset, message));
+
+    case ErrorHandler::LOG:
+      log_error("{}: offset {}: {}", m_filename ? *m_filename : "<unknown>",
+                offset, message);
+      break;
+
+    case ErrorHandler::IGNORE:
+      break;
+  }
+}
+
+ReaderObject
+BinaryReaderDocumentImpl::get_root() const
+{
+  return ReaderObject(std::in_place_type<BinaryReaderObjectImpl>, *this, m_root);
+}
+
+std::size_t
+BinaryReaderDocumentImpl::get_memory_usage() const
+{
+  return sizeof(*this) + m_buffer->get_memory_usage();
+}
+
+BinaryReaderObjectImpl::BinaryReaderObjectImpl(BinaryReaderDocumentImpl const& doc, std::uint32_t node) :
+  m_doc(doc),
+  m_node(node),
+  m_count(mapping_count(doc, node))
+{
+  if (m_count != 1)
+  {
+    m_doc.error(m_node, "expected mapping with one element");
+  }
+}
+
+BinaryReaderObjectImpl::~BinaryReaderObjectImpl()
+{
+}
+
+std::string
+BinaryReaderObjectImpl::get_name() const
+{
+  return std::string(get_name_view());
+}
+
+std::string_view
+BinaryReaderObjectImpl::get_name_view() const
+{
+  if (m_count == 0) {
+    return {};
+  }
+
+  return entry_key(m_doc, m_node, 0);
+}
+
+ReaderMapping
+BinaryReaderObjectImpl::get_mapping() const
+{
+  if (m_count == 0) {
+    return {};
+  }
+
+  Slot const value = entry_value(m_doc, m_node, 0);
+  if (value.tag != binary::MAPPING) {
+    return {};
+  }
+
+  return ReaderMapping(std::in_place_type<BinaryReaderMappingImpl>, m_doc, value.payload);
+}
+
+
+BinaryReaderCollectionImpl::BinaryReaderCollectionImpl(BinaryReaderDocumentImpl const& doc, std::uint32_t node) :
+  m_doc(doc),
+  m_node(node),
+  m_count(array_count(doc, node))
+{
+  if (array_kind(m_doc, m_node) != binary::SLOTS)
+  {
+    m_doc.error(m_node, "expected collection");
+    m_count = 0;
+  }
+}
+
+BinaryReaderCollectionImpl::~BinaryReaderCollectionImpl()
+{
+}
+
+std::vector<ReaderObject>
+BinaryReaderCollectionImpl::get_objects() const
+{
+  std::vector<ReaderObject> result;
+  result.reserve(m_count);
+  for (std::uint32_t i = 0; i < m_count; ++i)
+  {
+    Slot const value = array_element(m_doc, m_node, binary::SLOTS, i);
+    if (value.tag != binary::MAPPING) {
+      m_doc.error(m_node, std::format("element {}: expected object", i));
+      continue;
+    }
+    result.emplace_back(std::in_place_type<BinaryReaderObjectImpl>, m_doc, value.payload);
+  }
+  return result;
+}
+
+std::size_t
+BinaryReaderCollectionImpl::get_size() const
+{
+  return m_count;
+}
+
+ReaderObject
+BinaryReaderCollectionImpl::get_object(std::size_t index) const
+{
+  std::uint32_t const i = static_cast<std::uint32_t>(index);
+  Slot const value = array_element(m_doc, m_node, binary::SLOTS, i);
+  if (value.tag != binary::MAPPING) {
+    m_doc.error(m_node, std::format("element {}: expected object", i));
+    return {};
+  }
+  return ReaderObject(std::in_place_type<BinaryReaderObjectImpl>, m_doc, value.payload);
+}
+
+
+BinaryReaderMappingImpl::BinaryReaderMappingImpl(BinaryReaderDocumentImpl const& doc, std::uint32_t node) :
+  m_doc(doc),
+  m_node(node),
+  m_count(mapping_count(doc, node))
+{
+}
+
+BinaryReaderMappingImpl::~BinaryReaderMappingImpl()
+{
+}
+
+std::vector<std::string>
+BinaryReaderMappingImpl::get_keys() const
+{
+  std::vector<std::string> result;
+  result.reserve(m_count);
+  std::string buffer;
+  for (std::size_t i = first_key_cursor(); i != end_key_cursor(); i = next_key_cursor(i)) {
+    result.emplace_back(get_key_at_cursor(i, buffer));
+  }
+  return result;
+}
+
+std::size_t
+BinaryReaderMappingImpl::first_key_cursor() const
+{
+  return 0;
+}
+
+std::size_t
+BinaryReaderMappingImpl::next_key_cursor(std::size_t cursor) const
+{
+  return cursor + 1;
+}
+
+std::size_t
+BinaryReaderMappingImpl::end_key_cursor() const
+{
+  return m_count;
+}
+
+std::string_view
+BinaryReaderMappingImpl::get_key_at_cursor(std::size_t cursor, std::string& /*buffer*/) const
+{
+  // keys are sorted, the cursor counts in document order
+  return entry_key(m_doc, m_node, entry_order(m_doc, m_node, m_count, static_cast<std::uint32_t>(cursor)));
+}
+
+std::uint32_t
+BinaryReaderMappingImpl::find(std::string_view key) const
+{
+  std::uint32_t lo = 0;
+  std::uint32_t hi = m_count;
+  while (lo < hi) {
+    std::uint32_t const mid = lo + (hi - lo) / 2;
+    if (entry_key(m_doc, m_node, mid) < key) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  if (lo < m_count && entry_key(m_doc, m_node, lo) == key) {
+    return lo;
+  } else {
+    return BinaryReaderDocumentImpl::npos;
+  }
+}
+
+#define GET_VALUE_MACRO(type, checker, getter)                          \
+  std::uint32_t const entry = find(key);                                \
+  if (entry == BinaryReaderDocumentImpl::npos) { return false; }        \
+  Slot const element = entry_value(m_doc, m_node, entry);               \
+  if (!checker(element)) {                                              \
+    m_doc.error(m_node, std::format("{}: expected " type,               \
+                                    key.get_name()));                   \
+    return false;                                                       \
+  }                                                                     \
+  value = getter(m_doc, element);                                       \
+  return true
+
+bool
+BinaryReaderMappingImpl::read(Key const& key, bool& value) const
+{
+  GET_VALUE_MACRO("bool", is_bool, as_bool);
+}
+
+bool
+BinaryReaderMappingImpl::read(Key const& key, int& value) const
+{
+  GET_VALUE_MACRO("int", is_int, as_int);
+}
+
+bool
+BinaryReaderMappingImpl::read(Key const& key, float& value) const
+{
+  GET_VALUE_MACRO("float", is_double, as_float);
+}
+
+bool
+BinaryReaderMappingImpl::read(Key const& key, std::string& value) const
+{
+  GET_VALUE_MACRO("string", is_string, as_string);
+}
+
+bool
+BinaryReaderMappingImpl::read(Key const& key, std::string_view& value) const
+{
+  GET_VALUE_MACRO("string", is_string, as_string_view);
+}
+
+#undef GET_VALUE_MACRO
+
+#define GET_VALUES_MACRO(type, checker, getter)                         \
+  std::uint32_t const entry = find(key);                                \
+  if (entry == BinaryReaderDocumentImpl::npos) { return false; }        \
+  Slot const element = entry_value(m_doc, m_node, entry);               \
+  if (element.tag != binary::ARRAY) {                                   \
+    m_doc.error(m_node, std::format("{}: expected array",               \
+                                    key.get_name()));                   \
+    return false;                                                       \
+  }                                                                     \
+  if (std::uint32_t const count = array_count(m_doc, element.payload); \
+      !fits_values(values, count)) {                                    \
+    m_doc.error(m_node, std::format("{}: {}", key.get_name(),           \
+                                    size_mismatch_message(values.size(), count))); \
+    return false;                                                       \
+  }                                                                     \
+  if (!read_array(m_doc, element.payload, values, checker, getter)) {   \
+    m_doc.error(m_node, std::format("{}: expected " type,               \
+                                    key.get_name()));                   \
+    return false;                                                       \
+  }                                                                     \
+  return true
+
+bool
+BinaryReaderMappingImpl::read(Key const& key, std::vector<bool>& values) const
+{
+  GET_VALUES_MACRO("bool", is_bool, as_bool);
+}
+
+bool
+BinaryReaderMappingImpl::read(Key const& key, std::vector<int>& values) const
+{
+  GET_VALUES_MACRO("int", is_int, as_int);
+}
+
+bool
+BinaryReaderMappingImpl::read(Key const& key, std::vector<float>& values) const
+{
+  GET_VALUES_MACRO("float", is_double, as_float);
+}
+
+bool
+BinaryReaderMappingImpl::read(Key const& key, std::vector<std::string>& values) const
+{
+  GET_VALUES_MACRO("string", is_string, as_string);
+}
+
+bool
+BinaryReaderMappingImpl::read(Key const& key, std::span<int> values) const
+{
+  GET_VALUES_MACRO("int", is_int, as_int);
+}
+
+bool
+BinaryReaderMappingImpl::read(Key const& key, std::span<float> values) const
+{
+  GET_VALUES_MACRO("float", is_double, as_float);
+}
+
+#undef GET_VALUES_MACRO
+
+bool
+BinaryReaderMappingImpl::read(Key const& key, ReaderMapping& value) const
+{
+  std::uint32_t const entry = find(key);
+  if (entry == BinaryReaderDocumentImpl::npos) {
+    return false;
+  }
+
+  Slot const element = entry_value(m_doc, m_node, entry);
+  if (element.tag != binary::MAPPING) {
+    return false;
+  }
+
+  value = ReaderMapping(std::in_place_type<BinaryReaderMappingImpl>, m_doc, element.payload);
+  return true;
+}
+
+bool
+BinaryReaderMappingImpl::read(Key const& key, ReaderCollection& value) const
+{
+  std::uint32_t const entry = find(key);
+  if (entry == BinaryReaderDocumentImpl::npos) {
+    return false;
+  }
+
+  Slot const element = entry_value(m_doc, m_node, entry);
+  if (element.tag != binary::ARRAY || array_kind(m_doc, element.payload) != binary::SLOTS) {
+    return false;
+  }
+
+  value = ReaderCollection(std::in_place_type<BinaryReaderCollectionImpl>, m_doc, element.payload);
+  return true;
+}
+
+bool
+BinaryReaderMappingImpl::read(Key const& key, ReaderObject& value) const
+{
+  std::uint32_t const entry = find(key);
+  if (entry == BinaryReaderDocumentImpl::npos) {
+    return false;
+  }
+
+  Slot const element = entry_value(m_doc, m_node, entry);
+  if (element.tag != binary::MAPPING) {
+    return false;
+  }
+
+  value = ReaderObject(std::in_place_type<BinaryReaderObjectImpl>, m_doc, element.payload);
+  return true;
+}
+
+void
+BinaryReaderMappingImpl::error(std::string_view key, std::string_view message) const
+{
+  m_doc.error(m_node, std::format("{}: {}", key, message));
+}
+
+void
+BinaryReaderMappingImpl::missing_key_error(std::string_view key) const
+{
+  m_doc.error(ErrorHandler::THROW, m_node, std::format("required key not found: {}", key));
+}
+
+} // namespace prio
+
+/* EOF */
@@ -0,0 +1,335 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "binary_writer_impl.hpp"
+
+#include <assert.h>
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <numeric>
+#include <ostream>
+#include <stdexcept>
+
+namespace prio {
+
+BinaryWriterImpl::BinaryWriterImpl(std::ostream& out) :
+  m_out(out),
+  m_buffer(),
+  m_stack(),
+  m_keys()
+{
+}
+
+BinaryWriterImpl::~BinaryWriterImpl()
+{
+  assert(m_stack.empty());
+}
+
+void
+BinaryWriterImpl::begin_collection(std::string_view key)
+{
+  m_stack.push_back(Frame{FrameType::COLLECTION, std::string(key), {}, {}});
+}
+
+void
+BinaryWriterImpl::end_collection()
+{
+  assert(!m_stack.empty() && m_stack.back().type == FrameType::COLLECTION);
+
+  Frame const frame = std::move(m_stack.back());
+  m_stack.pop_back();
+
+  add(frame.key, binary::Slot{binary::ARRAY, emit_slots(frame.slots)});
+}
+
+void
+BinaryWriterImpl::begin_object(std::string_view type)
+{
+  if (m_stack.empty()) { // root
+    m_buffer.assign(binary::HEADER_SIZE, '\0');
+    m_keys.clear();
+  } else {
+    assert(m_stack.back().type == FrameType::COLLECTION ||
+           m_stack.back().type == FrameType::KEYVALUE);
+  }
+
+  m_stack.push_back(Frame{FrameType::OBJECT, std::string(type), {}, {}});
+}
+
+void
+BinaryWriterImpl::end_object()
+{
+  assert(!m_stack.empty() && m_stack.back().type == FrameType::OBJECT);
+
+  Frame const frame = std::move(m_stack.back());
+  m_stack.pop_back();
+
+  std::uint32_t const properties = emit_mapping(frame.entries);
+  std::uint32_t const object = emit_mapping({Entry{intern_key(frame.key), binary::Slot{binary::MAPPING, properties}}});
+
+  if (m_stack.empty()) {
+    flush(object);
+  } else {
+    add(binary::Slot{binary::MAPPING, object});
+  }
+}
+
+void
+BinaryWriterImpl::begin_mapping(std::string_view key)
+{
+  m_stack.push_back(Frame{FrameType::MAPPING, std::string(key), {}, {}});
+}
+
+void
+BinaryWriterImpl::end_mapping()
+{
+  assert(!m_stack.empty() && m_stack.back().type == FrameType::MAPPING);
+
+  Frame const frame = std::move(m_stack.back());
+  m_stack.pop_back();
+
+  add(frame.key, binary::Slot{binary::MAPPING, emit_mapping(frame.entries)});
+}
+
+void
+BinaryWriterImpl::begin_keyvalue(std::string_view key)
+{
+  m_stack.push_back(Frame{FrameType::KEYVALUE, std::string(key), {}, {}});
+}
+
+void
+BinaryWriterImpl::end_keyvalue()
+{
+  assert(!m_stack.empty() && m_stack.back().type == FrameType::KEYVALUE);
+
+  Frame const frame = std::move(m_stack.back());
+  m_stack.pop_back();
+
+  assert(frame.slots.size() == 1);
+  add(frame.key, frame.slots.front());
+}
+
+void
+BinaryWriterImpl::write(std::string_view key, bool value)
+{
+  add(key, binary::Slot{value ? binary::BOOL_TRUE : binary::BOOL_FALSE, 0});
+}
+
+void
+BinaryWriterImpl::write(std::string_view key, int value)
+{
+  add(key, binary::Slot{binary::INT, std::bit_cast<std::uint32_t>(value)});
+}
+
+void
+BinaryWriterImpl::write(std::string_view key, float value)
+{
+  add(key, binary::Slot{binary::FLOAT, std::bit_cast<std::uint32_t>(value)});
+}
+
+void
+BinaryWriterImpl::write(std::string_view key, char const* value)
+{
+  write(key, std::string_view(value));
+}
+
+void
+BinaryWriterImpl::write(std::string_view key, std::string_view value)
+{
+  add(key, binary::Slot{binary::STRING, emit_string(value)});
+}
+
+void
+BinaryWriterImpl::write(std::string_view key, std::span<bool const> values)
+{
+  std::uint32_t const array = begin_array(binary::BOOLS, values.size());
+  for (bool const value : values) {
+    m_buffer += static_cast<char>(value ? 1 : 0);
+  }
+  add(key, binary::Slot{binary::ARRAY, array});
+}
+
+void
+BinaryWriterImpl::write(std::string_view key, std::span<int const> values)
+{
+  std::uint32_t const array = begin_array(binary::INTS, values.size());
+  for (int const value : values) {
+    binary::append_u32(m_buffer, std::bit_cast<std::uint32_t>(value));
+  }
+  add(key, binary::Slot{binary::ARRAY, array});
+}
+
+void
+BinaryWriterImpl::write(std::string_view key, std::span<float const> values)
+{
+  std::uint32_t const array = begin_array(binary::FLOATS, values.size());
+  for (float const value : values) {
+    binary::append_u32(m_buffer, std::bit_cast<std::uint32_t>(value));
+  }
+  add(key, binary::Slot{binary::ARRAY, array});
+}
+
+void
+BinaryWriterImpl::write(std::string_view key, std::span<std::string const> values)
+{
+  std::vector<binary::Slot> slots;
+  slots.reserve(values.size());
+  for (std::string const& value : values) {
+    slots.push_back(binary::Slot{binary::STRING, emit_string(value)});
+  }
+  add(key, binary::Slot{binary::ARRAY, emit_slots(slots)});
+}
+
+void
+BinaryWriterImpl::write(std::string_view key, std::vector<bool> const& values)
+{
+  std::uint32_t const array = begin_array(binary::BOOLS, values.size());
+  for (bool const value : values) {
+    m_buffer += static_cast<char>(value ? 1 : 0);
+  }
+  add(key, binary::Slot{binary::ARRAY, array});
+}
+
+void
+BinaryWriterImpl::add(std::string_view key, binary::Slot value)
+{
+  assert(!m_stack.empty());
+  assert(m_stack.back().type == FrameType::OBJECT ||
+         m_stack.back().type == FrameType::MAPPING);
+
+  m_stack.back().entries.push_back(Entry{intern_key(key), value});
+}
+
+void
+BinaryWriterImpl::add(binary::Slot value)
+{
+  assert(!m_stack.empty());
+  assert(m_stack.back().type == FrameType::COLLECTION ||
+         (m_stack.back().type == FrameType::KEYVALUE && m_stack.back().slots.empty()));
+
+  m_stack.back().slots.push_back(value);
+}
+
+std::uint32_t
+BinaryWriterImpl::intern_key(std::string_view key)
+{
+  auto const it = m_keys.find(key);
+  if (it != m_keys.end()) {
+    return it->second;
+  }
+
+  std::uint32_t const offset = emit_string(key);
+  m_keys.emplace(std::string(key), offset);
+  return offset;
+}
+
+std::uint32_t
+BinaryWriterImpl::emit_string(std::string_view value)
+{
+  std::uint32_t const offset = tell();
+  binary::append_u32(m_buffer, static_cast<std::uint32_t>(value.size()));
+  m_buffer.append(value);
+  return offset;
+}
+
+std::uint32_t
+BinaryWriterImpl::emit_mapping(std::vector<Entry> const& entries)
+{
+  auto const key_text = [this](std::uint32_t key) {
+    return std::string_view(m_buffer).substr(key + 4, binary::load_u32(m_buffer, key));
+  };
+
+  // entries are stored sorted by key, order[] maps back to the order
+  // they were written in
+  std::vector<std::uint32_t> sorted(entries.size());
+  std::iota(sorted.begin(), sorted.end(), 0);
+  std::stable_sort(sorted.begin(), sorted.end(), [&](std::uint32_t lhs, std::uint32_t rhs) {
+    return entries[lhs].key != entries[rhs].key &&
+      key_text(entries[lhs].key) < key_text(entries[rhs].key);
+  });
+
+  std::vector<std::uint32_t> order(entries.size());
+  for (std::uint32_t i = 0; i < sorted.size(); ++i) {
+    order[sorted[i]] = i;
+  }
+
+  align();
+  std::uint32_t const offset = tell();
+  binary::append_u32(m_buffer, static_cast<std::uint32_t>(entries.size()));
+  for (std::uint32_t const index : sorted) {
+    binary::append_u32(m_buffer, entries[index].key);
+    binary::append_slot(m_buffer, entries[index].value);
+  }
+  for (std::uint32_t const index : order) {
+    binary::append_u32(m_buffer, index);
+  }
+  return offset;
+}
+
+std::uint32_t
+BinaryWriterImpl::emit_slots(std::span<binary::Slot const> slots)
+{
+  std::uint32_t const offset = begin_array(binary::SLOTS, slots.size());
+  for (binary::Slot const& slot : slots) {
+    binary::append_slot(m_buffer, slot);
+  }
+  return offset;
+}
+
+std::uint32_t
+BinaryWriterImpl::begin_array(binary::ArrayKind kind, std::size_t count)
+{
+  align();
+  std::uint32_t const offset = tell();
+  binary::append_u32(m_buffer, static_cast<std::uint32_t>(count));
+  char const head[4] = { static_cast<char>(kind), 0, 0, 0 };
+  m_buffer.append(head, 4);
+  return offset;
+}
+
+void
+BinaryWriterImpl::align()
+{
+  m_buffer.resize((m_buffer.size() + 3) & ~std::size_t{3}, '\0');
+}
+
+std::uint32_t
+BinaryWriterImpl::tell() const
+{
+  if (m_buffer.size() > std::numeric_limits<std::uint32_t>::max()) {
+    throw std::runtime_error("binary writer: documents larger than 4GiB are not supported");
+  }
+  return static_cast<std::uint32_t>(m_buffer.size());
+}
+
+void
+BinaryWriterImpl::flush(std::uint32_t root)
+{
+  m_buffer.replace(0, binary::MAGIC.size(), binary::MAGIC);
+  binary::store_u32(m_buffer, binary::MAGIC.size(), binary::VERSION);
+  binary::store_u32(m_buffer, binary::MAGIC.size() + 4, tell());
+  binary::store_u32(m_buffer, binary::MAGIC.size() + 8, root);
+
+  m_out.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+  m_buffer.clear();
+  m_keys.clear();
+}
+
+} // namespace prio
+
+/* EOF */
@@ -0,0 +1,117 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_PRIO_BINARY_WRITER_IMPL_HPP
+#define HEADER_PRIO_BINARY_WRITER_IMPL_HPP
+
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "binary_format.hpp"
+#include "writer_impl.hpp"
+
+namespace prio {
+
+/** Writes Format::BINARY documents, see binary_format.hpp. Nodes are
+    appended to an in-memory buffer as soon as they are complete, the
+    buffer is written out when the root object ends. */
+class BinaryWriterImpl final : public WriterImpl
+{
+public:
+  BinaryWriterImpl(std::ostream& out);
+  ~BinaryWriterImpl() override;
+
+  void begin_collection(std::string_view key) override;
+  void end_collection() override;
+
+  void begin_object(std::string_view type) override;
+  void end_object() override;
+
+  void begin_mapping(std::string_view key) override;
+  void end_mapping() override;
+
+  void begin_keyvalue(std::string_view key) override;
+  void end_keyvalue() override;
+
+  void write(std::string_view key, bool value) override;
+  void write(std::string_view key, int value) override;
+  void write(std::string_view key, float value) override;
+  void write(std::string_view key, char const* value) override;
+  void write(std::string_view key, std::string_view value) override;
+
+  void write(std::string_view key, std::span<bool const> values) override;
+  void write(std::string_view key, std::span<int const> values) override;
+  void write(std::string_view key, std::span<float const> values) override;
+  void write(std::string_view key, std::span<std::string const> values) override;
+
+  void write(std::string_view key, std::vector<bool> const& values) override;
+
+private:
+  enum class FrameType { OBJECT, MAPPING, COLLECTION, KEYVALUE };
+
+  struct Entry
+  {
+    std::uint32_t key; // offset of the key's string node
+    binary::Slot value;
+  };
+
+  struct Frame
+  {
+    FrameType type;
+    std::string key; // key in the parent mapping, type for objects
+    std::vector<Entry> entries; // members of mappings and objects
+    std::vector<binary::Slot> slots; // objects of collections or the keyvalue
+  };
+
+  struct KeyHash
+  {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view key) const { return std::hash<std::string_view>{}(key); }
+  };
+
+  void add(std::string_view key, binary::Slot value);
+  void add(binary::Slot value);
+
+  std::uint32_t intern_key(std::string_view key);
+  std::uint32_t emit_string(std::string_view value);
+  std::uint32_t emit_mapping(std::vector<Entry> const& entries);
+  std::uint32_t emit_slots(std::span<binary::Slot const> slots);
+  std::uint32_t begin_array(binary::ArrayKind kind, std::size_t count);
+  void align();
+  std::uint32_t tell() const;
+
+  void flush(std::uint32_t root);
+
+private:
+  std::ostream& m_out;
+  std::string m_buffer;
+  std::vector<Frame> m_stack;
+  std::unordered_map<std::string, std::uint32_t, KeyHash, std::equal_to<>> m_keys;
+
+private:
+  BinaryWriterImpl(const BinaryWriterImpl&) = delete;
+  BinaryWriterImpl& operator=(const BinaryWriterImpl&) = delete;
+};
+
+} // namespace prio
+
+#endif
+
+/* EOF */
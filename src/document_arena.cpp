@@ -0,0 +1,97 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "document_arena.hpp"
+
+#include <algorithm>
+
+namespace prio {
+
+DocumentArena::DocumentArena() :
+  m_mutex(),
+  m_resource(),
+  m_size(0),
+  m_strings(),
+  m_ids()
+{
+}
+
+DocumentArena::~DocumentArena()
+{
+}
+
+std::string_view
+DocumentArena::store(std::string_view text)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto const it = m_strings.find(text);
+  if (it != m_strings.end()) {
+    return *it;
+  }
+
+  std::string_view const result = copy(text);
+  m_strings.insert(result);
+  return result;
+}
+
+std::string_view
+DocumentArena::store(std::size_t id, std::string_view text)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto const it = m_ids.find(id);
+  if (it != m_ids.end()) {
+    return it->second;
+  }
+
+  std::string_view const result = copy(text);
+  m_ids.emplace(id, result);
+  return result;
+}
+
+std::optional<std::string_view>
+DocumentArena::find(std::size_t id) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto const it = m_ids.find(id);
+  if (it == m_ids.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+std::string_view
+DocumentArena::copy(std::string_view text)
+{
+  if (text.empty()) {
+    return {};
+  }
+
+  char* const data = static_cast<char*>(m_resource.allocate(text.size(), alignof(char)));
+  m_size += text.size();
+  std::copy(text.begin(), text.end(), data);
+  return std::string_view(data, text.size());
+}
+
+std::size_t
+DocumentArena::get_size() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_size;
+}
+
+} // namespace prio
+
+/* EOF */
@@ -0,0 +1,211 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "document_cache.hpp"
+
+#include <exception>
+#include <system_error>
+#include <utility>
+
+namespace prio {
+
+namespace {
+
+/** Returns the path that identifies @a filename, so that different
+    spellings of the same path share a document */
+std::string get_key_path(std::filesystem::path const& filename)
+{
+  std::error_code ec;
+  std::filesystem::path const canonical = std::filesystem::weakly_canonical(filename, ec);
+  return (ec ? filename.lexically_normal() : canonical).string();
+}
+
+} // namespace
+
+DocumentCache::DocumentCache(std::size_t memory_budget) :
+  m_mutex(),
+  m_entries(),
+  m_lru(),
+  m_memory_budget(memory_budget),
+  m_memory_usage(0),
+  m_next_id(0)
+{
+}
+
+DocumentCache::~DocumentCache()
+{
+}
+
+DocumentCache::Handle
+DocumentCache::from_file(Format format, std::filesystem::path const& filename, ErrorHandler error_handler)
+{
+  Key key{get_key_path(filename), format, error_handler};
+
+  std::promise<Handle> promise;
+  std::uint64_t id;
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    auto const it = m_entries.find(key);
+    if (it != m_entries.end()) {
+      if (it->second.document) {
+        Handle document = it->second.document;
+        m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+        update(it);
+        if (m_memory_usage > m_memory_budget) {
+          evict();
+        }
+        return document;
+      }
+
+      // another thread is loading the document
+      std::shared_future<Handle> const future = it->second.future;
+      lock.unlock();
+      return future.get();
+    }
+
+    id = m_next_id++;
+    m_entries.emplace(key, Entry{id, promise.get_future().share(), {}, 0, m_lru.end()});
+  }
+
+  Handle document;
+  try {
+    document = std::make_shared<ReaderDocument const>(ReaderDocument::from_file(format, filename, error_handler));
+  } catch (...) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      auto const it = m_entries.find(key);
+      if (it != m_entries.end() && it->second.id == id) {
+        m_entries.erase(it);
+      }
+    }
+    promise.set_exception(std::current_exception());
+    throw;
+  }
+
+  std::size_t const memory_usage = document->get_memory_usage();
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // the entry is gone or replaced if erase() or clear() were called
+    // while loading
+    auto const it = m_entries.find(key);
+    if (it != m_entries.end() && it->second.id == id) {
+      it->second.document = document;
+      it->second.memory_usage = memory_usage;
+      it->second.lru = m_lru.insert(m_lru.begin(), it);
+      m_memory_usage += memory_usage;
+      evict();
+    }
+  }
+  promise.set_value(document);
+
+  return document;
+}
+
+DocumentCache::Handle
+DocumentCache::from_file(std::filesystem::path const& filename, ErrorHandler error_handler)
+{
+  return from_file(Format::AUTO, filename, error_handler);
+}
+
+void
+DocumentCache::erase(std::filesystem::path const& filename)
+{
+  std::string const path = get_key_path(filename);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_entries.lower_bound(Key{path, Format{}, ErrorHandler{}});
+  while (it != m_entries.end() && std::get<0>(it->first) == path) {
+    remove(it++);
+  }
+}
+
+void
+DocumentCache::clear()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  while (!m_entries.empty()) {
+    remove(m_entries.begin());
+  }
+}
+
+void
+DocumentCache::set_memory_budget(std::size_t memory_budget)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_memory_budget = memory_budget;
+  evict();
+}
+
+std::size_t
+DocumentCache::get_memory_budget() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_memory_budget;
+}
+
+std::size_t
+DocumentCache::get_memory_usage() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_memory_usage;
+}
+
+std::size_t
+DocumentCache::size() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_lru.size();
+}
+
+void
+DocumentCache::update(Entries::iterator it)
+{
+  std::size_t const memory_usage = it->second.document->get_memory_usage();
+  m_memory_usage = m_memory_usage - it->second.memory_usage + memory_usage;
+  it->second.memory_usage = memory_usage;
+}
+
+void
+DocumentCache::evict()
+{
+  // documents that were handed out may have grown since they were last
+  // accounted for
+  for (Entries::iterator it : m_lru) {
+    update(it);
+  }
+
+  // a document larger than the whole budget is evicted right away, the
+  // caller that loaded it still gets it
+  while (m_memory_usage > m_memory_budget && !m_lru.empty()) {
+    remove(m_lru.back());
+  }
+}
+
+void
+DocumentCache::remove(Entries::iterator it)
+{
+  if (it->second.document) {
+    m_memory_usage -= it->second.memory_usage;
+    m_lru.erase(it->second.lru);
+  }
+  m_entries.erase(it);
+}
+
+} // namespace prio
+
+/* EOF */
@@ -0,0 +1,899 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "fastjson_parser.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#  include <immintrin.h>
+#  define PRIO_FASTJSON_AVX2
+#endif
+
+#include "reader_error.hpp"
+#include "value_boundary.hpp"
+
+namespace prio {
+
+namespace {
+
+constexpr std::size_t BLOCK_SIZE = 64;
+constexpr int MAX_DEPTH = 1024;
+
+/** Per-block bitmasks, bit i is set when byte i of the block belongs to
+    the given character class */
+struct BlockMasks
+{
+  std::uint64_t backslash;
+  std::uint64_t quote;
+  std::uint64_t whitespace;
+  std::uint64_t op;
+
+  /** the subset of op that opens or closes an object or array */
+  std::uint64_t bracket;
+};
+
+inline bool is_whitespace(char c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+inline bool is_bracket(char c)
+{
+  return c == '{' || c == '}' || c == '[' || c == ']';
+}
+
+inline bool is_operator(char c)
+{
+  return is_bracket(c) || c == ':' || c == ',';
+}
+
+inline bool is_digit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+#ifndef __SSE2__
+void classify_block_scalar(char const* block, BlockMasks& masks)
+{
+  masks = BlockMasks{0, 0, 0, 0, 0};
+  for (std::size_t i = 0; i < BLOCK_SIZE; ++i) {
+    std::uint64_t const bit = std::uint64_t{1} << i;
+    char const c = block[i];
+    if (c == '\\') {
+      masks.backslash |= bit;
+    } else if (c == '"') {
+      masks.quote |= bit;
+    } else if (is_whitespace(c)) {
+      masks.whitespace |= bit;
+    } else if (is_operator(c)) {
+      masks.op |= bit;
+      if (is_bracket(c)) {
+        masks.bracket |= bit;
+      }
+    }
+  }
+}
+#endif
+
+#ifdef __SSE2__
+inline std::uint64_t movemask(__m128i value, int shift)
+{
+  return static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm_movemask_epi8(value))) << shift;
+}
+
+void classify_block_sse2(char const* block, BlockMasks& masks)
+{
+  masks = BlockMasks{0, 0, 0, 0, 0};
+  for (int i = 0; i < 4; ++i) {
+    __m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(block + 16 * i));
+    auto eq = [&v](char c) { return _mm_cmpeq_epi8(v, _mm_set1_epi8(c)); };
+
+    __m128i const ws = _mm_or_si128(_mm_or_si128(eq(' '), eq('\t')),
+                                    _mm_or_si128(eq('\n'), eq('\r')));
+    __m128i const bracket = _mm_or_si128(_mm_or_si128(eq('{'), eq('}')),
+                                         _mm_or_si128(eq('['), eq(']')));
+    __m128i const op = _mm_or_si128(bracket, _mm_or_si128(eq(':'), eq(',')));
+
+    masks.backslash |= movemask(eq('\\'), 16 * i);
+    masks.quote |= movemask(eq('"'), 16 * i);
+    masks.whitespace |= movemask(ws, 16 * i);
+    masks.op |= movemask(op, 16 * i);
+    masks.bracket |= movemask(bracket, 16 * i);
+  }
+}
+#endif
+
+#ifdef PRIO_FASTJSON_AVX2
+// lambdas don't inherit the target attribute, so no helper lambdas here
+__attribute__((target("avx2")))
+inline __m256i eq_avx2(__m256i v, char c)
+{
+  return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c));
+}
+
+__attribute__((target("avx2")))
+inline std::uint64_t movemask_avx2(__m256i value, int shift)
+{
+  return static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(value))) << shift;
+}
+
+__attribute__((target("avx2")))
+void classify_block_avx2(char const* block, BlockMasks& masks)
+{
+  masks = BlockMasks{0, 0, 0, 0, 0};
+  for (int i = 0; i < 2; ++i) {
+    __m256i const v = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(block + 32 * i));
+
+    __m256i const ws = _mm256_or_si256(_mm256_or_si256(eq_avx2(v, ' '), eq_avx2(v, '\t')),
+                                       _mm256_or_si256(eq_avx2(v, '\n'), eq_avx2(v, '\r')));
+    __m256i const bracket = _mm256_or_si256(_mm256_or_si256(eq_avx2(v, '{'), eq_avx2(v, '}')),
+                                            _mm256_or_si256(eq_avx2(v, '['), eq_avx2(v, ']')));
+    __m256i const op = _mm256_or_si256(bracket, _mm256_or_si256(eq_avx2(v, ':'), eq_avx2(v, ',')));
+
+    masks.backslash |= movemask_avx2(eq_avx2(v, '\\'), 32 * i);
+    masks.quote |= movemask_avx2(eq_avx2(v, '"'), 32 * i);
+    masks.whitespace |= movemask_avx2(ws, 32 * i);
+    masks.op |= movemask_avx2(op, 32 * i);
+    masks.bracket |= movemask_avx2(bracket, 32 * i);
+  }
+}
+
+bool has_avx2()
+{
+  static bool const result = __builtin_cpu_supports("avx2");
+  return result;
+}
+#endif
+
+inline void classify_block(char const* block, BlockMasks& masks)
+{
+#ifdef __SSE2__
+  classify_block_sse2(block, masks);
+#else
+  classify_block_scalar(block, masks);
+#endif
+}
+
+/** Carry-less prefix sum: bit i of the result is the XOR of bits 0..i */
+inline std::uint64_t prefix_xor(std::uint64_t bits)
+{
+  bits ^= bits << 1;
+  bits ^= bits << 2;
+  bits ^= bits << 4;
+  bits ^= bits << 8;
+  bits ^= bits << 16;
+  bits ^= bits << 32;
+  return bits;
+}
+
+/** Turns the per-block character classes into the structural bitmap,
+    carrying string, escape and scalar state across block boundaries. */
+class StructuralScanner
+{
+public:
+  StructuralScanner() :
+    m_prev_escaped(0),
+    m_prev_in_string(0),
+    m_prev_scalar(0)
+  {}
+
+  std::uint64_t next(BlockMasks const& masks)
+  {
+    std::uint64_t quote;
+    std::uint64_t const string_tail = next_string_tail(masks, quote);
+
+    std::uint64_t const scalar = ~(masks.op | masks.whitespace);
+    std::uint64_t const nonquote_scalar = scalar & ~quote;
+    std::uint64_t const follows_nonquote_scalar = (nonquote_scalar << 1) | m_prev_scalar;
+    m_prev_scalar = nonquote_scalar >> 63;
+
+    std::uint64_t const scalar_start = scalar & ~follows_nonquote_scalar;
+    return (masks.op | scalar_start) & ~string_tail;
+  }
+
+  /** Cheaper variant of next() for splitting values: returns all
+      non-whitespace characters outside of strings, opening quotes
+      included */
+  std::uint64_t next_non_whitespace(BlockMasks const& masks)
+  {
+    std::uint64_t quote;
+    return ~masks.whitespace & ~next_string_tail(masks, quote);
+  }
+
+private:
+  /** Returns the mask of everything inside a string including the
+      closing quote, @a quote receives the unescaped quotes */
+  std::uint64_t next_string_tail(BlockMasks const& masks, std::uint64_t& quote)
+  {
+    std::uint64_t const escaped = find_escaped(masks.backslash);
+    quote = masks.quote & ~escaped;
+
+    std::uint64_t const in_string = prefix_xor(quote) ^ m_prev_in_string;
+    m_prev_in_string = static_cast<std::uint64_t>(static_cast<std::int64_t>(in_string) >> 63);
+
+    return in_string ^ quote;
+  }
+
+  /** Returns the mask of characters escaped by an odd-length run of
+      backslashes, see "Parsing Gigabytes of JSON per Second" */
+  std::uint64_t find_escaped(std::uint64_t backslash)
+  {
+    constexpr std::uint64_t even_bits = 0x5555555555555555ULL;
+
+    backslash &= ~m_prev_escaped;
+    std::uint64_t const follows_escape = (backslash << 1) | m_prev_escaped;
+    std::uint64_t const odd_sequence_starts = backslash & ~even_bits & ~follows_escape;
+    std::uint64_t const sequences_starting_on_even_bits = odd_sequence_starts + backslash;
+    m_prev_escaped = (sequences_starting_on_even_bits < odd_sequence_starts) ? 1 : 0;
+    std::uint64_t const invert_mask = sequences_starting_on_even_bits << 1;
+    return (even_bits ^ invert_mask) & follows_escape;
+  }
+
+private:
+  std::uint64_t m_prev_escaped;
+  std::uint64_t m_prev_in_string;
+  std::uint64_t m_prev_scalar;
+};
+
+/** Classifies @a text in 64 byte blocks and calls
+    @a visitor(offset, masks, scanner) for each of them, the final
+    partial block is padded with whitespace */
+template<void (*Classify)(char const*, BlockMasks&), typename Visitor>
+void scan_blocks(std::string_view text, Visitor& visitor)
+{
+  StructuralScanner scanner;
+  BlockMasks masks;
+
+  std::size_t offset = 0;
+  for (; offset + BLOCK_SIZE <= text.size(); offset += BLOCK_SIZE) {
+    Classify(text.data() + offset, masks);
+    visitor(offset, masks, scanner);
+  }
+
+  if (offset < text.size()) {
+    char block[BLOCK_SIZE];
+    std::memset(block, ' ', BLOCK_SIZE);
+    std::memcpy(block, text.data() + offset, text.size() - offset);
+    Classify(block, masks);
+    visitor(offset, masks, scanner);
+  }
+}
+
+/** Picks the widest block classifier the CPU supports at runtime */
+template<typename Visitor>
+void scan_structural(std::string_view text, Visitor& visitor)
+{
+#ifdef PRIO_FASTJSON_AVX2
+  if (has_avx2()) {
+    scan_blocks<classify_block_avx2>(text, visitor);
+    return;
+  }
+#endif
+  scan_blocks<classify_block>(text, visitor);
+}
+
+void flatten_bits(std::vector<std::uint32_t>& index, std::uint32_t base, std::uint64_t bits)
+{
+  while (bits != 0) {
+    index.push_back(base + static_cast<std::uint32_t>(std::countr_zero(bits)));
+    bits &= bits - 1;
+  }
+}
+
+void check_size(std::string_view text)
+{
+  if (text.size() >= UINT32_MAX) {
+    throw ReaderError("json parse error: input larger than 4GiB is not supported");
+  }
+}
+
+std::string location(std::string_view text, std::size_t offset)
+{
+  offset = std::min(offset, text.size());
+  std::string_view const head = text.substr(0, offset);
+  std::size_t const line = static_cast<std::size_t>(std::count(head.begin(), head.end(), '\n')) + 1;
+  std::size_t const line_start = head.rfind('\n');
+  std::size_t const column = (line_start == std::string_view::npos) ? offset + 1 : offset - line_start;
+  return std::format("line {}, column {}", line, column);
+}
+
+void append_utf8(std::string& out, std::uint32_t codepoint)
+{
+  if (codepoint < 0x80) {
+    out += static_cast<char>(codepoint);
+  } else if (codepoint < 0x800) {
+    out += static_cast<char>(0xc0 | (codepoint >> 6));
+    out += static_cast<char>(0x80 | (codepoint & 0x3f));
+  } else if (codepoint < 0x10000) {
+    out += static_cast<char>(0xe0 | (codepoint >> 12));
+    out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3f));
+    out += static_cast<char>(0x80 | (codepoint & 0x3f));
+  } else {
+    out += static_cast<char>(0xf0 | (codepoint >> 18));
+    out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3f));
+    out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3f));
+    out += static_cast<char>(0x80 | (codepoint & 0x3f));
+  }
+}
+
+[[noreturn]]
+void parse_error(std::string_view text, std::size_t offset, std::string_view message)
+{
+  throw ReaderError(std::format("json parse error: {}: {}", location(text, offset), message));
+}
+
+std::uint32_t parse_hex4(std::string_view text, std::size_t p)
+{
+  if (p + 4 > text.size()) {
+    parse_error(text, p, "truncated unicode escape");
+  }
+
+  std::uint32_t value = 0;
+  auto const result = std::from_chars(text.data() + p, text.data() + p + 4, value, 16);
+  if (result.ec != std::errc() || result.ptr != text.data() + p + 4) {
+    parse_error(text, p, "invalid unicode escape");
+  }
+  return value;
+}
+
+/** Handles the escape sequence at @a p, appends the decoded character
+    to @a out when given and returns the offset following the sequence */
+std::size_t scan_escape(std::string_view text, std::size_t p, std::string* out)
+{
+  if (p + 1 >= text.size()) {
+    parse_error(text, p, "unterminated escape sequence");
+  }
+
+  char decoded;
+  switch (text[p + 1]) {
+    case '"': decoded = '"'; break;
+    case '\\': decoded = '\\'; break;
+    case '/': decoded = '/'; break;
+    case 'b': decoded = '\b'; break;
+    case 'f': decoded = '\f'; break;
+    case 'n': decoded = '\n'; break;
+    case 'r': decoded = '\r'; break;
+    case 't': decoded = '\t'; break;
+
+    case 'u': {
+      std::uint32_t codepoint = parse_hex4(text, p + 2);
+      p += 6;
+      if (codepoint >= 0xd800 && codepoint <= 0xdbff) {
+        if (p + 1 >= text.size() || text[p] != '\\' || text[p + 1] != 'u') {
+          parse_error(text, p, "expected low surrogate after high surrogate");
+        }
+        std::uint32_t const low = parse_hex4(text, p + 2);
+        if (low < 0xdc00 || low > 0xdfff) {
+          parse_error(text, p, "invalid low surrogate");
+        }
+        codepoint = 0x10000 + ((codepoint - 0xd800) << 10) + (low - 0xdc00);
+        p += 6;
+      }
+      if (out) {
+        append_utf8(*out, codepoint);
+      }
+      return p;
+    }
+
+    default:
+      parse_error(text, p, "invalid escape sequence");
+  }
+
+  if (out) {
+    *out += decoded;
+  }
+  return p + 2;
+}
+
+/** Walks the string whose opening quote is at @a begin, validating
+    escape sequences and appending the decoded text to @a out when given.
+    Returns the offset of the closing quote. */
+std::size_t scan_string(std::string_view text, std::size_t begin, std::string* out, bool& escaped)
+{
+  std::size_t p = begin + 1;
+  escaped = false;
+  while (true) {
+    std::size_t const special = text.find_first_of("\"\\", p);
+    if (special == std::string_view::npos) {
+      parse_error(text, begin, "unterminated string");
+    }
+
+    if (out) {
+      out->append(text.substr(p, special - p));
+    }
+
+    if (text[special] == '"') {
+      return special;
+    }
+
+    escaped = true;
+    p = scan_escape(text, special, out);
+  }
+}
+
+} // namespace
+
+std::vector<std::uint32_t>
+fastjson_structural_index(std::string_view text)
+{
+  check_size(text);
+
+  std::vector<std::uint32_t> index;
+  index.reserve(text.size() / 8 + 16);
+
+  auto visitor = [&index](std::size_t offset, BlockMasks const& masks, StructuralScanner& scanner) {
+    flatten_bits(index, static_cast<std::uint32_t>(offset), scanner.next(masks));
+  };
+  scan_structural(text, visitor);
+
+  return index;
+}
+
+std::vector<std::uint32_t>
+fastjson_structural_index_fallback(std::string_view text)
+{
+  check_size(text);
+
+  std::vector<std::uint32_t> index;
+
+  bool escape = false;
+  bool in_string = false;
+  bool prev_nonquote_scalar = false;
+  for (std::size_t i = 0; i < text.size(); ++i) {
+    char const c = text[i];
+
+    bool const escaped = escape;
+    escape = !escaped && c == '\\';
+
+    // everything inside a string including the closing quote
+    bool const quote = !escaped && c == '"';
+    bool const string_tail = in_string;
+    if (quote) {
+      in_string = !in_string;
+    }
+
+    bool const op = is_operator(c);
+    bool const scalar = !op && !is_whitespace(c);
+    bool const scalar_start = scalar && !prev_nonquote_scalar;
+    prev_nonquote_scalar = scalar && !quote;
+
+    if ((op || scalar_start) && !string_tail) {
+      index.push_back(static_cast<std::uint32_t>(i));
+    }
+  }
+
+  return index;
+}
+
+std::vector<std::string_view>
+fastjson_split_values(std::string_view text)
+{
+  std::vector<std::string_view> values;
+  char const* const data = text.data();
+
+  int depth = 0;
+  std::size_t begin = 0;
+
+  // end of a top-level scalar, structural characters before it are
+  // part of that scalar
+  std::size_t skip_until = 0;
+
+  auto visitor = [&](std::size_t offset, BlockMasks const& masks, StructuralScanner& scanner) {
+    // inside a value only brackets are of interest
+    std::uint64_t remaining = scanner.next_non_whitespace(masks);
+    while (true) {
+      std::uint64_t const candidates = (depth > 0) ? (remaining & masks.bracket) : remaining;
+      if (candidates == 0) {
+        return;
+      }
+
+      int const bit = std::countr_zero(candidates);
+      remaining &= ~((std::uint64_t{2} << bit) - 1);
+
+      std::size_t const p = offset + static_cast<std::size_t>(bit);
+      if (p < skip_until) {
+        continue;
+      }
+
+      switch (char const c = data[p]) {
+        case '{':
+        case '[':
+          if (depth == 0) {
+            begin = p;
+          }
+          depth += 1;
+          break;
+
+        case '}':
+        case ']':
+          if (depth == 0) {
+            parse_error(text, p, std::format("unexpected '{}'", c));
+          }
+          depth -= 1;
+          if (depth == 0) {
+            values.emplace_back(data + begin, p + 1 - begin);
+          }
+          break;
+
+        case ':':
+        case ',':
+          parse_error(text, p, std::format("unexpected '{}'", c));
+
+        default: {
+          // top-level string, number or literal
+          char const* const end = json_value_end(data + p, data + text.size());
+          if (!end) {
+            parse_error(text, p, "incomplete or invalid JSON value");
+          }
+          skip_until = static_cast<std::size_t>(end - data);
+          values.emplace_back(data + p, skip_until - p);
+          break;
+        }
+      }
+    }
+  };
+  scan_structural(text, visitor);
+
+  if (depth > 0) {
+    parse_error(text, begin, "incomplete JSON value");
+  }
+
+  return values;
+}
+
+class FastJsonParser final
+{
+public:
+  FastJsonParser(std::string_view text, std::vector<std::uint32_t> const& index, FastJsonTape& tape) :
+    m_text(text),
+    m_index(index),
+    m_pos(0),
+    m_tape(tape)
+  {
+    m_tape.m_entries.reserve(m_index.size());
+  }
+
+  void parse()
+  {
+    if (m_index.empty()) {
+      error(m_text.size(), "document is empty");
+    }
+    parse_value(0);
+  }
+
+private:
+  std::uint32_t offset() const
+  {
+    if (m_pos >= m_index.size()) {
+      error(m_text.size(), "unexpected end of input");
+    }
+    return m_index[m_pos];
+  }
+
+  char peek() const { return m_text[offset()]; }
+
+  FastJsonTape::Entry& push(FastJsonTape::Type type, std::uint32_t source)
+  {
+    FastJsonTape::Entry entry{};
+    entry.type = type;
+    entry.source = source;
+    m_tape.m_entries.push_back(entry);
+    return m_tape.m_entries.back();
+  }
+
+  void parse_value(int depth)
+  {
+    if (depth > MAX_DEPTH) {
+      error(offset(), "document nested too deeply");
+    }
+
+    std::uint32_t const begin = offset();
+    char const c = m_text[begin];
+    switch (c) {
+      case '{':
+        parse_container(depth, FastJsonTape::Type::OBJECT, '}');
+        break;
+
+      case '[':
+        parse_container(depth, FastJsonTape::Type::ARRAY, ']');
+        break;
+
+      case '"':
+        parse_string(begin);
+        m_pos += 1;
+        break;
+
+      case 't':
+        parse_literal(begin, "true");
+        break;
+
+      case 'f':
+        parse_literal(begin, "false");
+        break;
+
+      case 'n':
+        parse_literal(begin, "null");
+        break;
+
+      default:
+        if (c == '-' || is_digit(c)) {
+          parse_number(begin);
+        } else {
+          error(begin, std::format("unexpected character '{}'", c));
+        }
+        break;
+    }
+  }
+
+  void parse_container(int depth, FastJsonTape::Type type, char close)
+  {
+    std::size_t const entry_index = m_tape.m_entries.size();
+    push(type, offset());
+    m_pos += 1;
+
+    if (peek() == close) {
+      finish_container(entry_index);
+      return;
+    }
+
+    while (true) {
+      if (type == FastJsonTape::Type::OBJECT) {
+        if (peek() != '"') {
+          error(offset(), "expected string as object key");
+        }
+        parse_string(offset());
+        m_pos += 1;
+
+        if (peek() != ':') {
+          error(offset(), "expected ':' after object key");
+        }
+        m_pos += 1;
+      }
+
+      parse_value(depth + 1);
+
+      char const c = peek();
+      if (c == close) {
+        finish_container(entry_index);
+        return;
+      } else if (c == ',') {
+        m_pos += 1;
+      } else {
+        error(offset(), std::format("expected ',' or '{}'", close));
+      }
+    }
+  }
+
+  void finish_container(std::size_t entry_index)
+  {
+    FastJsonTape::Entry& entry = m_tape.m_entries[entry_index];
+    entry.link = static_cast<std::uint32_t>(m_tape.m_entries.size());
+    entry.length = offset() - entry.source + 1;
+    m_pos += 1;
+  }
+
+  void parse_string(std::uint32_t begin)
+  {
+    bool escaped = false;
+    std::size_t const close = scan_string(m_text, begin, nullptr, escaped);
+
+    FastJsonTape::Entry& entry = push(FastJsonTape::Type::STRING, begin);
+    entry.escaped = escaped;
+    entry.length = static_cast<std::uint32_t>(close + 1 - begin);
+  }
+
+  void parse_literal(std::uint32_t begin, std::string_view literal)
+  {
+    if (m_text.substr(begin, literal.size()) != literal || !is_delimiter(begin + literal.size())) {
+      error(begin, "invalid literal");
+    }
+    m_pos += 1;
+
+    FastJsonTape::Entry& entry = push(literal == "null" ? FastJsonTape::Type::NULL_VALUE : FastJsonTape::Type::BOOLEAN, begin);
+    entry.length = static_cast<std::uint32_t>(literal.size());
+  }
+
+  void parse_number(std::uint32_t begin)
+  {
+    std::size_t p = begin;
+    bool integral = true;
+
+    if (m_text[p] == '-') {
+      ++p;
+    }
+
+    if (p >= m_text.size() || !is_digit(m_text[p])) {
+      error(begin, "invalid number");
+    } else if (m_text[p] == '0') {
+      ++p;
+    } else {
+      p = skip_digits(p);
+    }
+
+    if (p < m_text.size() && m_text[p] == '.') {
+      integral = false;
+      if (p + 1 >= m_text.size() || !is_digit(m_text[p + 1])) {
+        error(begin, "invalid number");
+      }
+      p = skip_digits(p + 1);
+    }
+
+    if (p < m_text.size() && (m_text[p] == 'e' || m_text[p] == 'E')) {
+      integral = false;
+      ++p;
+      if (p < m_text.size() && (m_text[p] == '+' || m_text[p] == '-')) {
+        ++p;
+      }
+      if (p >= m_text.size() || !is_digit(m_text[p])) {
+        error(begin, "invalid number");
+      }
+      p = skip_digits(p);
+    }
+
+    if (!is_delimiter(p)) {
+      error(begin, "invalid number");
+    }
+
+    m_pos += 1;
+
+    // the value itself is decoded on access
+    FastJsonTape::Entry& entry = push(integral ? FastJsonTape::Type::INTEGER : FastJsonTape::Type::REAL, begin);
+    entry.length = static_cast<std::uint32_t>(p - begin);
+  }
+
+  std::size_t skip_digits(std::size_t p) const
+  {
+    while (p < m_text.size() && is_digit(m_text[p])) {
+      ++p;
+    }
+    return p;
+  }
+
+  bool is_delimiter(std::size_t p) const
+  {
+    return p >= m_text.size() || is_whitespace(m_text[p]) || is_operator(m_text[p]);
+  }
+
+  [[noreturn]]
+  void error(std::size_t offset, std::string_view message) const
+  {
+    parse_error(m_text, offset, message);
+  }
+
+private:
+  std::string_view m_text;
+  std::vector<std::uint32_t> const& m_index;
+  std::size_t m_pos;
+  FastJsonTape& m_tape;
+
+private:
+  FastJsonParser(FastJsonParser const&) = delete;
+  FastJsonParser& operator=(FastJsonParser const&) = delete;
+};
+
+FastJsonTape
+fastjson_parse(std::string_view text)
+{
+  std::vector<std::uint32_t> const index = fastjson_structural_index(text);
+
+  FastJsonTape tape;
+  FastJsonParser parser(text, index, tape);
+  parser.parse();
+  return tape;
+}
+
+void
+fastjson_decode_string(std::string_view quoted, std::string& out)
+{
+  bool escaped;
+  scan_string(quoted, 0, &out, escaped);
+}
+
+bool
+FastJsonTape::get_bool(std::string_view source, std::uint32_t index) const
+{
+  return source[m_entries[index].source] == 't';
+}
+
+bool
+FastJsonTape::get_integer(std::string_view source, std::uint32_t index, std::int64_t& value) const
+{
+  std::string_view const text = get_source_text(source, index);
+  auto const result = std::from_chars(text.data(), text.data() + text.size(), value);
+  return result.ec == std::errc();
+}
+
+double
+FastJsonTape::get_real(std::string_view source, std::uint32_t index) const
+{
+  std::string_view const text = get_source_text(source, index);
+  double value = 0.0;
+  auto const result = std::from_chars(text.data(), text.data() + text.size(), value);
+  if (result.ec == std::errc::result_out_of_range) {
+    // from_chars() leaves the value untouched, strtod() saturates like jsoncpp
+    return std::strtod(std::string(text).c_str(), nullptr);
+  }
+  return value;
+}
+
+std::string_view
+FastJsonTape::get_raw_string(std::string_view source, std::uint32_t index) const
+{
+  Entry const& entry = m_entries[index];
+  return source.substr(entry.source + 1, entry.length - 2);
+}
+
+std::string
+FastJsonTape::get_string(std::string_view source, std::uint32_t index) const
+{
+  Entry const& entry = m_entries[index];
+  if (!entry.escaped) {
+    return std::string(get_raw_string(source, index));
+  }
+
+  std::string result;
+  bool escaped;
+  scan_string(source, entry.source, &result, escaped);
+  return result;
+}
+
+bool
+FastJsonTape::string_equals(std::string_view source, std::uint32_t index, std::string_view text) const
+{
+  if (!m_entries[index].escaped) {
+    return get_raw_string(source, index) == text;
+  } else {
+    return get_string(source, index) == text;
+  }
+}
+
+std::uint32_t
+FastJsonTape::find_member(std::string_view source, std::uint32_t index, std::string_view key) const
+{
+  Entry const& object = m_entries[index];
+  if (object.type != Type::OBJECT) {
+    return npos;
+  }
+
+  std::uint32_t result = npos;
+  for (std::uint32_t i = index + 1; i < object.link; i = next(i + 1)) {
+    if (string_equals(source, i, key)) {
+      result = i + 1;
+    }
+  }
+  return result;
+}
+
+std::string_view
+FastJsonTape::get_source_text(std::string_view source, std::uint32_t index) const
+{
+  Entry const& entry = m_entries[index];
+  return source.substr(entry.source, entry.length);
+}
+
+} // namespace prio
+
+/* EOF */
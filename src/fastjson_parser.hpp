@@ -0,0 +1,151 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_PRIO_FASTJSON_PARSER_HPP
+#define HEADER_PRIO_FASTJSON_PARSER_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace prio {
+
+/** Flat representation of a parsed JSON document. Values are stored in
+    document order, containers are followed by their children and know
+    the index one past their last child, so siblings can be skipped
+    without walking the subtree.
+
+    The tape only records where each value is found in the source text,
+    numbers and strings are validated while parsing but only decoded when
+    they are accessed. */
+class FastJsonTape final
+{
+public:
+  enum class Type : std::uint8_t
+  {
+    NULL_VALUE,
+    BOOLEAN,
+    INTEGER,
+    REAL,
+    STRING,
+    ARRAY,
+    OBJECT
+  };
+
+  struct Entry
+  {
+    Type type;
+
+    /** STRING: the string contains escape sequences */
+    bool escaped;
+
+    /** ARRAY/OBJECT: tape index one past the last child */
+    std::uint32_t link;
+
+    /** offset and length of the value in the source text, containers
+        include the closing bracket, strings the quotes */
+    std::uint32_t source;
+    std::uint32_t length;
+  };
+
+public:
+  FastJsonTape() : m_entries() {}
+
+  /** Restores a tape from entries previously obtained from
+      get_entries(), used by ParseCache */
+  explicit FastJsonTape(std::vector<Entry> entries) : m_entries(std::move(entries)) {}
+
+  std::vector<Entry> const& get_entries() const { return m_entries; }
+
+  Entry const& operator[](std::uint32_t index) const { return m_entries[index]; }
+  std::uint32_t size() const { return static_cast<std::uint32_t>(m_entries.size()); }
+
+  /** Returns the number of bytes held by the tape */
+  std::size_t get_memory_usage() const { return sizeof(*this) + m_entries.capacity() * sizeof(Entry); }
+
+  /** Returns the index of the value following the one at @a index */
+  std::uint32_t next(std::uint32_t index) const {
+    Entry const& entry = m_entries[index];
+    return (entry.type == Type::ARRAY || entry.type == Type::OBJECT) ? entry.link : index + 1;
+  }
+
+  bool get_bool(std::string_view source, std::uint32_t index) const;
+
+  /** Decodes the INTEGER at @a index, returns false if it doesn't fit
+      into 64 bits */
+  bool get_integer(std::string_view source, std::uint32_t index, std::int64_t& value) const;
+
+  /** Decodes the INTEGER or REAL at @a index */
+  double get_real(std::string_view source, std::uint32_t index) const;
+
+  /** Returns the text between the quotes of the STRING at @a index,
+      escape sequences are left as is */
+  std::string_view get_raw_string(std::string_view source, std::uint32_t index) const;
+
+  /** Returns the decoded STRING at @a index */
+  std::string get_string(std::string_view source, std::uint32_t index) const;
+
+  /** Compares the decoded STRING at @a index with @a text */
+  bool string_equals(std::string_view source, std::uint32_t index, std::string_view text) const;
+
+  /** Returns the index of the member value named @a key in the object at
+      @a index; like jsoncpp the last of several duplicate keys wins */
+  std::uint32_t find_member(std::string_view source, std::uint32_t index, std::string_view key) const;
+
+  /** Returns the raw source text of the value at @a index */
+  std::string_view get_source_text(std::string_view source, std::uint32_t index) const;
+
+  static constexpr std::uint32_t npos = UINT32_MAX;
+
+private:
+  friend class FastJsonParser;
+
+  std::vector<Entry> m_entries;
+};
+
+/** Stage 1: classifies @a text in 64 byte blocks (SSE2 when available,
+    scalar otherwise) and returns the offsets of all structural
+    characters and the first character of every scalar. */
+std::vector<std::uint32_t> fastjson_structural_index(std::string_view text);
+
+/** Scalar reference implementation of fastjson_structural_index() */
+std::vector<std::uint32_t> fastjson_structural_index_fallback(std::string_view text);
+
+/** Splits a sequence of whitespace separated JSON values, such as JSON
+    Lines or concatenated values, into the individual top-level values.
+    Uses the stage 1 classifier (AVX2 or SSE2 when available, scalar
+    otherwise) so the input is scanned once, 64 bytes at a time. Only the
+    nesting is checked, the values themselves are not validated. Throws
+    ReaderError on unbalanced brackets or incomplete values. */
+std::vector<std::string_view> fastjson_split_values(std::string_view text);
+
+/** Stage 2: builds a FastJsonTape for the first JSON value in @a text.
+    Trailing content after that value is ignored, as jsoncpp does by
+    default. Throws ReaderError on malformed input. */
+FastJsonTape fastjson_parse(std::string_view text);
+
+/** Appends the decoded contents of the string literal @a quoted, which
+    includes the surrounding quotes, to @a out. Throws ReaderError on
+    invalid escape sequences. */
+void fastjson_decode_string(std::string_view quoted, std::string& out);
+
+} // namespace prio
+
+#endif
+
+/* EOF */
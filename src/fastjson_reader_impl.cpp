@@ -0,0 +1,691 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "fastjson_reader_impl.hpp"
+
+#include <climits>
+#include <cmath>
+#include <format>
+#include <optional>
+#include <utility>
+#include <variant>
+
+#include <logmich/log.hpp>
+
+#include "array_values.hpp"
+#include "fastjson_parser.hpp"
+#include "input_buffer.hpp"
+#include "reader_collection.hpp"
+#include "reader_error.hpp"
+#include "reader_mapping.hpp"
+#include "reader_object.hpp"
+
+namespace prio {
+
+namespace {
+
+using Type = FastJsonTape::Type;
+using Entry = FastJsonTape::Entry;
+
+// The predicates follow the jsoncpp ones used by JsonReaderMappingImpl,
+// so that both JSON backends accept the same documents. Values are only
+// decoded from the source text here, on access.
+
+std::string as_string(FastJsonReaderDocumentImpl const& doc, std::uint32_t index)
+{
+  return doc.get_tape().get_string(doc.get_text(), index);
+}
+
+/** Like as_string() without the copy, escaped strings are decoded into
+    the arena of the document on their first read */
+std::string_view as_string_view(FastJsonReaderDocumentImpl const& doc, std::uint32_t index)
+{
+  FastJsonTape const& tape = doc.get_tape();
+  if (tape[index].escaped) {
+    DocumentArena& arena = doc.get_arena();
+    if (std::optional<std::string_view> const decoded = arena.find(index)) {
+      return *decoded;
+    }
+    return arena.store(index, tape.get_string(doc.get_text(), index));
+  }
+  return tape.get_raw_string(doc.get_text(), index);
+}
+
+// The getters return nothing when the value at index has another type,
+// the type check and the decoding share a single pass over the text.
+
+std::optional<bool> get_bool(FastJsonReaderDocumentImpl const& doc, std::uint32_t index)
+{
+  if (doc.get_tape()[index].type != Type::BOOLEAN) {
+    return std::nullopt;
+  }
+  return doc.get_tape().get_bool(doc.get_text(), index);
+}
+
+std::optional<int> get_int(FastJsonReaderDocumentImpl const& doc, std::uint32_t index)
+{
+  FastJsonTape const& tape = doc.get_tape();
+  if (tape[index].type == Type::INTEGER) {
+    std::int64_t value;
+    if (tape.get_integer(doc.get_text(), index, value) && value >= INT_MIN && value <= INT_MAX) {
+      return static_cast<int>(value);
+    }
+  } else if (tape[index].type == Type::REAL) {
+    double const value = tape.get_real(doc.get_text(), index);
+    double intpart;
+    if (value >= INT_MIN && value <= INT_MAX && std::modf(value, &intpart) == 0.0) {
+      return static_cast<int>(value);
+    }
+  }
+  return std::nullopt;
+}
+
+std::optional<float> get_float(FastJsonReaderDocumentImpl const& doc, std::uint32_t index)
+{
+  Type const type = doc.get_tape()[index].type;
+  if (type != Type::INTEGER && type != Type::REAL) {
+    return std::nullopt;
+  }
+  return static_cast<float>(doc.get_tape().get_real(doc.get_text(), index));
+}
+
+std::optional<std::string> get_string(FastJsonReaderDocumentImpl const& doc, std::uint32_t index)
+{
+  if (doc.get_tape()[index].type != Type::STRING) {
+    return std::nullopt;
+  }
+  return as_string(doc, index);
+}
+
+std::optional<std::string_view> get_string_view(FastJsonReaderDocumentImpl const& doc, std::uint32_t index)
+{
+  if (doc.get_tape()[index].type != Type::STRING) {
+    return std::nullopt;
+  }
+  return as_string_view(doc, index);
+}
+
+} // namespace
+
+FastJsonReaderDocumentImpl::FastJsonReaderDocumentImpl(std::shared_ptr<InputBuffer const> buffer, ErrorHandler error_handler,
+                                                       std::optional<std::string> filename) :
+  m_buffer(std::move(buffer)),
+  m_text(m_buffer->get_text()),
+  m_tape(std::make_unique<FastJsonTape>(fastjson_parse(m_text))),
+  m_error_handler(error_handler),
+  m_filename(std::move(filename)),
+  m_parent(nullptr)
+{
+}
+
+FastJsonReaderDocumentImpl::FastJsonReaderDocumentImpl(std::shared_ptr<InputBuffer const> buffer, std::unique_ptr<FastJsonTape> tape,
+                                                       ErrorHandler error_handler, std::optional<std::string> filename) :
+  m_buffer(std::move(buffer)),
+  m_text(m_buffer->get_text()),
+  m_tape(std::move(tape)),
+  m_error_handler(error_handler),
+  m_filename(std::move(filename)),
+  m_parent(nullptr)
+{
+}
+
+FastJsonReaderDocumentImpl::~FastJsonReaderDocumentImpl()
+{
+}
+
+void
+FastJsonReaderDocumentImpl::error(std::uint32_t index, std::string_view message) const
+{
+  error(m_error_handler, index, message);
+}
+
+void
+FastJsonReaderDocumentImpl::error(ErrorHandler error_handler, std::uint32_t index, std::string_view message) const
+{
+  switch (error_handler) {
+    case ErrorHandler::THROW:
+      throw ReaderError(std::format("{}: {}: {}", m_filename ? *m_filename : "<unknown>",
+                                    m_tape->get_source_text(m_text, index), message));
+
+    case ErrorHandler::LOG:
+      log_error("{}: {}: {}", m_filename ? *m_filename : "<unknown>",
+                m_tape->get_source_text(m_text, index), message);
+      break;
+
+    case ErrorHandler::IGNORE:
+      break;
+  }
+}
+
+ReaderObject
+FastJsonReaderDocumentImpl::get_root() const
+{
+  return ReaderObject(std::in_place_type<FastJsonReaderObjectImpl>, *this, 0);
+}
+
+std::size_t
+FastJsonReaderDocumentImpl::get_memory_usage() const
+{
+  return sizeof(*this) + m_buffer->get_memory_usage() + m_tape->get_memory_usage();
+}
+
+FastJsonReaderObjectImpl::FastJsonReaderObjectImpl(FastJsonReaderDocumentImpl const& doc, std::uint32_t index) :
+  m_doc(doc),
+  m_index(index)
+{
+  FastJsonTape const& tape = m_doc.get_tape();
+  if (tape[m_index].type != Type::OBJECT ||
+      tape[m_index].link == m_index + 1 ||
+      tape.next(m_index + 2) != tape[m_index].link)
+  {
+    m_doc.error(m_index, "expected hash with one element");
+  }
+}
+
+FastJsonReaderObjectImpl::~FastJsonReaderObjectImpl()
+{
+}
+
+std::string
+FastJsonReaderObjectImpl::get_name() const
+{
+  Entry const& entry = m_doc.get_tape()[m_index];
+  if (entry.type != Type::OBJECT || entry.link == m_index + 1) {
+    return {};
+  }
+
+  return as_string(m_doc, m_index + 1);
+}
+
+std::string_view
+FastJsonReaderObjectImpl::get_name_view() const
+{
+  Entry const& entry = m_doc.get_tape()[m_index];
+  if (entry.type != Type::OBJECT || entry.link == m_index + 1) {
+    return {};
+  }
+
+  return as_string_view(m_doc, m_index + 1);
+}
+
+ReaderMapping
+FastJsonReaderObjectImpl::get_mapping() const
+{
+  Entry const& entry = m_doc.get_tape()[m_index];
+  if (entry.type != Type::OBJECT || entry.link == m_index + 1) {
+    return {};
+  }
+
+  return ReaderMapping(std::in_place_type<FastJsonReaderMappingImpl>, m_doc, m_index + 2);
+}
+
+
+FastJsonReaderCollectionImpl::FastJsonReaderCollectionImpl(FastJsonReaderDocumentImpl const& doc, std::uint32_t index) :
+  m_doc(doc),
+  m_index(index),
+  m_elements(nullptr)
+{
+  if (m_doc.get_tape()[m_index].type != Type::ARRAY)
+  {
+    m_doc.error(m_index, "expected array");
+  }
+}
+
+FastJsonReaderCollectionImpl::FastJsonReaderCollectionImpl(FastJsonReaderCollectionImpl&& other) noexcept :
+  m_doc(other.m_doc),
+  m_index(other.m_index),
+  m_elements(other.m_elements.exchange(nullptr))
+{
+}
+
+FastJsonReaderCollectionImpl::~FastJsonReaderCollectionImpl()
+{
+  delete m_elements.load();
+}
+
+std::vector<ReaderObject>
+FastJsonReaderCollectionImpl::get_objects() const
+{
+  FastJsonTape const& tape = m_doc.get_tape();
+  if (tape[m_index].type != Type::ARRAY) {
+    return {};
+  }
+
+  std::vector<ReaderObject> result;
+  for (std::uint32_t i = m_index + 1; i < tape[m_index].link; i = tape.next(i))
+  {
+    result.emplace_back(std::in_place_type<FastJsonReaderObjectImpl>, m_doc, i);
+  }
+  return result;
+}
+
+std::size_t
+FastJsonReaderCollectionImpl::get_size() const
+{
+  return get_elements().size();
+}
+
+ReaderObject
+FastJsonReaderCollectionImpl::get_object(std::size_t index) const
+{
+  return get_object_at_cursor(get_elements()[index]);
+}
+
+FastJsonReaderCollectionImpl::Elements const&
+FastJsonReaderCollectionImpl::get_elements() const
+{
+  Elements const* elements = m_elements.load(std::memory_order_acquire);
+  if (elements != nullptr) {
+    return *elements;
+  }
+
+  auto result = std::make_unique<Elements>();
+  for (std::size_t i = first_cursor(); i != end_cursor(); i = next_cursor(i)) {
+    result->push_back(static_cast<std::uint32_t>(i));
+  }
+
+  if (m_elements.compare_exchange_strong(elements, result.get(), std::memory_order_acq_rel)) {
+    return *result.release();
+  }
+  // another thread was faster, elements now holds its index
+  return *elements;
+}
+
+std::size_t
+FastJsonReaderCollectionImpl::first_cursor() const
+{
+  return (m_doc.get_tape()[m_index].type == Type::ARRAY) ? m_index + 1 : end_cursor();
+}
+
+std::size_t
+FastJsonReaderCollectionImpl::next_cursor(std::size_t cursor) const
+{
+  return m_doc.get_tape().next(static_cast<std::uint32_t>(cursor));
+}
+
+std::size_t
+FastJsonReaderCollectionImpl::end_cursor() const
+{
+  FastJsonTape const& tape = m_doc.get_tape();
+  return (tape[m_index].type == Type::ARRAY) ? tape[m_index].link : m_index;
+}
+
+ReaderObject
+FastJsonReaderCollectionImpl::get_object_at_cursor(std::size_t cursor) const
+{
+  return ReaderObject(std::in_place_type<FastJsonReaderObjectImpl>, m_doc, static_cast<std::uint32_t>(cursor));
+}
+
+
+FastJsonReaderMappingImpl::FastJsonReaderMappingImpl(FastJsonReaderDocumentImpl const& doc, std::uint32_t index) :
+  m_doc(doc),
+  m_index(index)
+{
+}
+
+FastJsonReaderMappingImpl::~FastJsonReaderMappingImpl()
+{
+}
+
+std::vector<std::string>
+FastJsonReaderMappingImpl::get_keys() const
+{
+  std::vector<std::string> result;
+  std::string buffer;
+  for (std::size_t i = first_key_cursor(); i != end_key_cursor(); i = next_key_cursor(i)) {
+    result.emplace_back(get_key_at_cursor(i, buffer));
+  }
+  return result;
+}
+
+std::size_t
+FastJsonReaderMappingImpl::first_key_cursor() const
+{
+  return m_index + 1;
+}
+
+std::size_t
+FastJsonReaderMappingImpl::next_key_cursor(std::size_t cursor) const
+{
+  // skip the key and its value
+  return m_doc.get_tape().next(static_cast<std::uint32_t>(cursor) + 1);
+}
+
+std::size_t
+FastJsonReaderMappingImpl::end_key_cursor() const
+{
+  FastJsonTape const& tape = m_doc.get_tape();
+  if (tape[m_index].type != Type::OBJECT) {
+    return m_index + 1;
+  }
+  return tape[m_index].link;
+}
+
+std::string_view
+FastJsonReaderMappingImpl::get_key_at_cursor(std::size_t cursor, std::string& buffer) const
+{
+  FastJsonTape const& tape = m_doc.get_tape();
+  std::uint32_t const i = static_cast<std::uint32_t>(cursor);
+  if (tape[i].escaped) {
+    buffer = tape.get_string(m_doc.get_text(), i);
+    return buffer;
+  }
+  return tape.get_raw_string(m_doc.get_text(), i);
+}
+
+std::uint32_t
+FastJsonReaderMappingImpl::find(std::string_view key) const
+{
+  FastJsonTape const& tape = m_doc.get_tape();
+  std::uint32_t const index = tape.find_member(m_doc.get_text(), m_index, key);
+  if (index == FastJsonTape::npos || tape[index].type == Type::NULL_VALUE) {
+    return FastJsonTape::npos;
+  }
+  return index;
+}
+
+bool
+FastJsonReaderMappingImpl::read(Key const& key, bool& value) const
+{
+  return read_element(find(key), value);
+}
+
+bool
+FastJsonReaderMappingImpl::read(Key const& key, int& value) const
+{
+  return read_element(find(key), value);
+}
+
+bool
+FastJsonReaderMappingImpl::read(Key const& key, float& value) const
+{
+  return read_element(find(key), value);
+}
+
+bool
+FastJsonReaderMappingImpl::read(Key const& key, std::string& value) const
+{
+  return read_element(find(key), value);
+}
+
+bool
+FastJsonReaderMappingImpl::read(Key const& key, std::vector<bool>& values) const
+{
+  return read_element(find(key), values);
+}
+
+bool
+FastJsonReaderMappingImpl::read(Key const& key, std::vector<int>& values) const
+{
+  return read_element(find(key), values);
+}
+
+bool
+FastJsonReaderMappingImpl::read(Key const& key, std::vector<float>& values) const
+{
+  return read_element(find(key), values);
+}
+
+bool
+FastJsonReaderMappingImpl::read(Key const& key, std::vector<std::string>& values) const
+{
+  return read_element(find(key), values);
+}
+
+bool
+FastJsonReaderMappingImpl::read(Key const& key, std::string_view& value) const
+{
+  return read_element(find(key), value);
+}
+
+bool
+FastJsonReaderMappingImpl::read(Key const& key, std::span<int> values) const
+{
+  return read_element(find(key), values);
+}
+
+bool
+FastJsonReaderMappingImpl::read(Key const& key, std::span<float> values) const
+{
+  return read_element(find(key), values);
+}
+
+bool
+FastJsonReaderMappingImpl::read(Key const& key, ReaderObject& value) const
+{
+  return read_element(find(key), value);
+}
+
+bool
+FastJsonReaderMappingImpl::read(Key const& key, ReaderCollection& value) const
+{
+  return read_element(find(key), value);
+}
+
+bool
+FastJsonReaderMappingImpl::read(Key const& key, ReaderMapping& value) const
+{
+  return read_element(find(key), value);
+}
+
+void
+FastJsonReaderMappingImpl::read_fields(ReaderFieldTable const& fields, std::span<bool> found) const
+{
+  FastJsonTape const& tape = m_doc.get_tape();
+  if (tape[m_index].type != Type::OBJECT) {
+    return;
+  }
+
+  // like find(), the last of several duplicate keys wins, so only
+  // that one is decoded
+  std::vector<std::uint32_t> last(fields.size(), FastJsonTape::npos);
+  for (std::uint32_t i = m_index + 1; i < tape[m_index].link; i = tape.next(i + 1))
+  {
+    std::string unescaped;
+    std::string_view name = tape.get_raw_string(m_doc.get_text(), i);
+    if (tape[i].escaped) {
+      unescaped = tape.get_string(m_doc.get_text(), i);
+      name = unescaped;
+    }
+
+    std::size_t const field = fields.find(name);
+    if (field != fields.size()) {
+      last[field] = i + 1;
+    }
+  }
+
+  for (std::size_t field = 0; field < fields.size(); ++field)
+  {
+    std::uint32_t const element = last[field];
+    if (element == FastJsonTape::npos || tape[element].type == Type::NULL_VALUE) {
+      // like find(), a trailing null hides earlier values
+      continue;
+    }
+
+    found[field] = std::visit([this, element](auto* target) {
+      return read_element(element, *target);
+    }, fields[field].target);
+  }
+}
+
+#define GET_VALUE_MACRO(type, getter)                           \
+  if (element == FastJsonTape::npos) { return false; }          \
+  auto result = getter(m_doc, element);                         \
+  if (!result) {                                                \
+    m_doc.error(element, "expected " type);                     \
+    return false;                                               \
+  }                                                             \
+  value = *std::move(result);                                   \
+  return true
+
+bool
+FastJsonReaderMappingImpl::read_element(std::uint32_t element, bool& value) const
+{
+  GET_VALUE_MACRO("bool", get_bool);
+}
+
+bool
+FastJsonReaderMappingImpl::read_element(std::uint32_t element, int& value) const
+{
+  GET_VALUE_MACRO("int", get_int);
+}
+
+bool
+FastJsonReaderMappingImpl::read_element(std::uint32_t element, float& value) const
+{
+  GET_VALUE_MACRO("double", get_float);
+}
+
+bool
+FastJsonReaderMappingImpl::read_element(std::uint32_t element, std::string& value) const
+{
+  GET_VALUE_MACRO("string", get_string);
+}
+
+bool
+FastJsonReaderMappingImpl::read_element(std::uint32_t element, std::string_view& value) const
+{
+  GET_VALUE_MACRO("string", get_string_view);
+}
+
+#undef GET_VALUE_MACRO
+
+#define GET_VALUES_MACRO(type_, getter_)                                \
+  FastJsonTape const& tape = m_doc.get_tape();                          \
+  if (element == FastJsonTape::npos) { return false; }                  \
+  if (tape[element].type != Type::ARRAY) {                              \
+    m_doc.error(element, "expected array");                             \
+    return false;                                                       \
+  }                                                                     \
+                                                                        \
+  std::size_t count = 0;                                                \
+  for (std::uint32_t i = element + 1; i < tape[element].link; i = tape.next(i)) { \
+    count += 1;                                                         \
+  }                                                                     \
+                                                                        \
+  auto staged = stage_values(values, count);                            \
+  std::size_t j = 0;                                                    \
+  for (std::uint32_t i = element + 1; i < tape[element].link; i = tape.next(i)) { \
+    auto result = getter_(m_doc, i);                                    \
+    if (!result) {                                                      \
+      m_doc.error(i, "expected " type_);                                \
+      return false;                                                     \
+    }                                                                   \
+    staged[j++] = *std::move(result);                                   \
+  }                                                                     \
+                                                                        \
+  if (!fits_values(values, count)) {                                    \
+    m_doc.error(element, size_mismatch_message(values.size(), count));  \
+    return false;                                                       \
+  }                                                                     \
+  commit_values(values, staged);                                        \
+  return true
+
+bool
+FastJsonReaderMappingImpl::read_element(std::uint32_t element, std::vector<bool>& values) const
+{
+  GET_VALUES_MACRO("bool", get_bool);
+}
+
+bool
+FastJsonReaderMappingImpl::read_element(std::uint32_t element, std::vector<int>& values) const
+{
+  GET_VALUES_MACRO("int", get_int);
+}
+
+bool
+FastJsonReaderMappingImpl::read_element(std::uint32_t element, std::vector<float>& values) const
+{
+  GET_VALUES_MACRO("double", get_float);
+}
+
+bool
+FastJsonReaderMappingImpl::read_element(std::uint32_t element, std::vector<std::string>& values) const
+{
+  GET_VALUES_MACRO("string", get_string);
+}
+
+bool
+FastJsonReaderMappingImpl::read_element(std::uint32_t element, std::span<int> values) const
+{
+  GET_VALUES_MACRO("int", get_int);
+}
+
+bool
+FastJsonReaderMappingImpl::read_element(std::uint32_t element, std::span<float> values) const
+{
+  GET_VALUES_MACRO("double", get_float);
+}
+
+#undef GET_VALUES_MACRO
+
+bool
+FastJsonReaderMappingImpl::read_element(std::uint32_t element, ReaderMapping& value) const
+{
+  if (element != FastJsonTape::npos && m_doc.get_tape()[element].type == Type::OBJECT)
+  {
+    value = ReaderMapping(std::in_place_type<FastJsonReaderMappingImpl>, m_doc, element);
+    return true;
+  }
+  else
+  {
+    return false;
+  }
+}
+
+bool
+FastJsonReaderMappingImpl::read_element(std::uint32_t element, ReaderCollection& value) const
+{
+  if (element != FastJsonTape::npos && m_doc.get_tape()[element].type == Type::ARRAY)
+  {
+    value = ReaderCollection(std::in_place_type<FastJsonReaderCollectionImpl>, m_doc, element);
+    return true;
+  }
+  else
+  {
+    return false;
+  }
+}
+
+bool
+FastJsonReaderMappingImpl::read_element(std::uint32_t element, ReaderObject& value) const
+{
+  if (element != FastJsonTape::npos && m_doc.get_tape()[element].type == Type::OBJECT)
+  {
+    value = ReaderObject(std::in_place_type<FastJsonReaderObjectImpl>, m_doc, element);
+    return true;
+  }
+  else
+  {
+    return false;
+  }
+}
+
+void
+FastJsonReaderMappingImpl::error(std::string_view key, std::string_view message) const
+{
+  m_doc.error(m_index, std::format("{}: {}", key, message));
+}
+
+void
+FastJsonReaderMappingImpl::missing_key_error(std::string_view key) const
+{
+  m_doc.error(ErrorHandler::THROW, m_index, std::format("required key not found: {}", key));
+}
+
+} // namespace prio
+
+/* EOF */
@@ -0,0 +1,431 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "fastsexpr_parser.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdlib>
+#include <format>
+
+#include "reader_error.hpp"
+
+namespace prio {
+
+namespace {
+
+constexpr int MAX_DEPTH = 1024;
+
+enum CharClass : std::uint8_t
+{
+  ATOM = 0,
+  WHITESPACE = 1 << 0,
+  DELIMITER = 1 << 1
+};
+
+constexpr std::array<std::uint8_t, 256> make_char_classes()
+{
+  std::array<std::uint8_t, 256> table{};
+  for (unsigned char c : std::string_view(" \t\n\r\f\v")) {
+    table[c] = WHITESPACE | DELIMITER;
+  }
+  for (unsigned char c : std::string_view("()\";")) {
+    table[c] = DELIMITER;
+  }
+  return table;
+}
+
+constexpr std::array<std::uint8_t, 256> char_classes = make_char_classes();
+
+inline bool is_whitespace(char c)
+{
+  return char_classes[static_cast<unsigned char>(c)] & WHITESPACE;
+}
+
+inline bool is_delimiter(char c)
+{
+  return char_classes[static_cast<unsigned char>(c)] & DELIMITER;
+}
+
+inline bool is_digit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+std::string location(std::string_view text, std::size_t offset)
+{
+  offset = std::min(offset, text.size());
+  std::string_view const head = text.substr(0, offset);
+  std::size_t const line = static_cast<std::size_t>(std::count(head.begin(), head.end(), '\n')) + 1;
+  std::size_t const line_start = head.rfind('\n');
+  std::size_t const column = (line_start == std::string_view::npos) ? offset + 1 : offset - line_start;
+  return std::format("line {}, column {}", line, column);
+}
+
+bool fits_int(std::string_view token)
+{
+  if (token[0] == '+') {
+    token.remove_prefix(1);
+  }
+  int value;
+  auto const result = std::from_chars(token.data(), token.data() + token.size(), value);
+  return result.ec == std::errc();
+}
+
+/** Returns the type of the number in @a token without decoding it,
+    SYMBOL if it isn't one */
+FastSExprTape::Type classify_number(std::string_view token)
+{
+  std::size_t p = 0;
+  if (p < token.size() && (token[p] == '+' || token[p] == '-')) {
+    p += 1;
+  }
+
+  std::size_t const int_begin = p;
+  while (p < token.size() && is_digit(token[p])) {
+    p += 1;
+  }
+  std::size_t mantissa_digits = p - int_begin;
+
+  if (p == token.size()) {
+    if (mantissa_digits == 0) {
+      return FastSExprTape::Type::SYMBOL;
+    } else if (mantissa_digits < 10 || fits_int(token)) {
+      return FastSExprTape::Type::INTEGER;
+    } else {
+      // out of range integers degrade to reals
+      return FastSExprTape::Type::REAL;
+    }
+  }
+
+  if (token[p] == '.') {
+    std::size_t const frac_begin = ++p;
+    while (p < token.size() && is_digit(token[p])) {
+      p += 1;
+    }
+    mantissa_digits += p - frac_begin;
+  }
+
+  if (mantissa_digits == 0) {
+    return FastSExprTape::Type::SYMBOL;
+  }
+
+  if (p < token.size() && (token[p] == 'e' || token[p] == 'E')) {
+    p += 1;
+    if (p < token.size() && (token[p] == '+' || token[p] == '-')) {
+      p += 1;
+    }
+    std::size_t const exp_begin = p;
+    while (p < token.size() && is_digit(token[p])) {
+      p += 1;
+    }
+    if (p == exp_begin) {
+      return FastSExprTape::Type::SYMBOL;
+    }
+  }
+
+  return (p == token.size()) ? FastSExprTape::Type::REAL : FastSExprTape::Type::SYMBOL;
+}
+
+} // namespace
+
+class FastSExprParser final
+{
+public:
+  FastSExprParser(std::string_view text, FastSExprTape& tape) :
+    m_text(text),
+    m_pos(0),
+    m_tape(tape)
+  {
+    if (m_text.size() >= UINT32_MAX) {
+      throw ReaderError("sexpr parse error: input larger than 4GiB is not supported");
+    }
+  }
+
+  void parse()
+  {
+    skip_whitespace();
+    if (m_pos >= m_text.size()) {
+      error(m_pos, "document is empty");
+    }
+
+    parse_value(0);
+
+    skip_whitespace();
+    if (m_pos < m_text.size()) {
+      error(m_pos, "trailing garbage in stream");
+    }
+  }
+
+private:
+  void skip_whitespace()
+  {
+    while (m_pos < m_text.size()) {
+      char const c = m_text[m_pos];
+      if (is_whitespace(c)) {
+        m_pos += 1;
+      } else if (c == ';') {
+        std::size_t const eol = m_text.find('\n', m_pos);
+        m_pos = (eol == std::string_view::npos) ? m_text.size() : eol + 1;
+      } else {
+        break;
+      }
+    }
+  }
+
+  FastSExprTape::Entry& push(FastSExprTape::Type type, std::size_t source)
+  {
+    FastSExprTape::Entry entry{};
+    entry.type = type;
+    entry.source = static_cast<std::uint32_t>(source);
+    m_tape.m_entries.push_back(entry);
+    return m_tape.m_entries.back();
+  }
+
+  void parse_value(int depth)
+  {
+    switch (m_text[m_pos]) {
+      case '(':
+        parse_list(depth);
+        break;
+
+      case ')':
+        error(m_pos, "unexpected ')'");
+
+      case '"':
+        parse_string();
+        break;
+
+      default:
+        parse_atom();
+        break;
+    }
+  }
+
+  void parse_list(int depth)
+  {
+    if (depth > MAX_DEPTH) {
+      error(m_pos, "document nested too deeply");
+    }
+
+    std::size_t const entry_index = m_tape.m_entries.size();
+    push(FastSExprTape::Type::ARRAY, m_pos);
+    m_pos += 1;
+
+    while (true) {
+      skip_whitespace();
+      if (m_pos >= m_text.size()) {
+        error(m_tape.m_entries[entry_index].source, "unexpected end of file in list");
+      }
+
+      if (m_text[m_pos] == ')') {
+        m_pos += 1;
+        break;
+      }
+
+      parse_value(depth + 1);
+    }
+
+    FastSExprTape::Entry& entry = m_tape.m_entries[entry_index];
+    entry.link = static_cast<std::uint32_t>(m_tape.m_entries.size());
+    entry.length = static_cast<std::uint32_t>(m_pos - entry.source);
+  }
+
+  void parse_string()
+  {
+    std::size_t const begin = m_pos;
+    bool escaped = false;
+    std::size_t p = begin + 1;
+    while (true) {
+      p = m_text.find_first_of("\"\\", p);
+      if (p == std::string_view::npos || (m_text[p] == '\\' && p + 1 >= m_text.size())) {
+        error(begin, "unterminated string");
+      }
+
+      if (m_text[p] == '"') {
+        break;
+      }
+
+      escaped = true;
+      p += 2;
+    }
+    m_pos = p + 1;
+
+    FastSExprTape::Entry& entry = push(FastSExprTape::Type::STRING, begin);
+    entry.escaped = escaped;
+    entry.length = static_cast<std::uint32_t>(m_pos - begin);
+  }
+
+  void parse_atom()
+  {
+    std::size_t const begin = m_pos;
+    std::size_t end = begin;
+    while (end < m_text.size() && !is_delimiter(m_text[end])) {
+      end += 1;
+    }
+    m_pos = end;
+
+    std::string_view const token = m_text.substr(begin, end - begin);
+
+    push(fastsexpr_classify_atom(token), begin).length = static_cast<std::uint32_t>(token.size());
+  }
+
+  [[noreturn]]
+  void error(std::size_t offset, std::string_view message) const
+  {
+    throw ReaderError(std::format("sexpr parse error: {}: {}", location(m_text, offset), message));
+  }
+
+private:
+  std::string_view m_text;
+  std::size_t m_pos;
+  FastSExprTape& m_tape;
+
+private:
+  FastSExprParser(FastSExprParser const&) = delete;
+  FastSExprParser& operator=(FastSExprParser const&) = delete;
+};
+
+FastSExprTape::Type
+fastsexpr_classify_atom(std::string_view token)
+{
+  if (token == "#t" || token == "#true" || token == "#f" || token == "#false") {
+    return FastSExprTape::Type::BOOLEAN;
+  } else {
+    return classify_number(token);
+  }
+}
+
+FastSExprTape
+fastsexpr_parse(std::string_view text)
+{
+  FastSExprTape tape;
+  FastSExprParser parser(text, tape);
+  parser.parse();
+  return tape;
+}
+
+std::uint32_t
+FastSExprTape::count(std::uint32_t index) const
+{
+  std::uint32_t result = 0;
+  for (std::uint32_t i = index + 1; i < m_entries[index].link; i = next(i)) {
+    result += 1;
+  }
+  return result;
+}
+
+bool
+FastSExprTape::get_bool(std::string_view source, std::uint32_t index) const
+{
+  return source[m_entries[index].source + 1] == 't';
+}
+
+int
+FastSExprTape::get_integer(std::string_view source, std::uint32_t index) const
+{
+  std::string_view text = get_source_text(source, index);
+  if (text[0] == '+') {
+    text.remove_prefix(1);
+  }
+
+  int value = 0;
+  std::from_chars(text.data(), text.data() + text.size(), value);
+  return value;
+}
+
+float
+FastSExprTape::get_real(std::string_view source, std::uint32_t index) const
+{
+  if (m_entries[index].type == Type::INTEGER) {
+    return static_cast<float>(get_integer(source, index));
+  }
+
+  // std::from_chars() rejects a leading '+'
+  std::string_view text = get_source_text(source, index);
+  if (text[0] == '+') {
+    text.remove_prefix(1);
+  }
+
+  float value = 0.0f;
+  auto const result = std::from_chars(text.data(), text.data() + text.size(), value);
+  if (result.ec == std::errc::result_out_of_range) {
+    // from_chars() leaves the value untouched, strtof() saturates
+    return std::strtof(std::string(text).c_str(), nullptr);
+  }
+  return value;
+}
+
+std::string_view
+FastSExprTape::get_raw_string(std::string_view source, std::uint32_t index) const
+{
+  Entry const& entry = m_entries[index];
+  if (entry.type == Type::STRING) {
+    return source.substr(entry.source + 1, entry.length - 2);
+  } else {
+    return source.substr(entry.source, entry.length);
+  }
+}
+
+std::string
+FastSExprTape::get_string(std::string_view source, std::uint32_t index) const
+{
+  std::string_view const raw = get_raw_string(source, index);
+  if (!m_entries[index].escaped) {
+    return std::string(raw);
+  }
+
+  std::string result;
+  result.reserve(raw.size());
+  for (std::size_t p = 0; p < raw.size(); ++p) {
+    if (raw[p] == '\\') {
+      p += 1;
+      result += (raw[p] == 'n') ? '\n' : (raw[p] == 't') ? '\t' : raw[p];
+    } else {
+      result += raw[p];
+    }
+  }
+  return result;
+}
+
+bool
+FastSExprTape::string_equals(std::string_view source, std::uint32_t index, std::string_view text) const
+{
+  if (!m_entries[index].escaped) {
+    return get_raw_string(source, index) == text;
+  } else {
+    return get_string(source, index) == text;
+  }
+}
+
+std::string_view
+FastSExprTape::get_source_text(std::string_view source, std::uint32_t index) const
+{
+  Entry const& entry = m_entries[index];
+  return source.substr(entry.source, entry.length);
+}
+
+int
+FastSExprTape::get_line(std::string_view source, std::uint32_t index) const
+{
+  std::string_view const head = source.substr(0, m_entries[index].source);
+  return static_cast<int>(std::count(head.begin(), head.end(), '\n')) + 1;
+}
+
+} // namespace prio
+
+/* EOF */
@@ -0,0 +1,127 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_PRIO_FASTSEXPR_PARSER_HPP
+#define HEADER_PRIO_FASTSEXPR_PARSER_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace prio {
+
+/** Flat representation of a parsed s-expression, laid out like
+    FastJsonTape: lists are followed by their elements and know the index
+    one past their last element. Atoms are classified while parsing, but
+    numbers and strings are only decoded from the source text when they
+    are accessed. */
+class FastSExprTape final
+{
+public:
+  enum class Type : std::uint8_t
+  {
+    BOOLEAN,
+    INTEGER,
+    REAL,
+    STRING,
+    SYMBOL,
+    ARRAY
+  };
+
+  struct Entry
+  {
+    Type type;
+
+    /** STRING: the string contains escape sequences */
+    bool escaped;
+
+    /** ARRAY: tape index one past the last element */
+    std::uint32_t link;
+
+    /** offset and length of the value in the source text, lists include
+        the closing parenthesis, strings the quotes */
+    std::uint32_t source;
+    std::uint32_t length;
+  };
+
+public:
+  FastSExprTape() : m_entries() {}
+
+  /** Restores a tape from entries previously obtained from
+      get_entries(), used by ParseCache */
+  explicit FastSExprTape(std::vector<Entry> entries) : m_entries(std::move(entries)) {}
+
+  std::vector<Entry> const& get_entries() const { return m_entries; }
+
+  Entry const& operator[](std::uint32_t index) const { return m_entries[index]; }
+  std::uint32_t size() const { return static_cast<std::uint32_t>(m_entries.size()); }
+
+  /** Returns the number of bytes held by the tape */
+  std::size_t get_memory_usage() const { return sizeof(*this) + m_entries.capacity() * sizeof(Entry); }
+
+  /** Returns the index of the value following the one at @a index */
+  std::uint32_t next(std::uint32_t index) const {
+    Entry const& entry = m_entries[index];
+    return entry.type == Type::ARRAY ? entry.link : index + 1;
+  }
+
+  /** Returns the number of elements in the list at @a index */
+  std::uint32_t count(std::uint32_t index) const;
+
+  bool get_bool(std::string_view source, std::uint32_t index) const;
+  int get_integer(std::string_view source, std::uint32_t index) const;
+  float get_real(std::string_view source, std::uint32_t index) const;
+
+  /** Returns the text of the SYMBOL at @a index or the text between the
+      quotes of the STRING at @a index with escape sequences left as is */
+  std::string_view get_raw_string(std::string_view source, std::uint32_t index) const;
+
+  /** Returns the decoded SYMBOL or STRING at @a index */
+  std::string get_string(std::string_view source, std::uint32_t index) const;
+
+  /** Compares the decoded SYMBOL or STRING at @a index with @a text */
+  bool string_equals(std::string_view source, std::uint32_t index, std::string_view text) const;
+
+  /** Returns the raw source text of the value at @a index */
+  std::string_view get_source_text(std::string_view source, std::uint32_t index) const;
+
+  /** Returns the 1-based line on which the value at @a index starts */
+  int get_line(std::string_view source, std::uint32_t index) const;
+
+  static constexpr std::uint32_t npos = UINT32_MAX;
+
+private:
+  friend class FastSExprParser;
+
+  std::vector<Entry> m_entries;
+};
+
+/** Returns the type of the unquoted atom @a token: BOOLEAN, INTEGER,
+    REAL or SYMBOL */
+FastSExprTape::Type fastsexpr_classify_atom(std::string_view token);
+
+/** Builds a FastSExprTape for the single s-expression in @a text. Like
+    sexp::Parser::from_stream() trailing content is an error. Throws
+    ReaderError on malformed input. */
+FastSExprTape fastsexpr_parse(std::string_view text);
+
+} // namespace prio
+
+#endif
+
+/* EOF */
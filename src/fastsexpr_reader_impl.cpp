@@ -0,0 +1,741 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "fastsexpr_reader_impl.hpp"
+
+#include <format>
+#include <optional>
+#include <utility>
+#include <variant>
+
+#include <logmich/log.hpp>
+
+#include "array_values.hpp"
+#include "fastsexpr_parser.hpp"
+#include "input_buffer.hpp"
+#include "reader_collection.hpp"
+#include "reader_error.hpp"
+#include "reader_mapping.hpp"
+#include "reader_object.hpp"
+
+namespace prio {
+
+namespace {
+
+using Type = FastSExprTape::Type;
+using Entry = FastSExprTape::Entry;
+
+// The predicates follow the sexp::Value ones used by
+// SExprReaderMappingImpl, integers are accepted as reals. Values are
+// only decoded from the source text here, on access.
+
+bool is_boolean(Entry const& entry)
+{
+  return entry.type == Type::BOOLEAN;
+}
+
+bool is_integer(Entry const& entry)
+{
+  return entry.type == Type::INTEGER;
+}
+
+bool is_real(Entry const& entry)
+{
+  return entry.type == Type::REAL || entry.type == Type::INTEGER;
+}
+
+bool is_string(Entry const& entry)
+{
+  return entry.type == Type::STRING;
+}
+
+bool as_bool(FastSExprReaderDocumentImpl const& doc, std::uint32_t index)
+{
+  return doc.get_tape().get_bool(doc.get_text(), index);
+}
+
+int as_int(FastSExprReaderDocumentImpl const& doc, std::uint32_t index)
+{
+  return doc.get_tape().get_integer(doc.get_text(), index);
+}
+
+float as_float(FastSExprReaderDocumentImpl const& doc, std::uint32_t index)
+{
+  return doc.get_tape().get_real(doc.get_text(), index);
+}
+
+std::string as_string(FastSExprReaderDocumentImpl const& doc, std::uint32_t index)
+{
+  return doc.get_tape().get_string(doc.get_text(), index);
+}
+
+/** Like as_string() without the copy, escaped strings are decoded into
+    the arena of the document on their first read */
+std::string_view as_string_view(FastSExprReaderDocumentImpl const& doc, std::uint32_t index)
+{
+  FastSExprTape const& tape = doc.get_tape();
+  if (tape[index].escaped) {
+    DocumentArena& arena = doc.get_arena();
+    if (std::optional<std::string_view> const decoded = arena.find(index)) {
+      return *decoded;
+    }
+    return arena.store(index, tape.get_string(doc.get_text(), index));
+  }
+  return tape.get_raw_string(doc.get_text(), index);
+}
+
+/** Returns true if the entry at @a index is a non-empty list starting
+    with a symbol or string, i.e. something that can be looked up by key */
+bool is_keyvalue(FastSExprTape const& tape, std::uint32_t index)
+{
+  return tape[index].type == Type::ARRAY &&
+    tape[index].link != index + 1 &&
+    (tape[index + 1].type == Type::SYMBOL || tape[index + 1].type == Type::STRING);
+}
+
+} // namespace
+
+FastSExprReaderDocumentImpl::FastSExprReaderDocumentImpl(std::shared_ptr<InputBuffer const> buffer, ErrorHandler error_handler,
+                                                         std::optional<std::string> filename) :
+  m_buffer(std::move(buffer)),
+  m_text(m_buffer->get_text()),
+  m_tape(std::make_unique<FastSExprTape>(fastsexpr_parse(m_text))),
+  m_error_handler(error_handler),
+  m_filename(std::move(filename)),
+  m_parent(nullptr)
+{
+}
+
+FastSExprReaderDocumentImpl::FastSExprReaderDocumentImpl(std::shared_ptr<InputBuffer const> buffer, std::unique_ptr<FastSExprTape> tape,
+                                                         ErrorHandler error_handler, std::optional<std::string> filename) :
+  m_buffer(std::move(buffer)),
+  m_text(m_buffer->get_text()),
+  m_tape(std::move(tape)),
+  m_error_handler(error_handler),
+  m_filename(std::move(filename)),
+  m_parent(nullptr)
+{
+}
+
+FastSExprReaderDocumentImpl::~FastSExprReaderDocumentImpl()
+{
+}
+
+void
+FastSExprReaderDocumentImpl::error(std::uint32_t index, std::string_view message) const
+{
+  error(m_error_handler, index, message);
+}
+
+void
+FastSExprReaderDocumentImpl::error(ErrorHandler error_handler, std::uint32_t index, std::string_view message) const
+{
+  switch (error_handler) {
+    case ErrorHandler::THROW:
+      throw ReaderError(std::format("{}:{}: {}: {}", m_filename ? *m_filename : "<unknown>",
+                                    m_tape->get_line(m_text, index),
+                                    m_tape->get_source_text(m_text, index), message));
+
+    case ErrorHandler::LOG:
+      log_error("{}:{}: {}: {}", m_filename ? *m_filename : "<unknown>",
+                m_tape->get_line(m_text, index),
+                m_tape->get_source_text(m_text, index), message);
+      break;
+
+    case ErrorHandler::IGNORE:
+      break;
+  }
+}
+
+ReaderObject
+FastSExprReaderDocumentImpl::get_root() const
+{
+  return ReaderObject(std::in_place_type<FastSExprReaderObjectImpl>, *this, 0);
+}
+
+std::size_t
+FastSExprReaderDocumentImpl::get_memory_usage() const
+{
+  return sizeof(*this) + m_buffer->get_memory_usage() + m_tape->get_memory_usage();
+}
+
+FastSExprReaderObjectImpl::FastSExprReaderObjectImpl(FastSExprReaderDocumentImpl const& doc, std::uint32_t index) :
+  m_doc(doc),
+  m_index(index)
+{
+  // Expects data in the format:
+  // (objectname
+  //   (property1 45)
+  //   (property2 45))
+  if (m_doc.get_tape()[m_index].type != Type::ARRAY) {
+    m_doc.error(m_index, "expected list");
+  }
+}
+
+FastSExprReaderObjectImpl::~FastSExprReaderObjectImpl()
+{
+}
+
+std::string
+FastSExprReaderObjectImpl::get_name() const
+{
+  FastSExprTape const& tape = m_doc.get_tape();
+  if (tape[m_index].type != Type::ARRAY ||
+      tape[m_index].link == m_index + 1 ||
+      (tape[m_index + 1].type != Type::SYMBOL && tape[m_index + 1].type != Type::STRING))
+  {
+    throw ReaderError("invalid syntax");
+  }
+
+  return as_string(m_doc, m_index + 1);
+}
+
+std::string_view
+FastSExprReaderObjectImpl::get_name_view() const
+{
+  FastSExprTape const& tape = m_doc.get_tape();
+  if (tape[m_index].type != Type::ARRAY ||
+      tape[m_index].link == m_index + 1 ||
+      (tape[m_index + 1].type != Type::SYMBOL && tape[m_index + 1].type != Type::STRING))
+  {
+    throw ReaderError("invalid syntax");
+  }
+
+  return as_string_view(m_doc, m_index + 1);
+}
+
+ReaderMapping
+FastSExprReaderObjectImpl::get_mapping() const
+{
+  if (m_doc.get_tape()[m_index].type != Type::ARRAY) {
+    return {};
+  }
+
+  return ReaderMapping(std::in_place_type<FastSExprReaderMappingImpl>, m_doc, m_index);
+}
+
+
+FastSExprReaderCollectionImpl::FastSExprReaderCollectionImpl(FastSExprReaderDocumentImpl const& doc, std::uint32_t index) :
+  m_doc(doc),
+  m_index(index),
+  m_elements(nullptr)
+{
+  assert(m_doc.get_tape()[m_index].type == Type::ARRAY);
+}
+
+FastSExprReaderCollectionImpl::FastSExprReaderCollectionImpl(FastSExprReaderCollectionImpl&& other) noexcept :
+  m_doc(other.m_doc),
+  m_index(other.m_index),
+  m_elements(other.m_elements.exchange(nullptr))
+{
+}
+
+FastSExprReaderCollectionImpl::~FastSExprReaderCollectionImpl()
+{
+  delete m_elements.load();
+}
+
+std::vector<ReaderObject>
+FastSExprReaderCollectionImpl::get_objects() const
+{
+  FastSExprTape const& tape = m_doc.get_tape();
+  std::uint32_t const end = tape[m_index].link;
+
+  std::vector<ReaderObject> result;
+  if (end == m_index + 1) {
+    return result;
+  }
+
+  for (std::uint32_t i = tape.next(m_index + 1); i < end; i = tape.next(i)) {
+    result.emplace_back(std::in_place_type<FastSExprReaderObjectImpl>, m_doc, i);
+  }
+  return result;
+}
+
+std::size_t
+FastSExprReaderCollectionImpl::get_size() const
+{
+  return get_elements().size();
+}
+
+ReaderObject
+FastSExprReaderCollectionImpl::get_object(std::size_t index) const
+{
+  return get_object_at_cursor(get_elements()[index]);
+}
+
+FastSExprReaderCollectionImpl::Elements const&
+FastSExprReaderCollectionImpl::get_elements() const
+{
+  Elements const* elements = m_elements.load(std::memory_order_acquire);
+  if (elements != nullptr) {
+    return *elements;
+  }
+
+  auto result = std::make_unique<Elements>();
+  for (std::size_t i = first_cursor(); i != end_cursor(); i = next_cursor(i)) {
+    result->push_back(static_cast<std::uint32_t>(i));
+  }
+
+  if (m_elements.compare_exchange_strong(elements, result.get(), std::memory_order_acq_rel)) {
+    return *result.release();
+  }
+  // another thread was faster, elements now holds its index
+  return *elements;
+}
+
+std::size_t
+FastSExprReaderCollectionImpl::first_cursor() const
+{
+  // skip the name of the collection
+  FastSExprTape const& tape = m_doc.get_tape();
+  return (tape[m_index].link == m_index + 1) ? end_cursor() : tape.next(m_index + 1);
+}
+
+std::size_t
+FastSExprReaderCollectionImpl::next_cursor(std::size_t cursor) const
+{
+  return m_doc.get_tape().next(static_cast<std::uint32_t>(cursor));
+}
+
+std::size_t
+FastSExprReaderCollectionImpl::end_cursor() const
+{
+  return m_doc.get_tape()[m_index].link;
+}
+
+ReaderObject
+FastSExprReaderCollectionImpl::get_object_at_cursor(std::size_t cursor) const
+{
+  return ReaderObject(std::in_place_type<FastSExprReaderObjectImpl>, m_doc, static_cast<std::uint32_t>(cursor));
+}
+
+
+FastSExprReaderMappingImpl::FastSExprReaderMappingImpl(FastSExprReaderDocumentImpl const& doc, std::uint32_t index) :
+  m_doc(doc),
+  m_index(index)
+{
+  // Expects data in this format:
+  // (objectname
+  //   (property1 45)
+  //   (property2 45))
+  // 'objectname' is ignored
+  assert(m_doc.get_tape()[m_index].type == Type::ARRAY);
+}
+
+FastSExprReaderMappingImpl::~FastSExprReaderMappingImpl()
+{
+}
+
+std::vector<std::string>
+FastSExprReaderMappingImpl::get_keys() const
+{
+  std::vector<std::string> result;
+  std::string buffer;
+  for (std::size_t i = first_key_cursor(); i != end_key_cursor(); i = next_key_cursor(i)) {
+    result.emplace_back(get_key_at_cursor(i, buffer));
+  }
+  return result;
+}
+
+std::size_t
+FastSExprReaderMappingImpl::first_key_cursor() const
+{
+  FastSExprTape const& tape = m_doc.get_tape();
+  if (tape[m_index].link == m_index + 1) {
+    return tape[m_index].link;
+  }
+
+  // skip the object name
+  return tape.next(m_index + 1);
+}
+
+std::size_t
+FastSExprReaderMappingImpl::next_key_cursor(std::size_t cursor) const
+{
+  return m_doc.get_tape().next(static_cast<std::uint32_t>(cursor));
+}
+
+std::size_t
+FastSExprReaderMappingImpl::end_key_cursor() const
+{
+  return m_doc.get_tape()[m_index].link;
+}
+
+std::string_view
+FastSExprReaderMappingImpl::get_key_at_cursor(std::size_t cursor, std::string& /*buffer*/) const
+{
+  FastSExprTape const& tape = m_doc.get_tape();
+  std::uint32_t const i = static_cast<std::uint32_t>(cursor);
+
+  if (tape[i].type != Type::ARRAY || tape[i].link == i + 1) {
+    throw ReaderError(std::format("{}: malformed mapping, expected array",
+                                  tape.get_source_text(m_doc.get_text(), i)));
+  }
+
+  if (tape[i + 1].type != Type::SYMBOL) {
+    throw ReaderError(std::format("{}: malformed mapping, expected symbol",
+                                  tape.get_source_text(m_doc.get_text(), i)));
+  }
+
+  // symbols are never escaped
+  return tape.get_raw_string(m_doc.get_text(), i + 1);
+}
+
+bool
+FastSExprReaderMappingImpl::read(Key const& key, bool& value) const
+{
+  return read_element(get_subsection(key), value);
+}
+
+bool
+FastSExprReaderMappingImpl::read(Key const& key, int& value) const
+{
+  return read_element(get_subsection(key), value);
+}
+
+bool
+FastSExprReaderMappingImpl::read(Key const& key, float& value) const
+{
+  return read_element(get_subsection(key), value);
+}
+
+bool
+FastSExprReaderMappingImpl::read(Key const& key, std::string& value) const
+{
+  return read_element(get_subsection(key), value);
+}
+
+bool
+FastSExprReaderMappingImpl::read(Key const& key, std::vector<bool>& values) const
+{
+  return read_element(get_subsection(key), values);
+}
+
+bool
+FastSExprReaderMappingImpl::read(Key const& key, std::vector<int>& values) const
+{
+  return read_element(get_subsection(key), values);
+}
+
+bool
+FastSExprReaderMappingImpl::read(Key const& key, std::vector<float>& values) const
+{
+  return read_element(get_subsection(key), values);
+}
+
+bool
+FastSExprReaderMappingImpl::read(Key const& key, std::vector<std::string>& values) const
+{
+  return read_element(get_subsection(key), values);
+}
+
+bool
+FastSExprReaderMappingImpl::read(Key const& key, std::string_view& value) const
+{
+  return read_element(get_subsection(key), value);
+}
+
+bool
+FastSExprReaderMappingImpl::read(Key const& key, std::span<int> values) const
+{
+  return read_element(get_subsection(key), values);
+}
+
+bool
+FastSExprReaderMappingImpl::read(Key const& key, std::span<float> values) const
+{
+  return read_element(get_subsection(key), values);
+}
+
+bool
+FastSExprReaderMappingImpl::read(Key const& key, ReaderObject& value) const
+{
+  return read_element(get_subsection(key), value);
+}
+
+bool
+FastSExprReaderMappingImpl::read(Key const& key, ReaderCollection& value) const
+{
+  return read_element(get_subsection(key), value);
+}
+
+bool
+FastSExprReaderMappingImpl::read(Key const& key, ReaderMapping& value) const
+{
+  return read_element(get_subsection(key), value);
+}
+
+void
+FastSExprReaderMappingImpl::read_fields(ReaderFieldTable const& fields, std::span<bool> found) const
+{
+  FastSExprTape const& tape = m_doc.get_tape();
+  std::uint32_t const end = tape[m_index].link;
+  if (end == m_index + 1) {
+    return;
+  }
+
+  // like get_subsection(), the last of several duplicate keys wins, so
+  // only that one is decoded
+  std::vector<std::uint32_t> last(fields.size(), FastSExprTape::npos);
+  for (std::uint32_t i = tape.next(m_index + 1); i < end; i = tape.next(i))
+  {
+    if (!is_keyvalue(tape, i)) {
+      continue;
+    }
+
+    std::string unescaped;
+    std::string_view name = tape.get_raw_string(m_doc.get_text(), i + 1);
+    if (tape[i + 1].escaped) {
+      unescaped = tape.get_string(m_doc.get_text(), i + 1);
+      name = unescaped;
+    }
+
+    std::size_t const field = fields.find(name);
+    if (field == fields.size()) {
+      continue;
+    }
+
+    if (last[field] != FastSExprTape::npos) {
+      log_error("duplicate key value '{}'", fields[field].key.get_name());
+    }
+    last[field] = i;
+  }
+
+  for (std::size_t field = 0; field < fields.size(); ++field)
+  {
+    std::uint32_t const sub = last[field];
+    if (sub == FastSExprTape::npos) {
+      continue;
+    }
+
+    found[field] = std::visit([this, sub](auto* target) {
+      return read_element(sub, *target);
+    }, fields[field].target);
+  }
+}
+
+#define GET_VALUE_MACRO(type, checker, getter)                  \
+  std::uint32_t const item = get_item(sub);                     \
+  if (item == FastSExprTape::npos) { return false; }            \
+  if (!checker(m_doc.get_tape()[item])) {                       \
+    m_doc.error(item, "expected " type);                        \
+    return false;                                               \
+  }                                                             \
+  value = getter(m_doc, item);                                  \
+  return true
+
+bool
+FastSExprReaderMappingImpl::read_element(std::uint32_t sub, bool& value) const
+{
+  GET_VALUE_MACRO("bool", is_boolean, as_bool);
+}
+
+bool
+FastSExprReaderMappingImpl::read_element(std::uint32_t sub, int& value) const
+{
+  GET_VALUE_MACRO("int", is_integer, as_int);
+}
+
+bool
+FastSExprReaderMappingImpl::read_element(std::uint32_t sub, float& value) const
+{
+  GET_VALUE_MACRO("float", is_real, as_float);
+}
+
+bool
+FastSExprReaderMappingImpl::read_element(std::uint32_t sub, std::string& value) const
+{
+  GET_VALUE_MACRO("string", is_string, as_string);
+}
+
+bool
+FastSExprReaderMappingImpl::read_element(std::uint32_t sub, std::string_view& value) const
+{
+  GET_VALUE_MACRO("string", is_string, as_string_view);
+}
+
+#undef GET_VALUE_MACRO
+
+#define GET_VALUES_MACRO(type, checker, getter)                         \
+  FastSExprTape const& tape = m_doc.get_tape();                         \
+  if (sub == FastSExprTape::npos) { return false; }                     \
+                                                                        \
+  std::uint32_t const first = tape.next(sub + 1);                       \
+  std::size_t count = 0;                                                \
+  for (std::uint32_t i = first; i < tape[sub].link; i = tape.next(i)) { \
+    count += 1;                                                         \
+  }                                                                     \
+                                                                        \
+  auto staged = stage_values(values, count);                            \
+  std::size_t j = 0;                                                    \
+  for (std::uint32_t i = first; i < tape[sub].link; i = tape.next(i)) { \
+    if (!checker(tape[i])) {                                            \
+      m_doc.error(i, "expected " type);                                 \
+      return false;                                                     \
+    }                                                                   \
+    staged[j++] = getter(m_doc, i);                                     \
+  }                                                                     \
+                                                                        \
+  if (!fits_values(values, count)) {                                    \
+    m_doc.error(sub, size_mismatch_message(values.size(), count));      \
+    return false;                                                       \
+  }                                                                     \
+  commit_values(values, staged);                                        \
+  return true
+
+bool
+FastSExprReaderMappingImpl::read_element(std::uint32_t sub, std::vector<bool>& values) const
+{
+  GET_VALUES_MACRO("bool", is_boolean, as_bool);
+}
+
+bool
+FastSExprReaderMappingImpl::read_element(std::uint32_t sub, std::vector<int>& values) const
+{
+  GET_VALUES_MACRO("int", is_integer, as_int);
+}
+
+bool
+FastSExprReaderMappingImpl::read_element(std::uint32_t sub, std::vector<float>& values) const
+{
+  GET_VALUES_MACRO("float", is_real, as_float);
+}
+
+bool
+FastSExprReaderMappingImpl::read_element(std::uint32_t sub, std::vector<std::string>& values) const
+{
+  GET_VALUES_MACRO("string", is_string, as_string);
+}
+
+bool
+FastSExprReaderMappingImpl::read_element(std::uint32_t sub, std::span<int> values) const
+{
+  GET_VALUES_MACRO("int", is_integer, as_int);
+}
+
+bool
+FastSExprReaderMappingImpl::read_element(std::uint32_t sub, std::span<float> values) const
+{
+  GET_VALUES_MACRO("float", is_real, as_float);
+}
+
+#undef GET_VALUES_MACRO
+
+bool
+FastSExprReaderMappingImpl::read_element(std::uint32_t sub, ReaderObject& value) const
+{
+  std::uint32_t const cur = get_item(sub);
+  if (cur == FastSExprTape::npos) {
+    return false;
+  }
+
+  if (m_doc.get_tape()[cur].type != Type::ARRAY) {
+    m_doc.error(cur, "must be array");
+    return false;
+  }
+
+  value = ReaderObject(std::in_place_type<FastSExprReaderObjectImpl>, m_doc, cur);
+  return true;
+}
+
+bool
+FastSExprReaderMappingImpl::read_element(std::uint32_t sub, ReaderCollection& value) const
+{
+  if (sub == FastSExprTape::npos) {
+    return false;
+  }
+
+  value = ReaderCollection(std::in_place_type<FastSExprReaderCollectionImpl>, m_doc, sub);
+  return true;
+}
+
+bool
+FastSExprReaderMappingImpl::read_element(std::uint32_t sub, ReaderMapping& value) const
+{
+  if (sub == FastSExprTape::npos) {
+    return false;
+  }
+
+  value = ReaderMapping(std::in_place_type<FastSExprReaderMappingImpl>, m_doc, sub);
+  return true;
+}
+
+void
+FastSExprReaderMappingImpl::error(std::string_view key, std::string_view message) const
+{
+  m_doc.error(m_index, std::format("{}: {}", key, message));
+}
+
+void
+FastSExprReaderMappingImpl::missing_key_error(std::string_view key) const
+{
+  m_doc.error(ErrorHandler::THROW, m_index, std::format("required key not found: {}", key));
+}
+
+std::uint32_t
+FastSExprReaderMappingImpl::get_item(std::uint32_t sub) const
+{
+  if (sub == FastSExprTape::npos) {
+    return FastSExprTape::npos;
+  }
+
+  FastSExprTape const& tape = m_doc.get_tape();
+  std::uint32_t const item = tape.next(sub + 1);
+  if (item == tape[sub].link) {
+    // unset values are ok
+    return FastSExprTape::npos;
+  }
+
+  if (tape.next(item) != tape[sub].link) {
+    m_doc.error(sub, "invalid items in section");
+    return FastSExprTape::npos;
+  }
+
+  return item;
+}
+
+std::uint32_t
+FastSExprReaderMappingImpl::get_subsection(std::string_view key) const
+{
+  FastSExprTape const& tape = m_doc.get_tape();
+  std::uint32_t const end = tape[m_index].link;
+  if (end == m_index + 1) {
+    return FastSExprTape::npos;
+  }
+
+  std::uint32_t result = FastSExprTape::npos;
+  int count = 0;
+  for (std::uint32_t i = tape.next(m_index + 1); i < end; i = tape.next(i))
+  {
+    if (is_keyvalue(tape, i) && tape.string_equals(m_doc.get_text(), i + 1, key))
+    {
+      count += 1;
+      result = i;
+    }
+  }
+
+  if (count > 1)
+  {
+    log_error("duplicate key value '{}'", key);
+  }
+
+  return result;
+}
+
+} // namespace prio
+
+/* EOF */
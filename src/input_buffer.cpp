@@ -0,0 +1,188 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "input_buffer.hpp"
+
+#include <errno.h>
+#include <string.h>
+
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+#ifndef _WIN32
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+#include "format_util.hpp"
+#include "reader_error.hpp"
+
+namespace prio {
+
+namespace {
+
+#ifndef _WIN32
+/** Closes the file descriptor when leaving scope */
+class FileDescriptor final
+{
+public:
+  explicit FileDescriptor(int fd) : m_fd(fd) {}
+  ~FileDescriptor() { if (m_fd >= 0) { ::close(m_fd); } }
+
+  int get() const { return m_fd; }
+
+private:
+  int m_fd;
+
+private:
+  FileDescriptor(FileDescriptor const&) = delete;
+  FileDescriptor& operator=(FileDescriptor const&) = delete;
+};
+
+std::string read_fd(int fd, std::filesystem::path const& filename)
+{
+  std::string result;
+  char buf[64 * 1024];
+  while (true) {
+    ssize_t const len = ::read(fd, buf, sizeof(buf));
+    if (len > 0) {
+      result.append(buf, static_cast<std::size_t>(len));
+    } else if (len == 0) {
+      return result;
+    } else if (errno != EINTR) {
+      throw ReaderError(std::format("{}: failed to read: {}", stream_str(filename), strerror(errno)));
+    }
+  }
+}
+#endif
+
+} // namespace
+
+std::shared_ptr<InputBuffer const>
+InputBuffer::from_file(std::filesystem::path const& filename)
+{
+#ifndef _WIN32
+  FileDescriptor fd(::open(filename.c_str(), O_RDONLY | O_CLOEXEC));
+  if (fd.get() < 0) {
+    throw ReaderError(std::format("{}: failed to open: {}", stream_str(filename), strerror(errno)));
+  }
+
+  struct stat st;
+  if (::fstat(fd.get(), &st) != 0) {
+    throw ReaderError(std::format("{}: failed to stat: {}", stream_str(filename), strerror(errno)));
+  }
+
+  // mmap() doesn't work for pipes or devices, small files are read as
+  // their mapping would fault when the file is truncated underneath it
+  if (S_ISREG(st.st_mode) && static_cast<std::size_t>(st.st_size) >= MMAP_THRESHOLD) {
+    std::size_t const size = static_cast<std::size_t>(st.st_size);
+    void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd.get(), 0);
+    if (mapping != MAP_FAILED) {
+      ::madvise(mapping, size, MADV_SEQUENTIAL);
+      return std::shared_ptr<InputBuffer const>(new InputBuffer(mapping, size));
+    }
+  }
+
+  return std::shared_ptr<InputBuffer const>(new InputBuffer(read_fd(fd.get(), filename)));
+#else
+  std::ifstream fin(filename, std::ios::binary);
+  if (!fin) {
+    throw ReaderError(std::format("{}: failed to open: {}", stream_str(filename), strerror(errno)));
+  }
+  return from_stream(fin);
+#endif
+}
+
+std::shared_ptr<InputBuffer const>
+InputBuffer::from_stream(std::istream& stream)
+{
+  std::string text((std::istreambuf_iterator<char>(stream)),
+                   std::istreambuf_iterator<char>());
+  return std::shared_ptr<InputBuffer const>(new InputBuffer(std::move(text)));
+}
+
+std::shared_ptr<InputBuffer const>
+InputBuffer::from_string(std::string text)
+{
+  return std::shared_ptr<InputBuffer const>(new InputBuffer(std::move(text)));
+}
+
+std::shared_ptr<InputBuffer const>
+InputBuffer::borrow(std::string_view text)
+{
+  return std::shared_ptr<InputBuffer const>(new InputBuffer(text));
+}
+
+std::size_t
+InputBuffer::get_memory_usage() const
+{
+  if (m_mapping != nullptr) {
+    return m_size;
+  } else {
+    return m_storage.capacity();
+  }
+}
+
+InputBuffer::InputBuffer(std::string storage) :
+  m_storage(std::move(storage)),
+  m_mapping(nullptr),
+  m_data(m_storage.data()),
+  m_size(m_storage.size())
+{
+}
+
+InputBuffer::InputBuffer(std::string_view borrowed) :
+  m_storage(),
+  m_mapping(nullptr),
+  m_data(borrowed.data()),
+  m_size(borrowed.size())
+{
+}
+
+InputBuffer::InputBuffer(void* mapping, std::size_t size) :
+  m_storage(),
+  m_mapping(mapping),
+  m_data(static_cast<char const*>(mapping)),
+  m_size(size)
+{
+}
+
+void
+InputBuffer::advise_random_access() const
+{
+#ifndef _WIN32
+  if (m_mapping) {
+    ::madvise(m_mapping, m_size, MADV_RANDOM);
+  }
+#endif
+}
+
+InputBuffer::~InputBuffer()
+{
+#ifndef _WIN32
+  if (m_mapping) {
+    ::munmap(m_mapping, m_size);
+  }
+#endif
+}
+
+} // namespace prio
+
+/* EOF */
@@ -0,0 +1,94 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_PRIO_INPUT_BUFFER_HPP
+#define HEADER_PRIO_INPUT_BUFFER_HPP
+
+#include <filesystem>
+#include <iosfwd>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace prio {
+
+/** Contiguous, immutable view of a whole input document. Large regular
+    files are memory mapped, everything else is read into owned storage.
+    The buffer is shared with the documents parsed from it, so backends
+    can keep views into the text for the lifetime of the document. */
+class InputBuffer final
+{
+public:
+  /** Files smaller than this are read instead of mapped */
+  static constexpr std::size_t MMAP_THRESHOLD = 1024 * 1024;
+
+  /** Maps @a filename into memory if it is a regular file of at least
+      MMAP_THRESHOLD bytes, reads it otherwise or when mmap() fails.
+      Truncating a mapped file while the buffer is alive makes accesses
+      to the lost pages fault with SIGBUS, files in use should be
+      replaced by renaming a new file over them instead. Throws
+      ReaderError when the file can't be opened or read. */
+  static std::shared_ptr<InputBuffer const> from_file(std::filesystem::path const& filename);
+
+  /** Reads the remaining content of @a stream */
+  static std::shared_ptr<InputBuffer const> from_stream(std::istream& stream);
+
+  static std::shared_ptr<InputBuffer const> from_string(std::string text);
+
+  /** References @a text without copying it, the caller has to keep the
+      memory alive for as long as the buffer is in use */
+  static std::shared_ptr<InputBuffer const> borrow(std::string_view text);
+
+public:
+  ~InputBuffer();
+
+  std::span<char const> get_span() const { return {m_data, m_size}; }
+  std::string_view get_text() const { return {m_data, m_size}; }
+
+  /** Returns true if the content is backed by a file mapping */
+  bool is_mapped() const { return m_mapping != nullptr; }
+
+  /** Returns the number of bytes held by the buffer, borrowed text
+      doesn't count */
+  std::size_t get_memory_usage() const;
+
+  /** Tells the kernel that the mapping will be accessed out of order,
+      so that only the pages touched are read instead of reading ahead
+      the whole file. Does nothing for buffers that aren't mapped. */
+  void advise_random_access() const;
+
+private:
+  InputBuffer(std::string storage);
+  InputBuffer(std::string_view borrowed);
+  InputBuffer(void* mapping, std::size_t size);
+
+private:
+  std::string m_storage;
+  void* m_mapping;
+  char const* m_data;
+  std::size_t m_size;
+
+private:
+  InputBuffer(InputBuffer const&) = delete;
+  InputBuffer& operator=(InputBuffer const&) = delete;
+};
+
+} // namespace prio
+
+#endif
+
+/* EOF */
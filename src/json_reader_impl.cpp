@@ -16,11 +16,13 @@
 
 #include "json_reader_impl.hpp"
 
+#include <iterator>
 #include <stdexcept>
 
 #include <json/writer.h>
 #include <logmich/log.hpp>
 
+#include "array_values.hpp"
 #include "reader_collection.hpp"
 #include "reader_error.hpp"
 #include "reader_impl.hpp"
@@ -32,15 +34,70 @@
 
 namespace prio {
 
+namespace {
+
+/** Estimates the heap memory used by the children of @a value, jsoncpp
+    keeps both arrays and objects in a std::map */
+std::size_t json_memory_usage(Json::Value const& value)
+{
+  std::size_t result = 0;
+  if (value.isString()) {
+    char const* begin;
+    char const* end;
+    if (value.getString(&begin, &end)) {
+      result += sizeof(unsigned) + static_cast<std::size_t>(end - begin) + 1;
+    }
+  } else if (value.isArray() || value.isObject()) {
+    for (auto it = value.begin(); it != value.end(); ++it) {
+      // tree node with links, color, key and value
+      result += 6 * sizeof(void*) + sizeof(Json::Value) + json_memory_usage(*it);
+      if (value.isObject()) {
+        char const* end;
+        char const* const name = it.memberName(&end);
+        result += static_cast<std::size_t>(end - name) + 1;
+      }
+    }
+  }
+  return result;
+}
+
+/** Looks up the member @a key of @a json, unlike Json::Value::operator[]
+    without copying the key into a std::string */
+Json::Value const& get_member(Json::Value const& json, std::string_view key)
+{
+  Json::Value const* member = json.find(key.data(), key.data() + key.size());
+  return member ? *member : Json::Value::nullSingleton();
+}
+
+} // namespace
+
 JsonReaderDocumentImpl::JsonReaderDocumentImpl(Json::Value value, ErrorHandler error_handler,
                                                std::optional<std::string> filename) :
   m_value(std::move(value)),
   m_error_handler(error_handler),
   m_filename(std::move(filename)),
-  m_parent(nullptr)
+  m_parent(nullptr),
+  m_member_names_mutex(),
+  m_member_names()
 {
 }
 
+std::span<std::string_view const>
+JsonReaderDocumentImpl::get_member_names(Json::Value const& json) const
+{
+  std::lock_guard<std::mutex> lock(m_member_names_mutex);
+  auto [it, inserted] = m_member_names.try_emplace(&json);
+  if (inserted) {
+    it->second.reserve(json.size());
+    for (auto member = json.begin(); member != json.end(); ++member) {
+      char const* end = nullptr;
+      char const* const name = member.memberName(&end);
+      it->second.emplace_back(name, static_cast<std::size_t>(end - name));
+    }
+  }
+  return it->second;
+}
+
 void
 JsonReaderDocumentImpl::error(Json::Value const& json, std::string_view message) const
 {
@@ -66,7 +123,13 @@ JsonReaderDocumentImpl::error(ErrorHandler error_handler, Json::Value const& jso
 ReaderObject
 JsonReaderDocumentImpl::get_root() const
 {
-  return ReaderObject(std::make_unique<JsonReaderObjectImpl>(*this, m_value));
+  return ReaderObject(std::in_place_type<JsonReaderObjectImpl>, *this, m_value);
+}
+
+std::size_t
+JsonReaderDocumentImpl::get_memory_usage() const
+{
+  return sizeof(*this) + json_memory_usage(m_value);
 }
 
 JsonReaderObjectImpl::JsonReaderObjectImpl(JsonReaderDocumentImpl const& doc, Json::Value const& json) :
@@ -90,11 +153,19 @@ JsonReaderObjectImpl::get_name() const
   return it.key().asString();
 }
 
+std::string_view
+JsonReaderObjectImpl::get_name_view() const
+{
+  char const* end = nullptr;
+  char const* const name = m_json.begin().memberName(&end);
+  return std::string_view(name, static_cast<std::size_t>(end - name));
+}
+
 ReaderMapping
 JsonReaderObjectImpl::get_mapping() const
 {
   auto it = m_json.begin();
-  return ReaderMapping(std::make_unique<JsonReaderMappingImpl>(m_doc, *it));
+  return ReaderMapping(std::in_place_type<JsonReaderMappingImpl>, m_doc, *it);
 }
 
 
@@ -118,11 +189,23 @@ JsonReaderCollectionImpl::get_objects() const
   std::vector<ReaderObject> result;
   for(Json::ArrayIndex i = 0; i < m_json.size(); ++i)
   {
-    result.push_back(ReaderObject(std::make_unique<JsonReaderObjectImpl>(m_doc, m_json[i])));
+    result.emplace_back(std::in_place_type<JsonReaderObjectImpl>, m_doc, m_json[i]);
   }
   return result;
 }
 
+std::size_t
+JsonReaderCollectionImpl::get_size() const
+{
+  return m_json.isArray() ? m_json.size() : 0;
+}
+
+ReaderObject
+JsonReaderCollectionImpl::get_object(std::size_t index) const
+{
+  return ReaderObject(std::in_place_type<JsonReaderObjectImpl>, m_doc, m_json[static_cast<Json::ArrayIndex>(index)]);
+}
+
 
 JsonReaderMappingImpl::JsonReaderMappingImpl(JsonReaderDocumentImpl const& doc, Json::Value const& json) :
   m_doc(doc),
@@ -145,8 +228,37 @@ JsonReaderMappingImpl::get_keys() const
   return result;
 }
 
+std::size_t
+JsonReaderMappingImpl::first_key_cursor() const
+{
+  return 0;
+}
+
+std::size_t
+JsonReaderMappingImpl::next_key_cursor(std::size_t cursor) const
+{
+  return cursor + 1;
+}
+
+std::size_t
+JsonReaderMappingImpl::end_key_cursor() const
+{
+  return m_json.size();
+}
+
+std::string_view
+JsonReaderMappingImpl::get_key_at_cursor(std::size_t cursor, std::string& buffer) const
+{
+  if (!m_json.isObject()) {
+    // array elements are keyed by their index
+    buffer = std::to_string(cursor);
+    return buffer;
+  }
+  return m_doc.get_member_names(m_json)[cursor];
+}
+
 #define GET_VALUE_MACRO(type, checker, getter)                  \
-  const Json::Value& element = m_json[std::string(key)];        \
+  const Json::Value& element = get_member(m_json, key);         \
   if (element.isNull()) { return false; }                       \
   if (!element.checker()) {                                     \
     m_doc.error(element, "expected " type);                     \
@@ -156,33 +268,49 @@ JsonReaderMappingImpl::get_keys() const
   return true
 
   bool
-  JsonReaderMappingImpl::read(std::string_view key, bool& value) const
+  JsonReaderMappingImpl::read(Key const& key, bool& value) const
   {
     GET_VALUE_MACRO("bool", isBool, asBool);
   }
 
 bool
-JsonReaderMappingImpl::read(std::string_view key, int& value) const
+JsonReaderMappingImpl::read(Key const& key, int& value) const
 {
   GET_VALUE_MACRO("int", isInt, asInt);
 }
 
 bool
-JsonReaderMappingImpl::read(std::string_view key, float& value) const
+JsonReaderMappingImpl::read(Key const& key, float& value) const
 {
   GET_VALUE_MACRO("double", isDouble, asFloat);
 }
 
 bool
-JsonReaderMappingImpl::read(std::string_view key, std::string& value) const
+JsonReaderMappingImpl::read(Key const& key, std::string& value) const
 {
   GET_VALUE_MACRO("string", isString, asString);
 }
 
+bool
+JsonReaderMappingImpl::read(Key const& key, std::string_view& value) const
+{
+  const Json::Value& element = get_member(m_json, key);
+  if (element.isNull()) { return false; }
+
+  char const* begin = nullptr;
+  char const* end = nullptr;
+  if (!element.isString() || !element.getString(&begin, &end)) {
+    m_doc.error(element, "expected string");
+    return false;
+  }
+  value = std::string_view(begin, static_cast<std::size_t>(end - begin));
+  return true;
+}
+
 #undef GET_VALUE_MACRO
 
 #define GET_VALUES_MACRO(type_, checker_, getter_)              \
-  const Json::Value& element = m_json[std::string(key)];        \
+  const Json::Value& element = get_member(m_json, key);         \
   if (element.isNull()) { return false; }                       \
   if (!element.isArray()) {                                     \
     m_doc.error(element, "expected array");                     \
@@ -196,45 +324,60 @@ JsonReaderMappingImpl::read(std::string_view key, std::string& value) const
     }                                                           \
   }                                                             \
                                                                 \
-  values.resize(element.size());                                \
+  if (!resize_values(values, element.size())) {                 \
+    m_doc.error(element, size_mismatch_message(values.size(), element.size())); \
+    return false;                                               \
+  }                                                             \
   for(Json::Value::ArrayIndex i = 0; i < element.size(); ++i) { \
     values[i] = element[i].getter_();                           \
   }                                                             \
   return true
 
   bool
-  JsonReaderMappingImpl::read(std::string_view key, std::vector<bool>& values) const
+  JsonReaderMappingImpl::read(Key const& key, std::vector<bool>& values) const
   {
     GET_VALUES_MACRO("bool", isBool, asBool);
   }
 
 bool
-JsonReaderMappingImpl::read(std::string_view key, std::vector<int>& values) const
+JsonReaderMappingImpl::read(Key const& key, std::vector<int>& values) const
 {
   GET_VALUES_MACRO("int", isInt, asInt);
 }
 
 bool
-JsonReaderMappingImpl::read(std::string_view key, std::vector<float>& values) const
+JsonReaderMappingImpl::read(Key const& key, std::vector<float>& values) const
 {
   GET_VALUES_MACRO("double", isDouble, asFloat);
 }
 
 bool
-JsonReaderMappingImpl::read(std::string_view key, std::vector<std::string>& values) const
+JsonReaderMappingImpl::read(Key const& key, std::vector<std::string>& values) const
 {
   GET_VALUES_MACRO("string", isString, asString);
 }
 
+bool
+JsonReaderMappingImpl::read(Key const& key, std::span<int> values) const
+{
+  GET_VALUES_MACRO("int", isInt, asInt);
+}
+
+bool
+JsonReaderMappingImpl::read(Key const& key, std::span<float> values) const
+{
+  GET_VALUES_MACRO("double", isDouble, asFloat);
+}
+
 #undef GET_VALUES_MACRO
 
 bool
-JsonReaderMappingImpl::read(std::string_view key, ReaderMapping& value) const
+JsonReaderMappingImpl::read(Key const& key, ReaderMapping& value) const
 {
-  const Json::Value& element = m_json[std::string(key)];
+  const Json::Value& element = get_member(m_json, key);
   if (element.isObject())
   {
-    value = ReaderMapping(std::make_unique<JsonReaderMappingImpl>(m_doc, element));
+    value = ReaderMapping(std::in_place_type<JsonReaderMappingImpl>, m_doc, element);
     return true;
   }
   else
@@ -244,12 +387,12 @@ JsonReaderMappingImpl::read(std::string_view key, ReaderMapping& value) const
 }
 
 bool
-JsonReaderMappingImpl::read(std::string_view key, ReaderCollection& value) const
+JsonReaderMappingImpl::read(Key const& key, ReaderCollection& value) const
 {
-  const Json::Value& element = m_json[std::string(key)];
+  const Json::Value& element = get_member(m_json, key);
   if (element.isArray())
   {
-    value = ReaderCollection(std::make_unique<JsonReaderCollectionImpl>(m_doc, element));
+    value = ReaderCollection(std::in_place_type<JsonReaderCollectionImpl>, m_doc, element);
     return true;
   }
   else
@@ -259,12 +402,12 @@ JsonReaderMappingImpl::read(std::string_view key, ReaderCollection& value) const
 }
 
 bool
-JsonReaderMappingImpl::read(std::string_view key, ReaderObject& value) const
+JsonReaderMappingImpl::read(Key const& key, ReaderObject& value) const
 {
-  const Json::Value& element = m_json[std::string(key)];
+  const Json::Value& element = get_member(m_json, key);
   if (element.isObject())
   {
-    value = ReaderObject(std::make_unique<JsonReaderObjectImpl>(m_doc, element));
+    value = ReaderObject(std::in_place_type<JsonReaderObjectImpl>, m_doc, element);
     return true;
   }
   else
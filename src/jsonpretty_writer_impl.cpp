@@ -18,10 +18,52 @@
 
 #include <sstream>
 #include <ostream>
+#include <variant>
 #include <assert.h>
 
+#include "number_format.hpp"
+#include "string_format.hpp"
+#include "writer_field.hpp"
+
 namespace prio {
 
+namespace {
+
+void append_value(std::string& out, bool value)
+{
+  out += value ? "true" : "false";
+}
+
+void append_value(std::string& out, int value)
+{
+  append_number(out, value);
+}
+
+void append_value(std::string& out, float value)
+{
+  append_number(out, value);
+}
+
+void append_value(std::string& out, std::string const& value)
+{
+  append_quoted_string(out, value);
+}
+
+template<typename T>
+void append_value(std::string& out, std::vector<T> const& values)
+{
+  out += '[';
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    if (i != 0) {
+      out += ", ";
+    }
+    append_value(out, static_cast<T const&>(values[i]));
+  }
+  out += ']';
+}
+
+} // namespace
+
 JsonPrettyWriterImpl::JsonPrettyWriterImpl(std::ostream& out) :
   m_out(out),
   m_depth(0),
@@ -327,6 +369,33 @@ JsonPrettyWriterImpl::write(std::string_view key, std::vector<bool> const& value
   write_separator();
 }
 
+void
+JsonPrettyWriterImpl::write_fields(std::span<WriterField const> fields)
+{
+  assert(m_context.back() == Context::Mapping);
+
+  std::string const indent(static_cast<std::size_t>(m_depth) * 2, ' ');
+
+  std::string text;
+  for (WriterField const& field : fields) {
+    text += m_write_seperator.back() ? ",\n" : "\n";
+    text += indent;
+    if (field.plain_key) {
+      text += '"';
+      text += field.key;
+      text += '"';
+    } else {
+      append_quoted_string(text, field.key);
+    }
+    text += ": ";
+    std::visit([&text](auto const* value) {
+      append_value(text, *value);
+    }, field.value);
+    write_separator();
+  }
+  m_out.write(text.data(), static_cast<std::streamsize>(text.size()));
+}
+
 void
 JsonPrettyWriterImpl::write_separator()
 {
@@ -336,23 +405,7 @@ JsonPrettyWriterImpl::write_separator()
 void
 JsonPrettyWriterImpl::write_quoted_string(std::string_view text)
 {
-  m_out << '"';
-  for(char const c : text) {
-    switch(c) {
-      case '"':
-        m_out << "\\\"";
-        break;
-
-      case '\\':
-        m_out << "\\\\";
-        break;
-
-      default:
-        m_out << c;
-        break;
-    }
-  }
-  m_out << '"';
+  prio::write_quoted_string(m_out, text);
 }
 
 } // namespace prio
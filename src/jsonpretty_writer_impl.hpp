@@ -64,6 +64,8 @@ public:
 
   void write(std::string_view key, std::vector<bool> const& values) override;
 
+  void write_fields(std::span<WriterField const> fields) override;
+
 private:
   inline void write_indent();
   inline void write_separator();
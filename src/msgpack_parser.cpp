@@ -0,0 +1,337 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "msgpack_parser.hpp"
+
+#include <bit>
+#include <format>
+
+#include "reader_error.hpp"
+
+namespace prio {
+
+namespace {
+
+constexpr int MAX_DEPTH = 1024;
+
+using Type = MsgPackTape::Type;
+
+[[noreturn]]
+void parse_error(std::size_t offset, std::string_view message)
+{
+  throw ReaderError(std::format("msgpack parse error: offset {}: {}", offset, message));
+}
+
+std::uint64_t load_be(std::string_view data, std::size_t offset, std::size_t size)
+{
+  std::uint64_t value = 0;
+  for (std::size_t i = 0; i < size; ++i) {
+    value = (value << 8) | static_cast<unsigned char>(data[offset + i]);
+  }
+  return value;
+}
+
+struct Header
+{
+  Type type;
+
+  /** number of elements or entries for containers, payload bytes otherwise */
+  std::uint64_t length;
+
+  /** offset of the payload */
+  std::size_t data;
+};
+
+/** Decodes the type and length bytes of the value at @a offset, the
+    payload itself isn't checked */
+Header decode_header(std::string_view data, std::size_t offset)
+{
+  if (offset >= data.size()) {
+    parse_error(offset, "unexpected end of data");
+  }
+
+  // @a size bytes of big-endian length, followed by @a skip bytes
+  // before the payload (the type byte of ext values)
+  auto const sized = [&](Type type, std::size_t size, std::size_t skip = 0) {
+    if (offset + 1 + size + skip > data.size()) {
+      parse_error(offset, "unexpected end of data");
+    }
+    return Header{type, load_be(data, offset + 1, size), offset + 1 + size + skip};
+  };
+
+  auto const fixed = [&](Type type, std::uint64_t length, std::size_t skip = 0) {
+    return Header{type, length, offset + 1 + skip};
+  };
+
+  std::uint8_t const b = static_cast<std::uint8_t>(data[offset]);
+  if (b <= 0x7f) {
+    return fixed(Type::INTEGER, 0);
+  } else if (b <= 0x8f) {
+    return fixed(Type::MAP, b & 0x0f);
+  } else if (b <= 0x9f) {
+    return fixed(Type::ARRAY, b & 0x0f);
+  } else if (b <= 0xbf) {
+    return fixed(Type::STRING, b & 0x1f);
+  } else if (b >= 0xe0) {
+    return fixed(Type::INTEGER, 0);
+  }
+
+  switch (b) {
+    case 0xc0: return fixed(Type::NIL, 0);
+    case 0xc2: return fixed(Type::BOOLEAN, 0);
+    case 0xc3: return fixed(Type::BOOLEAN, 0);
+    case 0xc4: return sized(Type::BINARY, 1);
+    case 0xc5: return sized(Type::BINARY, 2);
+    case 0xc6: return sized(Type::BINARY, 4);
+    case 0xc7: return sized(Type::EXT, 1, 1);
+    case 0xc8: return sized(Type::EXT, 2, 1);
+    case 0xc9: return sized(Type::EXT, 4, 1);
+    case 0xca: return fixed(Type::REAL, 4);
+    case 0xcb: return fixed(Type::REAL, 8);
+    case 0xcc: return fixed(Type::INTEGER, 1);
+    case 0xcd: return fixed(Type::INTEGER, 2);
+    case 0xce: return fixed(Type::INTEGER, 4);
+    case 0xcf: return fixed(Type::INTEGER, 8);
+    case 0xd0: return fixed(Type::INTEGER, 1);
+    case 0xd1: return fixed(Type::INTEGER, 2);
+    case 0xd2: return fixed(Type::INTEGER, 4);
+    case 0xd3: return fixed(Type::INTEGER, 8);
+    case 0xd4: return fixed(Type::EXT, 1, 1);
+    case 0xd5: return fixed(Type::EXT, 2, 1);
+    case 0xd6: return fixed(Type::EXT, 4, 1);
+    case 0xd7: return fixed(Type::EXT, 8, 1);
+    case 0xd8: return fixed(Type::EXT, 16, 1);
+    case 0xd9: return sized(Type::STRING, 1);
+    case 0xda: return sized(Type::STRING, 2);
+    case 0xdb: return sized(Type::STRING, 4);
+    case 0xdc: return sized(Type::ARRAY, 2);
+    case 0xdd: return sized(Type::ARRAY, 4);
+    case 0xde: return sized(Type::MAP, 2);
+    case 0xdf: return sized(Type::MAP, 4);
+    default: parse_error(offset, std::format("invalid type byte 0x{:02x}", b));
+  }
+}
+
+bool is_container(Type type)
+{
+  return type == Type::ARRAY || type == Type::MAP;
+}
+
+/** Returns the offset one past the value at @a offset */
+std::size_t value_end(std::string_view data, std::size_t offset)
+{
+  std::uint64_t pending = 1;
+  while (pending > 0) {
+    Header const header = decode_header(data, offset);
+    pending -= 1;
+
+    if (header.type == Type::ARRAY) {
+      pending += header.length;
+      offset = header.data;
+    } else if (header.type == Type::MAP) {
+      pending += 2 * header.length;
+      offset = header.data;
+    } else {
+      if (header.data + header.length > data.size()) {
+        parse_error(offset, "unexpected end of data");
+      }
+      offset = header.data + header.length;
+    }
+  }
+  return offset;
+}
+
+} // namespace
+
+class MsgPackParser final
+{
+public:
+  MsgPackParser(std::string_view data, MsgPackTape& tape) :
+    m_data(data),
+    m_pos(0),
+    m_tape(tape)
+  {
+    if (m_data.size() >= UINT32_MAX) {
+      parse_error(0, "input larger than 4GiB is not supported");
+    }
+  }
+
+  void parse()
+  {
+    if (m_data.empty()) {
+      parse_error(0, "document is empty");
+    }
+
+    parse_value(0);
+
+    if (m_pos < m_data.size()) {
+      parse_error(m_pos, "trailing garbage in stream");
+    }
+  }
+
+private:
+  void parse_value(int depth)
+  {
+    Header const header = decode_header(m_data, m_pos);
+
+    std::size_t const entry_index = m_tape.m_entries.size();
+    m_tape.m_entries.push_back(MsgPackTape::Entry{
+        header.type, 0,
+        static_cast<std::uint32_t>(m_pos),
+        static_cast<std::uint32_t>(header.data),
+        static_cast<std::uint32_t>(header.length)});
+
+    if (!is_container(header.type)) {
+      if (header.data + header.length > m_data.size()) {
+        parse_error(m_pos, "unexpected end of data");
+      }
+      m_pos = header.data + header.length;
+      return;
+    }
+
+    if (depth > MAX_DEPTH) {
+      parse_error(m_pos, "document nested too deeply");
+    }
+
+    m_pos = header.data;
+    for (std::uint64_t i = 0; i < header.length; ++i) {
+      if (header.type == Type::MAP) {
+        if (decode_header(m_data, m_pos).type != Type::STRING) {
+          parse_error(m_pos, "map key is not a string");
+        }
+        parse_value(depth + 1);
+      }
+      parse_value(depth + 1);
+    }
+
+    m_tape.m_entries[entry_index].link = static_cast<std::uint32_t>(m_tape.m_entries.size());
+  }
+
+private:
+  std::string_view m_data;
+  std::size_t m_pos;
+  MsgPackTape& m_tape;
+
+private:
+  MsgPackParser(MsgPackParser const&) = delete;
+  MsgPackParser& operator=(MsgPackParser const&) = delete;
+};
+
+MsgPackTape
+msgpack_parse(std::string_view data)
+{
+  MsgPackTape tape;
+  MsgPackParser parser(data, tape);
+  parser.parse();
+  return tape;
+}
+
+std::vector<std::string_view>
+msgpack_split_values(std::string_view data)
+{
+  std::vector<std::string_view> result;
+  std::size_t offset = 0;
+  while (offset < data.size()) {
+    std::size_t const end = value_end(data, offset);
+    result.push_back(data.substr(offset, end - offset));
+    offset = end;
+  }
+  return result;
+}
+
+bool
+msgpack_is_map(std::string_view data)
+{
+  if (data.empty()) {
+    return false;
+  }
+
+  std::uint8_t const b = static_cast<std::uint8_t>(data[0]);
+  return (b >= 0x80 && b <= 0x8f) || b == 0xde || b == 0xdf;
+}
+
+bool
+MsgPackTape::get_bool(std::string_view source, std::uint32_t index) const
+{
+  return static_cast<std::uint8_t>(source[m_entries[index].source]) == 0xc3;
+}
+
+bool
+MsgPackTape::get_integer(std::string_view source, std::uint32_t index, std::int64_t& value) const
+{
+  Entry const& entry = m_entries[index];
+  std::uint8_t const b = static_cast<std::uint8_t>(source[entry.source]);
+  if (b <= 0x7f) {
+    value = b;
+  } else if (b >= 0xe0) {
+    value = static_cast<std::int8_t>(b);
+  } else if (b >= 0xcc && b <= 0xcf) {
+    std::uint64_t const u = load_be(source, entry.data, entry.length);
+    if (u > static_cast<std::uint64_t>(INT64_MAX)) {
+      return false;
+    }
+    value = static_cast<std::int64_t>(u);
+  } else {
+    // sign extend the big-endian two's complement value
+    unsigned const shift = 64 - 8 * entry.length;
+    value = static_cast<std::int64_t>(load_be(source, entry.data, entry.length) << shift) >> shift;
+  }
+  return true;
+}
+
+double
+MsgPackTape::get_real(std::string_view source, std::uint32_t index) const
+{
+  Entry const& entry = m_entries[index];
+  if (entry.type == Type::INTEGER) {
+    std::int64_t value;
+    if (get_integer(source, index, value)) {
+      return static_cast<double>(value);
+    } else {
+      return static_cast<double>(load_be(source, entry.data, entry.length));
+    }
+  } else if (entry.length == 4) {
+    return std::bit_cast<float>(static_cast<std::uint32_t>(load_be(source, entry.data, 4)));
+  } else {
+    return std::bit_cast<double>(load_be(source, entry.data, 8));
+  }
+}
+
+std::string_view
+MsgPackTape::get_string(std::string_view source, std::uint32_t index) const
+{
+  Entry const& entry = m_entries[index];
+  return source.substr(entry.data, entry.length);
+}
+
+std::uint32_t
+MsgPackTape::find_member(std::string_view source, std::uint32_t index, std::string_view key) const
+{
+  if (m_entries[index].type != Type::MAP) {
+    return npos;
+  }
+
+  for (std::uint32_t i = index + 1; i < m_entries[index].link; i = next(i + 1)) {
+    if (get_string(source, i) == key) {
+      return i + 1;
+    }
+  }
+  return npos;
+}
+
+} // namespace prio
+
+/* EOF */
@@ -0,0 +1,126 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_PRIO_MSGPACK_PARSER_HPP
+#define HEADER_PRIO_MSGPACK_PARSER_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace prio {
+
+/** Flat representation of a parsed MessagePack value, laid out like
+    FastJsonTape: values are stored in document order, containers are
+    followed by their children and know the index one past their last
+    child. Map entries are stored as key, value pairs.
+
+    Only the structure is recorded, numbers are decoded on access and
+    strings are returned as views into the input. */
+class MsgPackTape final
+{
+public:
+  enum class Type : std::uint8_t
+  {
+    NIL,
+    BOOLEAN,
+    INTEGER,
+    REAL,
+    STRING,
+    BINARY,
+    EXT,
+    ARRAY,
+    MAP
+  };
+
+  struct Entry
+  {
+    Type type;
+
+    /** ARRAY/MAP: tape index one past the last child */
+    std::uint32_t link;
+
+    /** offset of the value's first byte in the input */
+    std::uint32_t source;
+
+    /** offset of the payload following the type and length bytes */
+    std::uint32_t data;
+
+    /** ARRAY/MAP: number of elements or entries, everything else:
+        number of payload bytes */
+    std::uint32_t length;
+  };
+
+public:
+  MsgPackTape() : m_entries() {}
+
+  Entry const& operator[](std::uint32_t index) const { return m_entries[index]; }
+  std::uint32_t size() const { return static_cast<std::uint32_t>(m_entries.size()); }
+
+  /** Returns the number of bytes held by the tape */
+  std::size_t get_memory_usage() const { return sizeof(*this) + m_entries.capacity() * sizeof(Entry); }
+
+  /** Returns the index of the value following the one at @a index */
+  std::uint32_t next(std::uint32_t index) const {
+    Entry const& entry = m_entries[index];
+    return (entry.type == Type::ARRAY || entry.type == Type::MAP) ? entry.link : index + 1;
+  }
+
+  bool get_bool(std::string_view source, std::uint32_t index) const;
+
+  /** Decodes the INTEGER at @a index, returns false if it doesn't fit
+      into 64 signed bits */
+  bool get_integer(std::string_view source, std::uint32_t index, std::int64_t& value) const;
+
+  /** Decodes the INTEGER or REAL at @a index */
+  double get_real(std::string_view source, std::uint32_t index) const;
+
+  /** Returns a view of the STRING at @a index */
+  std::string_view get_string(std::string_view source, std::uint32_t index) const;
+
+  /** Returns the index of the value of the entry named @a key in the MAP
+      at @a index; the first of several duplicate keys wins */
+  std::uint32_t find_member(std::string_view source, std::uint32_t index, std::string_view key) const;
+
+  static constexpr std::uint32_t npos = UINT32_MAX;
+
+private:
+  friend class MsgPackParser;
+
+  std::vector<Entry> m_entries;
+};
+
+/** Builds a MsgPackTape for @a data, which has to contain exactly one
+    MessagePack value. Map keys have to be strings. Throws ReaderError
+    on malformed or truncated input. */
+MsgPackTape msgpack_parse(std::string_view data);
+
+/** Splits a sequence of concatenated MessagePack values into the
+    individual values. Only the type and length bytes are looked at, the
+    values themselves are not validated. Throws ReaderError on truncated
+    input. */
+std::vector<std::string_view> msgpack_split_values(std::string_view data);
+
+/** Returns true if @a data starts like a MessagePack encoded prio
+    document, which is a map */
+bool msgpack_is_map(std::string_view data);
+
+} // namespace prio
+
+#endif
+
+/* EOF */
@@ -0,0 +1,654 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "msgpack_reader_impl.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <format>
+#include <utility>
+#include <variant>
+
+#include <logmich/log.hpp>
+
+#include "array_values.hpp"
+#include "input_buffer.hpp"
+#include "msgpack_parser.hpp"
+#include "reader_collection.hpp"
+#include "reader_error.hpp"
+#include "reader_mapping.hpp"
+#include "reader_object.hpp"
+
+namespace prio {
+
+namespace {
+
+using Type = MsgPackTape::Type;
+using Entry = MsgPackTape::Entry;
+
+// The predicates follow the jsoncpp ones used by JsonReaderMappingImpl,
+// so that documents read the same as their JSON equivalent. Values are only
+// decoded from the input here, on access.
+
+bool is_bool(MsgPackReaderDocumentImpl const& doc, std::uint32_t index)
+{
+  return doc.get_tape()[index].type == Type::BOOLEAN;
+}
+
+bool is_int(MsgPackReaderDocumentImpl const& doc, std::uint32_t index)
+{
+  MsgPackTape const& tape = doc.get_tape();
+  if (tape[index].type == Type::INTEGER) {
+    std::int64_t value;
+    return tape.get_integer(doc.get_data(), index, value) && value >= INT_MIN && value <= INT_MAX;
+  } else if (tape[index].type == Type::REAL) {
+    double const value = tape.get_real(doc.get_data(), index);
+    double intpart;
+    return value >= INT_MIN && value <= INT_MAX && std::modf(value, &intpart) == 0.0;
+  } else {
+    return false;
+  }
+}
+
+bool is_double(MsgPackReaderDocumentImpl const& doc, std::uint32_t index)
+{
+  Type const type = doc.get_tape()[index].type;
+  return type == Type::INTEGER || type == Type::REAL;
+}
+
+bool is_string(MsgPackReaderDocumentImpl const& doc, std::uint32_t index)
+{
+  return doc.get_tape()[index].type == Type::STRING;
+}
+
+bool as_bool(MsgPackReaderDocumentImpl const& doc, std::uint32_t index)
+{
+  return doc.get_tape().get_bool(doc.get_data(), index);
+}
+
+int as_int(MsgPackReaderDocumentImpl const& doc, std::uint32_t index)
+{
+  std::int64_t value;
+  if (doc.get_tape()[index].type == Type::INTEGER &&
+      doc.get_tape().get_integer(doc.get_data(), index, value)) {
+    return static_cast<int>(value);
+  } else {
+    return static_cast<int>(doc.get_tape().get_real(doc.get_data(), index));
+  }
+}
+
+float as_float(MsgPackReaderDocumentImpl const& doc, std::uint32_t index)
+{
+  return static_cast<float>(doc.get_tape().get_real(doc.get_data(), index));
+}
+
+std::string as_string(MsgPackReaderDocumentImpl const& doc, std::uint32_t index)
+{
+  return std::string(doc.get_tape().get_string(doc.get_data(), index));
+}
+
+std::string_view as_string_view(MsgPackReaderDocumentImpl const& doc, std::uint32_t index)
+{
+  return doc.get_tape().get_string(doc.get_data(), index);
+}
+
+} // namespace
+
+MsgPackReaderDocumentImpl::MsgPackReaderDocumentImpl(std::shared_ptr<InputBuffer const> buffer, ErrorHandler error_handler,
+                                                     std::optional<std::string> filename) :
+  MsgPackReaderDocumentImpl(buffer, buffer->get_text(), error_handler, std::move(filename))
+{
+}
+
+MsgPackReaderDocumentImpl::MsgPackReaderDocumentImpl(std::shared_ptr<InputBuffer const> buffer, std::string_view data,
+                                                     ErrorHandler error_handler, std::optional<std::string> filename) :
+  m_buffer(std::move(buffer)),
+  m_data(data),
+  m_base(static_cast<std::size_t>(data.data() - m_buffer->get_text().data())),
+  m_tape(std::make_unique<MsgPackTape>(msgpack_parse(m_data))),
+  m_error_handler(error_handler),
+  m_filename(std::move(filename)),
+  m_parent(nullptr)
+{
+}
+
+MsgPackReaderDocumentImpl::~MsgPackReaderDocumentImpl()
+{
+}
+
+void
+MsgPackReaderDocumentImpl::error(std::uint32_t index, std::string_view message) const
+{
+  error(m_error_handler, index, message);
+}
+
+void
+MsgPackReaderDocumentImpl::error(ErrorHandler error_handler, std::uint32_t index, std::string_view message) const
+{
+  switch (error_handler) {
+    case ErrorHandler::THROW:
+      throw ReaderError(std::format("{}: offset {}: {}", m_filename ? *m_filename : "<unknown>",
+                                    m_base + (*m_tape)[index].source, message));
+
+    case ErrorHandler::LOG:
+      log_error("{}: offset {}: {}", m_filename ? *m_filename : "<unknown>",
+                m_base + (*m_tape)[index].source, message);
+      break;
+
+    case ErrorHandler::IGNORE:
+      break;
+  }
+}
+
+ReaderObject
+MsgPackReaderDocumentImpl::get_root() const
+{
+  return ReaderObject(std::in_place_type<MsgPackReaderObjectImpl>, *this, 0);
+}
+
+std::size_t
+MsgPackReaderDocumentImpl::get_memory_usage() const
+{
+  // documents from parse_many() share one buffer, only count this one's part
+  return sizeof(*this) + std::min(m_data.size(), m_buffer->get_memory_usage()) + m_tape->get_memory_usage();
+}
+
+MsgPackReaderObjectImpl::MsgPackReaderObjectImpl(MsgPackReaderDocumentImpl const& doc, std::uint32_t index) :
+  m_doc(doc),
+  m_index(index)
+{
+  MsgPackTape const& tape = m_doc.get_tape();
+  if (tape[m_index].type != Type::MAP ||
+      tape[m_index].link == m_index + 1 ||
+      tape.next(m_index + 2) != tape[m_index].link)
+  {
+    m_doc.error(m_index, "expected map with one element");
+  }
+}
+
+MsgPackReaderObjectImpl::~MsgPackReaderObjectImpl()
+{
+}
+
+std::string
+MsgPackReaderObjectImpl::get_name() const
+{
+  return std::string(get_name_view());
+}
+
+std::string_view
+MsgPackReaderObjectImpl::get_name_view() const
+{
+  Entry const& entry = m_doc.get_tape()[m_index];
+  if (entry.type != Type::MAP || entry.link == m_index + 1) {
+    return {};
+  }
+
+  return as_string_view(m_doc, m_index + 1);
+}
+
+ReaderMapping
+MsgPackReaderObjectImpl::get_mapping() const
+{
+  Entry const& entry = m_doc.get_tape()[m_index];
+  if (entry.type != Type::MAP || entry.link == m_index + 1) {
+    return {};
+  }
+
+  return ReaderMapping(std::in_place_type<MsgPackReaderMappingImpl>, m_doc, m_index + 2);
+}
+
+
+MsgPackReaderCollectionImpl::MsgPackReaderCollectionImpl(MsgPackReaderDocumentImpl const& doc, std::uint32_t index) :
+  m_doc(doc),
+  m_index(index),
+  m_elements(nullptr)
+{
+  if (m_doc.get_tape()[m_index].type != Type::ARRAY)
+  {
+    m_doc.error(m_index, "expected array");
+  }
+}
+
+MsgPackReaderCollectionImpl::MsgPackReaderCollectionImpl(MsgPackReaderCollectionImpl&& other) noexcept :
+  m_doc(other.m_doc),
+  m_index(other.m_index),
+  m_elements(other.m_elements.exchange(nullptr))
+{
+}
+
+MsgPackReaderCollectionImpl::~MsgPackReaderCollectionImpl()
+{
+  delete m_elements.load();
+}
+
+std::vector<ReaderObject>
+MsgPackReaderCollectionImpl::get_objects() const
+{
+  MsgPackTape const& tape = m_doc.get_tape();
+  if (tape[m_index].type != Type::ARRAY) {
+    return {};
+  }
+
+  std::vector<ReaderObject> result;
+  for (std::uint32_t i = m_index + 1; i < tape[m_index].link; i = tape.next(i))
+  {
+    result.emplace_back(std::in_place_type<MsgPackReaderObjectImpl>, m_doc, i);
+  }
+  return result;
+}
+
+std::size_t
+MsgPackReaderCollectionImpl::get_size() const
+{
+  MsgPackTape const& tape = m_doc.get_tape();
+  return (tape[m_index].type == Type::ARRAY) ? tape[m_index].length : 0;
+}
+
+ReaderObject
+MsgPackReaderCollectionImpl::get_object(std::size_t index) const
+{
+  return get_object_at_cursor(get_elements()[index]);
+}
+
+MsgPackReaderCollectionImpl::Elements const&
+MsgPackReaderCollectionImpl::get_elements() const
+{
+  Elements const* elements = m_elements.load(std::memory_order_acquire);
+  if (elements != nullptr) {
+    return *elements;
+  }
+
+  auto result = std::make_unique<Elements>();
+  result->reserve(get_size());
+  for (std::size_t i = first_cursor(); i != end_cursor(); i = next_cursor(i)) {
+    result->push_back(static_cast<std::uint32_t>(i));
+  }
+
+  if (m_elements.compare_exchange_strong(elements, result.get(), std::memory_order_acq_rel)) {
+    return *result.release();
+  }
+  // another thread was faster, elements now holds its index
+  return *elements;
+}
+
+std::size_t
+MsgPackReaderCollectionImpl::first_cursor() const
+{
+  return (m_doc.get_tape()[m_index].type == Type::ARRAY) ? m_index + 1 : end_cursor();
+}
+
+std::size_t
+MsgPackReaderCollectionImpl::next_cursor(std::size_t cursor) const
+{
+  return m_doc.get_tape().next(static_cast<std::uint32_t>(cursor));
+}
+
+std::size_t
+MsgPackReaderCollectionImpl::end_cursor() const
+{
+  MsgPackTape const& tape = m_doc.get_tape();
+  return (tape[m_index].type == Type::ARRAY) ? tape[m_index].link : m_index;
+}
+
+ReaderObject
+MsgPackReaderCollectionImpl::get_object_at_cursor(std::size_t cursor) const
+{
+  return ReaderObject(std::in_place_type<MsgPackReaderObjectImpl>, m_doc, static_cast<std::uint32_t>(cursor));
+}
+
+
+MsgPackReaderMappingImpl::MsgPackReaderMappingImpl(MsgPackReaderDocumentImpl const& doc, std::uint32_t index) :
+  m_doc(doc),
+  m_index(index)
+{
+}
+
+MsgPackReaderMappingImpl::~MsgPackReaderMappingImpl()
+{
+}
+
+std::vector<std::string>
+MsgPackReaderMappingImpl::get_keys() const
+{
+  std::vector<std::string> result;
+  std::string buffer;
+  for (std::size_t i = first_key_cursor(); i != end_key_cursor(); i = next_key_cursor(i)) {
+    result.emplace_back(get_key_at_cursor(i, buffer));
+  }
+  return result;
+}
+
+std::size_t
+MsgPackReaderMappingImpl::first_key_cursor() const
+{
+  return m_index + 1;
+}
+
+std::size_t
+MsgPackReaderMappingImpl::next_key_cursor(std::size_t cursor) const
+{
+  // skip the key and its value
+  return m_doc.get_tape().next(static_cast<std::uint32_t>(cursor) + 1);
+}
+
+std::size_t
+MsgPackReaderMappingImpl::end_key_cursor() const
+{
+  MsgPackTape const& tape = m_doc.get_tape();
+  if (tape[m_index].type != Type::MAP) {
+    return m_index + 1;
+  }
+  return tape[m_index].link;
+}
+
+std::string_view
+MsgPackReaderMappingImpl::get_key_at_cursor(std::size_t cursor, std::string& /*buffer*/) const
+{
+  return m_doc.get_tape().get_string(m_doc.get_data(), static_cast<std::uint32_t>(cursor));
+}
+
+std::uint32_t
+MsgPackReaderMappingImpl::find(std::string_view key) const
+{
+  MsgPackTape const& tape = m_doc.get_tape();
+  std::uint32_t const index = tape.find_member(m_doc.get_data(), m_index, key);
+  if (index == MsgPackTape::npos || tape[index].type == Type::NIL) {
+    return MsgPackTape::npos;
+  }
+  return index;
+}
+
+bool
+MsgPackReaderMappingImpl::read(Key const& key, bool& value) const
+{
+  return read_element(find(key), value);
+}
+
+bool
+MsgPackReaderMappingImpl::read(Key const& key, int& value) const
+{
+  return read_element(find(key), value);
+}
+
+bool
+MsgPackReaderMappingImpl::read(Key const& key, float& value) const
+{
+  return read_element(find(key), value);
+}
+
+bool
+MsgPackReaderMappingImpl::read(Key const& key, std::string& value) const
+{
+  return read_element(find(key), value);
+}
+
+bool
+MsgPackReaderMappingImpl::read(Key const& key, std::vector<bool>& values) const
+{
+  return read_element(find(key), values);
+}
+
+bool
+MsgPackReaderMappingImpl::read(Key const& key, std::vector<int>& values) const
+{
+  return read_element(find(key), values);
+}
+
+bool
+MsgPackReaderMappingImpl::read(Key const& key, std::vector<float>& values) const
+{
+  return read_element(find(key), values);
+}
+
+bool
+MsgPackReaderMappingImpl::read(Key const& key, std::vector<std::string>& values) const
+{
+  return read_element(find(key), values);
+}
+
+bool
+MsgPackReaderMappingImpl::read(Key const& key, std::string_view& value) const
+{
+  return read_element(find(key), value);
+}
+
+bool
+MsgPackReaderMappingImpl::read(Key const& key, std::span<int> values) const
+{
+  return read_element(find(key), values);
+}
+
+bool
+MsgPackReaderMappingImpl::read(Key const& key, std::span<float> values) const
+{
+  return read_element(find(key), values);
+}
+
+bool
+MsgPackReaderMappingImpl::read(Key const& key, ReaderObject& value) const
+{
+  return read_element(find(key), value);
+}
+
+bool
+MsgPackReaderMappingImpl::read(Key const& key, ReaderCollection& value) const
+{
+  return read_element(find(key), value);
+}
+
+bool
+MsgPackReaderMappingImpl::read(Key const& key, ReaderMapping& value) const
+{
+  return read_element(find(key), value);
+}
+
+void
+MsgPackReaderMappingImpl::read_fields(ReaderFieldTable const& fields, std::span<bool> found) const
+{
+  MsgPackTape const& tape = m_doc.get_tape();
+  if (tape[m_index].type != Type::MAP) {
+    return;
+  }
+
+  for (std::uint32_t i = m_index + 1; i < tape[m_index].link; i = tape.next(i + 1))
+  {
+    std::string_view const name = tape.get_string(m_doc.get_data(), i);
+
+    std::size_t const field = fields.find(name);
+    if (field == fields.size()) {
+      continue;
+    }
+
+    if (found[field]) {
+      // like find(), the first of several duplicate keys wins
+      continue;
+    }
+
+    if (tape[i + 1].type == Type::NIL) {
+      continue;
+    }
+
+    found[field] = std::visit([this, i](auto* target) {
+      return read_element(i + 1, *target);
+    }, fields[field].target);
+  }
+}
+
+#define GET_VALUE_MACRO(type, checker, getter)                  \
+  if (element == MsgPackTape::npos) { return false; }          \
+  if (!checker(m_doc, element)) {                               \
+    m_doc.error(element, "expected " type);                     \
+    return false;                                               \
+  }                                                             \
+  value = getter(m_doc, element);                               \
+  return true
+
+bool
+MsgPackReaderMappingImpl::read_element(std::uint32_t element, bool& value) const
+{
+  GET_VALUE_MACRO("bool", is_bool, as_bool);
+}
+
+bool
+MsgPackReaderMappingImpl::read_element(std::uint32_t element, int& value) const
+{
+  GET_VALUE_MACRO("int", is_int, as_int);
+}
+
+bool
+MsgPackReaderMappingImpl::read_element(std::uint32_t element, float& value) const
+{
+  GET_VALUE_MACRO("double", is_double, as_float);
+}
+
+bool
+MsgPackReaderMappingImpl::read_element(std::uint32_t element, std::string& value) const
+{
+  GET_VALUE_MACRO("string", is_string, as_string);
+}
+
+bool
+MsgPackReaderMappingImpl::read_element(std::uint32_t element, std::string_view& value) const
+{
+  GET_VALUE_MACRO("string", is_string, as_string_view);
+}
+
+#undef GET_VALUE_MACRO
+
+#define GET_VALUES_MACRO(type_, checker_, getter_)                      \
+  MsgPackTape const& tape = m_doc.get_tape();                          \
+  if (element == MsgPackTape::npos) { return false; }                  \
+  if (tape[element].type != Type::ARRAY) {                              \
+    m_doc.error(element, "expected array");                             \
+    return false;                                                       \
+  }                                                                     \
+                                                                        \
+  std::size_t count = 0;                                                \
+  for (std::uint32_t i = element + 1; i < tape[element].link; i = tape.next(i)) { \
+    if (!checker_(m_doc, i)) {                                          \
+      m_doc.error(i, "expected " type_);                                \
+      return false;                                                     \
+    }                                                                   \
+    count += 1;                                                         \
+  }                                                                     \
+                                                                        \
+  if (!resize_values(values, count)) {                                  \
+    m_doc.error(element, size_mismatch_message(values.size(), count));  \
+    return false;                                                       \
+  }                                                                     \
+  std::size_t j = 0;                                                    \
+  for (std::uint32_t i = element + 1; i < tape[element].link; i = tape.next(i)) { \
+    values[j++] = getter_(m_doc, i);                                    \
+  }                                                                     \
+  return true
+
+bool
+MsgPackReaderMappingImpl::read_element(std::uint32_t element, std::vector<bool>& values) const
+{
+  GET_VALUES_MACRO("bool", is_bool, as_bool);
+}
+
+bool
+MsgPackReaderMappingImpl::read_element(std::uint32_t element, std::vector<int>& values) const
+{
+  GET_VALUES_MACRO("int", is_int, as_int);
+}
+
+bool
+MsgPackReaderMappingImpl::read_element(std::uint32_t element, std::vector<float>& values) const
+{
+  GET_VALUES_MACRO("double", is_double, as_float);
+}
+
+bool
+MsgPackReaderMappingImpl::read_element(std::uint32_t element, std::vector<std::string>& values) const
+{
+  GET_VALUES_MACRO("string", is_string, as_string);
+}
+
+bool
+MsgPackReaderMappingImpl::read_element(std::uint32_t element, std::span<int> values) const
+{
+  GET_VALUES_MACRO("int", is_int, as_int);
+}
+
+bool
+MsgPackReaderMappingImpl::read_element(std::uint32_t element, std::span<float> values) const
+{
+  GET_VALUES_MACRO("double", is_double, as_float);
+}
+
+#undef GET_VALUES_MACRO
+
+bool
+MsgPackReaderMappingImpl::read_element(std::uint32_t element, ReaderMapping& value) const
+{
+  if (element != MsgPackTape::npos && m_doc.get_tape()[element].type == Type::MAP)
+  {
+    value = ReaderMapping(std::in_place_type<MsgPackReaderMappingImpl>, m_doc, element);
+    return true;
+  }
+  else
+  {
+    return false;
+  }
+}
+
+bool
+MsgPackReaderMappingImpl::read_element(std::uint32_t element, ReaderCollection& value) const
+{
+  if (element != MsgPackTape::npos && m_doc.get_tape()[element].type == Type::ARRAY)
+  {
+    value = ReaderCollection(std::in_place_type<MsgPackReaderCollectionImpl>, m_doc, element);
+    return true;
+  }
+  else
+  {
+    return false;
+  }
+}
+
+bool
+MsgPackReaderMappingImpl::read_element(std::uint32_t element, ReaderObject& value) const
+{
+  if (element != MsgPackTape::npos && m_doc.get_tape()[element].type == Type::MAP)
+  {
+    value = ReaderObject(std::in_place_type<MsgPackReaderObjectImpl>, m_doc, element);
+    return true;
+  }
+  else
+  {
+    return false;
+  }
+}
+
+void
+MsgPackReaderMappingImpl::error(std::string_view key, std::string_view message) const
+{
+  m_doc.error(m_index, std::format("{}: {}", key, message));
+}
+
+void
+MsgPackReaderMappingImpl::missing_key_error(std::string_view key) const
+{
+  m_doc.error(ErrorHandler::THROW, m_index, std::format("required key not found: {}", key));
+}
+
+} // namespace prio
+
+/* EOF */
@@ -0,0 +1,344 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "msgpack_writer_impl.hpp"
+
+#include <assert.h>
+
+#include <bit>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+
+namespace prio {
+
+namespace {
+
+constexpr std::size_t KEYVALUE = std::numeric_limits<std::size_t>::max();
+
+void append_be(std::string& out, std::uint64_t value, int bytes)
+{
+  for (int i = bytes - 1; i >= 0; --i) {
+    out += static_cast<char>((value >> (i * 8)) & 0xff);
+  }
+}
+
+void append_header(std::string& out, bool map, std::uint32_t count)
+{
+  if (count < 16) {
+    out += static_cast<char>((map ? 0x80 : 0x90) | count);
+  } else if (count <= 0xffff) {
+    out += static_cast<char>(map ? 0xde : 0xdc);
+    append_be(out, count, 2);
+  } else {
+    out += static_cast<char>(map ? 0xdf : 0xdd);
+    append_be(out, count, 4);
+  }
+}
+
+std::uint32_t checked_size(std::size_t size)
+{
+  if (size > std::numeric_limits<std::uint32_t>::max()) {
+    throw std::runtime_error("msgpack writer: containers and strings larger than 4GiB are not supported");
+  }
+  return static_cast<std::uint32_t>(size);
+}
+
+} // namespace
+
+MsgPackWriterImpl::MsgPackWriterImpl(std::ostream& out) :
+  m_out(out),
+  m_buffer(),
+  m_headers(),
+  m_stack()
+{
+}
+
+MsgPackWriterImpl::~MsgPackWriterImpl()
+{
+  assert(m_stack.empty());
+}
+
+void
+MsgPackWriterImpl::begin_collection(std::string_view key)
+{
+  begin_entry(key);
+  begin_container(false);
+}
+
+void
+MsgPackWriterImpl::end_collection()
+{
+  end_container();
+}
+
+void
+MsgPackWriterImpl::begin_object(std::string_view type)
+{
+  if (m_stack.empty()) { // root
+    m_buffer.clear();
+    m_headers.clear();
+  } else {
+    assert(m_stack.back() == KEYVALUE || !m_headers[m_stack.back()].map);
+    begin_entry({});
+  }
+
+  // {"type": {...properties...}}
+  begin_container(true);
+  begin_entry(type);
+  begin_container(true);
+}
+
+void
+MsgPackWriterImpl::end_object()
+{
+  end_container();
+  end_container();
+
+  if (m_stack.empty()) {
+    flush();
+  }
+}
+
+void
+MsgPackWriterImpl::begin_mapping(std::string_view key)
+{
+  begin_entry(key);
+  begin_container(true);
+}
+
+void
+MsgPackWriterImpl::end_mapping()
+{
+  end_container();
+}
+
+void
+MsgPackWriterImpl::begin_keyvalue(std::string_view key)
+{
+  begin_entry(key);
+  m_stack.push_back(KEYVALUE);
+}
+
+void
+MsgPackWriterImpl::end_keyvalue()
+{
+  assert(!m_stack.empty() && m_stack.back() == KEYVALUE);
+  m_stack.pop_back();
+}
+
+void
+MsgPackWriterImpl::write(std::string_view key, bool value)
+{
+  begin_entry(key);
+  write_bool(value);
+}
+
+void
+MsgPackWriterImpl::write(std::string_view key, int value)
+{
+  begin_entry(key);
+  write_int(value);
+}
+
+void
+MsgPackWriterImpl::write(std::string_view key, float value)
+{
+  begin_entry(key);
+  write_float(value);
+}
+
+void
+MsgPackWriterImpl::write(std::string_view key, char const* value)
+{
+  write(key, std::string_view(value));
+}
+
+void
+MsgPackWriterImpl::write(std::string_view key, std::string_view value)
+{
+  begin_entry(key);
+  write_string(value);
+}
+
+void
+MsgPackWriterImpl::write(std::string_view key, std::span<bool const> values)
+{
+  begin_entry(key);
+  append_header(m_buffer, false, checked_size(values.size()));
+  for (bool const value : values) {
+    write_bool(value);
+  }
+}
+
+void
+MsgPackWriterImpl::write(std::string_view key, std::span<int const> values)
+{
+  begin_entry(key);
+  append_header(m_buffer, false, checked_size(values.size()));
+  for (int const value : values) {
+    write_int(value);
+  }
+}
+
+void
+MsgPackWriterImpl::write(std::string_view key, std::span<float const> values)
+{
+  begin_entry(key);
+  append_header(m_buffer, false, checked_size(values.size()));
+  for (float const value : values) {
+    write_float(value);
+  }
+}
+
+void
+MsgPackWriterImpl::write(std::string_view key, std::span<std::string const> values)
+{
+  begin_entry(key);
+  append_header(m_buffer, false, checked_size(values.size()));
+  for (std::string const& value : values) {
+    write_string(value);
+  }
+}
+
+void
+MsgPackWriterImpl::write(std::string_view key, std::vector<bool> const& values)
+{
+  begin_entry(key);
+  append_header(m_buffer, false, checked_size(values.size()));
+  for (bool const value : values) {
+    write_bool(value);
+  }
+}
+
+void
+MsgPackWriterImpl::begin_entry(std::string_view key)
+{
+  if (m_stack.empty() || m_stack.back() == KEYVALUE) {
+    // the root and the value of a keyvalue aren't counted
+    return;
+  }
+
+  Header& header = m_headers[m_stack.back()];
+  header.count += 1;
+  if (header.map) {
+    write_string(key);
+  }
+}
+
+void
+MsgPackWriterImpl::begin_container(bool map)
+{
+  m_stack.push_back(m_headers.size());
+  m_headers.push_back(Header{m_buffer.size(), map, 0});
+}
+
+void
+MsgPackWriterImpl::end_container()
+{
+  assert(!m_stack.empty() && m_stack.back() != KEYVALUE);
+  m_stack.pop_back();
+}
+
+void
+MsgPackWriterImpl::write_bool(bool value)
+{
+  m_buffer += static_cast<char>(value ? 0xc3 : 0xc2);
+}
+
+void
+MsgPackWriterImpl::write_int(int value)
+{
+  if (value >= 0) {
+    if (value < 0x80) {
+      m_buffer += static_cast<char>(value);
+    } else if (value <= 0xff) {
+      m_buffer += static_cast<char>(0xcc);
+      append_be(m_buffer, static_cast<std::uint64_t>(value), 1);
+    } else if (value <= 0xffff) {
+      m_buffer += static_cast<char>(0xcd);
+      append_be(m_buffer, static_cast<std::uint64_t>(value), 2);
+    } else {
+      m_buffer += static_cast<char>(0xce);
+      append_be(m_buffer, static_cast<std::uint64_t>(value), 4);
+    }
+  } else {
+    std::uint32_t const bits = std::bit_cast<std::uint32_t>(value);
+    if (value >= -32) {
+      m_buffer += static_cast<char>(bits & 0xff);
+    } else if (value >= -0x80) {
+      m_buffer += static_cast<char>(0xd0);
+      append_be(m_buffer, bits, 1);
+    } else if (value >= -0x8000) {
+      m_buffer += static_cast<char>(0xd1);
+      append_be(m_buffer, bits, 2);
+    } else {
+      m_buffer += static_cast<char>(0xd2);
+      append_be(m_buffer, bits, 4);
+    }
+  }
+}
+
+void
+MsgPackWriterImpl::write_float(float value)
+{
+  m_buffer += static_cast<char>(0xca);
+  append_be(m_buffer, std::bit_cast<std::uint32_t>(value), 4);
+}
+
+void
+MsgPackWriterImpl::write_string(std::string_view value)
+{
+  std::uint32_t const size = checked_size(value.size());
+  if (size < 32) {
+    m_buffer += static_cast<char>(0xa0 | size);
+  } else if (size <= 0xff) {
+    m_buffer += static_cast<char>(0xd9);
+    append_be(m_buffer, size, 1);
+  } else if (size <= 0xffff) {
+    m_buffer += static_cast<char>(0xda);
+    append_be(m_buffer, size, 2);
+  } else {
+    m_buffer += static_cast<char>(0xdb);
+    append_be(m_buffer, size, 4);
+  }
+  m_buffer.append(value);
+}
+
+void
+MsgPackWriterImpl::flush()
+{
+  // headers were recorded in document order, so a single pass merges
+  // them into the content
+  std::string head;
+  std::size_t pos = 0;
+  for (Header const& header : m_headers) {
+    m_out.write(m_buffer.data() + pos, static_cast<std::streamsize>(header.offset - pos));
+    pos = header.offset;
+
+    head.clear();
+    append_header(head, header.map, header.count);
+    m_out.write(head.data(), static_cast<std::streamsize>(head.size()));
+  }
+  m_out.write(m_buffer.data() + pos, static_cast<std::streamsize>(m_buffer.size() - pos));
+
+  m_buffer.clear();
+  m_headers.clear();
+}
+
+} // namespace prio
+
+/* EOF */
@@ -0,0 +1,102 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_PRIO_MSGPACK_WRITER_IMPL_HPP
+#define HEADER_PRIO_MSGPACK_WRITER_IMPL_HPP
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "writer_impl.hpp"
+
+namespace prio {
+
+/** Writes Format::MSGPACK documents using the value model of the JSON
+    writers. MessagePack puts the number of elements in front of maps
+    and arrays, so their headers are recorded separately from the
+    content and merged in when the root object ends, which keeps the
+    output in the smallest encoding without moving data around. */
+class MsgPackWriterImpl final : public WriterImpl
+{
+public:
+  MsgPackWriterImpl(std::ostream& out);
+  ~MsgPackWriterImpl() override;
+
+  void begin_collection(std::string_view key) override;
+  void end_collection() override;
+
+  void begin_object(std::string_view type) override;
+  void end_object() override;
+
+  void begin_mapping(std::string_view key) override;
+  void end_mapping() override;
+
+  void begin_keyvalue(std::string_view key) override;
+  void end_keyvalue() override;
+
+  void write(std::string_view key, bool value) override;
+  void write(std::string_view key, int value) override;
+  void write(std::string_view key, float value) override;
+  void write(std::string_view key, char const* value) override;
+  void write(std::string_view key, std::string_view value) override;
+
+  void write(std::string_view key, std::span<bool const> values) override;
+  void write(std::string_view key, std::span<int const> values) override;
+  void write(std::string_view key, std::span<float const> values) override;
+  void write(std::string_view key, std::span<std::string const> values) override;
+
+  void write(std::string_view key, std::vector<bool> const& values) override;
+
+private:
+  struct Header
+  {
+    /** position in m_buffer the header is inserted at */
+    std::size_t offset;
+    bool map;
+    std::uint32_t count;
+  };
+
+  void begin_entry(std::string_view key);
+  void begin_container(bool map);
+  void end_container();
+
+  void write_bool(bool value);
+  void write_int(int value);
+  void write_float(float value);
+  void write_string(std::string_view value);
+
+  void flush();
+
+private:
+  std::ostream& m_out;
+  std::string m_buffer;
+  std::vector<Header> m_headers;
+
+  /** indices into m_headers of the open containers, npos for keyvalues */
+  std::vector<std::size_t> m_stack;
+
+private:
+  MsgPackWriterImpl(const MsgPackWriterImpl&) = delete;
+  MsgPackWriterImpl& operator=(const MsgPackWriterImpl&) = delete;
+};
+
+} // namespace prio
+
+#endif
+
+/* EOF */
@@ -0,0 +1,47 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_PRIO_NUMBER_FORMAT_HPP
+#define HEADER_PRIO_NUMBER_FORMAT_HPP
+
+#include <charconv>
+#include <string>
+
+namespace prio {
+
+/** Appends @a value to @a out, the same as `std::ostream << value`
+    with default flags would produce, but without going through the
+    stream and its locale */
+inline void append_number(std::string& out, int value)
+{
+  char buf[16];
+  auto const result = std::to_chars(buf, buf + sizeof(buf), value);
+  out.append(buf, result.ptr);
+}
+
+inline void append_number(std::string& out, float value)
+{
+  // precision 6 in general notation is the ostream default, i.e. "%g"
+  char buf[32];
+  auto const result = std::to_chars(buf, buf + sizeof(buf), value, std::chars_format::general, 6);
+  out.append(buf, result.ptr);
+}
+
+} // namespace prio
+
+#endif
+
+/* EOF */
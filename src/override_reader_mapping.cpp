@@ -16,7 +16,10 @@
 
 #include "override_reader_mapping.hpp"
 
+#include <algorithm>
+#include <memory>
 #include <set>
+#include <unordered_set>
 
 #include "reader_document.hpp"
 #include "reader_mapping.hpp"
@@ -25,17 +28,33 @@
 
 namespace prio {
 
+namespace {
+
 class OverrideReaderMappingImpl : public ReaderMappingImpl
 {
+private:
+  /** Keys of the overrides, built on construction when there are more
+      than INDEX_THRESHOLD of them, so that merging them with the keys of
+      the reader doesn't scan the overrides for each key */
+  struct KeyHash
+  {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view key) const { return std::hash<std::string_view>{}(key); }
+  };
+  using OverrideKeys = std::unordered_set<std::string, KeyHash, std::equal_to<>>;
+  static constexpr std::size_t INDEX_THRESHOLD = 16;
+
 private:
   ReaderMapping const& m_reader;
   ReaderMapping const& m_overrides;
+  std::unique_ptr<OverrideKeys const> m_override_keys;
 
 public:
   OverrideReaderMappingImpl(ReaderMapping const& reader,
                             ReaderMapping const& overrides) :
     m_reader(reader),
-    m_overrides(overrides)
+    m_overrides(overrides),
+    m_override_keys(build_override_keys(overrides))
   {
   }
 
@@ -56,74 +75,106 @@ public:
     return std::vector<std::string>(result.begin(), result.end());
   }
 
-  bool read(std::string_view key, bool& v) const override
+  // Keys of the overrides come first, followed by those of the reader
+  // that aren't overridden. Cursors of the overrides are stored as
+  // `cursor << 1`, those of the reader as `cursor << 1 | 1`, so that
+  // override mappings can be nested.
+  std::size_t first_key_cursor() const override
+  {
+    std::size_t const cursor = first_key_cursor(m_overrides);
+    if (cursor != end_key_cursor(m_overrides)) {
+      return cursor << 1;
+    }
+    return reader_key_cursor(first_key_cursor(m_reader));
+  }
+
+  std::size_t next_key_cursor(std::size_t cursor) const override
+  {
+    if (cursor & 1) {
+      return reader_key_cursor(m_reader.get_impl().next_key_cursor(cursor >> 1));
+    }
+
+    std::size_t const next = m_overrides.get_impl().next_key_cursor(cursor >> 1);
+    if (next != end_key_cursor(m_overrides)) {
+      return next << 1;
+    }
+    return reader_key_cursor(first_key_cursor(m_reader));
+  }
+
+  std::size_t end_key_cursor() const override
+  {
+    return (end_key_cursor(m_reader) << 1) | 1;
+  }
+
+  std::string_view get_key_at_cursor(std::size_t cursor, std::string& buffer) const override
+  {
+    ReaderMapping const& side = (cursor & 1) ? m_reader : m_overrides;
+    return side.get_impl().get_key_at_cursor(cursor >> 1, buffer);
+  }
+
+  bool read(Key const& key, bool& v) const override
   {
     return m_overrides.read(key, v) || m_reader.read(key, v);
   }
 
-  bool read(std::string_view key, int& v) const override
+  bool read(Key const& key, int& v) const override
   {
     return m_overrides.read(key, v) || m_reader.read(key, v);
   }
 
-  bool read(std::string_view key, float& v) const override
+  bool read(Key const& key, float& v) const override
   {
     return m_overrides.read(key, v) || m_reader.read(key, v);
   }
 
-  bool read(std::string_view key, std::string& v) const override
+  bool read(Key const& key, std::string& v) const override
   {
     return m_overrides.read(key, v) || m_reader.read(key, v);
   }
 
-  bool read(std::string_view key, std::vector<bool>& v) const override
+  bool read(Key const& key, std::vector<bool>& v) const override
   {
     return m_overrides.read(key, v) || m_reader.read(key, v);
   }
 
-  bool read(std::string_view key, std::vector<int>& v) const override
+  bool read(Key const& key, std::vector<int>& v) const override
   {
     return m_overrides.read(key, v) || m_reader.read(key, v);
   }
 
-  bool read(std::string_view key, std::vector<float>& v) const override
+  bool read(Key const& key, std::vector<float>& v) const override
   {
     return m_overrides.read(key, v) || m_reader.read(key, v);
   }
 
-  bool read(std::string_view key, std::vector<std::string>& v) const override
+  bool read(Key const& key, std::vector<std::string>& v) const override
   {
     return m_overrides.read(key, v) || m_reader.read(key, v);
   }
 
-  bool read(std::string_view key, ReaderMapping& result) const override
+  bool read(Key const& key, std::string_view& v) const override
   {
-    ReaderMapping overwrite_result;
-    if (m_overrides.read(key, overwrite_result))
-    {
-      if (m_reader.read(key, result))
-      {
-        result = make_override_mapping(result, overwrite_result);
-        return true;
-      }
-      else
-      {
-        result = std::move(overwrite_result);
-        return true;
-      }
-    }
-    else
-    {
-      return m_reader.read(key, result);
-    }
+    return m_overrides.read(key, v) || m_reader.read(key, v);
+  }
+
+  bool read(Key const& key, std::span<int> v) const override
+  {
+    return m_overrides.read(key, v) || m_reader.read(key, v);
   }
 
-  bool read(std::string_view key, ReaderCollection& result) const override
+  bool read(Key const& key, std::span<float> v) const override
+  {
+    return m_overrides.read(key, v) || m_reader.read(key, v);
+  }
+
+  bool read(Key const& key, ReaderMapping& result) const override;
+
+  bool read(Key const& key, ReaderCollection& result) const override
   {
     return m_overrides.read(key, result) || m_reader.read(key, result);
   }
 
-  bool read(std::string_view key, ReaderObject& result) const override
+  bool read(Key const& key, ReaderObject& result) const override
   {
     return m_overrides.read(key, result) || m_reader.read(key, result);
   }
@@ -137,12 +188,112 @@ public:
   {
     m_reader.missing_key_error(key);
   }
+
+private:
+  static std::size_t first_key_cursor(ReaderMapping const& mapping)
+  {
+    return mapping ? mapping.get_impl().first_key_cursor() : 0;
+  }
+
+  static std::size_t end_key_cursor(ReaderMapping const& mapping)
+  {
+    return mapping ? mapping.get_impl().end_key_cursor() : 0;
+  }
+
+  static std::unique_ptr<OverrideKeys const> build_override_keys(ReaderMapping const& overrides)
+  {
+    ReaderMapping::KeyRange const keys = overrides.keys();
+    if (static_cast<std::size_t>(std::ranges::distance(keys)) <= INDEX_THRESHOLD) {
+      return {};
+    }
+    auto result = std::make_unique<OverrideKeys>();
+    for (std::string_view key : keys) {
+      result->emplace(key);
+    }
+    return result;
+  }
+
+  bool is_overridden(std::string_view key) const
+  {
+    if (m_override_keys) {
+      return m_override_keys->contains(key);
+    }
+
+    ReaderMapping::KeyRange const overrides = m_overrides.keys();
+    return std::ranges::find(overrides, key) != overrides.end();
+  }
+
+  /** Advances the reader @a cursor past keys that are overridden */
+  std::size_t reader_key_cursor(std::size_t cursor) const
+  {
+    std::size_t const end = end_key_cursor(m_reader);
+    std::string buffer;
+    for (; cursor != end; cursor = m_reader.get_impl().next_key_cursor(cursor)) {
+      if (!is_overridden(m_reader.get_impl().get_key_at_cursor(cursor, buffer))) {
+        break;
+      }
+    }
+    return (cursor << 1) | 1;
+  }
 };
 
+/** Holds the ReaderMappings of a nested override */
+struct OverrideMappingPair
+{
+  ReaderMapping reader;
+  ReaderMapping overrides;
+};
+
+/** Override of a nested mapping, which has to own the two mappings it
+    refers to. Too large to be stored inline, it is allocated on the heap
+    and released with the ReaderMapping, so repeated reads don't grow the
+    document. */
+class OwningOverrideReaderMappingImpl final : private OverrideMappingPair,
+                                              public OverrideReaderMappingImpl
+{
+public:
+  OwningOverrideReaderMappingImpl(ReaderMapping reader_, ReaderMapping overrides_) :
+    OverrideMappingPair{std::move(reader_), std::move(overrides_)},
+    OverrideReaderMappingImpl(OverrideMappingPair::reader, OverrideMappingPair::overrides)
+  {
+  }
+
+private:
+  OwningOverrideReaderMappingImpl(OwningOverrideReaderMappingImpl const&) = delete;
+  OwningOverrideReaderMappingImpl& operator=(OwningOverrideReaderMappingImpl const&) = delete;
+};
+
+bool
+OverrideReaderMappingImpl::read(Key const& key, ReaderMapping& result) const
+{
+  ReaderMapping overwrite_result;
+  if (m_overrides.read(key, overwrite_result))
+  {
+    ReaderMapping reader_result;
+    if (m_reader.read(key, reader_result))
+    {
+      result = ReaderMapping(std::in_place_type<OwningOverrideReaderMappingImpl>,
+                             std::move(reader_result), std::move(overwrite_result));
+      return true;
+    }
+    else
+    {
+      result = std::move(overwrite_result);
+      return true;
+    }
+  }
+  else
+  {
+    return m_reader.read(key, result);
+  }
+}
+
+} // namespace
+
 ReaderMapping
 make_override_mapping(const ReaderMapping& reader, const ReaderMapping& overrides)
 {
-  return ReaderMapping(std::make_unique<OverrideReaderMappingImpl>(reader, overrides));
+  return ReaderMapping(std::in_place_type<OverrideReaderMappingImpl>, reader, overrides);
 }
 
 } // namespace prio
@@ -0,0 +1,98 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_PRIO_PARALLEL_FOR_HPP
+#define HEADER_PRIO_PARALLEL_FOR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace prio {
+
+/** Calls @a func(begin, end) for consecutive index ranges covering
+    [0, count) from up to @a num_threads threads, 0 uses one thread per
+    core. The calling thread takes part in the work. Exceptions are
+    rethrown in the calling thread once all work is done, the one from
+    the lowest range wins so errors are reported deterministically. */
+template<typename Func>
+void parallel_for(std::size_t count, unsigned int num_threads, Func func)
+{
+  if (num_threads == 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  num_threads = static_cast<unsigned int>(std::min<std::size_t>(num_threads, count));
+
+  if (num_threads <= 1) {
+    if (count > 0) {
+      func(std::size_t{0}, count);
+    }
+    return;
+  }
+
+  // more ranges than threads to even out records of different size
+  std::size_t const num_ranges = std::min<std::size_t>(count, std::size_t{num_threads} * 4);
+  std::vector<std::exception_ptr> errors(num_ranges);
+  std::atomic<std::size_t> next_range = 0;
+
+  auto worker = [&] {
+    while (true) {
+      std::size_t const range = next_range.fetch_add(1, std::memory_order_relaxed);
+      if (range >= num_ranges) {
+        return;
+      }
+
+      try {
+        func(count * range / num_ranges, count * (range + 1) / num_ranges);
+      } catch (...) {
+        errors[range] = std::current_exception();
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads - 1);
+  for (unsigned int i = 1; i < num_threads; ++i) {
+    try {
+      threads.emplace_back(worker);
+    } catch (std::system_error const&) {
+      // continue with the threads we got
+      break;
+    }
+  }
+
+  worker();
+
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  for (std::exception_ptr const& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
+} // namespace prio
+
+#endif
+
+/* EOF */
@@ -0,0 +1,342 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "parse_cache.hpp"
+
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <random>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <logmich/log.hpp>
+
+#include "binary_format.hpp"
+#include "fastjson_parser.hpp"
+#include "fastjson_reader_impl.hpp"
+#include "fastsexpr_parser.hpp"
+#include "fastsexpr_reader_impl.hpp"
+#include "format_util.hpp"
+#include "input_buffer.hpp"
+#include "msgpack_parser.hpp"
+#include "reader_error.hpp"
+
+namespace prio {
+
+namespace {
+
+// Cache files consist of a Header, the source path and the tape entries
+// as they are laid out in memory. Byte order and struct layout are those
+// of the machine that wrote the file, a foreign file fails the version or
+// entry size check.
+constexpr std::string_view CACHE_MAGIC = "PRIOCACH";
+constexpr std::uint32_t CACHE_VERSION = 1;
+
+enum class Backend : std::uint32_t
+{
+  NONE = 0,
+  FASTJSON = 1,
+  FASTSEXPR = 2
+};
+
+struct Header
+{
+  char magic[8];
+  std::uint32_t version;
+  Backend backend;
+  std::uint32_t entry_size;
+  std::uint32_t path_size;
+  std::uint64_t source_size;
+  std::int64_t source_mtime;
+  std::uint64_t source_hash;
+  std::uint64_t entry_count;
+};
+
+/** 64 bit multiply-xorshift hash over 8 byte words, used to detect
+    changed sources, not cryptographically strong */
+std::uint64_t hash_content(std::string_view data)
+{
+  constexpr std::uint64_t K = 0x9e3779b97f4a7c15;
+
+  std::uint64_t h = (data.size() + 1) * K;
+  std::size_t i = 0;
+  for (; i + 8 <= data.size(); i += 8) {
+    std::uint64_t word;
+    std::memcpy(&word, data.data() + i, 8);
+    h = (h ^ word) * K;
+    h ^= h >> 32;
+  }
+
+  std::uint64_t tail = 0;
+  std::memcpy(&tail, data.data() + i, data.size() - i);
+  h = (h ^ tail) * K;
+  return h ^ (h >> 29);
+}
+
+/** Picks the tape backend used for @a text, NONE for formats that are not cached */
+Backend select_backend(Format format, std::string_view text)
+{
+  switch (format) {
+    case Format::JSON:
+    case Format::FASTJSON:
+      return Backend::FASTJSON;
+
+    case Format::SEXPR:
+    case Format::FASTSEXPR:
+      return Backend::FASTSEXPR;
+
+    case Format::AUTO:
+      // same detection as ReaderDocument::from_file()
+      if (binary::has_magic(text) || msgpack_is_map(text)) {
+        return Backend::NONE;
+      } else if (!text.empty() && text[0] == '{') {
+        return Backend::FASTJSON;
+      } else {
+        return Backend::FASTSEXPR;
+      }
+
+    default:
+      return Backend::NONE;
+  }
+}
+
+/** Returns the absolute path of @a filename, the identity of a source */
+std::string get_key(std::filesystem::path const& filename)
+{
+  std::error_code ec;
+  std::filesystem::path const absolute = std::filesystem::absolute(filename, ec);
+  return (ec ? filename : absolute).lexically_normal().string();
+}
+
+std::int64_t get_mtime(std::filesystem::path const& filename)
+{
+  std::error_code ec;
+  auto const mtime = std::filesystem::last_write_time(filename, ec);
+  return ec ? 0 : static_cast<std::int64_t>(mtime.time_since_epoch().count());
+}
+
+bool type_valid(FastJsonTape::Type type)
+{
+  return type <= FastJsonTape::Type::OBJECT;
+}
+
+bool type_valid(FastSExprTape::Type type)
+{
+  return type <= FastSExprTape::Type::ARRAY;
+}
+
+/** Checks that the entries of @a tape have a known type and only refer
+    to @a text and to entries that follow them, so that a damaged cache
+    file can't cause out of bounds accesses later on */
+template<typename Tape>
+bool tape_valid(Tape const& tape, std::string_view text)
+{
+  for (std::uint32_t i = 0; i < tape.size(); ++i) {
+    if (!type_valid(tape[i].type)) {
+      return false;
+    }
+
+    std::uint32_t const next = tape.next(i);
+    if (std::uint64_t{tape[i].source} + tape[i].length > text.size() ||
+        next <= i || next > tape.size()) {
+      return false;
+    }
+  }
+  return tape.size() > 0;
+}
+
+template<typename Tape>
+std::unique_ptr<Tape> read_cache(std::filesystem::path const& cache_filename, Header const& expected,
+                                 std::string_view key, std::string_view text)
+{
+  using Entry = typename Tape::Entry;
+
+  std::shared_ptr<InputBuffer const> cache;
+  try {
+    cache = InputBuffer::from_file(cache_filename);
+  } catch (std::exception const&) {
+    return {};
+  }
+
+  std::string_view const data = cache->get_text();
+  if (data.size() < sizeof(Header)) {
+    return {};
+  }
+
+  Header header;
+  std::memcpy(&header, data.data(), sizeof(Header));
+  if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 ||
+      header.version != expected.version ||
+      header.backend != expected.backend ||
+      header.entry_size != expected.entry_size ||
+      header.source_size != expected.source_size ||
+      header.source_mtime != expected.source_mtime ||
+      header.source_hash != expected.source_hash ||
+      data.substr(sizeof(Header), header.path_size) != key) {
+    return {};
+  }
+
+  std::string_view const payload = data.substr(sizeof(Header) + key.size());
+  if (payload.size() != header.entry_count * sizeof(Entry)) {
+    return {};
+  }
+
+  std::vector<Entry> entries(header.entry_count);
+  std::memcpy(entries.data(), payload.data(), payload.size());
+
+  auto tape = std::make_unique<Tape>(std::move(entries));
+  if (!tape_valid(*tape, text)) {
+    return {};
+  }
+  return tape;
+}
+
+template<typename Tape>
+void write_cache(std::filesystem::path const& cache_filename, Header header,
+                 std::string_view key, Tape const& tape)
+{
+  auto const& entries = tape.get_entries();
+  header.entry_count = entries.size();
+
+  // write to a private file first and rename it into place, so that
+  // concurrent readers never see a partial cache file
+  std::filesystem::path const tmp_filename = std::filesystem::path(cache_filename).concat(
+    std::format(".{:x}.tmp", std::random_device{}()));
+
+  std::error_code ec;
+  std::filesystem::create_directories(cache_filename.parent_path(), ec);
+
+  {
+    std::ofstream out(tmp_filename, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<char const*>(&header), sizeof(Header));
+    out.write(key.data(), static_cast<std::streamsize>(key.size()));
+    out.write(reinterpret_cast<char const*>(entries.data()),
+              static_cast<std::streamsize>(entries.size() * sizeof(entries[0])));
+    if (!out.flush()) {
+      log_warn("{}: failed to write parse cache", stream_str(tmp_filename));
+      std::filesystem::remove(tmp_filename, ec);
+      return;
+    }
+  }
+
+  std::filesystem::rename(tmp_filename, cache_filename, ec);
+  if (ec) {
+    log_warn("{}: failed to write parse cache: {}", stream_str(cache_filename), ec.message());
+    std::filesystem::remove(tmp_filename, ec);
+  }
+}
+
+template<typename Tape, typename DocumentImpl, typename Parse>
+ReaderDocument load(std::filesystem::path const& cache_filename, Header const& header, std::string_view key,
+                    std::shared_ptr<InputBuffer const> buffer, ErrorHandler error_handler,
+                    std::string filename, Parse parse)
+{
+  std::unique_ptr<Tape> tape = read_cache<Tape>(cache_filename, header, key, buffer->get_text());
+  if (!tape) {
+    tape = std::make_unique<Tape>(parse(buffer->get_text()));
+    write_cache(cache_filename, header, key, *tape);
+  }
+
+  return ReaderDocument(std::make_unique<DocumentImpl>(std::move(buffer), std::move(tape),
+                                                       error_handler, std::move(filename)));
+}
+
+} // namespace
+
+ParseCache::ParseCache() :
+  m_directory()
+{
+}
+
+ParseCache::ParseCache(std::filesystem::path directory) :
+  m_directory(std::move(directory))
+{
+}
+
+ReaderDocument
+ParseCache::from_file(Format format, std::filesystem::path const& filename, ErrorHandler error_handler) const
+{
+  // pipes and other special files have no stable identity
+  std::error_code ec;
+  if (!std::filesystem::is_regular_file(filename, ec)) {
+    return ReaderDocument::from_file(format, filename, error_handler);
+  }
+
+  // stat before reading, a file modified in between has a newer mtime
+  // than the one recorded and won't produce a stale hit
+  std::int64_t const mtime = get_mtime(filename);
+  std::shared_ptr<InputBuffer const> buffer = InputBuffer::from_file(filename);
+  std::string_view const text = buffer->get_text();
+
+  Backend const backend = select_backend(format, text);
+  if (backend == Backend::NONE) {
+    return ReaderDocument::from_file(format, filename, error_handler);
+  }
+
+  std::string const key = get_key(filename);
+
+  Header header{};
+  std::memcpy(header.magic, CACHE_MAGIC.data(), sizeof(header.magic));
+  header.version = CACHE_VERSION;
+  header.backend = backend;
+  header.path_size = static_cast<std::uint32_t>(key.size());
+  header.source_size = text.size();
+  header.source_mtime = mtime;
+  header.source_hash = hash_content(text);
+
+  std::filesystem::path const cache_filename = get_cache_filename(filename);
+  try {
+    if (backend == Backend::FASTJSON) {
+      header.entry_size = sizeof(FastJsonTape::Entry);
+      return load<FastJsonTape, FastJsonReaderDocumentImpl>(cache_filename, header, key, std::move(buffer),
+                                                            error_handler, filename.string(), fastjson_parse);
+    } else {
+      header.entry_size = sizeof(FastSExprTape::Entry);
+      return load<FastSExprTape, FastSExprReaderDocumentImpl>(cache_filename, header, key, std::move(buffer),
+                                                              error_handler, filename.string(), fastsexpr_parse);
+    }
+  } catch (ReaderError const&) {
+    // the tape parsers are stricter than jsoncpp and sexp-cpp, documents
+    // they reject are left to the requested backend and not cached
+    if (format == Format::FASTJSON || format == Format::FASTSEXPR) {
+      throw;
+    }
+    return ReaderDocument::from_file(format, filename, error_handler);
+  }
+}
+
+ReaderDocument
+ParseCache::from_file(std::filesystem::path const& filename, ErrorHandler error_handler) const
+{
+  return from_file(Format::AUTO, filename, error_handler);
+}
+
+std::filesystem::path
+ParseCache::get_cache_filename(std::filesystem::path const& filename) const
+{
+  if (!m_directory) {
+    return std::filesystem::path(filename).concat(".priocache");
+  }
+
+  // one file per source, named after a hash of its absolute path
+  return *m_directory / std::format("{:016x}.priocache", hash_content(get_key(filename)));
+}
+
+} // namespace prio
+
+/* EOF */
@@ -18,6 +18,8 @@
 
 #include "reader_impl.hpp"
 #include "reader_object.hpp"
+#include <format>
+#include <stdexcept>
 #include <utility>
 
 namespace prio {
@@ -55,6 +57,98 @@ ReaderCollection::get_objects() const
   return m_impl->get_objects();
 }
 
+std::size_t
+ReaderCollection::size() const
+{
+  if (!m_impl) { return 0; }
+
+  return m_impl->get_size();
+}
+
+ReaderObject
+ReaderCollection::at(std::size_t index) const
+{
+  if (index >= size()) {
+    throw std::out_of_range(std::format("ReaderCollection::at(): index {} out of range", index));
+  }
+
+  return m_impl->get_object(index);
+}
+
+ReaderCollection::iterator
+ReaderCollection::begin() const
+{
+  if (!m_impl) { return {}; }
+
+  return iterator(m_impl.get(), m_impl->first_cursor());
+}
+
+ReaderCollection::iterator
+ReaderCollection::end() const
+{
+  if (!m_impl) { return {}; }
+
+  return iterator(m_impl.get(), m_impl->end_cursor());
+}
+
+ReaderObject
+ReaderCollection::iterator::operator*() const
+{
+  return m_impl->get_object_at_cursor(m_cursor);
+}
+
+ReaderCollection::iterator&
+ReaderCollection::iterator::operator++()
+{
+  m_cursor = m_impl->next_cursor(m_cursor);
+  return *this;
+}
+
+ReaderCollection::iterator
+ReaderCollection::iterator::operator++(int)
+{
+  iterator result = *this;
+  ++*this;
+  return result;
+}
+
+std::size_t
+ReaderCollectionImpl::get_size() const
+{
+  return get_objects().size();
+}
+
+ReaderObject
+ReaderCollectionImpl::get_object(std::size_t index) const
+{
+  std::vector<ReaderObject> objects = get_objects();
+  return std::move(objects[index]);
+}
+
+std::size_t
+ReaderCollectionImpl::first_cursor() const
+{
+  return 0;
+}
+
+std::size_t
+ReaderCollectionImpl::next_cursor(std::size_t cursor) const
+{
+  return cursor + 1;
+}
+
+std::size_t
+ReaderCollectionImpl::end_cursor() const
+{
+  return get_size();
+}
+
+ReaderObject
+ReaderCollectionImpl::get_object_at_cursor(std::size_t cursor) const
+{
+  return get_object(cursor);
+}
+
 } // namespace prio
 
 /* EOF */
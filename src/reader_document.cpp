@@ -16,9 +16,11 @@
 
 #include "reader_document.hpp"
 
+#include <algorithm>
 #include <filesystem>
-#include <fstream>
-#include <sstream>
+#include <istream>
+#include <span>
+#include <streambuf>
 #include <utility>
 
 #include <logmich/log.hpp>
@@ -33,11 +35,21 @@
 #  include "sexpr_reader_impl.hpp"
 #endif
 
+#include "binary_format.hpp"
+#include "binary_reader_impl.hpp"
+#include "fastjson_parser.hpp"
+#include "fastjson_reader_impl.hpp"
+#include "fastsexpr_reader_impl.hpp"
+#include "input_buffer.hpp"
+#include "msgpack_parser.hpp"
+#include "msgpack_reader_impl.hpp"
+#include "parallel_for.hpp"
 #include "reader_collection.hpp"
 #include "reader_error.hpp"
 #include "reader_impl.hpp"
 #include "reader_mapping.hpp"
 #include "reader_object.hpp"
+#include "value_boundary.hpp"
 #include <cctype>
 #include <cstring>
 #include <format>
@@ -45,51 +57,91 @@
 
 namespace prio {
 
-ReaderDocument
-ReaderDocument::from_string(Format format,
-                            std::string_view text, ErrorHandler error_handler,
-                            std::optional<std::string> const& filename)
+namespace {
+
+#ifdef PRIO_USE_SEXPCPP
+/** Read-only streambuf over a memory region, lets sexp::Parser read an
+    InputBuffer without copying it into a std::istringstream */
+class MemoryStreambuf final : public std::streambuf
 {
-  std::istringstream in{std::string(text)};
-  return ReaderDocument::from_stream(format, in, error_handler, filename);
-}
+public:
+  MemoryStreambuf(std::span<char const> data)
+  {
+    char* const begin = const_cast<char*>(data.data());
+    setg(begin, begin, begin + data.size());
+  }
+};
+#endif
 
-ReaderDocument
-ReaderDocument::from_file(Format format,
-                          std::filesystem::path const& filename, ErrorHandler error_handler)
+/** Resolves Format::AUTO by looking at the binary header, the first
+    byte of a MessagePack map or the first character of @a text */
+Format
+detect_format(Format format, std::string_view text)
 {
-  std::ifstream fin(filename);
-  if (!fin) {
-    throw ReaderError(std::format("{}: failed to open: {}", stream_str(filename), strerror(errno)));
+  if (format != Format::AUTO) {
+    return format;
+  }
+
+  if (binary::has_magic(text)) {
+    return Format::BINARY;
+  } else if (msgpack_is_map(text)) {
+    return Format::MSGPACK;
+  } else if (!text.empty() && text[0] == '{') {
+#ifdef PRIO_USE_JSONCPP
+    return Format::JSON;
+#else
+    return Format::FASTJSON;
+#endif
   } else {
-    return from_stream(format, fin, error_handler, filename.string());
+#ifdef PRIO_USE_SEXPCPP
+    return Format::SEXPR;
+#else
+    return Format::FASTSEXPR;
+#endif
   }
 }
 
+/** Returns true if documents of @a format keep references into their
+    input, other backends are done with it once parsing has finished */
+bool
+references_input(Format format)
+{
+  return format == Format::FASTJSON || format == Format::FASTSEXPR ||
+    format == Format::BINARY || format == Format::MSGPACK;
+}
+
+std::string_view
+as_text(std::span<std::byte const> data)
+{
+  return std::string_view(reinterpret_cast<char const*>(data.data()), data.size());
+}
+
 ReaderDocument
-ReaderDocument::from_stream(Format format,
-                            std::istream& stream, ErrorHandler error_handler,
-                            std::optional<std::string> const& filename)
+from_input_buffer(Format format, std::shared_ptr<InputBuffer const> buffer,
+                  ErrorHandler error_handler, std::optional<std::string> const& filename)
 {
-  switch (format)
+  switch (detect_format(format, buffer->get_text()))
   {
-    case Format::AUTO: {
-      int c = stream.get();
-      stream.unget();
-      if (c == '{') {
-        return from_stream(Format::JSON, stream, error_handler, filename);
-      } else {
-        return from_stream(Format::SEXPR, stream, error_handler, filename);
-      }
-    }
+    case Format::FASTJSON:
+      return ReaderDocument(std::make_unique<FastJsonReaderDocumentImpl>(std::move(buffer), error_handler, filename));
+
+    case Format::FASTSEXPR:
+      return ReaderDocument(std::make_unique<FastSExprReaderDocumentImpl>(std::move(buffer), error_handler, filename));
+
+    case Format::BINARY:
+      return ReaderDocument(std::make_unique<BinaryReaderDocumentImpl>(std::move(buffer), error_handler, filename));
+
+    case Format::MSGPACK:
+      return ReaderDocument(std::make_unique<MsgPackReaderDocumentImpl>(std::move(buffer), error_handler, filename));
 
 #ifdef PRIO_USE_JSONCPP
-    case Format::FASTJSON:
     case Format::JSON: {
       Json::CharReaderBuilder builder;
+      std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+      std::span<char const> const data = buffer->get_span();
       std::string errs;
       Json::Value root;
-      if (!Json::parseFromStream(builder, stream, &root, &errs)) {
+      if (!reader->parse(data.data(), data.data() + data.size(), &root, &errs)) {
         throw ReaderError(std::format("json parse error: {}", errs));
       }
       return ReaderDocument(std::make_unique<JsonReaderDocumentImpl>(std::move(root), error_handler, filename));
@@ -99,6 +151,8 @@ ReaderDocument::from_stream(Format format,
 #ifdef PRIO_USE_SEXPCPP
     case Format::SEXPR: {
       try {
+        MemoryStreambuf streambuf(buffer->get_span());
+        std::istream stream(&streambuf);
         auto sx = sexp::Parser::from_stream(stream, sexp::Parser::USE_ARRAYS);
         return ReaderDocument(std::make_unique<SExprReaderDocumentImpl>(std::move(sx), error_handler, filename));
       } catch(std::exception const& err) {
@@ -112,6 +166,53 @@ ReaderDocument::from_stream(Format format,
   }
 }
 
+} // namespace
+
+ReaderDocument
+ReaderDocument::from_string(Format format,
+                            std::string_view text, ErrorHandler error_handler,
+                            std::optional<std::string> const& filename)
+{
+  return from_buffer(format, std::as_bytes(std::span(text)), error_handler, filename);
+}
+
+ReaderDocument
+ReaderDocument::from_buffer(Format format,
+                            std::span<std::byte const> data, ErrorHandler error_handler,
+                            std::optional<std::string> const& filename)
+{
+  std::string_view const text = as_text(data);
+  format = detect_format(format, text);
+  if (references_input(format)) {
+    return from_input_buffer(format, InputBuffer::from_string(std::string(text)), error_handler, filename);
+  } else {
+    return from_input_buffer(format, InputBuffer::borrow(text), error_handler, filename);
+  }
+}
+
+ReaderDocument
+ReaderDocument::from_borrowed_buffer(Format format,
+                                     std::span<std::byte const> data, ErrorHandler error_handler,
+                                     std::optional<std::string> const& filename)
+{
+  return from_input_buffer(format, InputBuffer::borrow(as_text(data)), error_handler, filename);
+}
+
+ReaderDocument
+ReaderDocument::from_file(Format format,
+                          std::filesystem::path const& filename, ErrorHandler error_handler)
+{
+  return from_input_buffer(format, InputBuffer::from_file(filename), error_handler, filename.string());
+}
+
+ReaderDocument
+ReaderDocument::from_stream(Format format,
+                            std::istream& stream, ErrorHandler error_handler,
+                            std::optional<std::string> const& filename)
+{
+  return from_input_buffer(format, InputBuffer::from_stream(stream), error_handler, filename);
+}
+
 ReaderDocument
 ReaderDocument::from_string(std::string_view text, ErrorHandler error_handler,
                             std::optional<std::string> const& filename)
@@ -126,6 +227,13 @@ ReaderDocument::from_stream(std::istream& stream, ErrorHandler error_handler,
   return from_stream(Format::AUTO, stream, error_handler, filename);
 }
 
+ReaderDocument
+ReaderDocument::from_buffer(std::span<std::byte const> data, ErrorHandler error_handler,
+                            std::optional<std::string> const& filename)
+{
+  return from_buffer(Format::AUTO, data, error_handler, filename);
+}
+
 ReaderDocument
 ReaderDocument::from_file(std::filesystem::path const& filename, ErrorHandler error_handler)
 {
@@ -135,145 +243,176 @@ ReaderDocument::from_file(std::filesystem::path const& filename, ErrorHandler er
 namespace {
 
 #ifdef PRIO_USE_JSONCPP
-/** Return a pointer just past one complete JSON value starting at @a p.
-    Supports objects, arrays, strings, numbers and keywords. Returns nullptr
-    if the value is incomplete or malformed. */
-char const*
-json_value_end(char const* p, char const* end)
-{
-  auto skip_string = [&](char const* s) -> char const* {
-    // s points at the opening quote
-    ++s;
-    while (s < end) {
-      if (*s == '\\') {
-        ++s;
-        if (s >= end) return nullptr;
-        ++s;
-        continue;
-      }
-      if (*s == '"') return s + 1;
-      ++s;
-    }
-    return nullptr;
-  };
-
-  if (p >= end) return p;
+/** Parse successive top-level JSON values from @a content, the values
+    are parsed on up to @a num_threads threads. Values may be separated
+    by any whitespace (JSON Lines is the newline-separated special case;
+    compact concatenation without newlines is also accepted). */
+std::vector<Json::Value>
+parse_json_values_many(std::string_view content, unsigned int num_threads)
+{
+  std::vector<std::string_view> const records = fastjson_split_values(content);
+  std::vector<Json::Value> values(records.size());
 
-  if (*p == '"') {
-    return skip_string(p);
-  }
+  parallel_for(records.size(), num_threads, [&records, &values](std::size_t begin, std::size_t end) {
+    Json::CharReaderBuilder builder;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
 
-  if (*p == '{' || *p == '[') {
-    char const open = *p;
-    char const close = (open == '{') ? '}' : ']';
-    int depth = 0;
-    char const* s = p;
-    while (s < end) {
-      if (*s == '"') {
-        s = skip_string(s);
-        if (!s) return nullptr;
-        continue;
-      }
-      if (*s == open) {
-        ++depth;
-      } else if (*s == close) {
-        --depth;
-        if (depth == 0) return s + 1;
+    for (std::size_t i = begin; i < end; ++i) {
+      std::string errs;
+      if (!reader->parse(records[i].data(), records[i].data() + records[i].size(), &values[i], &errs)) {
+        throw ReaderError(std::format("json parse error: record {}: {}", i + 1, errs));
       }
-      ++s;
     }
-    return nullptr;
-  }
+  });
 
-  // number
-  if (*p == '-' || (*p >= '0' && *p <= '9')) {
-    char const* s = p + 1;
-    while (s < end
-           && !std::isspace(static_cast<unsigned char>(*s))
-           && *s != ',' && *s != '}' && *s != ']' && *s != ':') {
-      ++s;
-    }
-    return s;
-  }
+  return values;
+}
+#endif
 
-  // keywords
-  if (p + 4 <= end && std::strncmp(p, "true", 4) == 0) return p + 4;
-  if (p + 5 <= end && std::strncmp(p, "false", 5) == 0) return p + 5;
-  if (p + 4 <= end && std::strncmp(p, "null", 4) == 0) return p + 4;
+#ifdef PRIO_USE_SEXPCPP
+struct SExprRecord
+{
+  std::string_view text;
 
-  return nullptr;
-}
+  /** line on which the record starts */
+  int line;
+};
 
-/** Parse successive top-level JSON values from @a content.
-    Values may be separated by any whitespace (JSON Lines is the
-    newline-separated special case; compact concatenation without
-    newlines is also accepted). */
-std::vector<Json::Value>
-parse_json_values_many(std::string const& content)
+/** Splits @a content into successive top-level s-expressions, skipping
+    whitespace and comments between them */
+std::vector<SExprRecord>
+split_sexpr_values(std::string_view content)
 {
-  std::vector<Json::Value> values;
+  std::vector<SExprRecord> records;
   char const* p = content.data();
   char const* const end = p + content.size();
-
-  Json::CharReaderBuilder builder;
-  std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+  int line = 1;
 
   while (true) {
-    while (p < end && std::isspace(static_cast<unsigned char>(*p))) {
-      ++p;
+    while (p < end) {
+      if (*p == '\n') {
+        ++line;
+        ++p;
+      } else if (std::isspace(static_cast<unsigned char>(*p))) {
+        ++p;
+      } else if (*p == ';') {
+        char const* const eol = static_cast<char const*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+        p = eol ? eol : end;
+      } else {
+        break;
+      }
     }
     if (p >= end) {
       break;
     }
 
-    char const* const value_end = json_value_end(p, end);
+    char const* const value_end = sexpr_value_end(p, end);
     if (!value_end) {
-      throw ReaderError("json parse error: incomplete or invalid JSON value");
+      throw ReaderError(std::format("sexpr parse error: line {}: incomplete or invalid value", line));
     }
 
-    Json::Value root;
-    std::string errs;
-    if (!reader->parse(p, value_end, &root, &errs)) {
-      throw ReaderError(std::format("json parse error: {}", errs));
-    }
-    values.push_back(std::move(root));
+    records.push_back(SExprRecord{std::string_view(p, static_cast<std::size_t>(value_end - p)), line});
+    line += static_cast<int>(std::count(p, value_end, '\n'));
     p = value_end;
   }
 
-  return values;
+  return records;
+}
+
+/** Parse successive top-level s-expressions from @a content on up to
+    @a num_threads threads, line numbers in error messages refer to
+    @a content as a whole */
+std::vector<ReaderDocument>
+parse_sexpr_values_many(std::string_view content, unsigned int num_threads, std::string const& pathname)
+{
+  std::vector<SExprRecord> const records = split_sexpr_values(content);
+  std::vector<ReaderDocument> docs(records.size());
+
+  parallel_for(records.size(), num_threads, [&records, &docs, &pathname](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+      try {
+        MemoryStreambuf streambuf(std::span<char const>(records[i].text));
+        std::istream stream(&streambuf);
+        auto sx = sexp::Parser::from_stream(stream, sexp::Parser::USE_ARRAYS);
+        docs[i] = ReaderDocument(std::make_unique<SExprReaderDocumentImpl>(
+            std::move(sx), ErrorHandler::THROW, pathname, records[i].line - 1));
+      } catch (std::exception const&) {
+        std::throw_with_nested(ReaderError(std::format(
+            "{}:{}: failed to parse s-expression", pathname, records[i].line)));
+      }
+    }
+  });
+
+  return docs;
 }
 #endif
 
+/** Parse a sequence of MessagePack maps from @a buffer on up to
+    @a num_threads threads, the documents share @a buffer and their
+    strings refer into it */
+std::vector<ReaderDocument>
+parse_msgpack_values_many(std::shared_ptr<InputBuffer const> const& buffer, unsigned int num_threads,
+                          std::string const& pathname)
+{
+  std::vector<std::string_view> const records = msgpack_split_values(buffer->get_text());
+  std::vector<ReaderDocument> docs(records.size());
+
+  parallel_for(records.size(), num_threads, [&buffer, &records, &docs, &pathname](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+      try {
+        docs[i] = ReaderDocument(std::make_unique<MsgPackReaderDocumentImpl>(
+            buffer, records[i], ErrorHandler::THROW, pathname));
+      } catch (std::exception const&) {
+        std::throw_with_nested(ReaderError(std::format(
+            "{}: offset {}: failed to parse MessagePack value",
+            pathname, records[i].data() - buffer->get_text().data())));
+      }
+    }
+  });
+
+  return docs;
+}
+
 } // namespace
 
 std::vector<ReaderDocument>
 ReaderDocument::parse_many(const std::string& pathname)
 {
-  std::ifstream fin(pathname);
-  if (!fin) {
-    throw ReaderError(std::format("{}: failed to open: {}", pathname, strerror(errno)));
+  return parse_many(pathname, 1);
+}
+
+std::vector<ReaderDocument>
+ReaderDocument::parse_many(const std::string& pathname, unsigned int num_threads)
+{
+  std::shared_ptr<InputBuffer const> const buffer = InputBuffer::from_file(pathname);
+  std::string_view const content = buffer->get_text();
+
+  // MessagePack is binary, so check for a map header before looking at
+  // the content as text
+  if (!binary::has_magic(content) && msgpack_is_map(content)) {
+    try {
+      return parse_msgpack_values_many(buffer, num_threads, pathname);
+    } catch (std::exception const&) {
+      std::throw_with_nested(ReaderError(std::format(
+          "{}: ReaderDocument::parse_many() failed", pathname)));
+    }
   }
 
   // Peek at the first non-whitespace character to choose a backend when both
   // are available. '{' / '[' => JSON; otherwise treat as sexpr.
-  int c = fin.get();
-  while (c != EOF && std::isspace(static_cast<unsigned char>(c))) {
-    c = fin.get();
-  }
-  if (c == EOF) {
+  auto const it = std::find_if(content.begin(), content.end(), [](char c) {
+    return !std::isspace(static_cast<unsigned char>(c));
+  });
+  if (it == content.end()) {
     return {};
   }
-  fin.unget();
 
-  bool const looks_json = (c == '{' || c == '[');
+  bool const looks_json = (*it == '{' || *it == '[');
 
 #ifdef PRIO_USE_JSONCPP
   if (looks_json) {
     try {
-      std::string content(
-          (std::istreambuf_iterator<char>(fin)),
-          std::istreambuf_iterator<char>());
-      auto values = parse_json_values_many(content);
+      auto values = parse_json_values_many(content, num_threads);
       std::vector<ReaderDocument> docs;
       docs.reserve(values.size());
       for (auto& value : values) {
@@ -291,14 +430,7 @@ ReaderDocument::parse_many(const std::string& pathname)
 #ifdef PRIO_USE_SEXPCPP
   if (!looks_json) {
     try {
-      auto values = sexp::Parser::from_stream_many(fin, sexp::Parser::USE_ARRAYS);
-      std::vector<ReaderDocument> docs;
-      docs.reserve(values.size());
-      for (auto& sx : values) {
-        docs.emplace_back(std::make_unique<SExprReaderDocumentImpl>(
-            std::move(sx), ErrorHandler::THROW, pathname));
-      }
-      return docs;
+      return parse_sexpr_values_many(content, num_threads, pathname);
     } catch (std::exception const&) {
       std::throw_with_nested(ReaderError(std::format(
           "{}: ReaderDocument::parse_many() failed", pathname)));
@@ -324,7 +456,9 @@ ReaderDocument::ReaderDocument(std::unique_ptr<ReaderDocumentImpl> impl) :
 ReaderDocument::ReaderDocument(ReaderDocument&& other) noexcept :
   m_impl(std::move(other.m_impl))
 {
-  m_impl->set_parent(this);
+  if (m_impl) {
+    m_impl->set_parent(this);
+  }
 }
 
 ReaderDocument::~ReaderDocument()
@@ -332,7 +466,14 @@ ReaderDocument::~ReaderDocument()
 }
 
 ReaderDocument&
-ReaderDocument::operator=(ReaderDocument&&) noexcept = default;
+ReaderDocument::operator=(ReaderDocument&& other) noexcept
+{
+  m_impl = std::move(other.m_impl);
+  if (m_impl) {
+    m_impl->set_parent(this);
+  }
+  return *this;
+}
 
 ReaderObject
 ReaderDocument::get_root() const
@@ -393,6 +534,14 @@ ReaderDocument::get_directory() const
   return filename.substr(0, p);
 }
 
+std::size_t
+ReaderDocument::get_memory_usage() const
+{
+  if (!m_impl) { return 0; }
+
+  return m_impl->get_memory_usage() + m_impl->get_arena().get_size();
+}
+
 } // namespace prio
 
 /* EOF */
@@ -0,0 +1,263 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "reader_document_range.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <exception>
+#include <format>
+#include <fstream>
+#include <string_view>
+
+#include "format_util.hpp"
+#include "reader_error.hpp"
+#include "value_boundary.hpp"
+
+namespace prio {
+
+namespace {
+
+constexpr std::size_t CHUNK_SIZE = 64 * 1024;
+
+} // namespace
+
+/** Rolling read window over a multi-document stream, consumed records
+    are dropped from the front before more input is read */
+class ReaderDocumentRangeImpl final
+{
+public:
+  ReaderDocumentRangeImpl(std::unique_ptr<std::istream> owned, std::istream& stream,
+                          ErrorHandler error_handler, std::optional<std::string> const& filename) :
+    m_owned(std::move(owned)),
+    m_stream(&stream),
+    m_error_handler(error_handler),
+    m_filename(filename),
+    m_window(),
+    m_pos(0),
+    m_eof(false),
+    m_json()
+  {}
+
+  /** Returns the next document or an empty one at the end of input */
+  ReaderDocument next()
+  {
+    if (!skip_separators()) {
+      return ReaderDocument();
+    }
+
+    char const first = m_window[m_pos];
+    if (!m_json) {
+      m_json = (first == '{' || first == '[');
+    }
+
+    if (*m_json ? std::string_view("{[\"-0123456789tfn").find(first) == std::string_view::npos : first == ')') {
+      error(std::format("unexpected character '{}'", first));
+    }
+
+    std::size_t length;
+    while (true) {
+      char const* const begin = m_window.data() + m_pos;
+      char const* const end = m_window.data() + m_window.size();
+      char const* const value_end = *m_json ? json_value_end(begin, end) : sexpr_value_end(begin, end);
+
+      // a value running up to the end of the window may continue in the
+      // next chunk, numbers and atoms have no closing delimiter
+      if (value_end && (value_end != end || m_eof)) {
+        length = static_cast<std::size_t>(value_end - begin);
+        break;
+      }
+
+      if (!fill()) {
+        if (value_end) {
+          length = static_cast<std::size_t>(value_end - begin);
+          break;
+        }
+        error("incomplete value at end of file");
+      }
+    }
+
+    std::string_view const record(m_window.data() + m_pos, length);
+    m_pos += length;
+
+    try {
+      return ReaderDocument::from_string(record_format(), record, m_error_handler, m_filename);
+    } catch (std::exception const&) {
+      std::throw_with_nested(ReaderError(std::format(
+          "{}: ReaderDocument::iterate_many() failed", get_filename())));
+    }
+  }
+
+private:
+  Format record_format() const
+  {
+    if (*m_json) {
+#ifdef PRIO_USE_JSONCPP
+      return Format::JSON;
+#else
+      return Format::FASTJSON;
+#endif
+    } else {
+#ifdef PRIO_USE_SEXPCPP
+      return Format::SEXPR;
+#else
+      return Format::FASTSEXPR;
+#endif
+    }
+  }
+
+  /** Skips whitespace and, for s-expressions, comments. Returns false
+      when the end of input is reached. */
+  bool skip_separators()
+  {
+    while (true) {
+      while (m_pos < m_window.size() && std::isspace(static_cast<unsigned char>(m_window[m_pos]))) {
+        m_pos += 1;
+      }
+
+      if (m_pos < m_window.size()) {
+        if (m_window[m_pos] != ';' || (m_json && *m_json)) {
+          return true;
+        }
+
+        std::size_t const eol = m_window.find('\n', m_pos);
+        if (eol != std::string::npos) {
+          m_pos = eol + 1;
+          continue;
+        } else if (m_eof) {
+          m_pos = m_window.size();
+        }
+      }
+
+      if (!fill()) {
+        return false;
+      }
+    }
+  }
+
+  /** Drops the consumed part of the window and appends at least one
+      chunk of input, returns false at the end of input */
+  bool fill()
+  {
+    if (m_eof) {
+      return false;
+    }
+
+    if (m_pos > 0) {
+      m_window.erase(0, m_pos);
+      m_pos = 0;
+    }
+
+    // grow geometrically so that rescanning an incomplete record stays
+    // linear in its size
+    std::size_t const chunk = std::max(CHUNK_SIZE, m_window.size());
+    std::size_t const old_size = m_window.size();
+    m_window.resize(old_size + chunk);
+    m_stream->read(m_window.data() + old_size, static_cast<std::streamsize>(chunk));
+    std::size_t const count = static_cast<std::size_t>(m_stream->gcount());
+    m_window.resize(old_size + count);
+
+    if (count < chunk) {
+      m_eof = true;
+    }
+    return count > 0;
+  }
+
+  std::string get_filename() const
+  {
+    return m_filename ? *m_filename : "<unknown>";
+  }
+
+  [[noreturn]]
+  void error(std::string_view message) const
+  {
+    throw ReaderError(std::format("{}: ReaderDocument::iterate_many(): {}", get_filename(), message));
+  }
+
+private:
+  std::unique_ptr<std::istream> m_owned;
+  std::istream* m_stream;
+  ErrorHandler m_error_handler;
+  std::optional<std::string> m_filename;
+
+  std::string m_window;
+  std::size_t m_pos;
+  bool m_eof;
+
+  /** detected from the first value */
+  std::optional<bool> m_json;
+
+private:
+  ReaderDocumentRangeImpl(ReaderDocumentRangeImpl const&) = delete;
+  ReaderDocumentRangeImpl& operator=(ReaderDocumentRangeImpl const&) = delete;
+};
+
+ReaderDocumentRange
+ReaderDocument::iterate_many(std::filesystem::path const& pathname, ErrorHandler error_handler)
+{
+  auto fin = std::make_unique<std::ifstream>(pathname, std::ios::binary);
+  if (!*fin) {
+    throw ReaderError(std::format("{}: failed to open", stream_str(pathname)));
+  }
+
+  std::istream& stream = *fin;
+  return ReaderDocumentRange(std::make_unique<ReaderDocumentRangeImpl>(
+      std::move(fin), stream, error_handler, pathname.string()));
+}
+
+ReaderDocumentRange
+ReaderDocument::iterate_many(std::istream& stream, ErrorHandler error_handler,
+                             std::optional<std::string> const& filename)
+{
+  return ReaderDocumentRange(std::make_unique<ReaderDocumentRangeImpl>(
+      nullptr, stream, error_handler, filename));
+}
+
+ReaderDocumentRange::ReaderDocumentRange(std::unique_ptr<ReaderDocumentRangeImpl> impl) :
+  m_impl(std::move(impl)),
+  m_current(),
+  m_started(false)
+{
+}
+
+ReaderDocumentRange::ReaderDocumentRange(ReaderDocumentRange&&) noexcept = default;
+
+ReaderDocumentRange::~ReaderDocumentRange()
+{
+}
+
+ReaderDocumentRange&
+ReaderDocumentRange::operator=(ReaderDocumentRange&&) noexcept = default;
+
+ReaderDocumentRange::iterator
+ReaderDocumentRange::begin()
+{
+  if (!m_started) {
+    m_started = true;
+    advance();
+  }
+  return iterator(this);
+}
+
+void
+ReaderDocumentRange::advance()
+{
+  m_current = m_impl->next();
+}
+
+} // namespace prio
+
+/* EOF */
@@ -16,6 +16,11 @@
 
 #include "reader_mapping.hpp"
 
+#include <algorithm>
+#include <array>
+#include <variant>
+
+#include "array_values.hpp"
 #include "reader_collection.hpp"
 #include "reader_object.hpp"
 #include "reader_impl.hpp"
@@ -49,7 +54,7 @@ ReaderMapping::get_document() const
 }
 
 bool
-ReaderMapping::read(std::string_view key, bool& value) const
+ReaderMapping::read(Key const& key, bool& value) const
 {
   if (!m_impl) { return false; }
 
@@ -57,7 +62,7 @@ ReaderMapping::read(std::string_view key, bool& value) const
 }
 
 bool
-ReaderMapping::read(std::string_view key, int& value) const
+ReaderMapping::read(Key const& key, int& value) const
 {
   if (!m_impl) { return false; }
 
@@ -65,7 +70,7 @@ ReaderMapping::read(std::string_view key, int& value) const
 }
 
 bool
-ReaderMapping::read (std::string_view key, float& value) const
+ReaderMapping::read(Key const& key, float& value) const
 {
   if (!m_impl) { return false; }
 
@@ -73,7 +78,7 @@ ReaderMapping::read (std::string_view key, float& value) const
 }
 
 bool
-ReaderMapping::read(std::string_view key, std::string& value) const
+ReaderMapping::read(Key const& key, std::string& value) const
 {
   if (!m_impl) { return false; }
 
@@ -81,7 +86,7 @@ ReaderMapping::read(std::string_view key, std::string& value) const
 }
 
 bool
-ReaderMapping::read(std::string_view key, std::vector<bool>& values) const
+ReaderMapping::read(Key const& key, std::vector<bool>& values) const
 {
  if (!m_impl) { return false; }
 
@@ -89,7 +94,7 @@ ReaderMapping::read(std::string_view key, std::vector<bool>& values) const
 }
 
 bool
-ReaderMapping::read(std::string_view key, std::vector<int>& values) const
+ReaderMapping::read(Key const& key, std::vector<int>& values) const
 {
   if (!m_impl) { return false; }
 
@@ -97,7 +102,7 @@ ReaderMapping::read(std::string_view key, std::vector<int>& values) const
 }
 
 bool
-ReaderMapping::read(std::string_view key, std::vector<float>& values) const
+ReaderMapping::read(Key const& key, std::vector<float>& values) const
 {
   if (!m_impl) { return false; }
 
@@ -105,7 +110,7 @@ ReaderMapping::read(std::string_view key, std::vector<float>& values) const
 }
 
 bool
-ReaderMapping::read(std::string_view key, std::vector<std::string>& values) const
+ReaderMapping::read(Key const& key, std::vector<std::string>& values) const
 {
   if (!m_impl) { return false; }
 
@@ -113,7 +118,7 @@ ReaderMapping::read(std::string_view key, std::vector<std::string>& values) cons
 }
 
 bool
-ReaderMapping::read(std::string_view key, ReaderObject& object) const
+ReaderMapping::read(Key const& key, ReaderObject& object) const
 {
   if (!m_impl) { return false; }
 
@@ -121,7 +126,31 @@ ReaderMapping::read(std::string_view key, ReaderObject& object) const
 }
 
 bool
-ReaderMapping::read(std::string_view key, ReaderMapping& mapping) const
+ReaderMapping::read(Key const& key, std::string_view& value) const
+{
+  if (!m_impl) { return false; }
+
+  return m_impl->read(key, value);
+}
+
+bool
+ReaderMapping::read(Key const& key, std::span<int> values) const
+{
+  if (!m_impl) { return false; }
+
+  return m_impl->read(key, values);
+}
+
+bool
+ReaderMapping::read(Key const& key, std::span<float> values) const
+{
+  if (!m_impl) { return false; }
+
+  return m_impl->read(key, values);
+}
+
+bool
+ReaderMapping::read(Key const& key, ReaderMapping& mapping) const
 {
   if (!m_impl) { return false; }
 
@@ -129,7 +158,7 @@ ReaderMapping::read(std::string_view key, ReaderMapping& mapping) const
 }
 
 bool
-ReaderMapping::read(std::string_view key, ReaderCollection& collection) const
+ReaderMapping::read(Key const& key, ReaderCollection& collection) const
 {
   if (!m_impl) { return false; }
 
@@ -144,6 +173,98 @@ ReaderMapping::get_keys() const
   return m_impl->get_keys();
 }
 
+ReaderMapping::KeyRange
+ReaderMapping::keys() const
+{
+  return KeyRange(m_impl.get());
+}
+
+ReaderMapping::key_iterator
+ReaderMapping::KeyRange::begin() const
+{
+  if (!m_impl) { return {}; }
+
+  return key_iterator(m_impl, m_impl->first_key_cursor());
+}
+
+ReaderMapping::key_iterator
+ReaderMapping::KeyRange::end() const
+{
+  if (!m_impl) { return {}; }
+
+  return key_iterator(m_impl, m_impl->end_key_cursor());
+}
+
+std::string_view
+ReaderMapping::key_iterator::operator*() const
+{
+  return m_impl->get_key_at_cursor(m_cursor, m_buffer);
+}
+
+ReaderMapping::key_iterator&
+ReaderMapping::key_iterator::operator++()
+{
+  m_cursor = m_impl->next_key_cursor(m_cursor);
+  return *this;
+}
+
+ReaderMapping::key_iterator
+ReaderMapping::key_iterator::operator++(int)
+{
+  key_iterator result = *this;
+  ++*this;
+  return result;
+}
+
+bool
+ReaderMapping::read_fields(ReaderFieldTable const& fields) const
+{
+  // small tables get their flags from the stack
+  constexpr std::size_t inline_count = 64;
+  std::array<bool, inline_count> inline_found{};
+  std::unique_ptr<bool[]> heap_found;
+  std::span<bool> found;
+  if (fields.size() <= inline_count) {
+    found = std::span<bool>(inline_found.data(), fields.size());
+  } else {
+    heap_found = std::make_unique<bool[]>(fields.size());
+    found = std::span<bool>(heap_found.get(), fields.size());
+  }
+
+  if (m_impl) {
+    m_impl->read_fields(fields, found);
+  }
+
+  std::string missing;
+  for (std::size_t i = 0; i < fields.size(); ++i) {
+    if (fields[i].required && !found[i]) {
+      if (!missing.empty()) {
+        missing += ", ";
+      }
+      missing += fields[i].key.get_name();
+    }
+  }
+
+  if (!missing.empty()) {
+    missing_key_error(missing);
+    return false;
+  }
+
+  return true;
+}
+
+bool
+ReaderMapping::read_fields(std::span<ReaderField const> fields) const
+{
+  return read_fields(ReaderFieldTable(fields));
+}
+
+bool
+ReaderMapping::read_fields(std::initializer_list<ReaderField> fields) const
+{
+  return read_fields(ReaderFieldTable(std::span<ReaderField const>(fields.begin(), fields.size())));
+}
+
 void
 ReaderMapping::error(std::string_view key, std::string_view message) const
 {
@@ -160,6 +281,87 @@ ReaderMapping::missing_key_error(std::string_view key) const
   m_impl->missing_key_error(key);
 }
 
+namespace {
+
+template<typename T>
+bool read_into_span(ReaderMappingImpl const& impl, Key const& key, std::span<T> values)
+{
+  std::vector<T> result;
+  if (!impl.read(key, result)) {
+    return false;
+  }
+
+  if (result.size() != values.size()) {
+    impl.error(key.get_name(), size_mismatch_message(values.size(), result.size()));
+    return false;
+  }
+
+  std::copy(result.begin(), result.end(), values.begin());
+  return true;
+}
+
+} // namespace
+
+bool
+ReaderMappingImpl::read(Key const& key, std::string_view& value) const
+{
+  std::string result;
+  if (!read(key, result)) {
+    return false;
+  }
+
+  value = get_document().get_arena().store(result);
+  return true;
+}
+
+bool
+ReaderMappingImpl::read(Key const& key, std::span<int> values) const
+{
+  return read_into_span(*this, key, values);
+}
+
+bool
+ReaderMappingImpl::read(Key const& key, std::span<float> values) const
+{
+  return read_into_span(*this, key, values);
+}
+
+void
+ReaderMappingImpl::read_fields(ReaderFieldTable const& fields, std::span<bool> found) const
+{
+  for (std::size_t i = 0; i < fields.size(); ++i) {
+    found[i] = std::visit([this, &fields, i](auto* target) {
+      return read(fields[i].key, *target);
+    }, fields[i].target);
+  }
+}
+
+std::size_t
+ReaderMappingImpl::first_key_cursor() const
+{
+  return 0;
+}
+
+std::size_t
+ReaderMappingImpl::next_key_cursor(std::size_t cursor) const
+{
+  return cursor + 1;
+}
+
+std::size_t
+ReaderMappingImpl::end_key_cursor() const
+{
+  return get_keys().size();
+}
+
+std::string_view
+ReaderMappingImpl::get_key_at_cursor(std::size_t cursor, std::string& buffer) const
+{
+  std::vector<std::string> keys = get_keys();
+  buffer = std::move(keys[cursor]);
+  return buffer;
+}
+
 } // namespace prio
 
 /* EOF */
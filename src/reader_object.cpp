@@ -55,6 +55,14 @@ ReaderObject::get_name() const
   return m_impl->get_name();
 }
 
+std::string_view
+ReaderObject::get_name_view() const
+{
+  if (!m_impl) { return {}; }
+
+  return m_impl->get_name_view();
+}
+
 ReaderMapping
 ReaderObject::get_mapping() const
 {
@@ -63,6 +71,12 @@ ReaderObject::get_mapping() const
   return m_impl->get_mapping();
 }
 
+std::string_view
+ReaderObjectImpl::get_name_view() const
+{
+  return get_document().get_arena().store(get_name());
+}
+
 } // namespace prio
 
 /* EOF */
@@ -0,0 +1,792 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "reader_stream.hpp"
+
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "fastjson_parser.hpp"
+#include "fastsexpr_parser.hpp"
+#include "format_util.hpp"
+#include "reader_error.hpp"
+
+namespace prio {
+
+namespace {
+
+constexpr std::size_t CHUNK_SIZE = 64 * 1024;
+constexpr std::size_t MAX_DEPTH = 1024;
+
+inline bool is_whitespace(int c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+/** Reads an std::istream in fixed size chunks and keeps track of the
+    current line */
+class CharSource final
+{
+public:
+  CharSource(std::unique_ptr<std::istream> owned, std::istream& stream) :
+    m_owned(std::move(owned)),
+    m_stream(&stream),
+    m_buffer(CHUNK_SIZE),
+    m_pos(0),
+    m_end(0),
+    m_line(1)
+  {}
+
+  int peek()
+  {
+    if (m_pos == m_end && !fill()) {
+      return EOF;
+    }
+    return static_cast<unsigned char>(m_buffer[m_pos]);
+  }
+
+  int get()
+  {
+    int const c = peek();
+    if (c != EOF) {
+      m_pos += 1;
+      if (c == '\n') {
+        m_line += 1;
+      }
+    }
+    return c;
+  }
+
+  void skip_whitespace()
+  {
+    while (is_whitespace(peek())) {
+      get();
+    }
+  }
+
+  int get_line() const { return m_line; }
+
+private:
+  bool fill()
+  {
+    m_stream->read(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+    m_pos = 0;
+    m_end = static_cast<std::size_t>(m_stream->gcount());
+    return m_end > 0;
+  }
+
+private:
+  std::unique_ptr<std::istream> m_owned;
+  std::istream* m_stream;
+  std::vector<char> m_buffer;
+  std::size_t m_pos;
+  std::size_t m_end;
+  int m_line;
+
+public:
+  CharSource(CharSource&&) = default;
+
+private:
+  CharSource(CharSource const&) = delete;
+  CharSource& operator=(CharSource const&) = delete;
+};
+
+} // namespace
+
+using Event = ReaderStream::Event;
+
+class ReaderStreamImpl
+{
+public:
+  ReaderStreamImpl(CharSource source, std::optional<std::string> const& filename) :
+    m_source(std::move(source)),
+    m_filename(filename),
+    m_name(),
+    m_string(),
+    m_token(),
+    m_bool(false),
+    m_int(0),
+    m_float(0.0f),
+    m_depth(0),
+    m_line(1)
+  {}
+
+  virtual ~ReaderStreamImpl() {}
+
+  Event next()
+  {
+    Event const event = read_event();
+    switch (event) {
+      case Event::BEGIN_OBJECT:
+      case Event::BEGIN_COLLECTION:
+        m_depth += 1;
+        break;
+
+      case Event::END_OBJECT:
+      case Event::END_COLLECTION:
+        m_depth -= 1;
+        break;
+
+      default:
+        break;
+    }
+    return event;
+  }
+
+  std::string_view get_name() const { return m_name; }
+  bool get_bool() const { return m_bool; }
+  int get_int() const { return m_int; }
+  float get_float() const { return m_float; }
+  std::string_view get_string() const { return m_string; }
+  int get_depth() const { return m_depth; }
+  int get_line() const { return m_line; }
+
+protected:
+  virtual Event read_event() = 0;
+
+  /** Records the line of the event that is about to be read */
+  void mark() { m_line = m_source.get_line(); }
+
+  Event set_int(int value)
+  {
+    m_int = value;
+    m_float = static_cast<float>(value);
+    return Event::INT;
+  }
+
+  Event set_float(float value)
+  {
+    m_float = value;
+    return Event::FLOAT;
+  }
+
+  [[noreturn]]
+  void error(std::string_view message) const
+  {
+    throw ReaderError(std::format("{}:{}: {}",
+                                  m_filename ? *m_filename : "<unknown>",
+                                  m_source.get_line(), message));
+  }
+
+protected:
+  CharSource m_source;
+  std::optional<std::string> m_filename;
+
+  std::string m_name;
+  std::string m_string;
+
+  /** scratch buffer for the token currently being read */
+  std::string m_token;
+
+  bool m_bool;
+  int m_int;
+  float m_float;
+
+private:
+  int m_depth;
+  int m_line;
+
+private:
+  ReaderStreamImpl(ReaderStreamImpl const&) = delete;
+  ReaderStreamImpl& operator=(ReaderStreamImpl const&) = delete;
+};
+
+namespace {
+
+class SExprReaderStreamImpl final : public ReaderStreamImpl
+{
+public:
+  using ReaderStreamImpl::ReaderStreamImpl;
+
+protected:
+  Event read_event() override
+  {
+    if (m_pending) {
+      Event const event = *m_pending;
+      m_pending.reset();
+      return event;
+    }
+
+    skip_whitespace();
+    mark();
+    switch (m_source.peek()) {
+      case EOF:
+        if (!m_stack.empty()) {
+          error("unexpected end of file in list");
+        }
+        return Event::END_DOCUMENT;
+
+      case '(': {
+        m_source.get();
+        if (m_stack.size() >= MAX_DEPTH) {
+          error("document nested too deeply");
+        }
+
+        // a list starting with a symbol is an object, anything else a
+        // collection whose first element has already been read
+        skip_whitespace();
+        int const c = m_source.peek();
+        if (c != EOF && c != '(' && c != ')' && c != '"') {
+          bool symbol;
+          Event const event = read_atom(symbol);
+          if (symbol) {
+            std::swap(m_name, m_string);
+            m_stack.push_back(true);
+            return Event::BEGIN_OBJECT;
+          }
+          m_pending = event;
+        }
+        m_stack.push_back(false);
+        return Event::BEGIN_COLLECTION;
+      }
+
+      case ')': {
+        m_source.get();
+        if (m_stack.empty()) {
+          error("unexpected ')'");
+        }
+        bool const object = m_stack.back();
+        m_stack.pop_back();
+        return object ? Event::END_OBJECT : Event::END_COLLECTION;
+      }
+
+      case '"':
+        read_string();
+        return Event::STRING;
+
+      default: {
+        bool symbol;
+        return read_atom(symbol);
+      }
+    }
+  }
+
+private:
+  void skip_whitespace()
+  {
+    while (true) {
+      int const c = m_source.peek();
+      if (is_whitespace(c)) {
+        m_source.get();
+      } else if (c == ';') {
+        while (m_source.peek() != EOF && m_source.get() != '\n') {}
+      } else {
+        return;
+      }
+    }
+  }
+
+  void read_string()
+  {
+    m_source.get();
+    m_string.clear();
+    while (true) {
+      int c = m_source.get();
+      if (c == EOF) {
+        error("unterminated string");
+      } else if (c == '"') {
+        return;
+      } else if (c == '\\') {
+        c = m_source.get();
+        if (c == EOF) {
+          error("unterminated string");
+        }
+        m_string += (c == 'n') ? '\n' : (c == 't') ? '\t' : static_cast<char>(c);
+      } else {
+        m_string += static_cast<char>(c);
+      }
+    }
+  }
+
+  /** Reads an unquoted atom, symbols are reported as STRING with
+      @a symbol set */
+  Event read_atom(bool& symbol)
+  {
+    m_string.clear();
+    while (true) {
+      int const c = m_source.peek();
+      if (c == EOF || is_whitespace(c) || c == '(' || c == ')' || c == '"' || c == ';') {
+        break;
+      }
+      m_string += static_cast<char>(m_source.get());
+    }
+
+    symbol = false;
+    std::string_view token = m_string;
+    switch (fastsexpr_classify_atom(token)) {
+      case FastSExprTape::Type::BOOLEAN:
+        m_bool = (token[1] == 't');
+        return Event::BOOL;
+
+      case FastSExprTape::Type::INTEGER: {
+        if (token[0] == '+') {
+          token.remove_prefix(1);
+        }
+        int value = 0;
+        std::from_chars(token.data(), token.data() + token.size(), value);
+        return set_int(value);
+      }
+
+      case FastSExprTape::Type::REAL:
+        return set_float(std::strtof(m_string.c_str(), nullptr));
+
+      default:
+        symbol = true;
+        return Event::STRING;
+    }
+  }
+
+private:
+  /** true for objects, false for collections */
+  std::vector<bool> m_stack {};
+
+  /** value read while classifying a list, returned by the next call */
+  std::optional<Event> m_pending {};
+};
+
+class JsonReaderStreamImpl final : public ReaderStreamImpl
+{
+public:
+  using ReaderStreamImpl::ReaderStreamImpl;
+
+private:
+  enum class State
+  {
+    FIRST,         // directly after the opening bracket
+    ITEM,          // after a comma
+    MEMBER_VALUE,  // after "key":
+    IN_VALUE,      // a value is being read
+    AFTER_ITEM     // a value has been completed
+  };
+
+  struct Frame
+  {
+    bool object;
+
+    /** arrays only: BEGIN_COLLECTION was reported */
+    bool collection;
+
+    /** objects only: BEGIN_OBJECT was reported for the current member */
+    bool member_open;
+
+    State state;
+  };
+
+protected:
+  Event read_event() override
+  {
+    while (true) {
+      if (m_value_done) {
+        m_value_done = false;
+        if (!m_stack.empty()) {
+          Frame& frame = m_stack.back();
+          frame.state = State::AFTER_ITEM;
+          if (frame.member_open) {
+            frame.member_open = false;
+            return Event::END_OBJECT;
+          }
+        }
+        continue;
+      }
+
+      m_source.skip_whitespace();
+      mark();
+      int const c = m_source.peek();
+
+      if (m_stack.empty()) {
+        if (c == EOF) {
+          return Event::END_DOCUMENT;
+        } else if (auto event = begin_value(c)) {
+          return *event;
+        } else {
+          continue;
+        }
+      }
+
+      if (c == EOF) {
+        error("unexpected end of file");
+      }
+
+      // begin_value() may grow m_stack, so the state is updated first
+      Frame& frame = m_stack.back();
+      char const close = frame.object ? '}' : ']';
+      switch (frame.state) {
+        case State::FIRST:
+          if (c == close) {
+            if (auto event = end_container()) {
+              return *event;
+            }
+            continue;
+          }
+          [[fallthrough]];
+
+        case State::ITEM:
+          if (frame.object) {
+            return begin_member(frame, c);
+          }
+          frame.state = State::IN_VALUE;
+          if (auto event = begin_value(c)) {
+            return *event;
+          }
+          continue;
+
+        case State::MEMBER_VALUE:
+          frame.state = State::IN_VALUE;
+          if (auto event = begin_value(c)) {
+            return *event;
+          }
+          continue;
+
+        case State::AFTER_ITEM:
+          if (c == ',') {
+            m_source.get();
+            frame.state = State::ITEM;
+            continue;
+          } else if (c == close) {
+            if (auto event = end_container()) {
+              return *event;
+            }
+            continue;
+          } else {
+            error(std::format("expected ',' or '{}'", close));
+          }
+
+        case State::IN_VALUE:
+          break;
+      }
+
+      error("invalid parser state");
+    }
+  }
+
+private:
+  void push_frame(bool object, bool collection)
+  {
+    if (m_stack.size() >= MAX_DEPTH) {
+      error("document nested too deeply");
+    }
+    m_stack.push_back(Frame{object, collection, false, State::FIRST});
+  }
+
+  std::optional<Event> end_container()
+  {
+    m_source.get();
+    Frame const frame = m_stack.back();
+    m_stack.pop_back();
+    m_value_done = true;
+    if (frame.collection) {
+      return Event::END_COLLECTION;
+    }
+    return std::nullopt;
+  }
+
+  Event begin_member(Frame& frame, int c)
+  {
+    if (c != '"') {
+      error("expected string as object key");
+    }
+    read_string(m_name);
+
+    m_source.skip_whitespace();
+    if (m_source.get() != ':') {
+      error("expected ':' after object key");
+    }
+
+    frame.member_open = true;
+    frame.state = State::MEMBER_VALUE;
+    return Event::BEGIN_OBJECT;
+  }
+
+  /** Reads the start of a value, returns nullopt for values that produce
+      no event of their own */
+  std::optional<Event> begin_value(int c)
+  {
+    switch (c) {
+      case '{':
+        m_source.get();
+        push_frame(true, false);
+        return std::nullopt;
+
+      case '[': {
+        m_source.get();
+        // arrays that are member values are transparent
+        bool const collection = m_stack.empty() || !m_stack.back().object;
+        push_frame(false, collection);
+        if (collection) {
+          return Event::BEGIN_COLLECTION;
+        }
+        return std::nullopt;
+      }
+
+      case '"':
+        read_string(m_string);
+        m_value_done = true;
+        return Event::STRING;
+
+      case 't':
+      case 'f':
+      case 'n': {
+        read_token();
+        m_value_done = true;
+        if (m_token == "true" || m_token == "false") {
+          m_bool = (m_token == "true");
+          return Event::BOOL;
+        } else if (m_token == "null") {
+          return std::nullopt;
+        }
+        error(std::format("invalid literal '{}'", m_token));
+      }
+
+      case EOF:
+        error("unexpected end of file");
+
+      default:
+        if (c == '-' || (c >= '0' && c <= '9')) {
+          read_token();
+          m_value_done = true;
+          return read_number();
+        }
+        error(std::format("unexpected character '{}'", static_cast<char>(c)));
+    }
+  }
+
+  void read_string(std::string& out)
+  {
+    // collect the literal including its quotes and decode it in one go
+    m_token.clear();
+    m_token += static_cast<char>(m_source.get());
+    bool has_escape = false;
+    while (true) {
+      int c = m_source.get();
+      if (c == EOF) {
+        error("unterminated string");
+      }
+      m_token += static_cast<char>(c);
+      if (c == '"') {
+        break;
+      } else if (c == '\\') {
+        has_escape = true;
+        c = m_source.get();
+        if (c == EOF) {
+          error("unterminated string");
+        }
+        m_token += static_cast<char>(c);
+      }
+    }
+
+    out.clear();
+    if (!has_escape) {
+      out.append(m_token, 1, m_token.size() - 2);
+      return;
+    }
+
+    try {
+      fastjson_decode_string(m_token, out);
+    } catch (ReaderError const& err) {
+      error(err.what());
+    }
+  }
+
+  /** Reads the characters of a literal or number into m_token */
+  void read_token()
+  {
+    m_token.clear();
+    while (true) {
+      int const c = m_source.peek();
+      if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') ||
+          c == '-' || c == '+' || c == '.' || c == 'E') {
+        m_token += static_cast<char>(m_source.get());
+      } else {
+        return;
+      }
+    }
+  }
+
+  Event read_number()
+  {
+    char const* const begin = m_token.data();
+    char const* const end = begin + m_token.size();
+
+    if (m_token.find_first_of(".eE") == std::string::npos) {
+      int value = 0;
+      auto const result = std::from_chars(begin, end, value);
+      if (result.ec == std::errc() && result.ptr == end) {
+        return set_int(value);
+      } else if (result.ec != std::errc::result_out_of_range) {
+        error(std::format("invalid number '{}'", m_token));
+      }
+      // out of range integers degrade to floats
+    }
+
+    double value = 0.0;
+    auto const result = std::from_chars(begin, end, value);
+    if (result.ptr != end || (result.ec != std::errc() && result.ec != std::errc::result_out_of_range)) {
+      error(std::format("invalid number '{}'", m_token));
+    }
+    if (result.ec == std::errc::result_out_of_range) {
+      // from_chars() leaves the value untouched, strtod() saturates
+      value = std::strtod(m_token.c_str(), nullptr);
+    }
+    return set_float(static_cast<float>(value));
+  }
+
+private:
+  std::vector<Frame> m_stack {};
+
+  /** the last value completed, the enclosing member is closed by the
+      next call */
+  bool m_value_done = false;
+};
+
+std::unique_ptr<ReaderStreamImpl>
+create_impl(Format format, CharSource source, std::optional<std::string> const& filename)
+{
+  if (format == Format::AUTO) {
+    source.skip_whitespace();
+    int const c = source.peek();
+    format = (c == '{' || c == '[') ? Format::JSON : Format::SEXPR;
+  }
+
+  switch (format) {
+    case Format::JSON:
+    case Format::FASTJSON:
+      return std::make_unique<JsonReaderStreamImpl>(std::move(source), filename);
+
+    case Format::SEXPR:
+    case Format::FASTSEXPR:
+      return std::make_unique<SExprReaderStreamImpl>(std::move(source), filename);
+
+    default:
+      throw std::invalid_argument("ReaderStream: unsupported format");
+  }
+}
+
+} // namespace
+
+ReaderStream
+ReaderStream::from_file(Format format, std::filesystem::path const& filename)
+{
+  auto fin = std::make_unique<std::ifstream>(filename, std::ios::binary);
+  if (!*fin) {
+    throw ReaderError(std::format("{}: failed to open", stream_str(filename)));
+  }
+
+  std::istream& stream = *fin;
+  return ReaderStream(create_impl(format, CharSource(std::move(fin), stream), filename.string()));
+}
+
+ReaderStream
+ReaderStream::from_stream(Format format, std::istream& stream, std::optional<std::string> const& filename)
+{
+  return ReaderStream(create_impl(format, CharSource(nullptr, stream), filename));
+}
+
+ReaderStream
+ReaderStream::from_file(std::filesystem::path const& filename)
+{
+  return from_file(Format::AUTO, filename);
+}
+
+ReaderStream
+ReaderStream::from_stream(std::istream& stream, std::optional<std::string> const& filename)
+{
+  return from_stream(Format::AUTO, stream, filename);
+}
+
+ReaderStream::ReaderStream(std::unique_ptr<ReaderStreamImpl> impl) :
+  m_impl(std::move(impl))
+{
+}
+
+ReaderStream::ReaderStream(ReaderStream&&) noexcept = default;
+
+ReaderStream::~ReaderStream()
+{
+}
+
+ReaderStream&
+ReaderStream::operator=(ReaderStream&&) noexcept = default;
+
+ReaderStream::Event
+ReaderStream::next()
+{
+  return m_impl->next();
+}
+
+void
+ReaderStream::skip()
+{
+  int const depth = m_impl->get_depth() - 1;
+  while (m_impl->get_depth() > depth) {
+    if (m_impl->next() == Event::END_DOCUMENT) {
+      return;
+    }
+  }
+}
+
+std::string_view
+ReaderStream::get_name() const
+{
+  return m_impl->get_name();
+}
+
+bool
+ReaderStream::get_bool() const
+{
+  return m_impl->get_bool();
+}
+
+int
+ReaderStream::get_int() const
+{
+  return m_impl->get_int();
+}
+
+float
+ReaderStream::get_float() const
+{
+  return m_impl->get_float();
+}
+
+std::string_view
+ReaderStream::get_string() const
+{
+  return m_impl->get_string();
+}
+
+int
+ReaderStream::get_depth() const
+{
+  return m_impl->get_depth();
+}
+
+int
+ReaderStream::get_line() const
+{
+  return m_impl->get_line();
+}
+
+} // namespace prio
+
+/* EOF */
@@ -18,11 +18,13 @@
 
 #include <set>
 #include <sstream>
+#include <variant>
 
 #include <logmich/log.hpp>
 #include <sexp/util.hpp>
 #include <sexp/io.hpp>
 
+#include "array_values.hpp"
 #include "reader_collection.hpp"
 #include "reader_error.hpp"
 #include "reader_impl.hpp"
@@ -34,19 +36,81 @@
 
 namespace prio {
 
+namespace {
+
+/** Estimates the heap memory used by the children of @a sx */
+std::size_t sexp_memory_usage(sexp::Value const& sx)
+{
+  if (sx.is_array()) {
+    std::vector<sexp::Value> const& items = sx.as_array();
+    std::size_t result = items.capacity() * sizeof(sexp::Value);
+    for (sexp::Value const& item : items) {
+      result += sexp_memory_usage(item);
+    }
+    return result;
+  } else if (sx.is_string() || sx.is_symbol()) {
+    // short strings are stored inline
+    std::string const& text = sx.as_string();
+    return (text.capacity() > std::string().capacity()) ? text.capacity() + 1 : 0;
+  } else {
+    return 0;
+  }
+}
+
+} // namespace
+
 SExprReaderDocumentImpl::SExprReaderDocumentImpl(sexp::Value sx, ErrorHandler error_handler,
-                                                 std::optional<std::string> filename) :
+                                                 std::optional<std::string> filename, int line_offset) :
   m_sx(std::move(sx)),
   m_error_handler(error_handler),
   m_filename(std::move(filename)),
-  m_parent(nullptr)
+  m_line_offset(line_offset),
+  m_parent(nullptr),
+  m_indices_mutex(),
+  m_indices()
 {
 }
 
+SExprReaderDocumentImpl::Index const&
+SExprReaderDocumentImpl::get_index(sexp::Value const& sx) const
+{
+  std::lock_guard<std::mutex> lock(m_indices_mutex);
+  auto const [result, inserted] = m_indices.try_emplace(&sx);
+  if (!inserted) {
+    return result->second;
+  }
+
+  std::vector<sexp::Value> const& arr = sx.as_array();
+  Index& index = result->second;
+  index.reserve(arr.size() - 1);
+  for (size_t i = 1; i < arr.size(); ++i)
+  {
+    std::vector<sexp::Value> const& keyvalue = arr[i].as_array();
+    if (keyvalue.empty()) {
+      continue;
+    }
+
+    auto const [it, emplaced] = index.try_emplace(keyvalue[0].as_string(), &arr[i]);
+    if (!emplaced)
+    {
+      log_error("duplicate key value '{}'", it->first);
+      it->second = &arr[i];
+    }
+  }
+
+  return index;
+}
+
 ReaderObject
 SExprReaderDocumentImpl::get_root() const
 {
-  return ReaderObject(std::make_unique<SExprReaderObjectImpl>(*this, m_sx));
+  return ReaderObject(std::in_place_type<SExprReaderObjectImpl>, *this, m_sx);
+}
+
+std::size_t
+SExprReaderDocumentImpl::get_memory_usage() const
+{
+  return sizeof(*this) + sexp_memory_usage(m_sx);
 }
 
 void
@@ -60,10 +124,10 @@ SExprReaderDocumentImpl::error(ErrorHandler error_handler, sexp::Value const& sx
 {
   switch (error_handler) {
     case ErrorHandler::THROW:
-      throw ReaderError(std::format("{}:{}: {}: {}", m_filename ? *m_filename : "<unknown>", sx.get_line(), stream_str(sx), message));
+      throw ReaderError(std::format("{}:{}: {}: {}", m_filename ? *m_filename : "<unknown>", sx.get_line() + m_line_offset, stream_str(sx), message));
 
     case ErrorHandler::LOG:
-      log_error("{}:{}: {}: {}", m_filename ? *m_filename : "<unknown>", sx.get_line(), stream_str(sx), message);
+      log_error("{}:{}: {}: {}", m_filename ? *m_filename : "<unknown>", sx.get_line() + m_line_offset, stream_str(sx), message);
       break;
 
     case ErrorHandler::IGNORE:
@@ -88,6 +152,12 @@ SExprReaderObjectImpl::~SExprReaderObjectImpl()
 
 std::string
 SExprReaderObjectImpl::get_name() const
+{
+  return std::string(get_name_view());
+}
+
+std::string_view
+SExprReaderObjectImpl::get_name_view() const
 {
   if (m_sx.as_array().empty()) {
     throw ReaderError("invalid syntax");
@@ -99,7 +169,7 @@ SExprReaderObjectImpl::get_name() const
 ReaderMapping
 SExprReaderObjectImpl::get_mapping() const
 {
-  return ReaderMapping(std::make_unique<SExprReaderMappingImpl>(m_doc, m_sx));
+  return ReaderMapping(std::in_place_type<SExprReaderMappingImpl>, m_doc, m_sx);
 }
 
 
@@ -119,15 +189,28 @@ SExprReaderCollectionImpl::get_objects() const
 {
   std::vector<ReaderObject> lst;
   for (size_t i = 1; i < m_sx.as_array().size(); ++i) {
-    lst.push_back(ReaderObject(std::make_unique<SExprReaderObjectImpl>(m_doc, m_sx.as_array()[i])));
+    lst.emplace_back(std::in_place_type<SExprReaderObjectImpl>, m_doc, m_sx.as_array()[i]);
   }
   return lst;
 }
 
+std::size_t
+SExprReaderCollectionImpl::get_size() const
+{
+  return m_sx.as_array().size() - 1;
+}
+
+ReaderObject
+SExprReaderCollectionImpl::get_object(std::size_t index) const
+{
+  return ReaderObject(std::in_place_type<SExprReaderObjectImpl>, m_doc, m_sx.as_array()[index + 1]);
+}
+
 
 SExprReaderMappingImpl::SExprReaderMappingImpl(SExprReaderDocumentImpl const& doc, sexp::Value const& sx) :
   m_doc(doc),
-  m_sx(sx)
+  m_sx(sx),
+  m_index(nullptr)
 {
   assert(m_sx.is_array());
   // Expects data in this format:
@@ -137,6 +220,13 @@ SExprReaderMappingImpl::SExprReaderMappingImpl(SExprReaderDocumentImpl const& do
   // 'objectname' is ignored
 }
 
+SExprReaderMappingImpl::SExprReaderMappingImpl(SExprReaderMappingImpl&& other) noexcept :
+  m_doc(other.m_doc),
+  m_sx(other.m_sx),
+  m_index(other.m_index.load(std::memory_order_relaxed))
+{
+}
+
 SExprReaderMappingImpl::~SExprReaderMappingImpl()
 {
 }
@@ -145,30 +235,170 @@ std::vector<std::string>
 SExprReaderMappingImpl::get_keys() const
 {
   std::vector<std::string> result;
+  std::string buffer;
+  for (std::size_t i = first_key_cursor(); i != end_key_cursor(); i = next_key_cursor(i)) {
+    result.emplace_back(get_key_at_cursor(i, buffer));
+  }
+  return result;
+}
+
+std::size_t
+SExprReaderMappingImpl::first_key_cursor() const
+{
+  return 1;
+}
 
+std::size_t
+SExprReaderMappingImpl::next_key_cursor(std::size_t cursor) const
+{
+  return cursor + 1;
+}
+
+std::size_t
+SExprReaderMappingImpl::end_key_cursor() const
+{
   assert(m_sx.is_array());
-  for (size_t i = 1; i < m_sx.as_array().size(); ++i) {
-    sexp::Value const& keyvalue = m_sx.as_array()[i];
-    if (!keyvalue.is_array() || keyvalue.as_array().empty()) {
-      std::ostringstream oss;
-      oss << keyvalue << ": malformed mapping, expected array";
-      throw ReaderError(oss.str());
-    }
+  return m_sx.as_array().size();
+}
+
+std::string_view
+SExprReaderMappingImpl::get_key_at_cursor(std::size_t cursor, std::string& /*buffer*/) const
+{
+  sexp::Value const& keyvalue = m_sx.as_array()[cursor];
+  if (!keyvalue.is_array() || keyvalue.as_array().empty()) {
+    std::ostringstream oss;
+    oss << keyvalue << ": malformed mapping, expected array";
+    throw ReaderError(oss.str());
+  }
+
+  if (!keyvalue.as_array()[0].is_symbol()) {
+    std::ostringstream oss;
+    oss << keyvalue << ": malformed mapping, expected symbol";
+    throw ReaderError(oss.str());
+  }
+
+  return keyvalue.as_array()[0].as_string();
+}
 
-    if (!keyvalue.as_array()[0].is_symbol()) {
-      std::ostringstream oss;
-      oss << keyvalue << ": malformed mapping, expected symbol";
-      throw ReaderError(oss.str());
+bool
+SExprReaderMappingImpl::read(Key const& key, bool& value) const
+{
+  return read_element(get_subsection(key), value);
+}
+
+bool
+SExprReaderMappingImpl::read(Key const& key, int& value) const
+{
+  return read_element(get_subsection(key), value);
+}
+
+bool
+SExprReaderMappingImpl::read(Key const& key, float& value) const
+{
+  return read_element(get_subsection(key), value);
+}
+
+bool
+SExprReaderMappingImpl::read(Key const& key, std::string& value) const
+{
+  return read_element(get_subsection(key), value);
+}
+
+bool
+SExprReaderMappingImpl::read(Key const& key, std::vector<bool>& values) const
+{
+  return read_element(get_subsection(key), values);
+}
+
+bool
+SExprReaderMappingImpl::read(Key const& key, std::vector<int>& values) const
+{
+  return read_element(get_subsection(key), values);
+}
+
+bool
+SExprReaderMappingImpl::read(Key const& key, std::vector<float>& values) const
+{
+  return read_element(get_subsection(key), values);
+}
+
+bool
+SExprReaderMappingImpl::read(Key const& key, std::vector<std::string>& values) const
+{
+  return read_element(get_subsection(key), values);
+}
+
+bool
+SExprReaderMappingImpl::read(Key const& key, std::string_view& value) const
+{
+  return read_element(get_subsection(key), value);
+}
+
+bool
+SExprReaderMappingImpl::read(Key const& key, std::span<int> values) const
+{
+  return read_element(get_subsection(key), values);
+}
+
+bool
+SExprReaderMappingImpl::read(Key const& key, std::span<float> values) const
+{
+  return read_element(get_subsection(key), values);
+}
+
+bool
+SExprReaderMappingImpl::read(Key const& key, ReaderObject& value) const
+{
+  return read_element(get_subsection(key), value);
+}
+
+bool
+SExprReaderMappingImpl::read(Key const& key, ReaderCollection& value) const
+{
+  return read_element(get_subsection(key), value);
+}
+
+bool
+SExprReaderMappingImpl::read(Key const& key, ReaderMapping& value) const
+{
+  return read_element(get_subsection(key), value);
+}
+
+void
+SExprReaderMappingImpl::read_fields(ReaderFieldTable const& fields, std::span<bool> found) const
+{
+  // like get_subsection(), the last of several duplicate keys wins, so
+  // only that one is decoded
+  std::vector<sexp::Value const*> last(fields.size(), nullptr);
+  std::vector<sexp::Value> const& arr = m_sx.as_array();
+  for (size_t i = 1; i < arr.size(); ++i)
+  {
+    std::size_t const field = fields.find(arr[i].as_array()[0].as_string());
+    if (field == fields.size()) {
+      continue;
     }
 
-    result.emplace_back(keyvalue.as_array()[0].as_string());
+    if (last[field] != nullptr) {
+      log_error("duplicate key value '{}'", fields[field].key.get_name());
+    }
+    last[field] = &arr[i];
   }
 
-  return result;
+  for (std::size_t field = 0; field < fields.size(); ++field)
+  {
+    sexp::Value const* sub = last[field];
+    if (sub == nullptr) {
+      continue;
+    }
+
+    found[field] = std::visit([this, sub](auto* target) {
+      return read_element(sub, *target);
+    }, fields[field].target);
+  }
 }
 
 #define GET_VALUE_MACRO(type, checker, getter)         \
-  sexp::Value const* item = get_subsection_item(key);  \
+  sexp::Value const* item = get_item(sub);             \
   if (!item) { return false; }                         \
   if (!item->checker()) {                              \
     m_doc.error(*item, "expected " type);              \
@@ -178,25 +408,31 @@ SExprReaderMappingImpl::get_keys() const
   return true
 
 bool
-SExprReaderMappingImpl::read(std::string_view key, bool& value) const
+SExprReaderMappingImpl::read_element(sexp::Value const* sub, bool& value) const
 {
   GET_VALUE_MACRO("bool", is_boolean, as_bool);
 }
 
 bool
-SExprReaderMappingImpl::read(std::string_view key, int& value) const
+SExprReaderMappingImpl::read_element(sexp::Value const* sub, int& value) const
 {
   GET_VALUE_MACRO("int", is_integer, as_int);
 }
 
 bool
-SExprReaderMappingImpl::read(std::string_view key, float& value) const
+SExprReaderMappingImpl::read_element(sexp::Value const* sub, float& value) const
 {
   GET_VALUE_MACRO("float", is_real, as_float);
 }
 
 bool
-SExprReaderMappingImpl::read(std::string_view key, std::string& value) const
+SExprReaderMappingImpl::read_element(sexp::Value const* sub, std::string& value) const
+{
+  GET_VALUE_MACRO("string", is_string, as_string);
+}
+
+bool
+SExprReaderMappingImpl::read_element(sexp::Value const* sub, std::string_view& value) const
 {
   GET_VALUE_MACRO("string", is_string, as_string);
 }
@@ -204,7 +440,7 @@ SExprReaderMappingImpl::read(std::string_view key, std::string& value) const
 #undef GET_VALUE_MACRO
 
 #define GET_VALUES_MACRO(type, checker, getter)                 \
-  sexp::Value const* item = get_subsection_items(key);          \
+  sexp::Value const* item = get_items(sub);                     \
   if (!item) { return false; }                                  \
   if (!item->is_array()) {                                      \
     m_doc.error(*item, "expected array");                       \
@@ -218,42 +454,58 @@ SExprReaderMappingImpl::read(std::string_view key, std::string& value) const
     }                                                           \
   }                                                             \
                                                                 \
-  values.resize(item->as_array().size() - 1);                   \
+  if (!resize_values(values, item->as_array().size() - 1)) {    \
+    m_doc.error(*item, size_mismatch_message(values.size(),     \
+                                             item->as_array().size() - 1)); \
+    return false;                                               \
+  }                                                             \
   for (size_t i = 0; i < values.size(); ++i) {                  \
     values[i] = item->as_array()[i + 1].getter();               \
   }                                                             \
   return true
 
 bool
-SExprReaderMappingImpl::read(std::string_view key, std::vector<bool>& values) const
+SExprReaderMappingImpl::read_element(sexp::Value const* sub, std::vector<bool>& values) const
 {
   GET_VALUES_MACRO("bool", is_boolean, as_bool);
 }
 
 bool
-SExprReaderMappingImpl::read(std::string_view key, std::vector<int>& values) const
+SExprReaderMappingImpl::read_element(sexp::Value const* sub, std::vector<int>& values) const
 {
   GET_VALUES_MACRO("int", is_integer, as_int);
 }
 
 bool
-SExprReaderMappingImpl::read(std::string_view key, std::vector<float>& values) const
+SExprReaderMappingImpl::read_element(sexp::Value const* sub, std::vector<float>& values) const
 {
   GET_VALUES_MACRO("float", is_real, as_float);
 }
 
 bool
-SExprReaderMappingImpl::read(std::string_view key, std::vector<std::string>& values) const
+SExprReaderMappingImpl::read_element(sexp::Value const* sub, std::vector<std::string>& values) const
 {
   GET_VALUES_MACRO("string", is_string, as_string);
 }
 
+bool
+SExprReaderMappingImpl::read_element(sexp::Value const* sub, std::span<int> values) const
+{
+  GET_VALUES_MACRO("int", is_integer, as_int);
+}
+
+bool
+SExprReaderMappingImpl::read_element(sexp::Value const* sub, std::span<float> values) const
+{
+  GET_VALUES_MACRO("float", is_real, as_float);
+}
+
 #undef GET_VALUES_MACRO
 
 bool
-SExprReaderMappingImpl::read(std::string_view key, ReaderObject& value) const
+SExprReaderMappingImpl::read_element(sexp::Value const* sub, ReaderObject& value) const
 {
-  sexp::Value const* cur = get_subsection_item(key);
+  sexp::Value const* cur = get_item(sub);
   if (!cur) {
     return false;
   }
@@ -263,41 +515,39 @@ SExprReaderMappingImpl::read(std::string_view key, ReaderObject& value) const
     return false;
   }
 
-  value = ReaderObject(std::make_unique<SExprReaderObjectImpl>(m_doc, *cur));
+  value = ReaderObject(std::in_place_type<SExprReaderObjectImpl>, m_doc, *cur);
   return true;
 }
 
 bool
-SExprReaderMappingImpl::read(std::string_view key, ReaderCollection& value) const
+SExprReaderMappingImpl::read_element(sexp::Value const* sub, ReaderCollection& value) const
 {
-  sexp::Value const* cur = get_subsection(key);
-  if (!cur) {
+  if (!sub) {
     return false;
   }
 
-  if (!cur->is_array()) {
-    m_doc.error(*cur, "must be array");
+  if (!sub->is_array()) {
+    m_doc.error(*sub, "must be array");
     return false;
   }
 
-  value = ReaderCollection(std::make_unique<SExprReaderCollectionImpl>(m_doc, *cur));
+  value = ReaderCollection(std::in_place_type<SExprReaderCollectionImpl>, m_doc, *sub);
   return true;
 }
 
 bool
-SExprReaderMappingImpl::read(std::string_view key, ReaderMapping& value) const
+SExprReaderMappingImpl::read_element(sexp::Value const* sub, ReaderMapping& value) const
 {
-  sexp::Value const* cur = get_subsection(key);
-  if (!cur) {
+  if (!sub) {
     return false;
   }
 
-  assert(cur->is_array());
+  assert(sub->is_array());
 
 #ifdef FIXME_WRONG_PLACE_TO_VALIDATE
   std::set<std::string> keys;
-  for (size_t i = 1; i < cur->as_array().size(); ++i) {
-    sexp::Value const& keyvalue_pair = cur->as_array()[i];
+  for (size_t i = 1; i < sub->as_array().size(); ++i) {
+    sexp::Value const& keyvalue_pair = sub->as_array()[i];
     if (!keyvalue_pair.is_array() || keyvalue_pair.as_array().empty()) {
       m_doc.error(keyvalue_pair, "malformed key/value pair");
       return false;
@@ -309,7 +559,7 @@ SExprReaderMappingImpl::read(std::string_view key, ReaderMapping& value) const
     }
 
     if (keys.find(keyvalue_pair.as_array()[0].as_string()) != keys.end()) {
-      m_doc.error(*cur, "duplicate key in mapping");
+      m_doc.error(*sub, "duplicate key in mapping");
       return false;
     }
 
@@ -317,7 +567,7 @@ SExprReaderMappingImpl::read(std::string_view key, ReaderMapping& value) const
   }
 #endif
 
-  value = ReaderMapping(std::make_unique<SExprReaderMappingImpl>(m_doc, *cur));
+  value = ReaderMapping(std::in_place_type<SExprReaderMappingImpl>, m_doc, *sub);
   return true;
 }
 
@@ -336,9 +586,8 @@ SExprReaderMappingImpl::missing_key_error(std::string_view key) const
 }
 
 sexp::Value const*
-SExprReaderMappingImpl::get_subsection_item(std::string_view key) const
+SExprReaderMappingImpl::get_item(sexp::Value const* sub) const
 {
-  sexp::Value const* sub = get_subsection(key);
   if (!sub) {
     return nullptr;
   }
@@ -357,9 +606,8 @@ SExprReaderMappingImpl::get_subsection_item(std::string_view key) const
 }
 
 sexp::Value const*
-SExprReaderMappingImpl::get_subsection_items(std::string_view key) const
+SExprReaderMappingImpl::get_items(sexp::Value const* sub) const
 {
-  sexp::Value const* sub = get_subsection(key);
   if (sub && !sub->as_array().empty()) {
     return sub;
   } else {
@@ -368,23 +616,37 @@ SExprReaderMappingImpl::get_subsection_items(std::string_view key) const
 }
 
 sexp::Value const*
-SExprReaderMappingImpl::get_subsection(std::string_view key) const
+SExprReaderMappingImpl::get_subsection(Key const& key) const
 {
+  std::vector<sexp::Value> const& arr = m_sx.as_array();
+
+  if (arr.size() > INDEX_THRESHOLD)
+  {
+    SExprReaderDocumentImpl::Index const* index = m_index.load(std::memory_order_acquire);
+    if (index == nullptr) {
+      index = &m_doc.get_index(m_sx);
+      m_index.store(index, std::memory_order_release);
+    }
+
+    auto const it = index->find(key);
+    return (it == index->end()) ? nullptr : it->second;
+  }
+
   sexp::Value const* result = nullptr;
 
   int count = 0;
-  for (size_t i = 1; i < m_sx.as_array().size(); ++i)
+  for (size_t i = 1; i < arr.size(); ++i)
   {
-    if (m_sx.as_array()[i].as_array()[0].as_string() == key)
+    if (arr[i].as_array()[0].as_string() == key.get_name())
     {
       count += 1;
-      result = &m_sx.as_array()[i];
+      result = &arr[i];
     }
   }
 
   if (count > 1)
   {
-    log_error("duplicate key value '{}'", key);
+    log_error("duplicate key value '{}'", key.get_name());
   }
 
   return result;
@@ -18,30 +18,54 @@
 
 #include <assert.h>
 #include <map>
+#include <variant>
+
+#include "number_format.hpp"
+#include "string_format.hpp"
+#include "writer_field.hpp"
 
 namespace prio {
 
 namespace {
 
-void write_escaped(std::ostream& os, std::string_view text)
+/** Append @a value as the element of a list, vectors become a
+    sequence of elements */
+void append_element(std::string& out, bool value)
 {
-  os << '"';
-  for(char const c : text) {
-    switch(c) {
-      case '"':
-        os << "\\\"";
-        break;
+  out += value ? " #t" : " #f";
+}
 
-      case '\\':
-        os << "\\\\";
-        break;
+void append_element(std::string& out, int value)
+{
+  out += ' ';
+  append_number(out, value);
+}
 
-      default:
-        os << c;
-        break;
-    }
+void append_element(std::string& out, float value)
+{
+  out += ' ';
+  append_number(out, value);
+}
+
+void append_element(std::string& out, std::string const& value)
+{
+  out += ' ';
+  append_quoted_string(out, value);
+}
+
+template<typename T>
+void append_element(std::string& out, std::vector<T> const& values)
+{
+  for (T const value : values) {
+    append_element(out, value);
+  }
+}
+
+void append_element(std::string& out, std::vector<std::string> const& values)
+{
+  for (std::string const& value : values) {
+    append_element(out, value);
   }
-  os << '"';
 }
 
 } // namespace
@@ -177,7 +201,7 @@ void
 SExprWriterImpl::write(std::string_view key, std::string_view value)
 {
   (*out) << "\n" << indent() << "(" << key << " ";
-  write_escaped(*out, value);
+  write_quoted_string(*out, value);
   (*out) << ")";
 }
 
@@ -217,7 +241,7 @@ SExprWriterImpl::write(std::string_view key, std::span<std::string const> values
   (*out) << "\n" << indent() << "(" << key;
   for (std::string const& value : values) {
     (*out) << ' ';
-    write_escaped(*out, value);
+    write_quoted_string(*out, value);
   }
   (*out) << ")";
 }
@@ -232,6 +256,23 @@ SExprWriterImpl::write(std::string_view key, std::vector<bool> const& values)
   (*out) << ")";
 }
 
+void
+SExprWriterImpl::write_fields(std::span<WriterField const> fields)
+{
+  std::string const prefix = "\n" + indent() + "(";
+
+  std::string text;
+  for (WriterField const& field : fields) {
+    text += prefix;
+    text += field.key;
+    std::visit([&text](auto const* value) {
+      append_element(text, *value);
+    }, field.value);
+    text += ')';
+  }
+  out->write(text.data(), static_cast<std::streamsize>(text.size()));
+}
+
 } // namespace prio
 
 /* EOF */
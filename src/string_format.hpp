@@ -0,0 +1,63 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_PRIO_STRING_FORMAT_HPP
+#define HEADER_PRIO_STRING_FORMAT_HPP
+
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace prio {
+
+/** Passes @a text in double quotes to @a append, with quotes and
+    backslashes escaped. Runs of plain characters are passed on in one
+    piece. JSON and s-expressions share this escaping. */
+template<typename Append>
+void quote_string(std::string_view text, Append&& append)
+{
+  append(std::string_view("\"", 1));
+  std::size_t start = 0;
+  for (std::size_t i = 0; i < text.size(); ++i) {
+    if (text[i] == '"' || text[i] == '\\') {
+      append(text.substr(start, i - start));
+      append(std::string_view("\\", 1));
+      start = i;
+    }
+  }
+  append(text.substr(start));
+  append(std::string_view("\"", 1));
+}
+
+inline void append_quoted_string(std::string& out, std::string_view text)
+{
+  quote_string(text, [&out](std::string_view part) {
+    out += part;
+  });
+}
+
+inline void write_quoted_string(std::ostream& os, std::string_view text)
+{
+  quote_string(text, [&os](std::string_view part) {
+    os.write(part.data(), static_cast<std::streamsize>(part.size()));
+  });
+}
+
+} // namespace prio
+
+#endif
+
+/* EOF */
@@ -0,0 +1,158 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "value_boundary.hpp"
+
+#include <cctype>
+#include <cstring>
+
+namespace prio {
+
+char const*
+json_value_end(char const* p, char const* end)
+{
+  auto skip_string = [&](char const* s) -> char const* {
+    // s points at the opening quote
+    ++s;
+    while (s < end) {
+      if (*s == '\\') {
+        ++s;
+        if (s >= end) return nullptr;
+        ++s;
+        continue;
+      }
+      if (*s == '"') return s + 1;
+      ++s;
+    }
+    return nullptr;
+  };
+
+  if (p >= end) return p;
+
+  if (*p == '"') {
+    return skip_string(p);
+  }
+
+  if (*p == '{' || *p == '[') {
+    char const open = *p;
+    char const close = (open == '{') ? '}' : ']';
+    int depth = 0;
+    char const* s = p;
+    while (s < end) {
+      if (*s == '"') {
+        s = skip_string(s);
+        if (!s) return nullptr;
+        continue;
+      }
+      if (*s == open) {
+        ++depth;
+      } else if (*s == close) {
+        --depth;
+        if (depth == 0) return s + 1;
+      }
+      ++s;
+    }
+    return nullptr;
+  }
+
+  // number
+  if (*p == '-' || (*p >= '0' && *p <= '9')) {
+    char const* s = p + 1;
+    while (s < end
+           && !std::isspace(static_cast<unsigned char>(*s))
+           && *s != ',' && *s != '}' && *s != ']' && *s != ':') {
+      ++s;
+    }
+    return s;
+  }
+
+  // keywords
+  if (p + 4 <= end && std::strncmp(p, "true", 4) == 0) return p + 4;
+  if (p + 5 <= end && std::strncmp(p, "false", 5) == 0) return p + 5;
+  if (p + 4 <= end && std::strncmp(p, "null", 4) == 0) return p + 4;
+
+  return nullptr;
+}
+
+char const*
+sexpr_value_end(char const* p, char const* end)
+{
+  auto skip_string = [&](char const* s) -> char const* {
+    // s points at the opening quote
+    ++s;
+    while (s < end) {
+      if (*s == '\\') {
+        ++s;
+        if (s >= end) return nullptr;
+        ++s;
+        continue;
+      }
+      if (*s == '"') return s + 1;
+      ++s;
+    }
+    return nullptr;
+  };
+
+  auto is_delimiter = [](char c) {
+    return std::isspace(static_cast<unsigned char>(c)) || c == '(' || c == ')' || c == '"' || c == ';';
+  };
+
+  if (p >= end) return p;
+
+  if (*p == '"') {
+    return skip_string(p);
+  }
+
+  if (*p == '(') {
+    int depth = 0;
+    char const* s = p;
+    while (s < end) {
+      if (*s == '"') {
+        s = skip_string(s);
+        if (!s) return nullptr;
+        continue;
+      }
+      if (*s == ';') {
+        s = static_cast<char const*>(std::memchr(s, '\n', static_cast<std::size_t>(end - s)));
+        if (!s) return nullptr;
+        continue;
+      }
+      if (*s == '(') {
+        ++depth;
+      } else if (*s == ')') {
+        --depth;
+        if (depth == 0) return s + 1;
+      }
+      ++s;
+    }
+    return nullptr;
+  }
+
+  if (*p == ')' || *p == ';') {
+    return nullptr;
+  }
+
+  // atom
+  char const* s = p + 1;
+  while (s < end && !is_delimiter(*s)) {
+    ++s;
+  }
+  return s;
+}
+
+} // namespace prio
+
+/* EOF */
@@ -0,0 +1,36 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_PRIO_VALUE_BOUNDARY_HPP
+#define HEADER_PRIO_VALUE_BOUNDARY_HPP
+
+namespace prio {
+
+/** Return a pointer just past one complete JSON value starting at @a p.
+    Supports objects, arrays, strings, numbers and keywords. Returns nullptr
+    if the value is incomplete or malformed. */
+char const* json_value_end(char const* p, char const* end);
+
+/** Return a pointer just past one complete s-expression starting at
+    @a p, skipping over strings, escape sequences and ';' comments.
+    Returns nullptr if the value is incomplete or malformed. */
+char const* sexpr_value_end(char const* p, char const* end);
+
+} // namespace prio
+
+#endif
+
+/* EOF */
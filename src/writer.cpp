@@ -24,8 +24,12 @@
 #include <sstream>
 #include <stdexcept>
 #include <utility>
+#include <variant>
 #include <cstring>
 
+#include "binary_writer_impl.hpp"
+#include "msgpack_writer_impl.hpp"
+
 #ifdef PRIO_USE_JSONCPP
 #  include "json_writer_impl.hpp"
 #  include "jsonpretty_writer_impl.hpp"
@@ -40,7 +44,8 @@ namespace prio {
 Writer
 Writer::from_file(Format format, std::filesystem::path const& filename)
 {
-  std::ofstream fout(filename);
+  bool const binary = (format == Format::BINARY || format == Format::MSGPACK);
+  std::ofstream fout(filename, binary ? std::ios::binary : std::ios::openmode{});
   if (!fout) {
     std::ostringstream oss;
     oss << filename << ": failed to open for writing: " << strerror(errno);
@@ -76,9 +81,16 @@ Writer::from_stream(Format format, std::ostream& out)
 #ifdef PRIO_USE_SEXPCPP
     case Format::AUTO:
     case Format::SEXPR:
+    case Format::FASTSEXPR:
       return Writer(std::make_unique<SExprWriterImpl>(out));
 #endif
 
+    case Format::BINARY:
+      return Writer(std::make_unique<BinaryWriterImpl>(out));
+
+    case Format::MSGPACK:
+      return Writer(std::make_unique<MsgPackWriterImpl>(out));
+
     default:
       throw std::invalid_argument("invalid format");
   }
@@ -327,6 +339,41 @@ Writer::write(std::string_view key, std::vector<std::string> const& values)
   return *this;
 }
 
+Writer&
+Writer::write_fields(std::span<WriterField const> fields)
+{
+  assert(m_impl);
+  m_impl->write_fields(fields);
+  return *this;
+}
+
+Writer&
+Writer::write_fields(std::initializer_list<WriterField> fields)
+{
+  return write_fields(std::span<WriterField const>(fields.begin(), fields.size()));
+}
+
+void
+WriterImpl::write_fields(std::span<WriterField const> fields)
+{
+  for (WriterField const& field : fields) {
+    std::visit([this, &field](auto const* value) {
+      using T = std::remove_cvref_t<decltype(*value)>;
+      if constexpr (std::is_same_v<T, std::string>) {
+        write(field.key, std::string_view(*value));
+      } else if constexpr (std::is_same_v<T, std::vector<bool>>) {
+        write(field.key, *value);
+      } else if constexpr (std::is_same_v<T, std::vector<int>> ||
+                           std::is_same_v<T, std::vector<float>> ||
+                           std::is_same_v<T, std::vector<std::string>>) {
+        write(field.key, std::span<typename T::value_type const>(*value));
+      } else {
+        write(field.key, *value);
+      }
+    }, field.value);
+  }
+}
+
 } // namespace prio
 
 /* EOF */
@@ -23,6 +23,8 @@
 
 namespace prio {
 
+struct WriterField;
+
 /** Interface to write out name/value pairs out of some kind of file or
     structure */
 class WriterImpl
@@ -55,6 +57,9 @@ public:
 
   virtual void write(std::string_view key, std::vector<bool> const& values) = 0;
 
+  /** Writes @a fields in order, the default calls write() for each */
+  virtual void write_fields(std::span<WriterField const> fields);
+
   /** Optional; formats that have no comment syntax (e.g. JSON) may ignore it. */
   virtual void write_comment(std::string_view /* text */) {}
 };
@@ -0,0 +1,113 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include <prio/reader_collection.hpp>
+#include <prio/reader_document.hpp>
+#include <prio/reader_error.hpp>
+#include <prio/reader_mapping.hpp>
+
+#include "binary_writer_impl.hpp"
+#include "writer_impl_test.hpp"
+
+using namespace prio;
+
+TEST(BinaryWriterImplTest, layout)
+{
+  std::ostringstream os;
+  BinaryWriterImpl writer(os);
+  writer.begin_object("doc");
+  writer.write("a", 1);
+  writer.end_object();
+
+  ASSERT_EQ(os.str(),
+            std::string("\x89PRIO\r\n\x1a" "\x02\x00\x00\x00" // magic, version
+                        "\x4c\x00\x00\x00" "\x38\x00\x00\x00" // size 76, root at 56
+                        "\x01\x00\x00\x00" "a" "\x00\x00\x00" // 20: key "a", padding
+                        "\x01\x00\x00\x00" // 28: mapping with 1 entry
+                        "\x14\x00\x00\x00" "\x03\x00\x00\x00" "\x01\x00\x00\x00" // "a": int 1
+                        "\x00\x00\x00\x00" // order
+                        "\x03\x00\x00\x00" "doc" "\x00" // 48: key "doc", padding
+                        "\x01\x00\x00\x00" // 56: mapping with 1 entry
+                        "\x30\x00\x00\x00" "\x07\x00\x00\x00" "\x1c\x00\x00\x00" // "doc": mapping at 28
+                        "\x00\x00\x00\x00", 76)); // order
+}
+
+TEST(BinaryWriterImplTest, write)
+{
+  std::ostringstream os;
+  BinaryWriterImpl writer(os);
+  write_testfile(writer);
+
+  ReaderDocument const doc = ReaderDocument::from_string(os.str(), ErrorHandler::THROW);
+  ReaderObject const root = doc.get_root();
+  ASSERT_EQ(root.get_name(), "testfile");
+
+  ReaderMapping const map = root.get_mapping();
+  EXPECT_EQ(map.get_keys(), (std::vector<std::string>{
+        "trueval", "falseval", "intval", "floatval", "stringval", "escapedstringval",
+        "truevals", "intvals", "floatvals", "stringvals",
+        "collection", "mapping", "background"}));
+
+  EXPECT_EQ(map.get<bool>("trueval"), true);
+  EXPECT_EQ(map.get<bool>("falseval"), false);
+  EXPECT_EQ(map.get<int>("intval"), 123);
+  EXPECT_EQ(map.get<float>("floatval"), 123.5f);
+  EXPECT_EQ(map.get<std::string>("escapedstringval"), "\"Hello\\World\"");
+  EXPECT_EQ(map.get<std::vector<bool>>("truevals"), (std::vector<bool>{true, false, true}));
+  EXPECT_EQ(map.get<std::vector<int>>("intvals"), (std::vector<int>{1, 2, 3}));
+  EXPECT_EQ(map.get<std::vector<float>>("floatvals"), (std::vector<float>{1.5f, 2.5f, 3.5f}));
+  EXPECT_EQ(map.get<std::vector<std::string>>("stringvals"), (std::vector<std::string>{"\"Hello", "World\""}));
+
+  std::vector<ReaderObject> const objects = map.get<ReaderCollection>("collection").get_objects();
+  ASSERT_EQ(objects.size(), 2u);
+  EXPECT_EQ(objects[1].get_name(), "object1");
+  EXPECT_EQ(objects[1].get_mapping().get<float>("y"), 90.5f);
+
+  EXPECT_EQ(map.get<ReaderMapping>("mapping").get<int>("three"), 3);
+
+  ReaderObject const background = map.get<ReaderObject>("background");
+  EXPECT_EQ(background.get_name(), "color");
+  EXPECT_EQ(background.get_mapping().get<float>("blue"), 0.5f);
+}
+
+TEST(BinaryWriterImplTest, read_fail)
+{
+  std::ostringstream os;
+  BinaryWriterImpl writer(os);
+  write_testfile(writer);
+  std::string const data = os.str();
+
+  EXPECT_THROW(ReaderDocument::from_string(Format::BINARY, "(doc)"), ReaderError);
+  for (std::size_t size : {8u, 12u, 13u, 100u}) {
+    EXPECT_THROW(ReaderDocument::from_string(data.substr(0, size), ErrorHandler::IGNORE), ReaderError) << size;
+  }
+  EXPECT_THROW(ReaderDocument::from_string(data + '\x01'), ReaderError);
+
+  std::string bad_version = data;
+  bad_version[8] = '\x7f';
+  EXPECT_THROW(ReaderDocument::from_string(bad_version), ReaderError);
+
+  // only the header is checked on open, the rest when it is accessed
+  std::string bad_root = data;
+  bad_root[16] = static_cast<char>(data.size() - 2);
+  bad_root[17] = static_cast<char>((data.size() - 2) >> 8);
+  ReaderDocument const doc = ReaderDocument::from_string(bad_root, ErrorHandler::IGNORE);
+  EXPECT_THROW(doc.get_root(), ReaderError);
+}
+
+/* EOF */
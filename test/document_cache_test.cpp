@@ -0,0 +1,196 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#include <prio/document_cache.hpp>
+#include <prio/reader_error.hpp>
+#include <prio/reader_mapping.hpp>
+#include <prio/reader_object.hpp>
+
+using namespace prio;
+
+namespace {
+
+class DocumentCacheTest : public ::testing::Test
+{
+protected:
+  DocumentCacheTest() :
+    m_directory(std::filesystem::temp_directory_path() / "prio-document-cache-test")
+  {
+  }
+
+  void SetUp() override
+  {
+    std::filesystem::remove_all(m_directory);
+    std::filesystem::create_directories(m_directory);
+  }
+
+  void TearDown() override
+  {
+    std::filesystem::remove_all(m_directory);
+  }
+
+  /** Writes a document with the given id and roughly @a size bytes.
+      The file is replaced rather than rewritten, as documents of large
+      files map their file. */
+  std::filesystem::path write_source(std::string const& name, int id, std::size_t size = 0)
+  {
+    std::filesystem::path const filename = m_directory / name;
+    std::filesystem::path const tmp_filename = m_directory / (name + ".tmp");
+    std::ofstream(tmp_filename) << "(doc (id " << id << ") (padding \"" << std::string(size, 'x') << "\"))";
+    std::filesystem::rename(tmp_filename, filename);
+    return filename;
+  }
+
+protected:
+  std::filesystem::path m_directory;
+};
+
+} // namespace
+
+TEST_F(DocumentCacheTest, shared)
+{
+  DocumentCache cache(1024 * 1024);
+  std::filesystem::path const filename = write_source("a.sexp", 1);
+
+  DocumentCache::Handle const doc = cache.from_file(filename);
+  EXPECT_EQ(doc->get_root().get_mapping().get<int>("id"), 1);
+  EXPECT_EQ(cache.from_file(filename), doc);
+  EXPECT_EQ(cache.from_file(m_directory / "." / "a.sexp"), doc);
+  EXPECT_EQ(cache.size(), 1u);
+  EXPECT_EQ(cache.get_memory_usage(), doc->get_memory_usage());
+
+  // format and error handler are part of the key
+  EXPECT_NE(cache.from_file(Format::FASTSEXPR, filename), doc);
+  EXPECT_NE(cache.from_file(filename, ErrorHandler::IGNORE), doc);
+  EXPECT_EQ(cache.size(), 3u);
+
+  // handles outlive the cache entry
+  write_source("a.sexp", 2);
+  cache.erase(filename);
+  EXPECT_EQ(cache.size(), 0u);
+  EXPECT_EQ(cache.get_memory_usage(), 0u);
+  EXPECT_EQ(doc->get_root().get_mapping().get<int>("id"), 1);
+  EXPECT_EQ(cache.from_file(filename)->get_root().get_mapping().get<int>("id"), 2);
+}
+
+TEST_F(DocumentCacheTest, lru_eviction)
+{
+  std::filesystem::path const a = write_source("a.sexp", 1, 10000);
+  std::filesystem::path const b = write_source("b.sexp", 2, 10000);
+  std::filesystem::path const c = write_source("c.sexp", 3, 10000);
+
+  std::size_t const usage = ReaderDocument::from_file(a).get_memory_usage();
+  ASSERT_GT(usage, 10000u);
+
+  // room for two documents
+  DocumentCache cache(usage * 5 / 2);
+  DocumentCache::Handle const doc_a = cache.from_file(a);
+  DocumentCache::Handle const doc_b = cache.from_file(b);
+  EXPECT_EQ(cache.size(), 2u);
+
+  EXPECT_EQ(cache.from_file(a), doc_a);
+  DocumentCache::Handle const doc_c = cache.from_file(c);
+  EXPECT_EQ(cache.size(), 2u);
+  EXPECT_LE(cache.get_memory_usage(), cache.get_memory_budget());
+
+  EXPECT_EQ(cache.from_file(a), doc_a);
+  EXPECT_EQ(cache.from_file(c), doc_c);
+  EXPECT_NE(cache.from_file(b), doc_b);
+
+  cache.set_memory_budget(usage * 3 / 2);
+  EXPECT_EQ(cache.size(), 1u);
+  EXPECT_EQ(cache.from_file(b)->get_root().get_mapping().get<int>("id"), 2);
+
+  // too large for the budget, returned but not kept
+  cache.set_memory_budget(usage / 2);
+  EXPECT_EQ(cache.size(), 0u);
+  EXPECT_EQ(cache.from_file(a)->get_root().get_mapping().get<int>("id"), 1);
+  EXPECT_EQ(cache.size(), 0u);
+  EXPECT_EQ(cache.get_memory_usage(), 0u);
+}
+
+TEST_F(DocumentCacheTest, memory_usage_growth)
+{
+  std::filesystem::path const filename = m_directory / "escaped.sexp";
+  std::ofstream(filename) << R"((doc (id 1) (name "a\nb")))";
+
+  DocumentCache cache(1024 * 1024);
+  DocumentCache::Handle const doc = cache.from_file(Format::FASTSEXPR, filename);
+  std::size_t const memory_usage = cache.get_memory_usage();
+
+  // decoding the escaped string grows the arena of the document
+  EXPECT_EQ(doc->get_root().get_mapping().get<std::string_view>("name"), "a\nb");
+  EXPECT_GT(doc->get_memory_usage(), memory_usage);
+
+  EXPECT_EQ(cache.from_file(Format::FASTSEXPR, filename), doc);
+  EXPECT_EQ(cache.get_memory_usage(), doc->get_memory_usage());
+
+  // the grown document no longer fits the budget it was loaded with
+  cache.set_memory_budget(memory_usage);
+  EXPECT_EQ(cache.size(), 0u);
+  EXPECT_EQ(cache.get_memory_usage(), 0u);
+}
+
+TEST_F(DocumentCacheTest, concurrent_loads)
+{
+  std::filesystem::path const filename = write_source("big.sexp", 7, 4 * 1024 * 1024);
+  DocumentCache cache(64 * 1024 * 1024);
+
+  std::vector<DocumentCache::Handle> results(8);
+  std::vector<std::thread> threads;
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    threads.emplace_back([&cache, &results, &filename, i] {
+      results[i] = cache.from_file(filename);
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  // only a single load took place
+  for (DocumentCache::Handle const& result : results) {
+    EXPECT_EQ(result, results[0]);
+  }
+  EXPECT_EQ(results[0]->get_root().get_mapping().get<int>("id"), 7);
+  EXPECT_EQ(cache.size(), 1u);
+}
+
+TEST_F(DocumentCacheTest, errors)
+{
+  DocumentCache cache(1024 * 1024);
+  EXPECT_THROW(cache.from_file(m_directory / "does-not-exist"), ReaderError);
+
+  std::filesystem::path const filename = m_directory / "broken.sexp";
+  std::ofstream(filename) << "(doc (id 1)";
+  EXPECT_THROW(cache.from_file(filename), ReaderError);
+  EXPECT_EQ(cache.size(), 0u);
+
+  // errors are not cached
+  write_source("broken.sexp", 5);
+  EXPECT_EQ(cache.from_file(filename)->get_root().get_mapping().get<int>("id"), 5);
+
+  cache.clear();
+  EXPECT_EQ(cache.size(), 0u);
+  EXPECT_EQ(cache.get_memory_usage(), 0u);
+}
+
+/* EOF */
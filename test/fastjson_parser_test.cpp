@@ -0,0 +1,213 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include <prio/reader_error.hpp>
+
+#include "fastjson_parser.hpp"
+#include "value_boundary.hpp"
+
+using namespace prio;
+
+using Type = FastJsonTape::Type;
+
+TEST(FastJsonParserTest, structural_index)
+{
+  std::vector<std::string> const inputs = {
+    "",
+    "{}",
+    R"({"a": [1, 2.5, -3e4, true, false, null]})",
+    R"({"escaped \" quote": "back\\slash\\", "x": "\\\"\\"})",
+    R"(["{[,:]}", "\u00e4\ud83d\ude00", 123])",
+    std::string(63, ' ') + R"({"a":"\\)" + std::string(64, '\\') + R"("})",
+    std::string(62, ' ') + R"("\"" , "\\" )",
+  };
+
+  for (auto const& input : inputs) {
+    EXPECT_EQ(fastjson_structural_index(input), fastjson_structural_index_fallback(input)) << input;
+  }
+}
+
+TEST(FastJsonParserTest, structural_index_random)
+{
+  std::mt19937 rng(1234);
+  std::string const alphabet = "{}[]:,\"\\ \n01ab";
+  std::uniform_int_distribution<std::size_t> dist(0, alphabet.size() - 1);
+
+  for (int round = 0; round < 200; ++round) {
+    std::string input(static_cast<std::size_t>(round * 3), ' ');
+    for (char& c : input) {
+      c = alphabet[dist(rng)];
+    }
+    EXPECT_EQ(fastjson_structural_index(input), fastjson_structural_index_fallback(input)) << input;
+  }
+}
+
+TEST(FastJsonParserTest, parse)
+{
+  std::string const text = R"({"int": -42, "real": 0.5e1, "big": 12345678901234567890,
+                               "str": "plain", "esc": "a\tb\u00e4\ud83d\ude00",
+                               "arr": [true, false, null, {}], "dup": 1, "dup": 2})";
+  FastJsonTape const tape = fastjson_parse(text);
+
+  ASSERT_EQ(tape[0].type, Type::OBJECT);
+  EXPECT_EQ(tape[0].link, tape.size());
+
+  std::int64_t integer = 0;
+
+  std::uint32_t idx = tape.find_member(text, 0, "int");
+  ASSERT_EQ(tape[idx].type, Type::INTEGER);
+  EXPECT_TRUE(tape.get_integer(text, idx, integer));
+  EXPECT_EQ(integer, -42);
+
+  idx = tape.find_member(text, 0, "real");
+  ASSERT_EQ(tape[idx].type, Type::REAL);
+  EXPECT_EQ(tape.get_real(text, idx), 5.0);
+
+  idx = tape.find_member(text, 0, "big");
+  ASSERT_EQ(tape[idx].type, Type::INTEGER);
+  EXPECT_FALSE(tape.get_integer(text, idx, integer));
+  EXPECT_EQ(tape.get_real(text, idx), 12345678901234567890.0);
+
+  idx = tape.find_member(text, 0, "str");
+  ASSERT_EQ(tape[idx].type, Type::STRING);
+  EXPECT_FALSE(tape[idx].escaped);
+  EXPECT_EQ(tape.get_string(text, idx), "plain");
+
+  idx = tape.find_member(text, 0, "esc");
+  ASSERT_EQ(tape[idx].type, Type::STRING);
+  EXPECT_TRUE(tape[idx].escaped);
+  EXPECT_EQ(tape.get_raw_string(text, idx), "a\\tb\\u00e4\\ud83d\\ude00");
+  EXPECT_EQ(tape.get_string(text, idx), "a\tb\xc3\xa4\xf0\x9f\x98\x80");
+
+  idx = tape.find_member(text, 0, "arr");
+  ASSERT_EQ(tape[idx].type, Type::ARRAY);
+  EXPECT_EQ(tape[idx + 1].type, Type::BOOLEAN);
+  EXPECT_TRUE(tape.get_bool(text, idx + 1));
+  EXPECT_EQ(tape[idx + 2].type, Type::BOOLEAN);
+  EXPECT_FALSE(tape.get_bool(text, idx + 2));
+  EXPECT_EQ(tape[idx + 3].type, Type::NULL_VALUE);
+  EXPECT_EQ(tape[idx + 4].type, Type::OBJECT);
+  EXPECT_EQ(tape.next(idx), idx + 5);
+  EXPECT_EQ(tape.get_source_text(text, idx), "[true, false, null, {}]");
+
+  idx = tape.find_member(text, 0, "dup");
+  ASSERT_EQ(tape[idx].type, Type::INTEGER);
+  EXPECT_TRUE(tape.get_integer(text, idx, integer));
+  EXPECT_EQ(integer, 2);
+
+  EXPECT_EQ(tape.find_member(text, 0, "missing"), FastJsonTape::npos);
+}
+
+TEST(FastJsonParserTest, parse_trailing)
+{
+  EXPECT_NO_THROW(fastjson_parse("{\"a\": 1};"));
+}
+
+TEST(FastJsonParserTest, parse_fail)
+{
+  EXPECT_THROW(fastjson_parse(""), ReaderError);
+  EXPECT_THROW(fastjson_parse("   "), ReaderError);
+  EXPECT_THROW(fastjson_parse("{"), ReaderError);
+  EXPECT_THROW(fastjson_parse("{\"a\" 1}"), ReaderError);
+  EXPECT_THROW(fastjson_parse("{\"a\": 1,}"), ReaderError);
+  EXPECT_THROW(fastjson_parse("[1 2]"), ReaderError);
+  EXPECT_THROW(fastjson_parse("[01]"), ReaderError);
+  EXPECT_THROW(fastjson_parse("[1.]"), ReaderError);
+  EXPECT_THROW(fastjson_parse("[tru]"), ReaderError);
+  EXPECT_THROW(fastjson_parse("[\"unterminated]"), ReaderError);
+  EXPECT_THROW(fastjson_parse("[\"bad \\x escape\"]"), ReaderError);
+  EXPECT_THROW(fastjson_parse("[\"\\ud83d\"]"), ReaderError);
+  EXPECT_THROW(fastjson_parse(std::string(2000, '[')), ReaderError);
+}
+
+TEST(FastJsonParserTest, split_values)
+{
+  std::string text;
+  std::vector<std::string> expected;
+  auto add = [&](std::string const& value, std::string const& separator) {
+    expected.push_back(value);
+    text += value + separator;
+  };
+
+  add(R"({"a": {"b": [1, 2, {"c": "}]"}]}})", "\n");
+  add(R"(["\"[", "\\", "{"])", "");
+  add(R"({"x":1})", "   ");
+  add("42", "\n");
+  add(R"("top level \" string")", " ");
+  add("true", "\t");
+  add(std::string(100, '[') + std::string(100, ']'), "\r\n");
+  add(R"({"long": ")" + std::string(200, 'x') + R"("})", "");
+  add("-1.5e3", "");
+
+  std::vector<std::string_view> const values = fastjson_split_values(text);
+  ASSERT_EQ(values.size(), expected.size());
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    EXPECT_EQ(values[i], expected[i]);
+  }
+
+  EXPECT_TRUE(fastjson_split_values("").empty());
+  EXPECT_TRUE(fastjson_split_values(" \n ").empty());
+}
+
+TEST(FastJsonParserTest, split_values_random)
+{
+  // random JSON Lines, compared against the byte-wise json_value_end()
+  std::mt19937 rng(4321);
+  std::string const alphabet = "{}[]\"\\ab ,:";
+  std::uniform_int_distribution<std::size_t> dist(0, alphabet.size() - 1);
+
+  std::string text;
+  for (int record = 0; record < 300; ++record) {
+    std::string str;
+    for (int i = 0; i < record % 50; ++i) {
+      char const c = alphabet[dist(rng)];
+      str += (c == '"' || c == '\\') ? std::string("\\") + c : std::string(1, c);
+    }
+    text += R"({"id": )" + std::to_string(record) + R"(, "s": [")" + str + R"("]})";
+    text += (record % 4 == 0) ? "" : "\n";
+  }
+
+  std::vector<std::string_view> reference;
+  char const* p = text.data();
+  char const* const end = p + text.size();
+  while (p < end) {
+    if (*p == '\n') {
+      ++p;
+      continue;
+    }
+    char const* const value_end = json_value_end(p, end);
+    ASSERT_NE(value_end, nullptr);
+    reference.emplace_back(p, static_cast<std::size_t>(value_end - p));
+    p = value_end;
+  }
+
+  EXPECT_EQ(fastjson_split_values(text), reference);
+}
+
+TEST(FastJsonParserTest, split_values_fail)
+{
+  EXPECT_THROW(fastjson_split_values("{"), ReaderError);
+  EXPECT_THROW(fastjson_split_values("{} }"), ReaderError);
+  EXPECT_THROW(fastjson_split_values("{}, {}"), ReaderError);
+  EXPECT_THROW(fastjson_split_values("[\"unterminated]"), ReaderError);
+  EXPECT_THROW(fastjson_split_values("{} \"unterminated"), ReaderError);
+}
+
+/* EOF */
@@ -0,0 +1,104 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include <prio/reader_error.hpp>
+
+#include "fastsexpr_parser.hpp"
+
+using namespace prio;
+
+using Type = FastSExprTape::Type;
+
+TEST(FastSExprParserTest, parse)
+{
+  std::string const text =
+    "; leading comment\n"
+    "(doc (int -42) ; trailing comment\n"
+    "     (real 0.5e1) (plus +7) (sym hello-world) (str \"plain\")\n"
+    "     (esc \"a\\\"b\\nc\") (bools #t #f) (empty))";
+  FastSExprTape const tape = fastsexpr_parse(text);
+
+  ASSERT_EQ(tape[0].type, Type::ARRAY);
+  EXPECT_EQ(tape[0].link, tape.size());
+  EXPECT_EQ(tape.count(0), 9u);
+
+  EXPECT_EQ(tape[1].type, Type::SYMBOL);
+  EXPECT_EQ(tape.get_string(text, 1), "doc");
+
+  EXPECT_EQ(tape[4].type, Type::INTEGER);
+  EXPECT_EQ(tape.get_integer(text, 4), -42);
+  EXPECT_EQ(tape.get_line(text, 4), 2);
+
+  EXPECT_EQ(tape[7].type, Type::REAL);
+  EXPECT_EQ(tape.get_real(text, 7), 5.0f);
+  EXPECT_EQ(tape.get_line(text, 7), 3);
+
+  EXPECT_EQ(tape[10].type, Type::INTEGER);
+  EXPECT_EQ(tape.get_integer(text, 10), 7);
+
+  EXPECT_EQ(tape[13].type, Type::SYMBOL);
+  EXPECT_EQ(tape.get_string(text, 13), "hello-world");
+
+  EXPECT_EQ(tape[16].type, Type::STRING);
+  EXPECT_EQ(tape.get_string(text, 16), "plain");
+  EXPECT_EQ(tape.get_source_text(text, 16), "\"plain\"");
+
+  EXPECT_EQ(tape[19].type, Type::STRING);
+  EXPECT_TRUE(tape[19].escaped);
+  EXPECT_EQ(tape.get_string(text, 19), "a\"b\nc");
+
+  EXPECT_EQ(tape[22].type, Type::BOOLEAN);
+  EXPECT_TRUE(tape.get_bool(text, 22));
+  EXPECT_FALSE(tape.get_bool(text, 23));
+
+  EXPECT_EQ(tape[24].type, Type::ARRAY);
+  EXPECT_EQ(tape.count(24), 1u);
+}
+
+TEST(FastSExprParserTest, parse_numbers)
+{
+  std::string const text = "(1 -2 +3 99999999999 1.5 .5 1e3 -1.5e-2 1e 1.2.3 - + . 12abc)";
+  FastSExprTape const tape = fastsexpr_parse(text);
+
+  std::vector<Type> const expected = {
+    Type::INTEGER, Type::INTEGER, Type::INTEGER, Type::REAL,
+    Type::REAL, Type::REAL, Type::REAL, Type::REAL,
+    Type::SYMBOL, Type::SYMBOL, Type::SYMBOL, Type::SYMBOL, Type::SYMBOL, Type::SYMBOL
+  };
+  ASSERT_EQ(tape.count(0), expected.size());
+  for (std::uint32_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(tape[i + 1].type, expected[i]) << tape.get_source_text(text, i + 1);
+  }
+
+  EXPECT_EQ(tape.get_integer(text, 3), 3);
+  EXPECT_EQ(tape.get_real(text, 4), 99999999999.0f);
+  EXPECT_EQ(tape.get_real(text, 8), -1.5e-2f);
+}
+
+TEST(FastSExprParserTest, parse_fail)
+{
+  EXPECT_THROW(fastsexpr_parse(""), ReaderError);
+  EXPECT_THROW(fastsexpr_parse("; only a comment"), ReaderError);
+  EXPECT_THROW(fastsexpr_parse("(doc"), ReaderError);
+  EXPECT_THROW(fastsexpr_parse(")"), ReaderError);
+  EXPECT_THROW(fastsexpr_parse("(doc \"unterminated)"), ReaderError);
+  EXPECT_THROW(fastsexpr_parse("(doc) (trailing)"), ReaderError);
+  EXPECT_THROW(fastsexpr_parse(std::string(2000, '(')), ReaderError);
+}
+
+/* EOF */
@@ -0,0 +1,228 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include <prio/fields.hpp>
+#include <prio/reader_collection.hpp>
+#include <prio/reader_document.hpp>
+#include <prio/reader_mapping.hpp>
+#include <prio/reader_object.hpp>
+#include <prio/writer.hpp>
+
+using namespace prio;
+
+namespace {
+
+struct SubMap
+{
+  int int_value = 0;
+  float float_value = 0.0f;
+};
+
+// keys that aren't valid member names
+constexpr auto prio_fields(SubMap const*)
+{
+  return std::make_tuple(make_field("int", &SubMap::int_value),
+                         make_field("float", &SubMap::float_value));
+}
+
+struct Document
+{
+  bool boolvalue = false;
+  int intvalue = 0;
+  float floatvalue = 0.0f;
+  std::string stringvalue = {};
+  std::vector<bool> boolvalues = {};
+  std::vector<int> intvalues = {};
+  std::vector<std::string> stringvalues = {};
+  SubMap submap = {};
+  ReaderCollection collection = {};
+  ReaderObject object = {};
+  int doesnotexist = 42;
+};
+
+PRIO_FIELDS(Document, boolvalue, intvalue, floatvalue, stringvalue, boolvalues,
+            intvalues, stringvalues, submap, collection, object, doesnotexist)
+
+using DocumentInfo = detail::FieldInfo<Document>;
+static_assert(HasFields<Document>);
+static_assert(!HasFields<int>);
+static_assert(DocumentInfo::count == 11);
+static_assert(DocumentInfo::direct_count == 10);
+static_assert(DocumentInfo::slots.size() >= DocumentInfo::direct_count);
+
+struct Entity
+{
+  std::string name = {};
+  int health = 0;
+  SubMap sub = {};
+  float speed = 0.0f;
+  bool alive = false;
+  std::vector<float> position = {};
+  std::vector<std::string> tags = {};
+};
+
+PRIO_FIELDS(Entity, name, health, sub, speed, alive, position, tags)
+
+static_assert(is_plain_key("health"));
+static_assert(!is_plain_key("a\"b"));
+
+} // namespace
+
+class FieldsTest : public ::testing::TestWithParam<std::tuple<Format, std::string>>
+{
+public:
+  FieldsTest() :
+    doc(ReaderDocument::from_file(std::get<0>(GetParam()), "test/data/data" + std::get<1>(GetParam()))),
+    map(doc.get_root().get_mapping())
+  {}
+
+protected:
+  ReaderDocument const doc;
+  ReaderMapping const map;
+};
+
+TEST_P(FieldsTest, read_struct)
+{
+  Document document;
+  ASSERT_TRUE(read_struct(map, document));
+
+  EXPECT_TRUE(document.boolvalue);
+  EXPECT_EQ(document.intvalue, 5);
+  EXPECT_EQ(document.floatvalue, 5.5f);
+  EXPECT_EQ(document.stringvalue, "Hello World");
+  EXPECT_EQ(document.boolvalues, std::vector<bool>({true, false, true}));
+  EXPECT_EQ(document.intvalues, std::vector<int>({1, 2, 3, 4}));
+  EXPECT_EQ(document.stringvalues, std::vector<std::string>({"Hello", "World"}));
+  EXPECT_EQ(document.submap.int_value, 7);
+  EXPECT_EQ(document.submap.float_value, 9.9f);
+  EXPECT_EQ(document.collection.get_objects().size(), 3u);
+  EXPECT_EQ(document.object.get_name(), "realthing");
+  EXPECT_EQ(document.doesnotexist, 42);
+}
+
+TEST_P(FieldsTest, get)
+{
+  SubMap const submap = map.get<SubMap>("submap");
+  EXPECT_EQ(submap.int_value, 7);
+  EXPECT_EQ(submap.float_value, 9.9f);
+
+  SubMap const fallback = map.get<SubMap>("doesnotexist", SubMap{1, 2.0f});
+  EXPECT_EQ(fallback.int_value, 1);
+  EXPECT_EQ(fallback.float_value, 2.0f);
+}
+
+TEST(FieldInfoTest, perfect_hash)
+{
+  for (std::size_t i = 0; i < DocumentInfo::direct_count; ++i) {
+    std::uint16_t const slot = DocumentInfo::slots[DocumentInfo::hashes[i] % DocumentInfo::slots.size()];
+    EXPECT_EQ(slot, i + 1);
+  }
+}
+
+TEST(WriteStructTest, write_struct)
+{
+  std::vector<Format> formats = { Format::BINARY, Format::MSGPACK };
+#ifdef PRIO_USE_SEXPCPP
+  formats.push_back(Format::SEXPR);
+#endif
+#ifdef PRIO_USE_JSONCPP
+  formats.push_back(Format::JSON);
+  formats.push_back(Format::FASTJSON);
+#endif
+
+  Entity const entity{"Bob \"the\" Blob", 100, SubMap{7, 9.5f}, 1.0e-7f, true,
+                      {1.5f, -2.25f, 1e10f}, {"a", "b\\c"}};
+
+  for (Format const format : formats) {
+    std::ostringstream expected;
+    {
+      Writer writer = Writer::from_stream(format, expected);
+      writer.begin_object("entity")
+        .write("name", entity.name)
+        .write("health", entity.health)
+        .begin_mapping("sub")
+        .write("int", entity.sub.int_value)
+        .write("float", entity.sub.float_value);
+      writer.end_mapping();
+      writer.write("speed", entity.speed)
+        .write("alive", entity.alive)
+        .write("position", entity.position)
+        .write("tags", entity.tags);
+      writer.end_object();
+    }
+
+    std::ostringstream actual;
+    {
+      Writer writer = Writer::from_stream(format, actual);
+      writer.begin_object("entity");
+      write_struct(writer, entity);
+      writer.end_object();
+    }
+
+    EXPECT_EQ(actual.str(), expected.str()) << static_cast<int>(format);
+  }
+}
+
+TEST(WriteStructTest, write_nested)
+{
+  std::ostringstream expected;
+  std::ostringstream actual;
+  {
+    Writer writer = Writer::from_stream(Format::BINARY, expected);
+    writer.begin_object("doc")
+      .begin_mapping("submap")
+      .write("int", 1)
+      .write("float", 2.0f);
+    writer.end_mapping();
+    writer.end_object();
+  }
+  {
+    Writer writer = Writer::from_stream(Format::BINARY, actual);
+    writer.begin_object("doc")
+      .write("submap", SubMap{1, 2.0f});
+    writer.end_object();
+  }
+  EXPECT_EQ(actual.str(), expected.str());
+}
+
+#ifdef PRIO_USE_SEXPCPP
+INSTANTIATE_TEST_CASE_P(SExprFieldsTest, FieldsTest,
+                        ::testing::Values(std::make_tuple(Format::AUTO, ".sexp")));
+#endif
+
+#ifdef PRIO_USE_JSONCPP
+INSTANTIATE_TEST_CASE_P(JsonFieldsTest, FieldsTest,
+                        ::testing::Values(std::make_tuple(Format::AUTO, ".json")));
+#endif
+
+INSTANTIATE_TEST_CASE_P(FastJsonFieldsTest, FieldsTest,
+                        ::testing::Values(std::make_tuple(Format::FASTJSON, ".json")));
+
+INSTANTIATE_TEST_CASE_P(FastSExprFieldsTest, FieldsTest,
+                        ::testing::Values(std::make_tuple(Format::FASTSEXPR, ".sexp")));
+
+INSTANTIATE_TEST_CASE_P(BinaryFieldsTest, FieldsTest,
+                        ::testing::Values(std::make_tuple(Format::BINARY, ".bin")));
+
+INSTANTIATE_TEST_CASE_P(MsgPackFieldsTest, FieldsTest,
+                        ::testing::Values(std::make_tuple(Format::MSGPACK, ".msgpack")));
+
+/* EOF */
@@ -0,0 +1,153 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include <prio/binary_reader_impl.hpp>
+#include <prio/fastjson_reader_impl.hpp>
+#include <prio/fastsexpr_reader_impl.hpp>
+#include <prio/impl_storage.hpp>
+#include <prio/msgpack_reader_impl.hpp>
+#include <prio/reader_collection.hpp>
+#include <prio/reader_mapping.hpp>
+#include <prio/reader_object.hpp>
+#ifdef PRIO_USE_JSONCPP
+#  include <prio/json_reader_impl.hpp>
+#endif
+#ifdef PRIO_USE_SEXPCPP
+#  include <prio/sexpr_reader_impl.hpp>
+#endif
+
+using namespace prio;
+
+namespace {
+
+struct Base
+{
+  virtual ~Base() {}
+  virtual int get() const = 0;
+};
+
+/** Counts the live instances to check that every one is destroyed */
+template<std::size_t N>
+struct Impl final : public Base
+{
+  static int alive;
+
+  Impl(int value_) : value(value_), padding() { alive += 1; }
+  Impl(Impl const& other) noexcept : Base(), value(other.value), padding() { alive += 1; }
+  ~Impl() override { alive -= 1; }
+
+  int get() const override { return value; }
+
+  int value;
+  char padding[N];
+
+private:
+  Impl& operator=(Impl const&) = delete;
+};
+
+template<std::size_t N>
+int Impl<N>::alive = 0;
+
+using Storage = ImplStorage<Base, 32>;
+using Small = Impl<4>;
+using Large = Impl<64>;
+
+// the handles of all builtin backends are stored inline
+static_assert(sizeof(ReaderMapping::Storage) == 48);
+static_assert(ReaderObject::Storage::fits_inline<BinaryReaderObjectImpl>);
+static_assert(ReaderCollection::Storage::fits_inline<BinaryReaderCollectionImpl>);
+static_assert(ReaderMapping::Storage::fits_inline<BinaryReaderMappingImpl>);
+static_assert(ReaderObject::Storage::fits_inline<FastJsonReaderObjectImpl>);
+static_assert(ReaderCollection::Storage::fits_inline<FastJsonReaderCollectionImpl>);
+static_assert(ReaderMapping::Storage::fits_inline<FastJsonReaderMappingImpl>);
+static_assert(ReaderObject::Storage::fits_inline<FastSExprReaderObjectImpl>);
+static_assert(ReaderCollection::Storage::fits_inline<FastSExprReaderCollectionImpl>);
+static_assert(ReaderMapping::Storage::fits_inline<FastSExprReaderMappingImpl>);
+static_assert(ReaderObject::Storage::fits_inline<MsgPackReaderObjectImpl>);
+static_assert(ReaderCollection::Storage::fits_inline<MsgPackReaderCollectionImpl>);
+static_assert(ReaderMapping::Storage::fits_inline<MsgPackReaderMappingImpl>);
+#ifdef PRIO_USE_JSONCPP
+static_assert(ReaderObject::Storage::fits_inline<JsonReaderObjectImpl>);
+static_assert(ReaderCollection::Storage::fits_inline<JsonReaderCollectionImpl>);
+static_assert(ReaderMapping::Storage::fits_inline<JsonReaderMappingImpl>);
+#endif
+#ifdef PRIO_USE_SEXPCPP
+static_assert(ReaderObject::Storage::fits_inline<SExprReaderObjectImpl>);
+static_assert(ReaderCollection::Storage::fits_inline<SExprReaderCollectionImpl>);
+static_assert(ReaderMapping::Storage::fits_inline<SExprReaderMappingImpl>);
+#endif
+
+} // namespace
+
+TEST(ImplStorageTest, emplace)
+{
+  {
+    Storage small;
+    EXPECT_FALSE(small);
+    small.emplace<Small>(5);
+    EXPECT_TRUE(small.is_inline());
+    EXPECT_EQ(small->get(), 5);
+
+    Storage large;
+    large.emplace<Large>(7);
+    EXPECT_FALSE(large.is_inline());
+    EXPECT_EQ(large->get(), 7);
+
+    Storage owned(std::make_unique<Small>(9));
+    EXPECT_FALSE(owned.is_inline());
+    EXPECT_EQ(owned->get(), 9);
+
+    EXPECT_EQ(Small::alive, 2);
+    EXPECT_EQ(Large::alive, 1);
+
+    small.emplace<Small>(6);
+    EXPECT_EQ(small->get(), 6);
+    EXPECT_EQ(Small::alive, 2);
+  }
+  EXPECT_EQ(Small::alive, 0);
+  EXPECT_EQ(Large::alive, 0);
+}
+
+TEST(ImplStorageTest, move)
+{
+  {
+    Storage a;
+    a.emplace<Small>(1);
+    Storage b(std::move(a));
+    EXPECT_FALSE(a);
+    ASSERT_TRUE(b.is_inline());
+    EXPECT_EQ(b->get(), 1);
+    EXPECT_EQ(Small::alive, 1);
+
+    Storage c;
+    c.emplace<Large>(2);
+    Base const* const large = c.get();
+    b = std::move(c);
+    EXPECT_EQ(b.get(), large);
+    EXPECT_EQ(Small::alive, 0);
+
+    c.emplace<Small>(3);
+    b = std::move(c);
+    EXPECT_EQ(b->get(), 3);
+    EXPECT_EQ(Large::alive, 0);
+  }
+  EXPECT_EQ(Small::alive, 0);
+  EXPECT_EQ(Large::alive, 0);
+}
+
+/* EOF */
@@ -0,0 +1,77 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#include <prio/reader_error.hpp>
+
+#include "input_buffer.hpp"
+
+using namespace prio;
+
+TEST(InputBufferTest, from_file)
+{
+  std::ifstream fin("test/data/data.sexp", std::ios::binary);
+  std::string const expected((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+
+  auto const buffer = InputBuffer::from_file("test/data/data.sexp");
+  EXPECT_EQ(buffer->get_text(), expected);
+  EXPECT_EQ(buffer->get_span().size(), expected.size());
+  EXPECT_FALSE(buffer->is_mapped());
+}
+
+#ifndef _WIN32
+TEST(InputBufferTest, from_file__mapped)
+{
+  std::filesystem::path const filename = std::filesystem::temp_directory_path() / "prio-input-buffer-test.txt";
+  std::string const expected(InputBuffer::MMAP_THRESHOLD, 'x');
+  std::ofstream(filename, std::ios::binary) << expected;
+
+  auto const buffer = InputBuffer::from_file(filename);
+  EXPECT_TRUE(buffer->is_mapped());
+  EXPECT_EQ(buffer->get_text(), expected);
+  std::filesystem::remove(filename);
+}
+#endif
+
+TEST(InputBufferTest, from_file__fail)
+{
+  EXPECT_THROW(InputBuffer::from_file("does-not-exist"), ReaderError);
+}
+
+#ifndef _WIN32
+TEST(InputBufferTest, from_file__non_regular)
+{
+  auto const buffer = InputBuffer::from_file("/dev/null");
+  EXPECT_FALSE(buffer->is_mapped());
+  EXPECT_TRUE(buffer->get_text().empty());
+}
+#endif
+
+TEST(InputBufferTest, from_stream)
+{
+  std::istringstream in("(hello world)");
+  auto const buffer = InputBuffer::from_stream(in);
+  EXPECT_EQ(buffer->get_text(), "(hello world)");
+  EXPECT_FALSE(buffer->is_mapped());
+}
+
+/* EOF */
@@ -0,0 +1,109 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include <prio/reader_error.hpp>
+
+#include "msgpack_parser.hpp"
+
+using namespace prio;
+
+using Type = MsgPackTape::Type;
+
+TEST(MsgPackParserTest, parse)
+{
+  // {"int": -42, "u64": 2^64-1, "real": 0.5, "f32": 1.5f,
+  //  "str": "plain", "arr": [true, false, nil, {}], "dup": 1, "dup": 2}
+  std::string const data(
+    "\x88"
+    "\xa3" "int" "\xd0\xd6"
+    "\xa3" "u64" "\xcf\xff\xff\xff\xff\xff\xff\xff\xff"
+    "\xa4" "real" "\xcb\x3f\xe0\x00\x00\x00\x00\x00\x00"
+    "\xa3" "f32" "\xca\x3f\xc0\x00\x00"
+    "\xa3" "str" "\xa5" "plain"
+    "\xa3" "arr" "\x94\xc3\xc2\xc0\x80"
+    "\xa3" "dup" "\x01"
+    "\xa3" "dup" "\x02", 72);
+  MsgPackTape const tape = msgpack_parse(data);
+
+  ASSERT_EQ(tape[0].type, Type::MAP);
+  EXPECT_EQ(tape[0].link, tape.size());
+  EXPECT_EQ(tape[0].length, 8u);
+
+  std::int64_t integer = 0;
+
+  std::uint32_t idx = tape.find_member(data, 0, "int");
+  ASSERT_EQ(tape[idx].type, Type::INTEGER);
+  EXPECT_TRUE(tape.get_integer(data, idx, integer));
+  EXPECT_EQ(integer, -42);
+
+  idx = tape.find_member(data, 0, "u64");
+  ASSERT_EQ(tape[idx].type, Type::INTEGER);
+  EXPECT_FALSE(tape.get_integer(data, idx, integer));
+  EXPECT_EQ(tape.get_real(data, idx), 18446744073709551615.0);
+
+  idx = tape.find_member(data, 0, "real");
+  ASSERT_EQ(tape[idx].type, Type::REAL);
+  EXPECT_EQ(tape.get_real(data, idx), 0.5);
+  EXPECT_EQ(tape.get_real(data, tape.find_member(data, 0, "f32")), 1.5);
+
+  idx = tape.find_member(data, 0, "str");
+  ASSERT_EQ(tape[idx].type, Type::STRING);
+  EXPECT_EQ(tape.get_string(data, idx), "plain");
+  EXPECT_EQ(tape.get_string(data, idx).data(), data.data() + tape[idx].data);
+
+  idx = tape.find_member(data, 0, "arr");
+  ASSERT_EQ(tape[idx].type, Type::ARRAY);
+  EXPECT_EQ(tape[idx].length, 4u);
+  EXPECT_TRUE(tape.get_bool(data, idx + 1));
+  EXPECT_FALSE(tape.get_bool(data, idx + 2));
+  EXPECT_EQ(tape[idx + 3].type, Type::NIL);
+  EXPECT_EQ(tape[idx + 4].type, Type::MAP);
+
+  idx = tape.find_member(data, 0, "dup");
+  EXPECT_TRUE(tape.get_integer(data, idx, integer));
+  EXPECT_EQ(integer, 1);
+
+  EXPECT_EQ(tape.find_member(data, 0, "missing"), MsgPackTape::npos);
+}
+
+TEST(MsgPackParserTest, parse_fail)
+{
+  EXPECT_THROW(msgpack_parse(""), ReaderError);
+  EXPECT_THROW(msgpack_parse("\x81\xa1" "a"), ReaderError);
+  EXPECT_THROW(msgpack_parse("\x81\x01\x02"), ReaderError);
+  EXPECT_THROW(msgpack_parse("\x81\xa1" "a\xa5" "abc"), ReaderError);
+  EXPECT_THROW(msgpack_parse("\x81\xa1" "a\xc1"), ReaderError);
+  EXPECT_THROW(msgpack_parse("\x80\x80"), ReaderError);
+  EXPECT_THROW(msgpack_parse("\xdf\xff\xff\xff\xff"), ReaderError);
+  EXPECT_THROW(msgpack_parse(std::string(2000, '\x91')), ReaderError);
+}
+
+TEST(MsgPackParserTest, split_values)
+{
+  std::string const data("\x81\xa1" "a\x92\x01\xcd\x01\x00" "\x80" "\x81\xa1" "b\xc0", 13);
+  std::vector<std::string_view> const values = msgpack_split_values(data);
+  ASSERT_EQ(values.size(), 3u);
+  EXPECT_EQ(values[0], std::string_view(data).substr(0, 8));
+  EXPECT_EQ(values[1], "\x80");
+  EXPECT_EQ(values[2], "\x81\xa1" "b\xc0");
+
+  EXPECT_TRUE(msgpack_split_values("").empty());
+  EXPECT_THROW(msgpack_split_values(data.substr(0, 12)), ReaderError);
+}
+
+/* EOF */
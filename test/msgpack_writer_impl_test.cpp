@@ -0,0 +1,190 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include <prio/override_reader_mapping.hpp>
+#include <prio/reader_collection.hpp>
+#include <prio/reader_document.hpp>
+#include <prio/reader_error.hpp>
+#include <prio/reader_mapping.hpp>
+
+#include "msgpack_writer_impl.hpp"
+#include "writer_impl_test.hpp"
+
+using namespace prio;
+
+TEST(MsgPackWriterImplTest, layout)
+{
+  std::ostringstream os;
+  MsgPackWriterImpl writer(os);
+  writer.begin_object("doc");
+  writer.write("a", 1);
+  writer.write("b", -300);
+  writer.write("c", std::vector<int>({1, 200}));
+  writer.write("d", 0.5f);
+  writer.begin_collection("e");
+  writer.begin_object("x");
+  writer.end_object();
+  writer.end_collection();
+  writer.end_object();
+
+  ASSERT_EQ(os.str(),
+            std::string("\x81\xa3" "doc" "\x85" // {"doc": {5 entries
+                        "\xa1" "a" "\x01"
+                        "\xa1" "b" "\xd1\xfe\xd4"
+                        "\xa1" "c" "\x92\x01\xcc\xc8"
+                        "\xa1" "d" "\xca\x3f\x00\x00\x00"
+                        "\xa1" "e" "\x91\x81\xa1" "x" "\x80", 34));
+}
+
+TEST(MsgPackWriterImplTest, large_containers)
+{
+  std::ostringstream os;
+  MsgPackWriterImpl writer(os);
+  writer.begin_object("doc");
+  writer.begin_mapping("map");
+  for (int i = 0; i < 20; ++i) {
+    writer.write(std::to_string(i), i);
+  }
+  writer.end_mapping();
+  writer.write("ints", std::vector<int>(70000, 7));
+  writer.write("str", std::string(300, 'x'));
+  writer.begin_collection("objs");
+  for (int i = 0; i < 20; ++i) {
+    writer.begin_object(std::to_string(i));
+    writer.end_object();
+  }
+  writer.end_collection();
+  writer.end_object();
+
+  std::string const data = os.str();
+  // map16 header for 20 entries
+  EXPECT_EQ(data.substr(0, 13), std::string("\x81\xa3" "doc" "\x84\xa3" "map" "\xde\x00\x14", 13));
+
+  ReaderDocument const doc = ReaderDocument::from_string(data);
+  ReaderMapping const map = doc.get_root().get_mapping();
+  EXPECT_EQ(map.get<ReaderMapping>("map").get<int>("19"), 19);
+  EXPECT_EQ(map.get<std::vector<int>>("ints"), std::vector<int>(70000, 7));
+  EXPECT_EQ(map.get<std::string>("str"), std::string(300, 'x'));
+  ReaderCollection const objs = map.get<ReaderCollection>("objs");
+  ASSERT_EQ(objs.size(), 20u);
+  for (std::size_t i = 0; i < objs.size(); ++i) {
+    EXPECT_EQ(objs.at(i).get_name(), std::to_string(i));
+  }
+}
+
+TEST(MsgPackWriterImplTest, write)
+{
+  std::ostringstream os;
+  MsgPackWriterImpl writer(os);
+  write_testfile(writer);
+
+  ReaderDocument const doc = ReaderDocument::from_string(os.str(), ErrorHandler::THROW);
+  ReaderObject const root = doc.get_root();
+  ASSERT_EQ(root.get_name(), "testfile");
+
+  ReaderMapping const map = root.get_mapping();
+  EXPECT_EQ(map.get_keys(), (std::vector<std::string>{
+        "trueval", "falseval", "intval", "floatval", "stringval", "escapedstringval",
+        "truevals", "intvals", "floatvals", "stringvals",
+        "collection", "mapping", "background"}));
+
+  EXPECT_EQ(map.get<bool>("trueval"), true);
+  EXPECT_EQ(map.get<int>("intval"), 123);
+  EXPECT_EQ(map.get<float>("floatval"), 123.5f);
+  EXPECT_EQ(map.get<std::string>("escapedstringval"), "\"Hello\\World\"");
+  EXPECT_EQ(map.get<std::vector<bool>>("truevals"), (std::vector<bool>{true, false, true}));
+  EXPECT_EQ(map.get<std::vector<float>>("floatvals"), (std::vector<float>{1.5f, 2.5f, 3.5f}));
+  EXPECT_EQ(map.get<std::vector<std::string>>("stringvals"), (std::vector<std::string>{"\"Hello", "World\""}));
+
+  std::vector<ReaderObject> const objects = map.get<ReaderCollection>("collection").get_objects();
+  ASSERT_EQ(objects.size(), 2u);
+  EXPECT_EQ(objects[1].get_name(), "object1");
+  EXPECT_EQ(objects[1].get_mapping().get<float>("y"), 90.5f);
+
+  EXPECT_EQ(map.get<ReaderMapping>("mapping").get<int>("three"), 3);
+
+  ReaderObject const background = map.get<ReaderObject>("background");
+  EXPECT_EQ(background.get_name(), "color");
+  EXPECT_EQ(background.get_mapping().get<float>("blue"), 0.5f);
+}
+
+TEST(MsgPackWriterImplTest, override_mapping)
+{
+  std::ostringstream base_os;
+  MsgPackWriterImpl base_writer(base_os);
+  base_writer.begin_object("config");
+  base_writer.write("width", 640);
+  base_writer.write("title", "base");
+  base_writer.begin_mapping("window");
+  base_writer.write("x", 10);
+  base_writer.write("y", 20);
+  base_writer.end_mapping();
+  base_writer.end_object();
+
+  std::ostringstream overrides_os;
+  MsgPackWriterImpl overrides_writer(overrides_os);
+  overrides_writer.begin_object("config");
+  overrides_writer.write("width", 1280);
+  overrides_writer.begin_mapping("window");
+  overrides_writer.write("y", 30);
+  overrides_writer.end_mapping();
+  overrides_writer.end_object();
+
+  ReaderDocument const base = ReaderDocument::from_string(Format::MSGPACK, base_os.str());
+  ReaderDocument const overrides = ReaderDocument::from_string(Format::MSGPACK, overrides_os.str());
+  ReaderMapping const base_map = base.get_root().get_mapping();
+  ReaderMapping const overrides_map = overrides.get_root().get_mapping();
+  ReaderMapping const map = make_override_mapping(base_map, overrides_map);
+  EXPECT_EQ(map.get<int>("width"), 1280);
+  EXPECT_EQ(map.get<std::string>("title"), "base");
+
+  // overridden keys first, followed by the remaining ones of the base
+  ReaderMapping::KeyRange const keys = map.keys();
+  EXPECT_EQ(std::vector<std::string>(keys.begin(), keys.end()),
+            (std::vector<std::string>{"width", "window", "title"}));
+
+  // nested overrides own their mappings, reading them doesn't grow the document
+  std::size_t const memory_usage = base.get_memory_usage();
+  ReaderMapping const window = map.get<ReaderMapping>("window");
+  EXPECT_EQ(window.get<int>("x"), 10);
+  EXPECT_EQ(window.get<int>("y"), 30);
+  ReaderMapping::KeyRange const window_keys = window.keys();
+  EXPECT_EQ(std::vector<std::string>(window_keys.begin(), window_keys.end()),
+            (std::vector<std::string>{"y", "x"}));
+  EXPECT_EQ(base.get_memory_usage(), memory_usage);
+}
+
+TEST(MsgPackWriterImplTest, read_fail)
+{
+  std::ostringstream os;
+  MsgPackWriterImpl writer(os);
+  write_testfile(writer);
+  std::string const data = os.str();
+
+  EXPECT_THROW(ReaderDocument::from_string(Format::MSGPACK, "(doc)"), ReaderError);
+  for (std::size_t size : {1u, 2u, 12u, 100u}) {
+    EXPECT_THROW(ReaderDocument::from_string(data.substr(0, size), ErrorHandler::IGNORE), ReaderError) << size;
+  }
+  EXPECT_THROW(ReaderDocument::from_string(data + '\x01'), ReaderError);
+
+  ReaderDocument const two_roots = ReaderDocument::from_string(Format::MSGPACK, "\x82\xa1" "a\x80\xa1" "b\x80",
+                                                               ErrorHandler::THROW);
+  EXPECT_THROW(two_roots.get_root(), ReaderError);
+}
+
+/* EOF */
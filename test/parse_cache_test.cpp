@@ -0,0 +1,208 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+#include <prio/parse_cache.hpp>
+#include <prio/reader_error.hpp>
+#include <prio/reader_mapping.hpp>
+#include <prio/reader_object.hpp>
+#include "fastsexpr_parser.hpp"
+
+using namespace prio;
+
+namespace {
+
+class ParseCacheTest : public ::testing::Test
+{
+protected:
+  ParseCacheTest() :
+    m_directory(std::filesystem::temp_directory_path() / "prio-parse-cache-test")
+  {
+  }
+
+  void SetUp() override
+  {
+    std::filesystem::remove_all(m_directory);
+    std::filesystem::create_directories(m_directory / "src");
+  }
+
+  void TearDown() override
+  {
+    std::filesystem::remove_all(m_directory);
+  }
+
+  std::filesystem::path write_source(std::string const& name, std::string const& text)
+  {
+    std::filesystem::path const filename = m_directory / "src" / name;
+    std::ofstream(filename, std::ios::binary) << text;
+    return filename;
+  }
+
+  int read_id(ParseCache const& cache, std::filesystem::path const& filename)
+  {
+    ReaderDocument const doc = cache.from_file(filename);
+    int id = -1;
+    doc.get_root().get_mapping().read("id", id);
+    return id;
+  }
+
+  /** Moves the modification time of @a filename into the past, so a
+      rewrite of the file can be detected */
+  void age(std::filesystem::path const& filename)
+  {
+    std::filesystem::last_write_time(filename, std::filesystem::last_write_time(filename) - std::chrono::hours(1));
+  }
+
+protected:
+  std::filesystem::path m_directory;
+};
+
+} // namespace
+
+TEST_F(ParseCacheTest, hit_and_miss)
+{
+  ParseCache const cache(m_directory / "cache");
+  for (auto const& [name, text] : std::vector<std::pair<std::string, std::string>>{
+      {"doc.sexp", "(doc (id 1) (name \"first\"))"},
+      {"doc.json", "{\"doc\": {\"id\": 1, \"name\": \"first\"}}"}})
+  {
+    std::filesystem::path const filename = write_source(name, text);
+    std::filesystem::path const cache_filename = cache.get_cache_filename(filename);
+    EXPECT_EQ(cache_filename.parent_path(), m_directory / "cache");
+
+    EXPECT_EQ(read_id(cache, filename), 1);
+    ASSERT_TRUE(std::filesystem::exists(cache_filename)) << name;
+
+    // a hit leaves the cache file alone
+    age(cache_filename);
+    auto const cached_time = std::filesystem::last_write_time(cache_filename);
+    ReaderDocument const doc = cache.from_file(filename);
+    EXPECT_EQ(doc.get_root().get_name(), "doc");
+    EXPECT_EQ(doc.get_root().get_mapping().get<std::string>("name"), "first");
+    EXPECT_EQ(doc.get_filename(), filename.string());
+    EXPECT_EQ(std::filesystem::last_write_time(cache_filename), cached_time) << name;
+
+    // same size and mtime, different content
+    auto const source_time = std::filesystem::last_write_time(filename);
+    std::string changed = text;
+    changed[changed.find('1')] = '2';
+    write_source(name, changed);
+    std::filesystem::last_write_time(filename, source_time);
+    EXPECT_EQ(read_id(cache, filename), 2) << name;
+    EXPECT_NE(std::filesystem::last_write_time(cache_filename), cached_time) << name;
+
+    // different size
+    write_source(name, text + "\n\n");
+    EXPECT_EQ(read_id(cache, filename), 1) << name;
+  }
+}
+
+TEST_F(ParseCacheTest, next_to_source)
+{
+  ParseCache const cache;
+  std::filesystem::path const filename = write_source("doc.sexp", "(doc (id 3))");
+  EXPECT_EQ(cache.get_cache_filename(filename), m_directory / "src" / "doc.sexp.priocache");
+
+  EXPECT_EQ(read_id(cache, filename), 3);
+  EXPECT_TRUE(std::filesystem::exists(m_directory / "src" / "doc.sexp.priocache"));
+  EXPECT_EQ(read_id(cache, filename), 3);
+}
+
+TEST_F(ParseCacheTest, damaged_cache)
+{
+  ParseCache const cache(m_directory / "cache");
+  std::filesystem::path const filename = write_source("doc.sexp", "(doc (id 4) (list (a 1) (b 2)))");
+  EXPECT_EQ(read_id(cache, filename), 4);
+
+  std::filesystem::path const cache_filename = cache.get_cache_filename(filename);
+  std::uintmax_t const size = std::filesystem::file_size(cache_filename);
+
+  // truncated
+  std::filesystem::resize_file(cache_filename, size - 3);
+  EXPECT_EQ(read_id(cache, filename), 4);
+  EXPECT_EQ(std::filesystem::file_size(cache_filename), size);
+
+  // entries pointing outside of the source
+  {
+    std::fstream file(cache_filename, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(static_cast<std::streamoff>(size - 8));
+    file.write("\xff\xff\xff\x7f\xff\xff\xff\x7f", 8);
+  }
+  EXPECT_EQ(read_id(cache, filename), 4);
+
+  // unknown entry type
+  EXPECT_EQ(std::filesystem::file_size(cache_filename), size);
+  {
+    std::fstream file(cache_filename, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(static_cast<std::streamoff>(size - sizeof(FastSExprTape::Entry)));
+    file.put('\x7f');
+  }
+  EXPECT_EQ(read_id(cache, filename), 4);
+  {
+    // rejected and replaced
+    std::ifstream file(cache_filename, std::ios::binary);
+    file.seekg(static_cast<std::streamoff>(size - sizeof(FastSExprTape::Entry)));
+    EXPECT_NE(file.get(), 0x7f);
+  }
+
+  // garbage
+  std::ofstream(cache_filename, std::ios::binary) << "garbage";
+  EXPECT_EQ(read_id(cache, filename), 4);
+}
+
+#ifdef PRIO_USE_JSONCPP
+TEST_F(ParseCacheTest, rejected_by_tape_parser)
+{
+  // jsoncpp accepts comments, FASTJSON doesn't
+  ParseCache const cache(m_directory / "cache");
+  std::filesystem::path const filename = write_source("comment.json", "{ \"obj\": { // c\n \"id\": 6 } }");
+  ReaderDocument const doc = cache.from_file(Format::JSON, filename);
+  EXPECT_EQ(doc.get_root().get_mapping().get<int>("id"), 6);
+  EXPECT_EQ(read_id(cache, filename), 6);
+  EXPECT_FALSE(std::filesystem::exists(cache.get_cache_filename(filename)));
+  EXPECT_THROW(cache.from_file(Format::FASTJSON, filename), ReaderError);
+}
+#endif
+
+TEST_F(ParseCacheTest, uncached)
+{
+  ParseCache const cache(m_directory / "cache");
+
+  std::filesystem::path const binary = m_directory / "src" / "data.bin";
+  std::filesystem::copy_file("test/data/data.bin", binary);
+  EXPECT_EQ(cache.from_file(binary).get_root().get_name(), "test-document");
+  EXPECT_FALSE(std::filesystem::exists(cache.get_cache_filename(binary)));
+
+  // parse errors are reported and nothing is cached
+  std::filesystem::path const broken = write_source("broken.sexp", "(doc (id 1)");
+  EXPECT_THROW(cache.from_file(broken), ReaderError);
+  EXPECT_FALSE(std::filesystem::exists(cache.get_cache_filename(broken)));
+
+  EXPECT_THROW(cache.from_file(m_directory / "src" / "does-not-exist"), ReaderError);
+
+  // an unusable cache directory only disables caching
+  std::ofstream(m_directory / "file") << "not a directory";
+  ParseCache const unusable(m_directory / "file");
+  std::filesystem::path const filename = write_source("doc.json", "{\"doc\": {\"id\": 5}}");
+  EXPECT_EQ(read_id(unusable, filename), 5);
+}
+
+/* EOF */
@@ -16,28 +16,49 @@
 
 #include <gtest/gtest.h>
 
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
 #include <prio/reader_document.hpp>
+#include <prio/reader_document_range.hpp>
 #include <prio/reader_error.hpp>
 #include <prio/reader_mapping.hpp>
 #include <prio/reader_object.hpp>
+#include <prio/writer.hpp>
 
 using namespace prio;
 
-class ReaderDocumentTest : public ::testing::TestWithParam<std::string> {};
+class ReaderDocumentTest : public ::testing::TestWithParam<std::tuple<Format, std::string>>
+{
+protected:
+  Format format() const { return std::get<0>(GetParam()); }
+  std::string extension() const { return std::get<1>(GetParam()); }
+};
 
 TEST_P(ReaderDocumentTest, from_file)
 {
-  EXPECT_NO_THROW(ReaderDocument::from_file("test/data/data" + GetParam()));
-  EXPECT_NO_THROW(ReaderDocument::from_file("test/data/data" + GetParam(), ErrorHandler::IGNORE));
+  EXPECT_NO_THROW(ReaderDocument::from_file(format(), "test/data/data" + extension()));
+  EXPECT_NO_THROW(ReaderDocument::from_file(format(), "test/data/data" + extension(), ErrorHandler::IGNORE));
+}
+
+TEST_P(ReaderDocumentTest, get_memory_usage)
+{
+  std::uintmax_t const file_size = std::filesystem::file_size("test/data/data" + extension());
+  ReaderDocument const doc = ReaderDocument::from_file(format(), "test/data/data" + extension());
+  EXPECT_GT(doc.get_memory_usage(), file_size / 2);
+  EXPECT_EQ(ReaderDocument().get_memory_usage(), 0u);
 }
 
 TEST_P(ReaderDocumentTest, from_file__fail)
 {
-  EXPECT_THROW(ReaderDocument::from_file("does-not-exist"), ReaderError);
-  EXPECT_THROW(ReaderDocument::from_file("does-not-exist", ErrorHandler::IGNORE), ReaderError);
+  EXPECT_THROW(ReaderDocument::from_file(format(), "does-not-exist"), ReaderError);
+  EXPECT_THROW(ReaderDocument::from_file(format(), "does-not-exist", ErrorHandler::IGNORE), ReaderError);
 
-  EXPECT_THROW(ReaderDocument::from_file("test/data/data-corrupt" + GetParam()), ReaderError);
-  EXPECT_THROW(ReaderDocument::from_file("test/data/data-corrupt" + GetParam(), ErrorHandler::IGNORE), ReaderError);
+  EXPECT_THROW(ReaderDocument::from_file(format(), "test/data/data-corrupt" + extension()), ReaderError);
+  EXPECT_THROW(ReaderDocument::from_file(format(), "test/data/data-corrupt" + extension(), ErrorHandler::IGNORE), ReaderError);
 }
 
 TEST(ReaderDocumentTest, from_file__format)
@@ -46,41 +67,104 @@ TEST(ReaderDocumentTest, from_file__format)
   EXPECT_THROW(ReaderDocument::from_file(Format::JSON, "test/data/data.sexp"), ReaderError);
   EXPECT_NO_THROW(ReaderDocument::from_file(Format::JSON, "test/data/data.json"));
 #endif
+  EXPECT_THROW(ReaderDocument::from_file(Format::FASTJSON, "test/data/data.sexp"), ReaderError);
+  EXPECT_NO_THROW(ReaderDocument::from_file(Format::FASTJSON, "test/data/data.json"));
+  EXPECT_THROW(ReaderDocument::from_file(Format::FASTSEXPR, "test/data/data.json"), ReaderError);
+  EXPECT_NO_THROW(ReaderDocument::from_file(Format::FASTSEXPR, "test/data/data.sexp"));
+  EXPECT_THROW(ReaderDocument::from_file(Format::BINARY, "test/data/data.json"), ReaderError);
+  EXPECT_NO_THROW(ReaderDocument::from_file(Format::BINARY, "test/data/data.bin"));
+  EXPECT_THROW(ReaderDocument::from_file(Format::MSGPACK, "test/data/data.json"), ReaderError);
+  EXPECT_NO_THROW(ReaderDocument::from_file(Format::MSGPACK, "test/data/data.msgpack"));
 #ifdef PRIO_USE_SEXPCPP
   EXPECT_THROW(ReaderDocument::from_file(Format::SEXPR, "test/data/data.json"), ReaderError);
   EXPECT_NO_THROW(ReaderDocument::from_file(Format::SEXPR, "test/data/data.sexp"));
 #endif
 }
 
+TEST(ReaderDocumentTest, from_file__rewritten)
+{
+  std::filesystem::path const filename = std::filesystem::temp_directory_path() / "prio_rewritten_test.sexp";
+  {
+    std::ofstream out(filename, std::ios::binary);
+    out << "(doc (name \"abc\") (id 1))";
+  }
+
+  ReaderDocument doc = ReaderDocument::from_file(Format::FASTSEXPR, filename);
+  {
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    out << "(x)";
+  }
+
+  ReaderMapping mapping = doc.get_root().get_mapping();
+  EXPECT_EQ("abc", mapping.get<std::string_view>("name"));
+  EXPECT_EQ(1, mapping.get<int>("id"));
+
+  std::filesystem::remove(filename);
+}
+
 TEST_P(ReaderDocumentTest, get_filename)
 {
-  ReaderDocument doc = ReaderDocument::from_file("test/data/data" + GetParam());
-  EXPECT_EQ(doc.get_filename(), "test/data/data" + GetParam());
+  ReaderDocument doc = ReaderDocument::from_file(format(), "test/data/data" + extension());
+  EXPECT_EQ(doc.get_filename(), "test/data/data" + extension());
 }
 
 TEST_P(ReaderDocumentTest, get_directory)
 {
-  ReaderDocument doc = ReaderDocument::from_file("test/data/data" + GetParam());
+  ReaderDocument doc = ReaderDocument::from_file(format(), "test/data/data" + extension());
   EXPECT_EQ(doc.get_directory(), "test/data");
 }
 
 TEST_P(ReaderDocumentTest, get_root)
 {
-  ReaderDocument doc = ReaderDocument::from_file("test/data/data" + GetParam());
+  ReaderDocument doc = ReaderDocument::from_file(format(), "test/data/data" + extension());
+  EXPECT_EQ(doc.get_root().get_name(), "test-document");
+}
+
+TEST_P(ReaderDocumentTest, from_buffer)
+{
+  std::ifstream fin("test/data/data" + extension(), std::ios::binary);
+  std::vector<char> const content((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+
+  std::vector<std::byte> buffer(content.size());
+  std::memcpy(buffer.data(), content.data(), content.size());
+
+  ReaderDocument const doc = ReaderDocument::from_buffer(format(), buffer);
+  std::fill(buffer.begin(), buffer.end(), std::byte{' '});
   EXPECT_EQ(doc.get_root().get_name(), "test-document");
+
+  std::memcpy(buffer.data(), content.data(), content.size());
+  ReaderDocument const borrowed = ReaderDocument::from_borrowed_buffer(format(), buffer);
+  EXPECT_EQ(borrowed.get_root().get_name(), "test-document");
+
+  int intvalue = 0;
+  EXPECT_TRUE(borrowed.get_mapping().read("intvalue", intvalue));
+  EXPECT_EQ(intvalue, 5);
 }
 
-#if defined(PRIO_USE_SEXPCPP) && defined(PRIO_USE_JSONCPP)
-INSTANTIATE_TEST_CASE_P(ParamReaderDocumentTest, ReaderDocumentTest,
-                        ::testing::Values(".sexp", ".json"));
-#elif defined(PRIO_USE_SEXPCPP)
-INSTANTIATE_TEST_CASE_P(ParamReaderDocumentTest, ReaderDocumentTest,
-                        ::testing::Values(".sexp"));
-#elif defined(PRIO_USE_JSONCPP)
-INSTANTIATE_TEST_CASE_P(ParamReaderDocumentTest, ReaderDocumentTest,
-                        ::testing::Values(".json"));
+#ifdef PRIO_USE_SEXPCPP
+INSTANTIATE_TEST_CASE_P(SExprReaderDocumentTest, ReaderDocumentTest,
+                        ::testing::Values(std::make_tuple(Format::AUTO, ".sexp")));
+#endif
+
+#ifdef PRIO_USE_JSONCPP
+INSTANTIATE_TEST_CASE_P(JsonReaderDocumentTest, ReaderDocumentTest,
+                        ::testing::Values(std::make_tuple(Format::AUTO, ".json")));
 #endif
 
+INSTANTIATE_TEST_CASE_P(FastJsonReaderDocumentTest, ReaderDocumentTest,
+                        ::testing::Values(std::make_tuple(Format::FASTJSON, ".json")));
+
+INSTANTIATE_TEST_CASE_P(FastSExprReaderDocumentTest, ReaderDocumentTest,
+                        ::testing::Values(std::make_tuple(Format::FASTSEXPR, ".sexp")));
+
+INSTANTIATE_TEST_CASE_P(BinaryReaderDocumentTest, ReaderDocumentTest,
+                        ::testing::Values(std::make_tuple(Format::AUTO, ".bin"),
+                                          std::make_tuple(Format::BINARY, ".bin")));
+
+INSTANTIATE_TEST_CASE_P(MsgPackReaderDocumentTest, ReaderDocumentTest,
+                        ::testing::Values(std::make_tuple(Format::AUTO, ".msgpack"),
+                                          std::make_tuple(Format::MSGPACK, ".msgpack")));
+
 
 #ifdef PRIO_USE_JSONCPP
 TEST(ReaderDocumentTest, parse_many_json_lines)
@@ -104,6 +188,36 @@ TEST(ReaderDocumentTest, parse_many_json_compact)
   EXPECT_EQ(docs[0].get_root().get_name(), "doc-a");
   EXPECT_EQ(docs[1].get_root().get_name(), "doc-b");
 }
+
+TEST(ReaderDocumentTest, parse_many_json_parallel)
+{
+  std::filesystem::path const filename = std::filesystem::temp_directory_path() / "prio-parse-many-test.jsonl";
+  {
+    std::ofstream out(filename);
+    for (int i = 0; i < 1000; ++i) {
+      out << "{\"doc-" << i << "\": {\"id\": " << i << "}}" << ((i % 3 == 0) ? " " : "\n");
+    }
+  }
+
+  for (unsigned int num_threads : {0u, 1u, 4u}) {
+    auto docs = ReaderDocument::parse_many(filename.string(), num_threads);
+    ASSERT_EQ(docs.size(), 1000u);
+    for (int i = 0; i < 1000; ++i) {
+      int id = -1;
+      ASSERT_TRUE(docs[i].get_root().get_mapping().read("id", id));
+      EXPECT_EQ(id, i);
+      EXPECT_EQ(docs[i].get_root().get_name(), "doc-" + std::to_string(i));
+    }
+  }
+
+  {
+    std::ofstream out(filename, std::ios::app);
+    out << "{\"broken\": [1, 2,, 3]}\n";
+  }
+  EXPECT_THROW(ReaderDocument::parse_many(filename.string(), 4), ReaderError);
+
+  std::filesystem::remove(filename);
+}
 #endif
 
 #ifdef PRIO_USE_SEXPCPP
@@ -115,11 +229,151 @@ TEST(ReaderDocumentTest, parse_many_sexp)
   EXPECT_EQ(docs[1].get_root().get_name(), "doc-b");
   EXPECT_EQ(docs[2].get_root().get_name(), "doc-c");
 }
+
+TEST(ReaderDocumentTest, parse_many_sexp_parallel)
+{
+  std::filesystem::path const filename = std::filesystem::temp_directory_path() / "prio-parse-many-test.sexp";
+  {
+    std::ofstream out(filename);
+    for (int i = 0; i < 500; ++i) {
+      // each record starts on line 4 * i + 2
+      out << "; record " << i << "\n"
+          << "(doc-" << i << "\n"
+          << "  (id " << i << ")\n"
+          << "  (text \"a (string) with ; and \\\" inside\"))\n";
+    }
+  }
+
+  for (unsigned int num_threads : {0u, 1u, 4u}) {
+    auto docs = ReaderDocument::parse_many(filename.string(), num_threads);
+    ASSERT_EQ(docs.size(), 500u);
+    for (int i = 0; i < 500; ++i) {
+      int id = -1;
+      ASSERT_TRUE(docs[i].get_root().get_mapping().read("id", id));
+      EXPECT_EQ(id, i);
+      EXPECT_EQ(docs[i].get_root().get_name(), "doc-" + std::to_string(i));
+    }
+
+    // line numbers refer to the whole file
+    int value;
+    try {
+      docs[100].get_root().get_mapping().must_read("missing", value);
+      FAIL() << "expected ReaderError";
+    } catch (ReaderError const& err) {
+      EXPECT_NE(std::string(err.what()).find(filename.string() + ":402:"), std::string::npos) << err.what();
+    }
+  }
+
+  {
+    std::ofstream out(filename, std::ios::app);
+    out << "(broken\n";
+  }
+  EXPECT_THROW(ReaderDocument::parse_many(filename.string(), 4), ReaderError);
+
+  std::filesystem::remove(filename);
+}
 #endif
 
+TEST(ReaderDocumentTest, parse_many_msgpack_parallel)
+{
+  std::filesystem::path const filename = std::filesystem::temp_directory_path() / "prio-parse-many-test.msgpack";
+  {
+    std::ofstream out(filename, std::ios::binary);
+    for (int i = 0; i < 1000; ++i) {
+      Writer writer = Writer::from_stream(Format::MSGPACK, out);
+      writer.begin_object("doc-" + std::to_string(i));
+      writer.write("id", i);
+      writer.write("text", std::string(static_cast<std::size_t>(i % 40), 'x'));
+      writer.end_object();
+    }
+  }
+
+  for (unsigned int num_threads : {0u, 1u, 4u}) {
+    auto docs = ReaderDocument::parse_many(filename.string(), num_threads);
+    ASSERT_EQ(docs.size(), 1000u);
+    for (int i = 0; i < 1000; ++i) {
+      int id = -1;
+      ASSERT_TRUE(docs[i].get_root().get_mapping().read("id", id));
+      EXPECT_EQ(id, i);
+      EXPECT_EQ(docs[i].get_root().get_name(), "doc-" + std::to_string(i));
+    }
+  }
+
+  {
+    std::ofstream out(filename, std::ios::binary | std::ios::app);
+    out << "\x81\xa3" "doc\x81\xa2" "id";
+  }
+  EXPECT_THROW(ReaderDocument::parse_many(filename.string(), 4), ReaderError);
+
+  std::filesystem::remove(filename);
+}
+
 TEST(ReaderDocumentTest, parse_many_missing_file)
 {
   EXPECT_THROW(ReaderDocument::parse_many("does-not-exist"), ReaderError);
 }
 
+TEST(ReaderDocumentTest, iterate_many)
+{
+  for (std::string const filename : {"test/data/many.jsonl", "test/data/many.sexp"}) {
+    std::vector<std::string> names;
+    for (ReaderDocument const& doc : ReaderDocument::iterate_many(filename)) {
+      names.push_back(doc.get_root().get_name());
+    }
+    EXPECT_EQ(names, (std::vector<std::string>{"doc-a", "doc-b", "doc-c"})) << filename;
+  }
+
+  ReaderDocumentRange range = ReaderDocument::iterate_many("test/data/many-compact.json");
+  auto it = range.begin();
+  ASSERT_NE(it, range.end());
+  EXPECT_EQ(it->get_root().get_name(), "doc-a");
+  ++it;
+  ASSERT_NE(it, range.end());
+  int id = 0;
+  ASSERT_TRUE(it->get_root().get_mapping().read("id", id));
+  EXPECT_EQ(id, 2);
+  ++it;
+  EXPECT_EQ(it, range.end());
+}
+
+TEST(ReaderDocumentTest, iterate_many_large_records)
+{
+  // records larger than the read window and values split between reads
+  std::string const value(200000, 'x');
+  std::ostringstream json;
+  std::ostringstream sexpr;
+  for (int i = 0; i < 5; ++i) {
+    json << "{\"doc\": {\"id\": " << i << ", \"text\": \"" << value << "\"}}\n";
+    sexpr << "; record " << i << "\n(doc (id " << i << ") (text \"" << value << "\"))\n";
+  }
+
+  for (std::string const& text : {json.str(), sexpr.str()}) {
+    std::istringstream in(text);
+    int count = 0;
+    for (ReaderDocument const& doc : ReaderDocument::iterate_many(in)) {
+      int id = -1;
+      std::string str;
+      ASSERT_TRUE(doc.get_root().get_mapping().read("id", id));
+      ASSERT_TRUE(doc.get_root().get_mapping().read("text", str));
+      EXPECT_EQ(id, count);
+      EXPECT_EQ(str.size(), value.size());
+      count += 1;
+    }
+    EXPECT_EQ(count, 5);
+  }
+}
+
+TEST(ReaderDocumentTest, iterate_many_fail)
+{
+  EXPECT_THROW(ReaderDocument::iterate_many("does-not-exist"), ReaderError);
+
+  for (std::string const text : {"{\"doc\": {}} {\"doc\": ", "(doc) (doc", "(doc) )"}) {
+    std::istringstream in(text);
+    ReaderDocumentRange range = ReaderDocument::iterate_many(in);
+    EXPECT_THROW({
+        for (auto it = range.begin(); it != range.end(); ++it) {}
+      }, ReaderError) << text;
+  }
+}
+
 /* EOF */
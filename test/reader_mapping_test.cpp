@@ -16,8 +16,11 @@
 
 #include <gtest/gtest.h>
 
+#include <array>
+#include <format>
 #include <fstream>
 
+#include <prio/override_reader_mapping.hpp>
 #include <prio/reader_collection.hpp>
 #include <prio/reader_document.hpp>
 #include <prio/reader_error.hpp>
@@ -25,18 +28,20 @@
 
 using namespace prio;
 
-class ReaderMappingTest : public ::testing::TestWithParam<std::string>
+class ReaderMappingTest : public ::testing::TestWithParam<std::tuple<Format, std::string>>
 {
 public:
   ReaderMappingTest() :
-    filename("test/data/data" + GetParam()),
-    doc(ReaderDocument::from_file(filename, ErrorHandler::IGNORE)),
+    format(std::get<0>(GetParam())),
+    filename("test/data/data" + std::get<1>(GetParam())),
+    doc(ReaderDocument::from_file(format, filename, ErrorHandler::IGNORE)),
     map(doc.get_root().get_mapping()),
-    doc_pedantic(ReaderDocument::from_file("test/data/data" + GetParam(), ErrorHandler::THROW)),
+    doc_pedantic(ReaderDocument::from_file(format, filename, ErrorHandler::THROW)),
     map_pedantic(doc_pedantic.get_root().get_mapping())
   {}
 
 protected:
+  Format format;
   std::string filename;
   ReaderDocument const doc;
   ReaderMapping const map;
@@ -117,12 +122,116 @@ TEST_P(ReaderMappingTest, read_string)
   EXPECT_EQ("Hello World", stringvalue);
 }
 
+TEST_P(ReaderMappingTest, read_string_view)
+{
+  std::string_view stringvalue;
+  ASSERT_TRUE(map.read("stringvalue", stringvalue));
+  EXPECT_EQ(stringvalue, "Hello World");
+  EXPECT_EQ(map.get<std::string_view>("stringvalue-doesnotexist", "Fallback"), "Fallback");
+
+  ASSERT_THROW(map_pedantic.read("intvalue", stringvalue), ReaderError);
+  EXPECT_EQ(stringvalue, "Hello World");
+}
+
 TEST_P(ReaderMappingTest, get_string)
 {
   ASSERT_EQ(map.get<std::string>("stringvalue"), "Hello World");
   ASSERT_EQ(map.get<std::string>("stringvalue-doesnotexist", "Fallback"), "Fallback");
 }
 
+TEST_P(ReaderMappingTest, read_key)
+{
+  static constexpr Key key_intvalue("intvalue");
+  static_assert(key_intvalue.get_hash() == Key::hash("intvalue"));
+  static_assert(key_intvalue.size() == 8);
+
+  int intvalue;
+  ASSERT_TRUE(map.read(key_intvalue, intvalue));
+  EXPECT_EQ(intvalue, 5);
+  EXPECT_EQ(map.get<std::string>(Key("stringvalue")), "Hello World");
+  EXPECT_EQ(map.get<float>(std::string("floatvalue")), 5.5f);
+  EXPECT_EQ(map.get<int>(std::string_view("intvalue-doesnotexist"), 99), 99);
+  EXPECT_EQ(map.must_get<ReaderMapping>(Key("submap")).get<int>(Key("int")), 7);
+}
+
+TEST_P(ReaderMappingTest, read_fields)
+{
+  bool boolvalue = false;
+  int intvalue = 0;
+  float floatvalue = 0.0f;
+  std::string stringvalue;
+  std::vector<int> intvalues;
+  std::vector<std::string> stringvalues;
+  ReaderMapping submap;
+  ReaderCollection collection;
+  int missing = 99;
+
+  ASSERT_TRUE(map.read_fields({
+        {"boolvalue", &boolvalue},
+        {"intvalue", &intvalue, true},
+        {"floatvalue", &floatvalue},
+        {"stringvalue", &stringvalue},
+        {"intvalues", &intvalues},
+        {"stringvalues", &stringvalues},
+        {"submap", &submap, true},
+        {"collection", &collection},
+        {"missing", &missing}
+      }));
+
+  EXPECT_TRUE(boolvalue);
+  EXPECT_EQ(intvalue, 5);
+  EXPECT_EQ(floatvalue, 5.5f);
+  EXPECT_EQ(stringvalue, "Hello World");
+  EXPECT_EQ(intvalues, std::vector<int>({1, 2, 3, 4}));
+  EXPECT_EQ(stringvalues, std::vector<std::string>({"Hello", "World"}));
+  EXPECT_EQ(submap.get<int>("int"), 7);
+  EXPECT_EQ(collection.get_objects().size(), 3u);
+  EXPECT_EQ(missing, 99);
+}
+
+TEST_P(ReaderMappingTest, read_fields__missing)
+{
+  int intvalue = 0;
+  int missing1 = 0;
+  int missing2 = 0;
+  try {
+    map.read_fields({
+        {"missing1", &missing1, true},
+        {"intvalue", &intvalue, true},
+        {"missing2", &missing2, true}
+      });
+    FAIL() << "expected ReaderError";
+  } catch (ReaderError const& err) {
+    std::string const what = err.what();
+    EXPECT_NE(what.find("missing1, missing2"), std::string::npos) << what;
+  }
+  EXPECT_EQ(intvalue, 5);
+
+  EXPECT_FALSE(ReaderMapping().read_fields({{"intvalue", &intvalue, true}}));
+}
+
+TEST_P(ReaderMappingTest, collection)
+{
+  static_assert(std::forward_iterator<ReaderCollection::iterator>);
+
+  ReaderCollection const collection = map.get<ReaderCollection>("collection");
+  ASSERT_EQ(collection.size(), 3u);
+
+  std::vector<std::string> names;
+  for (ReaderObject const& object : collection) {
+    names.push_back(object.get_name());
+  }
+  EXPECT_EQ(names, std::vector<std::string>({"obj1", "obj2", "obj3"}));
+
+  EXPECT_EQ(collection.at(0).get_name(), "obj1");
+  EXPECT_EQ(collection.at(2).get_name(), "obj3");
+  EXPECT_THROW(collection.at(3), std::out_of_range);
+
+  ReaderCollection const empty;
+  EXPECT_EQ(empty.size(), 0u);
+  EXPECT_EQ(empty.begin(), empty.end());
+}
+
 TEST_P(ReaderMappingTest, read_bools)
 {
   std::vector<bool> boolvalues;
@@ -177,6 +286,23 @@ TEST_P(ReaderMappingTest, read_floats)
   EXPECT_EQ(std::vector<float>({1.5f, 2.5f, 3.5f, 4.5f}), floatvalues);
 }
 
+TEST_P(ReaderMappingTest, read_spans)
+{
+  std::array<int, 4> intvalues{};
+  ASSERT_TRUE(map.read("intvalues", std::span<int>(intvalues)));
+  EXPECT_EQ(intvalues, (std::array<int, 4>{1, 2, 3, 4}));
+
+  std::array<float, 4> floatvalues{};
+  ASSERT_TRUE(map.read("floatvalues", std::span<float>(floatvalues)));
+  EXPECT_EQ(floatvalues, (std::array<float, 4>{1.5f, 2.5f, 3.5f, 4.5f}));
+
+  // the size has to match, the storage is left untouched otherwise
+  std::array<float, 3> too_small{7.0f, 7.0f, 7.0f};
+  EXPECT_FALSE(map.read("floatvalues", std::span<float>(too_small)));
+  ASSERT_THROW(map_pedantic.read("floatvalues", std::span<float>(too_small)), ReaderError);
+  EXPECT_EQ(too_small, (std::array<float, 3>{7.0f, 7.0f, 7.0f}));
+}
+
 TEST_P(ReaderMappingTest, get_floats)
 {
   EXPECT_EQ(map.get<std::vector<float>>("floatvalues"),
@@ -297,6 +423,7 @@ TEST_P(ReaderMappingTest, read_object)
   ReaderObject object;
   ASSERT_TRUE(map.read("object", object));
   EXPECT_EQ("realthing", object.get_name());
+  EXPECT_EQ(object.get_name_view(), "realthing");
   ReaderMapping object_mapping = object.get_mapping();
   int prop1 = 0;
   int prop2 = 0;
@@ -364,6 +491,70 @@ TEST_P(ReaderMappingTest, get_keys)
   ASSERT_EQ(expected, result);
 }
 
+TEST_P(ReaderMappingTest, keys)
+{
+  static_assert(std::input_iterator<ReaderMapping::key_iterator>);
+
+  std::vector<std::string> keys;
+  for (std::string_view key : map.keys()) {
+    keys.emplace_back(key);
+  }
+  EXPECT_EQ(keys, map.get_keys());
+
+  ReaderMapping const empty;
+  EXPECT_TRUE(empty.keys().empty());
+
+  // iterators of different mappings don't compare equal
+  ReaderMapping const submap = map.get<ReaderMapping>("submap");
+  EXPECT_EQ(map.keys().begin(), map.keys().begin());
+  EXPECT_NE(map.keys().begin(), submap.keys().begin());
+}
+
+TEST(ReaderMappingKeysTest, escaped)
+{
+  ReaderDocument const doc = ReaderDocument::from_string(Format::FASTJSON,
+                                                         R"({"doc": {"a\"b": 1, "plain": 2}})");
+  ReaderMapping const map = doc.get_root().get_mapping();
+  std::vector<std::string> keys;
+  for (std::string_view key : map.keys()) {
+    keys.emplace_back(key);
+  }
+  EXPECT_EQ(keys, std::vector<std::string>({"a\"b", "plain"}));
+}
+
+TEST(ReaderMappingKeysTest, override_many)
+{
+  // large enough for the override keys to be indexed
+  std::string base = R"({"doc": {)";
+  std::string overrides = R"({"doc": {)";
+  for (int i = 0; i < 40; ++i) {
+    base += std::format(R"({}"key{}": {})", (i == 0) ? "" : ", ", i, i);
+  }
+  for (int i = 0; i < 40; i += 2) {
+    overrides += std::format(R"({}"key{}": {})", (i == 0) ? "" : ", ", i, -i);
+  }
+  base += "}}";
+  overrides += "}}";
+
+  ReaderDocument const base_doc = ReaderDocument::from_string(Format::FASTJSON, base);
+  ReaderDocument const overrides_doc = ReaderDocument::from_string(Format::FASTJSON, overrides);
+  ReaderMapping const base_map = base_doc.get_root().get_mapping();
+  ReaderMapping const overrides_map = overrides_doc.get_root().get_mapping();
+  ReaderMapping const map = make_override_mapping(base_map, overrides_map);
+
+  std::vector<std::string> expected;
+  for (int i = 0; i < 40; i += 2) {
+    expected.push_back(std::format("key{}", i));
+  }
+  for (int i = 1; i < 40; i += 2) {
+    expected.push_back(std::format("key{}", i));
+  }
+  ReaderMapping::KeyRange const keys = map.keys();
+  EXPECT_EQ(std::vector<std::string>(keys.begin(), keys.end()), expected);
+  EXPECT_EQ(map.get<int>("key4"), -4);
+  EXPECT_EQ(map.get<int>("key5"), 5);
+}
+
 TEST_P(ReaderMappingTest, read_wrong)
 {
   bool bool_value;
@@ -399,15 +590,155 @@ TEST_P(ReaderMappingTest, read_wrong)
   SUCCEED();
 }
 
-#if defined(PRIO_USE_SEXPCPP) && defined(PRIO_USE_JSONCPP)
-INSTANTIATE_TEST_CASE_P(ParamReaderMappingTest, ReaderMappingTest,
-                        ::testing::Values(".sexp", ".json"));
-#elif defined(PRIO_USE_SEXPCPP)
-INSTANTIATE_TEST_CASE_P(ParamReaderMappingTest, ReaderMappingTest,
-                        ::testing::Values(".sexp"));
-#elif defined(PRIO_USE_JSONCPP)
-INSTANTIATE_TEST_CASE_P(ParamReaderMappingTest, ReaderMappingTest,
-                        ::testing::Values(".json"));
+TEST(FastJsonReaderMappingTest, read_string_view_escaped)
+{
+  // escaped strings are decoded into the document arena once
+  ReaderDocument const doc = ReaderDocument::from_string(Format::FASTJSON,
+                                                         R"({"doc": {"plain": "abc", "escaped": "a\nb"}})");
+  ReaderMapping const map = doc.get_root().get_mapping();
+  std::size_t const memory_usage = doc.get_memory_usage();
+  EXPECT_EQ(map.get<std::string_view>("plain"), "abc");
+  EXPECT_EQ(doc.get_memory_usage(), memory_usage);
+  EXPECT_EQ(map.get<std::string_view>("escaped"), "a\nb");
+  std::size_t const decoded_memory_usage = doc.get_memory_usage();
+  EXPECT_GT(decoded_memory_usage, memory_usage);
+  EXPECT_EQ(map.get<std::string_view>("escaped"), "a\nb");
+  EXPECT_EQ(doc.get_memory_usage(), decoded_memory_usage);
+}
+
+#ifdef PRIO_USE_SEXPCPP
+TEST(SExprReaderMappingTest, many_keys)
+{
+  // large enough to go through the key index instead of a linear scan
+  std::string text = "(doc";
+  for (int i = 0; i < 100; ++i) {
+    text += std::format(" (key{} {})", i, i);
+  }
+  text += " (key7 700))";
+
+  ReaderDocument const doc = ReaderDocument::from_string(Format::SEXPR, text);
+  ReaderMapping const map = doc.get_root().get_mapping();
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(map.get<int>(std::format("key{}", i)), (i == 7) ? 700 : i);
+  }
+  EXPECT_EQ(map.get<int>("key100", -1), -1);
+  EXPECT_EQ(map.get_keys().size(), 101u);
+
+  // small mappings resolve duplicates the same way
+  ReaderDocument const small_doc = ReaderDocument::from_string(Format::SEXPR, "(doc (a 1) (b 2) (a 3))");
+  EXPECT_EQ(small_doc.get_root().get_mapping().get<int>("a"), 3);
+}
+#endif
+
+TEST(ReaderMappingTest, read_fields__duplicate)
+{
+  // duplicate keys of the wrong type behave like a sequence of read() calls
+  std::vector<std::pair<Format, std::string>> cases = {
+    {Format::FASTJSON, R"({"doc": {"a": "str", "a": 5, "b": 5, "b": "str"}})"},
+    {Format::FASTSEXPR, R"((doc (a "str") (a 5) (b 5) (b "str")))"},
+  };
+#ifdef PRIO_USE_SEXPCPP
+  cases.emplace_back(Format::SEXPR, R"((doc (a "str") (a 5) (b 5) (b "str")))");
+#endif
+
+  for (auto const& [format, text] : cases) {
+    ReaderDocument const doc = ReaderDocument::from_string(format, text, ErrorHandler::IGNORE);
+    ReaderMapping const map = doc.get_root().get_mapping();
+
+    int a_read = 99;
+    int b_read = 99;
+    EXPECT_TRUE(map.read("a", a_read));
+    EXPECT_FALSE(map.read("b", b_read));
+
+    int a = 99;
+    int b = 99;
+    EXPECT_TRUE(map.read_fields({{"a", &a, true}, {"b", &b}}));
+    EXPECT_EQ(a, a_read);
+    EXPECT_EQ(b, b_read);
+    EXPECT_THROW(map.read_fields({{"b", &b, true}}), ReaderError);
+  }
+}
+
+TEST(ReaderMappingTest, read_values__mismatch)
+{
+  // a mismatch after the first element leaves the target untouched
+  std::string json = R"({"doc": {"mixed": [1, 2, "x"], "ints": [)";
+  std::string sexpr = R"((doc (mixed 1 2 "x") (ints)";
+  for (int i = 0; i < 20; ++i) {
+    json += std::format("{}{}", (i == 0) ? "" : ", ", i);
+    sexpr += std::format(" {}", i);
+  }
+  json += "]}}";
+  sexpr += "))";
+
+  for (auto const& [format, text] : { std::pair{Format::FASTJSON, json},
+                                      std::pair{Format::FASTSEXPR, sexpr} }) {
+    ReaderDocument const doc = ReaderDocument::from_string(format, text, ErrorHandler::IGNORE);
+    ReaderMapping const map = doc.get_root().get_mapping();
+
+    std::vector<int> values{7, 7, 7};
+    EXPECT_FALSE(map.read("mixed", values));
+    EXPECT_EQ(values, std::vector<int>({7, 7, 7}));
+
+    std::array<int, 3> span_values{7, 7, 7};
+    EXPECT_FALSE(map.read("mixed", std::span<int>(span_values)));
+    EXPECT_EQ(span_values, (std::array<int, 3>{7, 7, 7}));
+
+    // more elements than are staged inline
+    std::array<int, 20> ints{};
+    ASSERT_TRUE(map.read("ints", std::span<int>(ints)));
+    for (int i = 0; i < 20; ++i) {
+      EXPECT_EQ(ints[static_cast<std::size_t>(i)], i);
+    }
+  }
+}
+
+TEST(ReaderMappingTest, collection__large)
+{
+  // indexed access goes through the element index of the tape based backends
+  std::string json = R"({"doc": {"collection": [)";
+  std::string sexpr = "(doc (collection";
+  for (int i = 0; i < 100; ++i) {
+    json += std::format(R"({}{{"obj{}": {{}}}})", (i == 0) ? "" : ", ", i);
+    sexpr += std::format(" (obj{})", i);
+  }
+  json += "]}}";
+  sexpr += "))";
+
+  for (auto const& [format, text] : { std::pair{Format::FASTJSON, json},
+                                      std::pair{Format::FASTSEXPR, sexpr} }) {
+    ReaderDocument const doc = ReaderDocument::from_string(format, text);
+    ReaderCollection const collection = doc.get_root().get_mapping().get<ReaderCollection>("collection");
+    ASSERT_EQ(collection.size(), 100u);
+    for (std::size_t i = 0; i < collection.size(); ++i) {
+      EXPECT_EQ(collection.at(i).get_name(), std::format("obj{}", i));
+    }
+    EXPECT_THROW(collection.at(100), std::out_of_range);
+  }
+}
+
+#ifdef PRIO_USE_SEXPCPP
+INSTANTIATE_TEST_CASE_P(SExprReaderMappingTest, ReaderMappingTest,
+                        ::testing::Values(std::make_tuple(Format::AUTO, ".sexp")));
+#endif
+
+#ifdef PRIO_USE_JSONCPP
+INSTANTIATE_TEST_CASE_P(JsonReaderMappingTest, ReaderMappingTest,
+                        ::testing::Values(std::make_tuple(Format::AUTO, ".json")));
 #endif
 
+INSTANTIATE_TEST_CASE_P(FastJsonReaderMappingTest, ReaderMappingTest,
+                        ::testing::Values(std::make_tuple(Format::FASTJSON, ".json")));
+
+INSTANTIATE_TEST_CASE_P(FastSExprReaderMappingTest, ReaderMappingTest,
+                        ::testing::Values(std::make_tuple(Format::FASTSEXPR, ".sexp")));
+
+INSTANTIATE_TEST_CASE_P(BinaryReaderMappingTest, ReaderMappingTest,
+                        ::testing::Values(std::make_tuple(Format::AUTO, ".bin"),
+                                          std::make_tuple(Format::BINARY, ".bin")));
+
+INSTANTIATE_TEST_CASE_P(MsgPackReaderMappingTest, ReaderMappingTest,
+                        ::testing::Values(std::make_tuple(Format::AUTO, ".msgpack"),
+                                          std::make_tuple(Format::MSGPACK, ".msgpack")));
+
 /* EOF */
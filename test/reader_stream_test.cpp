@@ -0,0 +1,188 @@
+// prio - Property I/O for C++
+// Copyright (C) 2005-2026 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include <format>
+#include <sstream>
+
+#include <prio/reader_error.hpp>
+#include <prio/reader_stream.hpp>
+
+using namespace prio;
+
+namespace {
+
+/** Renders the events of the first top-level value of @a stream as an
+    s-expression like string */
+std::string trace(ReaderStream& stream)
+{
+  std::string result;
+  auto emit = [&result](std::string const& token) {
+    if (!result.empty() && result.back() != '(' && result.back() != '[' &&
+        token != ")" && token != "]") {
+      result += ' ';
+    }
+    result += token;
+  };
+
+  do {
+    switch (stream.next()) {
+      case ReaderStream::Event::BEGIN_OBJECT:
+        emit(std::format("({}", stream.get_name()));
+        break;
+
+      case ReaderStream::Event::BEGIN_COLLECTION:
+        emit("[");
+        break;
+
+      case ReaderStream::Event::END_OBJECT:
+        emit(")");
+        break;
+
+      case ReaderStream::Event::END_COLLECTION:
+        emit("]");
+        break;
+
+      case ReaderStream::Event::BOOL:
+        emit(stream.get_bool() ? "#t" : "#f");
+        break;
+
+      case ReaderStream::Event::INT:
+        emit(std::format("{}", stream.get_int()));
+        break;
+
+      case ReaderStream::Event::FLOAT:
+        emit(std::format("{}f", stream.get_float()));
+        break;
+
+      case ReaderStream::Event::STRING:
+        emit(std::format("\"{}\"", stream.get_string()));
+        break;
+
+      case ReaderStream::Event::END_DOCUMENT:
+        emit("<eof>");
+        return result;
+    }
+  } while (stream.get_depth() > 0);
+
+  return result;
+}
+
+std::string trace(Format format, std::string const& text)
+{
+  std::istringstream in(text);
+  ReaderStream stream = ReaderStream::from_stream(format, in);
+  std::string result = trace(stream);
+  while (stream.get_depth() == 0 && result.find("<eof>") == std::string::npos) {
+    result += " | " + trace(stream);
+  }
+  return result;
+}
+
+constexpr char const* data_trace =
+  "(test-document (boolvalue #t) (intvalue 5) (floatvalue 5.5f) (stringvalue \"Hello World\")"
+  " (boolvalues #t #f #t) (intvalues 1 2 3 4) (floatvalues 1.5f 2.5f 3.5f 4.5f)"
+  " (stringvalues \"Hello\" \"World\") (enumvalue \"C\") (customvalue 5)"
+  " (submap (int 7) (float 9.9f)) (collection (obj1) (obj2) (obj3))"
+  " (object (realthing (prop1 5) (prop2 7))) (vector 1f 2f 3f))";
+
+} // namespace
+
+TEST(ReaderStreamTest, from_file)
+{
+  ReaderStream sexpr = ReaderStream::from_file("test/data/data.sexp");
+  EXPECT_EQ(trace(sexpr), data_trace);
+  EXPECT_EQ(sexpr.next(), ReaderStream::Event::END_DOCUMENT);
+
+  // data.json has a stray ';' after the document, so only read the first value
+  ReaderStream json = ReaderStream::from_file("test/data/data.json");
+  EXPECT_EQ(trace(json), data_trace);
+
+  EXPECT_THROW(ReaderStream::from_file("does-not-exist"), ReaderError);
+}
+
+TEST(ReaderStreamTest, multiple_roots)
+{
+  EXPECT_EQ(trace(Format::AUTO, "(a (id 1)) ; comment\n(b (id 2))"),
+            "(a (id 1)) | (b (id 2)) | <eof>");
+  EXPECT_EQ(trace(Format::AUTO, "{\"a\": {\"id\": 1}}\n{\"b\": {\"id\": 2}}\n"),
+            "(a (id 1)) | (b (id 2)) | <eof>");
+}
+
+TEST(ReaderStreamTest, collections)
+{
+  EXPECT_EQ(trace(Format::SEXPR, "(l (1 2) (\"a\" b) () (((x))))"),
+            "(l [1 2] [\"a\" \"b\"] [] [[(x)]]) | <eof>");
+  EXPECT_EQ(trace(Format::JSON, "{\"l\": [[1, 2], [\"a\", \"b\"], [], [[{\"x\": null}]]]}"),
+            "(l [1 2] [\"a\" \"b\"] [] [[(x)]]) | <eof>");
+  EXPECT_EQ(trace(Format::JSON, "[1, null, 2.5e1, -7, \"\\u00e4\\n\", 99999999999]"),
+            "[1 25f -7 \"\xc3\xa4\n\" 1e+11f] | <eof>");
+}
+
+TEST(ReaderStreamTest, skip)
+{
+  std::istringstream in("(doc (skipped (a 1) (b (c 2))) (kept 3))");
+  ReaderStream stream = ReaderStream::from_stream(in);
+  ASSERT_EQ(stream.next(), ReaderStream::Event::BEGIN_OBJECT);
+  ASSERT_EQ(stream.next(), ReaderStream::Event::BEGIN_OBJECT);
+  EXPECT_EQ(stream.get_name(), "skipped");
+  stream.skip();
+  EXPECT_EQ(stream.get_depth(), 1);
+  ASSERT_EQ(stream.next(), ReaderStream::Event::BEGIN_OBJECT);
+  EXPECT_EQ(stream.get_name(), "kept");
+  ASSERT_EQ(stream.next(), ReaderStream::Event::INT);
+  EXPECT_EQ(stream.get_int(), 3);
+}
+
+TEST(ReaderStreamTest, get_line)
+{
+  std::istringstream in("(doc\n  (a 1)\n\n  (b 2))");
+  ReaderStream stream = ReaderStream::from_stream(Format::SEXPR, in);
+  stream.next();
+  EXPECT_EQ(stream.get_line(), 1);
+  stream.next();
+  EXPECT_EQ(stream.get_line(), 2);
+  stream.skip();
+  stream.next();
+  EXPECT_EQ(stream.get_name(), "b");
+  EXPECT_EQ(stream.get_line(), 4);
+}
+
+TEST(ReaderStreamTest, errors)
+{
+  for (auto const& [format, text] : std::vector<std::pair<Format, std::string>>{
+      {Format::SEXPR, "(doc (a 1)"},
+      {Format::SEXPR, "(doc))"},
+      {Format::SEXPR, "(doc \"unterminated)"},
+      {Format::JSON, "{\"doc\": 1"},
+      {Format::JSON, "{\"doc\" 1}"},
+      {Format::JSON, "{\"doc\": 1,}"},
+      {Format::JSON, "[1 2]"},
+      {Format::JSON, "[tru]"},
+      {Format::JSON, "[1.2.3]"},
+      {Format::JSON, "[\"\\x\"]"},
+      {Format::JSON, std::string(2000, '[')}})
+  {
+    std::istringstream in(text);
+    ReaderStream stream = ReaderStream::from_stream(format, in, "input");
+    EXPECT_THROW({
+        while (stream.next() != ReaderStream::Event::END_DOCUMENT) {}
+      }, ReaderError) << text;
+  }
+}
+
+/* EOF */